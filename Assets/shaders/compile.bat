@@ -1,2 +0,0 @@
-glslc triangle.vert -o triangle-vert.spv
-glslc triangle.frag -o triangle-frag.spv
\ No newline at end of file
@@ -0,0 +1,23 @@
+#version 450
+
+layout(location = 0) in vec2 inPosition;
+
+layout(location = 0) out vec4 fragColor;
+
+// Center, half size and hue, indexed by the firstInstance cull.comp wrote
+layout(set = 0, binding = 0) readonly buffer Quads {
+    vec4 quads[];
+};
+
+layout(push_constant) uniform Push {
+    mat4 viewProjection;
+} push;
+
+void main() {
+    vec4 quad   = quads[gl_InstanceIndex];
+    gl_Position = push.viewProjection *
+                  vec4(inPosition * quad.z + quad.xy, 0.0, 1.0);
+    vec3 hue    = clamp(abs(fract(quad.w + vec3(0.0, 2.0, 1.0) / 3.0) * 6.0 -
+                            3.0) - 1.0, 0.0, 1.0);
+    fragColor   = vec4(hue, 1.0);
+}
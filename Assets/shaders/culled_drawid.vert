@@ -0,0 +1,30 @@
+#version 450
+#extension GL_ARB_shader_draw_parameters : require
+
+// culled.vert for devices without drawIndirectFirstInstance, the quad comes
+// from the instanceIndex cull.comp wrote for this draw
+
+layout(location = 0) in vec2 inPosition;
+
+layout(location = 0) out vec4 fragColor;
+
+// Center, half size and hue
+layout(set = 0, binding = 0) readonly buffer Quads {
+    vec4 quads[];
+};
+layout(set = 0, binding = 1) readonly buffer DrawObjects {
+    uint drawObjects[];
+};
+
+layout(push_constant) uniform Push {
+    mat4 viewProjection;
+} push;
+
+void main() {
+    vec4 quad   = quads[drawObjects[gl_DrawIDARB]];
+    gl_Position = push.viewProjection *
+                  vec4(inPosition * quad.z + quad.xy, 0.0, 1.0);
+    vec3 hue    = clamp(abs(fract(quad.w + vec3(0.0, 2.0, 1.0) / 3.0) * 6.0 -
+                            3.0) - 1.0, 0.0, 1.0);
+    fragColor   = vec4(hue, 1.0);
+}
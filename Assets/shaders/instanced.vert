@@ -0,0 +1,20 @@
+#version 450
+
+// Per vertex, binding 0
+layout(location = 0) in vec2 inPosition;
+// Per instance, binding 1
+layout(location = 1) in vec2 inOffset;
+layout(location = 2) in float inScale;
+layout(location = 3) in vec4 inColor;
+
+layout(location = 0) out vec4 fragColor;
+
+layout(push_constant) uniform Push {
+    vec2 aspect;
+} push;
+
+void main() {
+    vec2 position = inPosition * inScale + inOffset;
+    gl_Position   = vec4(position * push.aspect, 0.0, 1.0);
+    fragColor     = inColor;
+}
@@ -0,0 +1,13 @@
+#version 450
+
+layout(location = 0) in vec2 fragTexCoord;
+layout(location = 1) in vec4 fragColor;
+
+layout(location = 0) out vec4 outColor;
+
+// Same layout as the sets ImGui allocates for Image::GetDescriptorSet()
+layout(set = 0, binding = 0) uniform sampler2D texSampler;
+
+void main() {
+    outColor = fragColor * texture(texSampler, fragTexCoord);
+}
@@ -0,0 +1,35 @@
+#version 450
+
+// Per instance, the six corners of the quad come from gl_VertexIndex
+layout(location = 0) in vec2 inPosition;   // Center, in pixels
+layout(location = 1) in vec2 inSize;
+layout(location = 2) in float inRotation;  // Radians
+layout(location = 3) in vec4 inTexCoords;  // uv of the top left, bottom right
+layout(location = 4) in vec4 inColor;
+
+layout(location = 0) out vec2 fragTexCoord;
+layout(location = 1) out vec4 fragColor;
+
+// Pixels to normalized device coordinates
+layout(push_constant) uniform Push {
+    vec2 scale;
+    vec2 translate;
+} push;
+
+const vec2 corners[6] = vec2[](
+    vec2(-0.5, -0.5), vec2(0.5, -0.5), vec2(0.5, 0.5),
+    vec2(-0.5, -0.5), vec2(0.5, 0.5), vec2(-0.5, 0.5)
+);
+
+void main() {
+    vec2  corner  = corners[gl_VertexIndex];
+    vec2  local   = corner * inSize;
+    float s       = sin(inRotation);
+    float c       = cos(inRotation);
+    vec2  rotated = vec2(local.x * c - local.y * s, local.x * s + local.y * c);
+
+    gl_Position  = vec4((inPosition + rotated) * push.scale + push.translate,
+                        0.0, 1.0);
+    fragTexCoord = mix(inTexCoords.xy, inTexCoords.zw, corner + 0.5);
+    fragColor    = inColor;
+}
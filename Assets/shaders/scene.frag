@@ -0,0 +1,24 @@
+#version 450
+
+layout(location = 0) in vec2 fragUV;
+
+layout(location = 0) out vec4 outColor;
+
+layout(push_constant) uniform Push {
+    vec2  aspect;
+    float time;
+    int   iterations;  // Cost per pixel
+} push;
+
+// Domain warped sine pattern, expensive enough per pixel that the scene's
+// resolution decides the frame time
+void main() {
+    vec2 p = (fragUV * 2.0 - 1.0) * push.aspect * 3.0;
+    for (int i = 1; i <= push.iterations; i++) {
+        float f = float(i);
+        p += vec2(sin(p.y * f * 0.5 + push.time + f),
+                  cos(p.x * f * 0.5 - push.time * 0.7 + f)) / f;
+    }
+    vec3 color = 0.5 + 0.5 * cos(vec3(0.0, 2.0, 4.0) + p.x + p.y);
+    outColor   = vec4(color, 1.0);
+}
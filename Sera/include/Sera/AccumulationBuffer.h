@@ -0,0 +1,89 @@
+#pragma once
+
+#include <cstdint>
+#include <vector>
+
+#include <glm/glm.hpp>
+
+namespace Sera {
+
+  class Image;
+
+  // Declared outside AccumulationBuffer so it can be a default argument there
+  struct AccumulationBufferSettings {
+      // Tracks the running variance of every pixel's luminance, for adaptive
+      // sampling with GetStandardError()
+      bool variance = false;
+  };
+
+  // Running average of the samples a progressive renderer produces for an
+  // Image. Add() accumulates a sample and writes the new average, converted
+  // to the image's format, into a copy of the image's pixels. Accumulating,
+  // averaging and converting take a single pass over the frame, and End()
+  // uploads the pixels with one copy into the image's staging memory.
+  //
+  // Every pixel counts its own samples, so pixels can be skipped once they
+  // have converged. Skipped pixels keep their last value.
+  class AccumulationBuffer {
+    public:
+      using Settings = AccumulationBufferSettings;
+
+      AccumulationBuffer(Image& image, const Settings& settings = {});
+
+      // Starts this frame's samples. The accumulation restarts when the
+      // image was resized since the last frame, after Reset(), or when
+      // `view` differs from the last one.
+      void Begin();
+      void Begin(const glm::mat4& view);
+      // Queues the image's upload for the next frame, call once all samples
+      // of the frame were added
+      void End();
+
+      // Restarts the accumulation with the next Begin()
+      void Reset() { m_ResetPending = true; }
+
+      // Thread safe as long as threads add to different pixels
+      void Add(uint32_t x, uint32_t y, const glm::vec4& sample);
+      // `count` samples along the row starting at (x, y)
+      void AddRow(uint32_t x, uint32_t y, const glm::vec4* samples,
+                  uint32_t count);
+
+      glm::vec4 GetAverage(uint32_t x, uint32_t y) const;
+      uint32_t  GetSampleCount(uint32_t x, uint32_t y) const {
+        return m_Counts[y * m_Width + x];
+      }
+      // Sample variance of the pixel's luminance, 0 without
+      // Settings::variance or with fewer than two samples
+      float     GetVariance(uint32_t x, uint32_t y) const;
+      // Standard error of the pixel's mean luminance, adaptive samplers
+      // stop sampling a pixel once it is small enough
+      float     GetStandardError(uint32_t x, uint32_t y) const;
+
+      // Frames accumulated since the last restart
+      uint32_t GetFrameIndex() const { return m_FrameIndex; }
+
+    private:
+      void Accumulate(uint32_t index, const glm::vec4& sample);
+
+    private:
+      Image&   m_Image;
+      Settings m_Settings;
+
+      uint32_t m_Width = 0, m_Height = 0;
+
+      std::vector<glm::vec4> m_Sums;
+      std::vector<uint32_t>  m_Counts;
+      // Sum of squared luminance deviations, Welford's algorithm
+      std::vector<float>     m_M2;
+
+      // Averages in the image's format, m_Target between Begin() and End()
+      std::vector<uint8_t> m_Pixels;
+      uint8_t*             m_Target    = nullptr;
+      uint32_t             m_PixelSize = 0;
+
+      glm::mat4 m_View{1.0f};
+      uint32_t  m_FrameIndex   = 0;
+      bool      m_ResetPending = true;
+  };
+
+}  // namespace Sera
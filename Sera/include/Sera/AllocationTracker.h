@@ -0,0 +1,77 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+
+namespace Sera {
+
+  // Counts heap allocations when Sera is built with SR_TRACK_ALLOCATIONS,
+  // which replaces the global operator new and delete and routes ImGui's
+  // allocations through them. Allocations are counted per frame, per thread
+  // and, through the Profiler, per zone. Without SR_TRACK_ALLOCATIONS
+  // nothing is replaced and every count stays zero.
+  //
+  // Frames from ApplicationSpecification::SteadyStateFrame on are expected
+  // to allocate nothing. Allocations in them are flagged according to
+  // SetAssertion(), except on threads inside an AllowAllocations scope.
+  class AllocationTracker {
+    public:
+      struct Usage {
+          uint64_t allocations = 0;
+          uint64_t frees       = 0;
+          // Requested, without the allocator's overhead
+          uint64_t bytes       = 0;
+      };
+
+      enum class Assertion {
+        None = 0,
+        // Logs the first allocation of each steady-state frame and how many
+        // followed, at the end of the frame
+        Warn,
+        // Writes the allocation to stderr and aborts where it happened, so
+        // a debugger stops on the offending call stack
+        Abort
+      };
+
+      // Whether Sera was built with SR_TRACK_ALLOCATIONS
+      static bool IsEnabled();
+
+      // Made on the calling thread since it started
+      static Usage GetThreadUsage();
+      // Of the last frame, on all threads
+      static Usage GetFrameUsage();
+
+      // Ends the frame's counts and reports its steady-state allocations,
+      // Application calls it once per frame
+      static void MarkFrame();
+
+      static void SetAssertion(Assertion assertion);
+      static void SetSteadyState(bool steadyState);
+      static bool IsSteadyState();
+
+      // Innermost profiler zone of the calling thread, reported with
+      // steady-state allocations. Set by the Profiler.
+      static void SetZone(const char* name);
+
+      // For ImGui::SetAllocatorFunctions()
+      static void* Allocate(size_t size, void* userData);
+      static void  Free(void* memory, void* userData);
+
+    private:
+      friend class AllowAllocations;
+      static void Allow(bool allow);
+  };
+
+  // Allocations on the calling thread are expected while it lives, e.g.
+  // resizing the swapchain or loading on demand, and are counted but not
+  // flagged in steady-state frames
+  class AllowAllocations {
+    public:
+      AllowAllocations() { AllocationTracker::Allow(true); }
+      ~AllowAllocations() { AllocationTracker::Allow(false); }
+
+      AllowAllocations(const AllowAllocations&)            = delete;
+      AllowAllocations& operator=(const AllowAllocations&) = delete;
+  };
+
+}  // namespace Sera
@@ -1,6 +1,7 @@
 #pragma once
 
 #include "Layer.h"
+#include "Timer.h"
 
 #include <functional>
 #include <memory>
@@ -16,10 +17,53 @@ struct GLFWwindow;
 
 namespace Sera {
 
+  struct VulkanDevice;
+  class GpuProfiler;
+  class JobSystem;
+  class VulkanLayoutCache;
+  class VulkanPipelineCache;
+  class VulkanPipelineRegistry;
+  class VulkanShader;
+
+  // Depth attachment of the main render pass. ImGui and 2D content need no
+  // depth, so the attachment is only allocated when requested.
+  enum class DepthFormat { None = 0, D16, D32, D24S8 };
+
   struct ApplicationSpecification {
-      std::string Name   = "Sera App";
-      uint32_t    Width  = 1600;
-      uint32_t    Height = 900;
+      std::string Name              = "Sera App";
+      uint32_t    Width             = 1600;
+      uint32_t    Height            = 900;
+      DepthFormat DepthAttachment   = DepthFormat::None;
+      // Renders into offscreen images without GLFW, a window or a surface.
+      // Width and Height become the fixed ImGui display size.
+      bool        Headless          = false;
+      // Stops the main loop after this many frames, 0 runs until Close()
+      uint32_t    FrameCount        = 0;
+      // Seconds passed to OnUpdate every frame, 0 uses the measured time
+      float       FixedTimestep     = 0.0f;
+      // Uses VK_KHR_dynamic_rendering for the main pass when the device
+      // supports it, the render pass path is the fallback
+      bool        DynamicRendering  = true;
+      // Pipeline cache file, reused across runs on the same device and
+      // driver. Empty keeps the cache in memory only.
+      std::string PipelineCachePath = "pipeline_cache.bin";
+      // Rebuilds pipelines when a .spv file in ShaderDirectory changes.
+      // Empty uses the directory the build compiles shaders into, which is
+      // only watched in debug builds of Sera.
+      bool        ShaderHotReload   = true;
+      std::string ShaderDirectory   = "";
+      // Worker threads of the job system, 0 starts one per core besides the
+      // main thread
+      uint32_t    JobWorkerCount    = 0;
+      // Draws the FrameStats overlay from the first frame on
+      bool        ShowFrameStats    = false;
+      // Counts the host memory Vulkan allocates for Sera's objects, see
+      // MemoryTracker. Device memory is tracked either way.
+      bool        TrackMemory       = false;
+      // Frames from this one on should not allocate on the heap, which
+      // AllocationTracker checks in builds with SR_TRACK_ALLOCATIONS. 0
+      // never checks.
+      uint64_t    SteadyStateFrame  = 0;
   };
 
   class Application {
@@ -51,14 +95,67 @@ namespace Sera {
 
       float       GetTime();
       GLFWwindow *GetWindowHandle() const { return m_WindowHandle; };
+      bool        IsHeadless() const { return m_Specification.Headless; }
+      uint64_t    GetFrameIndex() const { return m_FrameIndex; }
+
+      // Frame time graph and counters drawn over the app, see FrameStats
+      void SetFrameStatsVisible(bool visible) { m_ShowFrameStats = visible; }
+      bool IsFrameStatsVisible() const { return m_ShowFrameStats; }
 
       static VkInstance       GetInstance();
       static VkPhysicalDevice GetPhysicalDevice();
       static VkDevice         GetDevice();
+      static VkPipelineCache  GetPipelineCache();
+      // Shared, deduplicated pipelines compiled off the main thread
+      static VulkanPipelineRegistry *GetPipelineRegistry();
+      // Descriptor set and pipeline layouts reflected from shaders
+      static VulkanLayoutCache      *GetLayoutCache();
+      // Backend objects, for pipelines created outside the registry
+      static VulkanDevice           *GetVulkanDevice();
+      static VulkanPipelineCache    *GetVulkanPipelineCache();
+      // Worker pool for CPU work, Layer::OnUpdate() is the usual place to
+      // fan out and wait for jobs
+      static JobSystem              &GetJobSystem();
+      // GPU time of the frame's passes, scopes are recorded into the command
+      // buffer passed to OnPreRender or OnRender
+      static GpuProfiler            &GetGpuProfiler();
+      // Whether Sera was built with SR_DEBUG, which is not defined for the
+      // applications using it
+      static bool                    IsDebugBuild();
+
+      // Attachments of the main pass, user pipelines drawing in OnRender are
+      // created against these. GetRenderPass() is VK_NULL_HANDLE when the
+      // main pass uses dynamic rendering.
+      static bool         IsDynamicRenderingEnabled();
+      static VkRenderPass GetRenderPass();
+      static VkFormat     GetColorFormat();
+      static VkFormat     GetDepthFormat();
+      // The depth format when it has a stencil aspect, VK_FORMAT_UNDEFINED
+      // otherwise
+      static VkFormat     GetStencilFormat();
+      static VkExtent2D   GetFramebufferExtent();
+
+      // SPIR-V embedded by sera_compile_shaders(). `name` is the .spv file in
+      // the shader directory, e.g. "triangle-vert.spv", so hot reload finds
+      // the shader, and with SR_SHADER_DISK_OVERRIDE that file wins.
+      static std::shared_ptr<VulkanShader> LoadShader(
+          const char *name, const uint32_t *spirv, size_t wordCount,
+          VkShaderStageFlagBits stage);
+
+      // Frames recorded while the GPU still works on earlier ones. Data the
+      // CPU rewrites every frame keeps one copy per frame in flight, indexed
+      // by GetCurrentFrameInFlight() while recording OnPreRender or OnRender.
+      static uint32_t GetFramesInFlight();
+      static uint32_t GetCurrentFrameInFlight();
 
       static VkCommandBuffer GetCommandBuffer(bool begin);
       static void            FlushCommandBuffer(VkCommandBuffer commandBuffer);
 
+      // Descriptor set that stays valid until this frame's slot is reused,
+      // for sets written while recording OnPreRender or OnRender
+      static VkDescriptorSet AllocateFrameDescriptorSet(
+          VkDescriptorSetLayout layout);
+
       static void SubmitResourceFree(std::function<void()> &&func);
 
     private:
@@ -70,9 +167,13 @@ namespace Sera {
       GLFWwindow              *m_WindowHandle = nullptr;
       bool                     m_Running      = false;
 
-      float m_TimeStep      = 0.0f;
-      float m_FrameTime     = 0.0f;
-      float m_LastFrameTime = 0.0f;
+      float    m_TimeStep          = 0.0f;
+      float    m_FrameTime         = 0.0f;
+      float    m_LastFrameTime     = 0.0f;
+      float    m_LastCacheSaveTime = 0.0f;
+      uint64_t m_FrameIndex        = 0;
+      Timer    m_HeadlessTimer;
+      bool     m_ShowFrameStats    = false;
 
       std::vector<std::shared_ptr<Layer>> m_LayerStack;
       std::function<void()>               m_MenubarCallback;
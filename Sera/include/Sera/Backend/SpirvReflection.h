@@ -0,0 +1,44 @@
+#pragma once
+#include <vulkan/vulkan.h>
+#include "SpecializationConstants.h"
+#include <cstdint>
+#include <vector>
+namespace Sera {
+  // Resource interface of one SPIR-V entry point, enough to build descriptor
+  // set layouts, push constant ranges and vertex input state. Parsed in tree,
+  // no SPIRV-Reflect or SPIRV-Cross dependency.
+  struct SpirvReflection {
+      struct Binding {
+          uint32_t         set     = 0;
+          uint32_t         binding = 0;
+          VkDescriptorType type    = VK_DESCRIPTOR_TYPE_MAX_ENUM;
+          uint32_t         count   = 1;
+      };
+      struct VertexInput {
+          uint32_t location = 0;
+          VkFormat format   = VK_FORMAT_UNDEFINED;
+          uint32_t size     = 0;
+      };
+      struct SpecConstant {
+          uint32_t           id   = 0;
+          SpecializationType type = SpecializationType::UInt;
+      };
+
+      VkShaderStageFlagBits stage = VK_SHADER_STAGE_ALL;
+      std::vector<Binding>  bindings;
+      // Size in bytes of the push constant block, 0 without one
+      uint32_t pushConstantSize = 0;
+      // Vertex stage only, sorted by location, built-ins are skipped.
+      // Matrices take one input per column, inputs without a 32-bit vertex
+      // format, e.g. 64-bit ones, have VK_FORMAT_UNDEFINED.
+      std::vector<VertexInput> vertexInputs;
+      // Compute stage only, from the LocalSize execution mode
+      uint32_t localSize[3] = {1, 1, 1};
+      // Sorted by constant_id, 64-bit and 16-bit constants are skipped
+      std::vector<SpecConstant> specConstants;
+  };
+
+  // Returns false on malformed SPIR-V, `reflection` is then incomplete.
+  bool ReflectSpirv(const std::vector<uint32_t>& code,
+                    SpirvReflection&             reflection);
+}  // namespace Sera
@@ -0,0 +1,51 @@
+#pragma once
+#include <vulkan/vulkan.h>
+#include "Backend/VulkanLayoutCache.h"
+#include "SpecializationConstants.h"
+#include <memory>
+#include <vector>
+namespace Sera {
+  class VulkanDevice;
+  class VulkanPipelineCache;
+  class VulkanShader;
+  class VulkanComputePipeline {
+    public:
+      struct CreateInfo {
+          VulkanDevice*                 device;
+          const VkAllocationCallbacks*  allocator = VK_NULL_HANDLE;
+          std::shared_ptr<VulkanShader> shader;
+          // E.g. tile sizes or modes, each variant is a separate pipeline
+          SpecializationConstants       specialization;
+          // Optional, pipelines are compiled from scratch without a cache
+          VulkanPipelineCache*          pipelineCache = nullptr;
+          // Shares layouts between pipelines, without one the pipeline keeps
+          // its layouts to itself
+          VulkanLayoutCache*            layoutCache   = nullptr;
+          VkPipelineCreateFlags         flags         = 0;
+      };
+      static VulkanComputePipeline* Create(CreateInfo info);
+      ~VulkanComputePipeline();
+
+      VkPipeline        GetHandle() const { return m_Handle; }
+      VkPipelineLayout  GetLayout() const { return m_Layout.layout; }
+      const CreateInfo& GetInfo() const { return m_Info; }
+      VkResult          GetResult() const { return m_Result; }
+      // Reflected from the shader, indexed by set number
+      const std::vector<VkDescriptorSetLayout>& GetSetLayouts() const {
+        return m_Layout.setLayouts;
+      }
+      const VkPushConstantRange& GetPushConstantRange() const {
+        return m_Layout.pushConstants;
+      }
+      // Workgroup size declared by the shader
+      const uint32_t* GetLocalSize() const;
+
+    private:
+      VulkanComputePipeline(CreateInfo info);
+      CreateInfo                         m_Info;
+      VkPipeline                         m_Handle = VK_NULL_HANDLE;
+      VulkanLayoutCache::Layout          m_Layout;
+      std::unique_ptr<VulkanLayoutCache> m_OwnedLayoutCache;
+      VkResult                           m_Result = VK_NOT_READY;
+  };
+}  // namespace Sera
@@ -17,4 +17,70 @@ namespace Sera {
   void FreeDebug(VkInstance instance);
 
   const char* VkObjectTypeToString(VkObjectType ObjectType);
-}  // namespace Sera
\ No newline at end of file
+
+  // Names an object in validation messages and GPU captures. The functions
+  // below do nothing unless debug utils were set up, which VulkanInstance
+  // only does in SR_DEBUG builds. Release builds should not build the names
+  // either, call them through the SR_DEBUG_* macros or under #ifdef SR_DEBUG.
+  void SetObjectName(VkDevice device, VkObjectType type, uint64_t handle,
+                     const char* name);
+  template <typename Handle>
+  void SetObjectName(VkDevice device, VkObjectType type, Handle handle,
+                     const char* name) {
+    SetObjectName(device, type, (uint64_t)handle, name);
+  }
+
+  // Labelled regions of a command buffer or a queue, they nest
+  void BeginDebugLabel(VkCommandBuffer commandBuffer, const char* name);
+  void EndDebugLabel(VkCommandBuffer commandBuffer);
+  void BeginQueueDebugLabel(VkQueue queue, const char* name);
+  void EndQueueDebugLabel(VkQueue queue);
+
+  class DebugLabel {
+    public:
+      DebugLabel(VkCommandBuffer commandBuffer, const char* name)
+          : m_CommandBuffer(commandBuffer) {
+        BeginDebugLabel(commandBuffer, name);
+      }
+      ~DebugLabel() { EndDebugLabel(m_CommandBuffer); }
+
+      DebugLabel(const DebugLabel&)            = delete;
+      DebugLabel& operator=(const DebugLabel&) = delete;
+
+    private:
+      VkCommandBuffer m_CommandBuffer;
+  };
+
+  class QueueDebugLabel {
+    public:
+      QueueDebugLabel(VkQueue queue, const char* name) : m_Queue(queue) {
+        BeginQueueDebugLabel(queue, name);
+      }
+      ~QueueDebugLabel() { EndQueueDebugLabel(m_Queue); }
+
+      QueueDebugLabel(const QueueDebugLabel&)            = delete;
+      QueueDebugLabel& operator=(const QueueDebugLabel&) = delete;
+
+    private:
+      VkQueue m_Queue;
+  };
+}  // namespace Sera
+
+#define SR_DEBUG_CONCAT_INNER(a, b) a##b
+#define SR_DEBUG_CONCAT(a, b)       SR_DEBUG_CONCAT_INNER(a, b)
+
+// Compiled out of release builds along with their arguments
+#ifdef SR_DEBUG
+#define SR_DEBUG_NAME(device, type, handle, name) \
+  ::Sera::SetObjectName(device, type, handle, name)
+#define SR_DEBUG_LABEL(commandBuffer, name)                    \
+  ::Sera::DebugLabel SR_DEBUG_CONCAT(srDebugLabel, __LINE__)( \
+      commandBuffer, name)
+#define SR_QUEUE_DEBUG_LABEL(queue, name)                           \
+  ::Sera::QueueDebugLabel SR_DEBUG_CONCAT(srQueueLabel, __LINE__)( \
+      queue, name)
+#else
+#define SR_DEBUG_NAME(device, type, handle, name)
+#define SR_DEBUG_LABEL(commandBuffer, name)
+#define SR_QUEUE_DEBUG_LABEL(queue, name)
+#endif
\ No newline at end of file
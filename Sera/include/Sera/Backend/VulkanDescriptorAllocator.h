@@ -0,0 +1,35 @@
+#pragma once
+#include <vulkan/vulkan.h>
+#include <cstdint>
+#include <vector>
+namespace Sera {
+  class VulkanDevice;
+  // Hands out short-lived descriptor sets from a growing list of pools. Sets
+  // are never freed one by one, Reset() recycles all of them at once when
+  // the GPU is done with them, e.g. once a frame in flight has finished.
+  class VulkanDescriptorAllocator {
+    public:
+      struct CreateInfo {
+          VulkanDevice*                device;
+          // Each pool holds this many sets of up to a few descriptors
+          uint32_t                     setsPerPool = 256;
+          const VkAllocationCallbacks* allocator   = VK_NULL_HANDLE;
+      };
+      ~VulkanDescriptorAllocator();
+      static VulkanDescriptorAllocator* Create(CreateInfo info);
+
+      // Adds a pool when the current ones are exhausted, VK_NULL_HANDLE when
+      // even a fresh pool cannot hold the set
+      VkDescriptorSet Allocate(VkDescriptorSetLayout layout);
+      void            Reset();
+
+    private:
+      VulkanDescriptorAllocator(CreateInfo info);
+      VkDescriptorPool CreatePool();
+
+    private:
+      CreateInfo                    m_Info;
+      std::vector<VkDescriptorPool> m_Pools;
+      size_t                        m_Current = 0;
+  };
+}  // namespace Sera
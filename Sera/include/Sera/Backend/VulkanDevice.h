@@ -3,11 +3,42 @@
 #include "Backend/VulkanPhysicalDevice.h"
 #include <vector>
 namespace Sera {
+  // Optional features. Requested ones are only enabled when the physical
+  // device supports them, afterwards `features` holds what was enabled.
+  // Declared outside VulkanDevice so it can be a default argument there.
+  struct VulkanDeviceFeatures {
+      bool dynamicRendering             = false;
+      // VkPipelineCreationFeedback, core in 1.3 or through the extension
+      bool pipelineCreationFeedback     = false;
+      // Allows VK_PIPELINE_CREATE_FAIL_ON_PIPELINE_COMPILE_REQUIRED_BIT
+      bool pipelineCreationCacheControl = false;
+      // vkGetBufferDeviceAddress, core in 1.2
+      bool bufferDeviceAddress          = false;
+      // vkCmdDrawIndexedIndirectCount, core in 1.2
+      bool drawIndirectCount            = false;
+      // More than one draw per vkCmdDrawIndexedIndirect
+      bool multiDrawIndirect            = false;
+      // Indirect draws with a firstInstance other than 0
+      bool drawIndirectFirstInstance    = false;
+      // gl_DrawID and the other draw parameters in shaders, core in 1.1
+      bool shaderDrawParameters         = false;
+      // vkCmdWriteTimestamp2 and the other synchronization2 commands, core
+      // in 1.3
+      bool synchronization2             = false;
+      // VK_QUERY_TYPE_PIPELINE_STATISTICS query pools
+      bool pipelineStatisticsQuery      = false;
+      // Heap budgets through VK_EXT_memory_budget, needs 1.1
+      bool memoryBudget                 = false;
+  };
+
   struct VulkanDevice {
+      using Features = VulkanDeviceFeatures;
+
       VulkanDevice(const VulkanPhysicalDevice*  pDevice,
                    const VkAllocationCallbacks* vkAllocator,
                    uint32_t queueFamily, std::vector<const char*>& extensions,
-                   void* pNext = nullptr);
+                   const Features& requestedFeatures = {},
+                   void*           pNext             = nullptr);
       ~VulkanDevice();
 
       VkResult WaitIdle() { return vkDeviceWaitIdle(device); }
@@ -17,5 +48,6 @@ namespace Sera {
       const VkAllocationCallbacks* allocator      = VK_NULL_HANDLE;
       VkQueue                      queue          = VK_NULL_HANDLE;
       uint32_t                     queueFamily;
+      Features                     features;
   };
 }  // namespace Sera
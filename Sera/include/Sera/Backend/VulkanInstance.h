@@ -15,6 +15,8 @@ namespace Sera {
           std::vector<const char*> additionalLayers;
           // you can set this false in release mode
           bool  enableValidation = true;
+          // headless applications run without any window system extension
+          bool  enableSurface    = true;
           void* pNext            = nullptr;
       };
       VulkanInstance(Specs specs);
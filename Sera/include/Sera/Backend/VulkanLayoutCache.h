@@ -0,0 +1,55 @@
+#pragma once
+#include <vulkan/vulkan.h>
+#include <cstdint>
+#include <map>
+#include <mutex>
+#include <vector>
+namespace Sera {
+  class VulkanDevice;
+  struct SpirvReflection;
+  // Owns descriptor set layouts and pipeline layouts built from shader
+  // reflection. Identical binding lists share one VkDescriptorSetLayout and
+  // identical set layouts plus push constants share one VkPipelineLayout, so
+  // binding-compatible pipelines can use the same descriptor sets.
+  class VulkanLayoutCache {
+    public:
+      struct CreateInfo {
+          VulkanDevice*                device;
+          const VkAllocationCallbacks* allocator = VK_NULL_HANDLE;
+      };
+      struct Layout {
+          VkPipelineLayout                   layout = VK_NULL_HANDLE;
+          // Indexed by set number, unused sets get an empty layout
+          std::vector<VkDescriptorSetLayout> setLayouts;
+          // One range at offset 0 for all stages, size 0 without push
+          // constants. vkCmdPushConstants has to use its stageFlags.
+          VkPushConstantRange                pushConstants{};
+      };
+
+      ~VulkanLayoutCache();
+      static VulkanLayoutCache* Create(CreateInfo info);
+
+      // Merges the interfaces of the stages of one pipeline. Thread safe,
+      // the handles live until the cache is destroyed. The layout is
+      // VK_NULL_HANDLE when a set layout or the layout could not be created.
+      Layout GetLayout(const std::vector<const SpirvReflection*>& stages);
+      VkDescriptorSetLayout GetSetLayout(
+          const std::vector<VkDescriptorSetLayoutBinding>& bindings);
+
+      uint32_t GetSetLayoutCount() const;
+      uint32_t GetPipelineLayoutCount() const;
+
+    private:
+      VulkanLayoutCache(CreateInfo info);
+      VkDescriptorSetLayout FindOrCreateSetLayout(
+          const std::vector<VkDescriptorSetLayoutBinding>& bindings);
+
+    private:
+      using Key = std::vector<uint64_t>;
+
+      CreateInfo                           m_Info;
+      mutable std::mutex                   m_Mutex;
+      std::map<Key, VkDescriptorSetLayout> m_SetLayouts;
+      std::map<Key, Layout>                m_Layouts;
+  };
+}  // namespace Sera
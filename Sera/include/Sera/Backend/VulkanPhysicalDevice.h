@@ -1,11 +1,28 @@
 #pragma once
 #include <vulkan/vulkan.h>
+#include <vector>
 namespace Sera {
   struct VulkanPhysicalDevice {
       VulkanPhysicalDevice(VkPhysicalDevice device);
 
-      void             SelectGraphicsQueueFamily();
-      uint32_t         queueFamilyIndex = 0;
-      VkPhysicalDevice physicalDevice;
+      void SelectGraphicsQueueFamily();
+      // Returns the first memory type matching both the filter bits and the
+      // property flags, or UINT32_MAX if none matches.
+      uint32_t FindMemoryType(uint32_t              typeFilter,
+                              VkMemoryPropertyFlags properties) const;
+      bool     IsDepthFormatSupported(VkFormat format) const;
+      bool     IsExtensionSupported(const char* extension) const;
+
+      uint32_t                         queueFamilyIndex = 0;
+      VkPhysicalDevice                 physicalDevice;
+      VkPhysicalDeviceProperties       properties{};
+      VkPhysicalDeviceMemoryProperties memoryProperties{};
+      // Supported features, the 1.1-1.3 structs stay zeroed on devices
+      // older than 1.2
+      VkPhysicalDeviceFeatures           features{};
+      VkPhysicalDeviceVulkan11Features   features11{};
+      VkPhysicalDeviceVulkan12Features   features12{};
+      VkPhysicalDeviceVulkan13Features   features13{};
+      std::vector<VkExtensionProperties> extensions;
   };
-}  // namespace Sera
\ No newline at end of file
+}  // namespace Sera
@@ -0,0 +1,63 @@
+#pragma once
+#include <vulkan/vulkan.h>
+#include <atomic>
+#include <cstdint>
+#include <string>
+namespace Sera {
+  class VulkanDevice;
+  // Device-wide VkPipelineCache persisted to disk between runs. The file is
+  // only loaded when it was written by the same vendor, device, driver and
+  // pipeline cache UUID, anything else starts with an empty cache.
+  class VulkanPipelineCache {
+    public:
+      struct CreateInfo {
+          VulkanDevice*                device;
+          // Empty path keeps the cache in memory only
+          std::string                  path;
+          const VkAllocationCallbacks* allocator = VK_NULL_HANDLE;
+      };
+      // Pipelines created through the cache, hits are only counted when
+      // creation feedback is enabled on the device
+      struct Stats {
+          uint32_t pipelines      = 0;
+          uint32_t cacheHits      = 0;
+          uint32_t withFeedback   = 0;
+          double   creationTimeMs = 0.0;
+      };
+
+      ~VulkanPipelineCache();
+      static VulkanPipelineCache* Create(CreateInfo info);
+      VkPipelineCache             GetHandle() const { return m_Handle; }
+
+      // Writes the cache to a temporary file and renames it over the old one,
+      // so a crash while saving never leaves a truncated cache behind.
+      bool Save();
+      // Saves only when the driver reports more data than was last written
+      bool SaveIfGrown();
+
+      // Chains VkPipelineCreationFeedbackCreateInfo into the create info when
+      // feedback is available, Record() reads it back after creation.
+      struct Feedback {
+          VkPipelineCreationFeedback           pipeline{};
+          VkPipelineCreationFeedbackCreateInfo createInfo{};
+      };
+      void  Attach(Feedback& feedback, const void** pNext) const;
+      void  Record(const Feedback& feedback, double creationTimeMs);
+      Stats GetStats() const;
+
+    private:
+      VulkanPipelineCache(CreateInfo info);
+      bool   Load(std::string& data) const;
+      size_t QueryDataSize() const;
+
+    private:
+      CreateInfo      m_Info;
+      VkPipelineCache m_Handle    = VK_NULL_HANDLE;
+      size_t          m_SavedSize = 0;
+
+      std::atomic<uint32_t> m_Pipelines{0};
+      std::atomic<uint32_t> m_CacheHits{0};
+      std::atomic<uint32_t> m_WithFeedback{0};
+      std::atomic<uint64_t> m_CreationTimeUs{0};
+  };
+}  // namespace Sera
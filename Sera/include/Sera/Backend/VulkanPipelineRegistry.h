@@ -0,0 +1,131 @@
+#pragma once
+#include "Backend/VulkanRenderPipeline.h"
+#include <atomic>
+#include <condition_variable>
+#include <cstdint>
+#include <deque>
+#include <functional>
+#include <future>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <unordered_map>
+#include <vector>
+namespace Sera {
+  // Shared reference to a pipeline of the registry. Get() returns nullptr
+  // while the pipeline is still compiling or when compilation failed.
+  class PipelineHandle {
+    public:
+      struct Entry {
+          VulkanRenderPipeline::CreateInfo   info;
+          uint64_t                           hash = 0;
+          std::atomic<VulkanRenderPipeline*> pipeline{nullptr};
+          std::atomic<bool>                  ready{false};
+          std::promise<void>                 compiled;
+          std::shared_future<void>           future;
+      };
+
+      PipelineHandle() = default;
+      PipelineHandle(std::shared_ptr<Entry> entry) : m_Entry(entry) {}
+
+      bool IsValid() const { return m_Entry != nullptr; }
+      bool IsReady() const { return m_Entry && m_Entry->ready; }
+      // Blocks until the worker finished compiling
+      void Wait() const {
+        if (m_Entry) m_Entry->future.wait();
+      }
+      VulkanRenderPipeline* Get() const {
+        return m_Entry ? m_Entry->pipeline.load() : nullptr;
+      }
+      uint64_t GetHash() const { return m_Entry ? m_Entry->hash : 0; }
+
+      bool operator==(const PipelineHandle& other) const {
+        return m_Entry == other.m_Entry;
+      }
+
+    private:
+      std::shared_ptr<Entry> m_Entry;
+  };
+
+  // Deduplicates graphics pipelines by their full state and compiles new ones
+  // on worker threads. Identical CreateInfos share one VkPipeline, which
+  // lives until the registry is destroyed.
+  class VulkanPipelineRegistry {
+    public:
+      struct CreateInfo {
+          VulkanDevice*        device;
+          // Used for every pipeline that does not bring its own cache
+          VulkanPipelineCache* pipelineCache = nullptr;
+          // Same for pipelines without a layout cache
+          VulkanLayoutCache*   layoutCache   = nullptr;
+          uint32_t             workerCount   = 2;
+      };
+      ~VulkanPipelineRegistry();
+      static VulkanPipelineRegistry* Create(CreateInfo info);
+
+      // Returns the existing handle for identical state, otherwise queues the
+      // pipeline for compilation. With pipeline cache control the cache is
+      // probed first, cache hits are ready before this returns.
+      PipelineHandle Get(const VulkanRenderPipeline::CreateInfo& info);
+
+      // Rebuilds every pipeline using the shader file on a worker thread.
+      // Pipelines that fail to compile keep their previous version. Once
+      // swapped in, Get() with the previous shader returns the rebuilt
+      // pipeline.
+      void ReloadShader(const std::string& path);
+      // Swaps rebuilt pipelines into their handles. Call once per frame
+      // before recording, replaced pipelines are destroyed once no frame in
+      // flight can still use them.
+      void Update(uint32_t framesInFlight);
+
+      uint32_t GetPipelineCount() const;
+      uint32_t GetPendingCount() const { return m_Pending; }
+
+      static uint64_t Hash(const VulkanRenderPipeline::CreateInfo& info);
+      static bool     IsSameState(const VulkanRenderPipeline::CreateInfo& a,
+                                  const VulkanRenderPipeline::CreateInfo& b);
+
+    private:
+      VulkanPipelineRegistry(CreateInfo info);
+      void WorkerLoop();
+      void Enqueue(std::function<void()>&& job);
+      void Compile(PipelineHandle::Entry& entry);
+      void Rebuild(const std::string& path);
+      // Replaces shaders that have been reloaded by their latest version
+      void ResolveReloaded(VulkanRenderPipeline::CreateInfo& info) const;
+      void AddReloaded(const std::shared_ptr<VulkanShader>& previous,
+                       const std::shared_ptr<VulkanShader>& replacement);
+
+    private:
+      using EntryRef = std::shared_ptr<PipelineHandle::Entry>;
+
+      struct Swap {
+          EntryRef                         entry;
+          VulkanRenderPipeline::CreateInfo info;
+          VulkanRenderPipeline*            pipeline;
+      };
+      struct Retired {
+          VulkanRenderPipeline* pipeline;
+          uint64_t              frame;
+      };
+
+      CreateInfo                                          m_Info;
+      mutable std::mutex                                  m_Mutex;
+      std::unordered_map<uint64_t, std::vector<EntryRef>> m_Entries;
+      // Latest version of every shader hash that has been reloaded
+      std::unordered_map<uint64_t, std::shared_ptr<VulkanShader>> m_Reloaded;
+
+      std::mutex                        m_QueueMutex;
+      std::condition_variable           m_QueueCondition;
+      std::deque<std::function<void()>> m_Queue;
+      std::vector<std::thread>          m_Workers;
+      std::atomic<uint32_t>             m_Pending{0};
+      bool                              m_Stop = false;
+
+      std::mutex           m_SwapMutex;
+      std::vector<Swap>    m_Swaps;
+      std::vector<Retired> m_Retired;
+      uint64_t             m_Frame = 0;
+  };
+}  // namespace Sera
@@ -1,28 +1,76 @@
 #pragma once
 #include <vulkan/vulkan.h>
+#include "Backend/VulkanLayoutCache.h"
+#include "SpecializationConstants.h"
+#include <memory>
+#include <vector>
 namespace Sera {
   class VulkanDevice;
+  class VulkanPipelineCache;
+  class VulkanShader;
   class VulkanRenderPipeline {
     public:
       struct CreateInfo {
-          VulkanDevice*                device;
-          const VkAllocationCallbacks* allocator;
-          VkShaderModule               vertexShader;
-          VkShaderModule               fragmentShader;
-          VkCullModeFlags              cullMode    = VK_CULL_MODE_BACK_BIT;
-          VkFrontFace                  frontFace   = VK_FRONT_FACE_CLOCKWISE;
-          float                        lineWidth   = 1.0F;
-          VkSampleCountFlagBits        sampleCount = VK_SAMPLE_COUNT_1_BIT;
-          VkRenderPass                 renderPass;
+          VulkanDevice*                 device;
+          const VkAllocationCallbacks*  allocator;
+          std::shared_ptr<VulkanShader> vertexShader;
+          std::shared_ptr<VulkanShader> fragmentShader;
+          // Empty derives one tightly packed per-vertex binding 0 from the
+          // vertex shader inputs, in location order
+          std::vector<VkVertexInputBindingDescription>   vertexBindings;
+          std::vector<VkVertexInputAttributeDescription> vertexAttributes;
+          // With derived bindings, inputs from this location on are packed
+          // into a per-instance binding 1 instead
+          uint32_t firstInstanceLocation = UINT32_MAX;
+          // Shared by both stages, each variant is a separate pipeline
+          SpecializationConstants specialization;
+          VkCullModeFlags               cullMode    = VK_CULL_MODE_BACK_BIT;
+          VkFrontFace                   frontFace   = VK_FRONT_FACE_CLOCKWISE;
+          float                         lineWidth   = 1.0F;
+          VkSampleCountFlagBits         sampleCount = VK_SAMPLE_COUNT_1_BIT;
+          // Standard alpha blending on every color attachment
+          bool                          blendEnable    = false;
+          bool                          depthTest      = true;
+          bool                          depthWrite     = true;
+          VkCompareOp                   depthCompareOp = VK_COMPARE_OP_LESS;
+          // Render pass path, used when renderPass is set
+          VkRenderPass renderPass = VK_NULL_HANDLE;
+          // Dynamic rendering path, the pipeline is created against the
+          // attachment formats of the pass instead of a render pass object
+          std::vector<VkFormat> colorFormats;
+          VkFormat              depthFormat   = VK_FORMAT_UNDEFINED;
+          VkFormat              stencilFormat = VK_FORMAT_UNDEFINED;
+          // Optional, pipelines are compiled from scratch without a cache
+          VulkanPipelineCache*  pipelineCache = nullptr;
+          // Shares layouts between pipelines, without one the pipeline keeps
+          // its layouts to itself
+          VulkanLayoutCache*    layoutCache   = nullptr;
+          // Creation flags only, they are not part of the pipeline state
+          VkPipelineCreateFlags flags         = 0;
       };
       static VulkanRenderPipeline* Create(CreateInfo info);
       VkPipeline                   GetHandle() const { return m_Handle; }
+      VkPipelineLayout             GetLayout() const { return m_Layout.layout; }
+      const CreateInfo&            GetInfo() const { return m_Info; }
+      // VK_PIPELINE_COMPILE_REQUIRED when created with
+      // VK_PIPELINE_CREATE_FAIL_ON_PIPELINE_COMPILE_REQUIRED_BIT and the
+      // pipeline was not found in the cache
+      VkResult                     GetResult() const { return m_Result; }
+      // Reflected from the shaders, indexed by set number
+      const std::vector<VkDescriptorSetLayout>& GetSetLayouts() const {
+        return m_Layout.setLayouts;
+      }
+      const VkPushConstantRange& GetPushConstantRange() const {
+        return m_Layout.pushConstants;
+      }
       ~VulkanRenderPipeline();
 
     private:
       VulkanRenderPipeline(CreateInfo info);
-      CreateInfo       m_Info;
-      VkPipeline       m_Handle;
-      VkPipelineLayout m_Layout;
+      CreateInfo                         m_Info;
+      VkPipeline                         m_Handle = VK_NULL_HANDLE;
+      VulkanLayoutCache::Layout          m_Layout;
+      std::unique_ptr<VulkanLayoutCache> m_OwnedLayoutCache;
+      VkResult                           m_Result = VK_NOT_READY;
   };
 }  // namespace Sera
@@ -0,0 +1,35 @@
+#pragma once
+#include <vulkan/vulkan.h>
+#include <cstdint>
+namespace Sera {
+  // Attachment of a dynamic rendering pass (VK_KHR_dynamic_rendering, core in
+  // Vulkan 1.3). The image must already be in `layout` when the pass begins.
+  struct RenderingAttachment {
+      VkImageView         view       = VK_NULL_HANDLE;
+      VkImageLayout       layout     = VK_IMAGE_LAYOUT_COLOR_ATTACHMENT_OPTIMAL;
+      VkAttachmentLoadOp  loadOp     = VK_ATTACHMENT_LOAD_OP_CLEAR;
+      VkAttachmentStoreOp storeOp    = VK_ATTACHMENT_STORE_OP_STORE;
+      VkClearValue        clearValue = {};
+  };
+
+  // Begins a pass without render pass or framebuffer objects. Stencil is
+  // bound to the depth attachment when its format has a stencil aspect.
+  void BeginRendering(VkCommandBuffer commandBuffer, VkExtent2D extent,
+                      const RenderingAttachment* colorAttachments,
+                      uint32_t                   colorAttachmentCount,
+                      const RenderingAttachment* depthAttachment = nullptr,
+                      bool                       hasStencil      = false);
+  void EndRendering(VkCommandBuffer commandBuffer);
+
+  // Whether a depth format also has a stencil aspect
+  bool IsStencilFormat(VkFormat format);
+
+  // Single image layout transition, covering all mips and layers.
+  void TransitionImageLayout(VkCommandBuffer commandBuffer, VkImage image,
+                             VkImageAspectFlags aspectMask,
+                             VkImageLayout oldLayout, VkImageLayout newLayout,
+                             VkPipelineStageFlags srcStage,
+                             VkAccessFlags        srcAccess,
+                             VkPipelineStageFlags dstStage,
+                             VkAccessFlags        dstAccess);
+}  // namespace Sera
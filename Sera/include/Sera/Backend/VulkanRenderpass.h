@@ -7,11 +7,19 @@ namespace Sera {
       struct CreateInfo {
           VulkanDevice*                device;
           VkSurfaceFormatKHR           surfaceFormat;
+          // VK_FORMAT_UNDEFINED builds a color-only render pass
+          VkFormat                     depthFormat = VK_FORMAT_UNDEFINED;
+          // Offscreen targets end in TRANSFER_SRC so they can be read back
+          VkImageLayout                finalLayout =
+              VK_IMAGE_LAYOUT_PRESENT_SRC_KHR;
           const VkAllocationCallbacks* allocator = VK_NULL_HANDLE;
       };
       ~VulkanRenderPass();
       static VulkanRenderPass* Create(CreateInfo info);
       VkRenderPass             GetHandle() const { return m_Handle; }
+      bool                     HasDepth() const {
+        return m_Info.depthFormat != VK_FORMAT_UNDEFINED;
+      }
 
     private:
       VulkanRenderPass(CreateInfo info);
@@ -0,0 +1,53 @@
+#pragma once
+#include <vulkan/vulkan.h>
+#include "Backend/SpirvReflection.h"
+#include <cstdint>
+#include <string>
+#include <vector>
+namespace Sera {
+  class VulkanDevice;
+  // Shader module together with the SPIR-V it was built from. Pipelines keep
+  // their shaders alive, so modules can be used from compile threads.
+  class VulkanShader {
+    public:
+      struct CreateInfo {
+          VulkanDevice*                device;
+          VkShaderStageFlagBits        stage;
+          std::vector<uint32_t>        code;
+          std::string                  entryPoint = "main";
+          // Source file, only used for logging
+          std::string                  path;
+          const VkAllocationCallbacks* allocator = VK_NULL_HANDLE;
+      };
+      ~VulkanShader();
+      static VulkanShader* Create(CreateInfo info);
+      // Reads a .spv file, fails on files that are not SPIR-V
+      static bool ReadSpirv(const std::string&     path,
+                            std::vector<uint32_t>& code);
+
+      VkShaderModule        GetHandle() const { return m_Handle; }
+      VkShaderStageFlagBits GetStage() const { return m_Info.stage; }
+      const std::string&    GetEntryPoint() const { return m_Info.entryPoint; }
+      const std::string&    GetPath() const { return m_Info.path; }
+      // Hash of stage, entry point and code, equal for identical shaders
+      uint64_t              GetHash() const { return m_Hash; }
+
+      const std::vector<uint32_t>& GetCode() const { return m_Info.code; }
+      const CreateInfo&            GetInfo() const { return m_Info; }
+      // Resources used by the entry point, see SpirvReflection
+      const SpirvReflection& GetReflection() const { return m_Reflection; }
+      // Warns about constants set with a different type than the shader
+      // declares. Ids the shader does not declare are fine, pipelines share
+      // one set of constants between their stages.
+      void CheckSpecialization(const SpecializationConstants& constants) const;
+
+    private:
+      VulkanShader(CreateInfo info);
+
+    private:
+      CreateInfo      m_Info;
+      VkShaderModule  m_Handle = VK_NULL_HANDLE;
+      uint64_t        m_Hash   = 0;
+      SpirvReflection m_Reflection;
+  };
+}  // namespace Sera
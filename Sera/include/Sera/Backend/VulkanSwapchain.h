@@ -11,22 +11,31 @@ namespace Sera {
       VkImage         Backbuffer     = VK_NULL_HANDLE;
       VkImageView     BackbufferView = VK_NULL_HANDLE;
       VkFramebuffer   Framebuffer    = VK_NULL_HANDLE;
+      // Only set for offscreen (headless) backbuffers
+      VkDeviceMemory BackbufferMemory = VK_NULL_HANDLE;
   };
   struct FrameSemaphores {
       VkSemaphore ImageAvailableSemaphore = VK_NULL_HANDLE;
       VkSemaphore RenderCompleteSemaphore = VK_NULL_HANDLE;
   };
 
+  // Owns the presentable images of the main window. When created without a
+  // surface it renders into offscreen images instead (headless mode), so the
+  // rest of the frame loop stays the same.
   class VulkanSwapchain {
     public:
-      static VulkanSwapchain* Create(VulkanInstance*        instance,
-                                     VulkanPhysicalDevice*  pDevice,
-                                     VkAllocationCallbacks* allocator,
+      static constexpr uint32_t OffscreenImageCount = 2;
+
+      static VulkanSwapchain* Create(VulkanInstance*              instance,
+                                     VulkanPhysicalDevice*        pDevice,
+                                     const VkAllocationCallbacks* allocator,
                                      VulkanDevice* device, bool isVsync,
                                      VkSurfaceFormatKHR surfaceFormat,
-                                     VkSurfaceKHR       surface) {
+                                     VkSurfaceKHR       surface,
+                                     VkFormat           depthFormat) {
         return new VulkanSwapchain(instance, pDevice, allocator, device,
-                                   isVsync, surfaceFormat, surface);
+                                   isVsync, surfaceFormat, surface,
+                                   depthFormat);
       }
       ~VulkanSwapchain();
       void Resize(int w, int h) {
@@ -40,9 +49,14 @@ namespace Sera {
       }
       VkSwapchainKHR Get() const { return m_Swapchain; }
       void           CreateFramebuffer(VkRenderPass rp);
+      VkResult       AcquireNextImage(VkSemaphore imageAvailable);
       VkResult       Present(VkQueue queue);
+      bool           IsHeadless() const { return m_Surface == VK_NULL_HANDLE; }
       int32_t        GetWidth() const { return m_Width; }
       int32_t        GetHeight() const { return m_Height; }
+      VkFormat       GetDepthFormat() const { return m_DepthFormat; }
+      VkImage        GetDepthImage() const { return m_DepthBuffer.Image; }
+      VkImageView    GetDepthView() const { return m_DepthBuffer.ImageView; }
       //   void CreateCommandBuffers();
 
     public:
@@ -58,28 +72,36 @@ namespace Sera {
 
     private:
       void CreateDepths();
+      void DestroyDepths();
       void ReCreate();
+      void CreateSwapchainImages(VkImage* backbuffers);
+      void CreateOffscreenImages();
       void InitializeFenceSemaphore();
+#ifdef SR_DEBUG
+      void NameObjects();
+#endif
 
     private:
-      VkSwapchainKHR         m_Swapchain = VK_NULL_HANDLE;
-      VkSurfaceKHR           m_Surface   = VK_NULL_HANDLE;
-      VulkanInstance*        m_VkInstance;
-      VulkanPhysicalDevice*  m_PhysicalDevice;
-      VulkanDevice*          m_Device;
-      VkAllocationCallbacks* m_Allocator;
-      VkPresentModeKHR       m_PresentMode;
-      VkRenderPass           m_RenderPass = VK_NULL_HANDLE;
-      bool                   m_Vsync;
-      int                    m_Width, m_Height;
+      VkSwapchainKHR               m_Swapchain = VK_NULL_HANDLE;
+      VkSurfaceKHR                 m_Surface   = VK_NULL_HANDLE;
+      VulkanInstance*              m_VkInstance;
+      VulkanPhysicalDevice*        m_PhysicalDevice;
+      VulkanDevice*                m_Device;
+      const VkAllocationCallbacks* m_Allocator;
+      VkPresentModeKHR             m_PresentMode;
+      VkRenderPass                 m_RenderPass = VK_NULL_HANDLE;
+      bool                         m_Vsync;
+      int                          m_Width, m_Height;
+      VkFormat                     m_DepthFormat = VK_FORMAT_UNDEFINED;
       struct DepthBuffer {
           VkImage        Image     = VK_NULL_HANDLE;
           VkImageView    ImageView = VK_NULL_HANDLE;
           VkDeviceMemory Memory    = VK_NULL_HANDLE;
       } m_DepthBuffer;
       VulkanSwapchain(VulkanInstance* instance, VulkanPhysicalDevice* pDevice,
-                      VkAllocationCallbacks* allocator, VulkanDevice* device,
-                      bool isVsync, VkSurfaceFormatKHR surfaceFormat,
-                      VkSurfaceKHR surface);
+                      const VkAllocationCallbacks* allocator,
+                      VulkanDevice* device, bool isVsync,
+                      VkSurfaceFormatKHR surfaceFormat, VkSurfaceKHR surface,
+                      VkFormat depthFormat);
   };
 }  // namespace Sera
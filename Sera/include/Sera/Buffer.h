@@ -0,0 +1,83 @@
+#pragma once
+
+#include <cstdint>
+
+#include "vulkan/vulkan.h"
+
+namespace Sera {
+
+  enum class BufferUsage : uint32_t {
+    None     = 0,
+    Vertex   = 1 << 0,
+    Index    = 1 << 1,
+    Uniform  = 1 << 2,
+    Storage  = 1 << 3,
+    Indirect = 1 << 4
+  };
+
+  inline BufferUsage operator|(BufferUsage a, BufferUsage b) {
+    return (BufferUsage)((uint32_t)a | (uint32_t)b);
+  }
+  inline bool operator&(BufferUsage a, BufferUsage b) {
+    return ((uint32_t)a & (uint32_t)b) != 0;
+  }
+
+  // Static buffers live in device local memory and are filled through a
+  // staging copy, for data that rarely changes. Dynamic buffers are host
+  // visible and keep one copy per frame in flight, so they can be rewritten
+  // every frame without waiting for the GPU.
+  enum class BufferMemory { Static = 0, Dynamic };
+
+  class Buffer {
+    public:
+      Buffer(uint64_t size, BufferUsage usage,
+             BufferMemory memory = BufferMemory::Static,
+             const void*  data   = nullptr);
+      ~Buffer();
+
+      // Static buffers wait for the copy, the GPU must not be using them.
+      // Dynamic buffers write this frame's copy, call it while recording
+      // OnPreRender or OnRender.
+      void SetData(const void* data, uint64_t size, uint64_t offset = 0);
+      // Dynamic buffers only, this frame's copy for writing in place. The
+      // memory is coherent, writes need no flush.
+      void* GetMappedData();
+      // Contents are lost
+      void Resize(uint64_t size);
+      // Changes whenever the memory is reallocated and every copy loses its
+      // contents, by Resize() or by GetMappedData() after the swapchain got
+      // more images
+      uint64_t GetGeneration() const { return m_Generation; }
+
+      VkBuffer     GetBuffer() const { return m_Buffer; }
+      // Start of this frame's copy, bind the buffer with it
+      VkDeviceSize GetOffset() const;
+      uint64_t     GetSize() const { return m_Size; }
+      BufferUsage  GetUsage() const { return m_Usage; }
+      BufferMemory GetMemory() const { return m_MemoryType; }
+      // For shaders reading through buffer references, GetOffset() is
+      // included. 0 when the device lacks bufferDeviceAddress.
+      VkDeviceAddress GetDeviceAddress() const;
+
+    private:
+      void Allocate(uint32_t copies);
+      void Release();
+
+    private:
+      uint64_t     m_Size       = 0;
+      BufferUsage  m_Usage      = BufferUsage::None;
+      BufferMemory m_MemoryType = BufferMemory::Static;
+
+      VkBuffer       m_Buffer = nullptr;
+      VkDeviceMemory m_Memory = nullptr;
+
+      // Dynamic buffers only, copies are m_Stride bytes apart
+      uint8_t*     m_Mapped = nullptr;
+      uint32_t     m_Copies = 1;
+      VkDeviceSize m_Stride = 0;
+
+      VkDeviceAddress m_DeviceAddress = 0;
+      uint64_t        m_Generation    = 0;
+  };
+
+}  // namespace Sera
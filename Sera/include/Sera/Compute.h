@@ -0,0 +1,91 @@
+#pragma once
+
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "SpecializationConstants.h"
+#include "vulkan/vulkan.h"
+
+namespace Sera {
+
+  class Buffer;
+  class Image;
+  class VulkanComputePipeline;
+
+  // Compute shader with its pipeline. Descriptor set and push constant
+  // layouts are reflected from the SPIR-V.
+  class ComputeShader {
+    public:
+      // SPIR-V embedded by sera_compile_shaders(), `name` is used for logging.
+      // `specialization` sets the shader's constant_id values, one
+      // ComputeShader per variant.
+      ComputeShader(const uint32_t* spirv, size_t wordCount,
+                    std::string_view               name = "",
+                    const SpecializationConstants& specialization = {});
+      // .spv file
+      ComputeShader(std::string_view               path,
+                    const SpecializationConstants& specialization = {});
+      ~ComputeShader();
+
+      bool IsValid() const;
+      // Workgroup size declared by the shader
+      uint32_t GetLocalSizeX() const;
+      uint32_t GetLocalSizeY() const;
+      uint32_t GetLocalSizeZ() const;
+
+      VulkanComputePipeline* GetPipeline() const { return m_Pipeline; }
+
+    private:
+      void Create(std::vector<uint32_t>&& code, const std::string& path,
+                  const SpecializationConstants& specialization);
+
+    private:
+      VulkanComputePipeline* m_Pipeline = nullptr;
+  };
+
+  // Records one dispatch into a command buffer outside of any pass, e.g. in
+  // Layer::OnPreRender(). Bindings refer to set 0 of the shader. Bound images
+  // are moved to VK_IMAGE_LAYOUT_GENERAL for the dispatch and back to
+  // VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL afterwards, so the result can be
+  // drawn through Image::GetDescriptorSet() in the same frame.
+  class ComputeDispatch {
+    public:
+      ComputeDispatch(VkCommandBuffer      commandBuffer,
+                      const ComputeShader& shader);
+
+      // Storage image
+      ComputeDispatch& Bind(uint32_t binding, Image& image);
+      // Storage or uniform buffer, whichever the shader declares
+      ComputeDispatch& Bind(uint32_t binding, VkBuffer buffer,
+                            VkDeviceSize offset = 0,
+                            VkDeviceSize range  = VK_WHOLE_SIZE);
+      ComputeDispatch& Bind(uint32_t binding, const Buffer& buffer);
+      ComputeDispatch& Push(const void* data, uint32_t size);
+      template <typename T>
+      ComputeDispatch& Push(const T& data) {
+        return Push(&data, sizeof(T));
+      }
+
+      void Dispatch(uint32_t groupsX, uint32_t groupsY = 1,
+                    uint32_t groupsZ = 1);
+      // One invocation per pixel of `target`, rounded up to whole workgroups
+      void Dispatch(const Image& target);
+
+    private:
+      struct BufferBinding {
+          uint32_t     binding;
+          VkBuffer     buffer;
+          VkDeviceSize offset;
+          VkDeviceSize range;
+      };
+
+      VkCommandBuffer                          m_CommandBuffer;
+      const ComputeShader&                     m_Shader;
+      std::vector<std::pair<uint32_t, Image*>> m_Images;
+      std::vector<BufferBinding>               m_Buffers;
+      std::vector<uint8_t>                     m_PushConstants;
+  };
+
+}  // namespace Sera
@@ -0,0 +1,79 @@
+#pragma once
+
+#include <cstdint>
+#include <vector>
+
+#include "vulkan/vulkan.h"
+
+namespace Sera {
+
+  class Buffer;
+  class VulkanRenderPipeline;
+
+  // Records draws into the main pass from Layer::OnRender(). The pipeline
+  // comes from Application::GetPipelineRegistry() and is created against the
+  // main pass attachments, a null pipeline (still compiling) skips the draws.
+  // Per-instance data goes into a vertex binding with
+  // VK_VERTEX_INPUT_RATE_INSTANCE, see
+  // VulkanRenderPipeline::CreateInfo::firstInstanceLocation, so thousands of
+  // objects take a single draw. Buffer bindings refer to set 0.
+  class DrawCall {
+    public:
+      DrawCall(VkCommandBuffer commandBuffer, VulkanRenderPipeline* pipeline);
+
+      DrawCall& BindVertexBuffer(uint32_t binding, const Buffer& buffer);
+      DrawCall& BindIndexBuffer(const Buffer& buffer,
+                                VkIndexType type = VK_INDEX_TYPE_UINT32);
+      // Storage or uniform buffer, whichever the shaders declare
+      DrawCall& Bind(uint32_t binding, const Buffer& buffer);
+      DrawCall& Push(const void* data, uint32_t size);
+      template <typename T>
+      DrawCall& Push(const T& data) {
+        return Push(&data, sizeof(T));
+      }
+      // Defaults to the whole framebuffer
+      DrawCall& SetViewport(float x, float y, float width, float height);
+
+      void Draw(uint32_t vertexCount, uint32_t instanceCount = 1,
+                uint32_t firstVertex = 0, uint32_t firstInstance = 0);
+      void DrawIndexed(uint32_t indexCount, uint32_t instanceCount = 1,
+                       uint32_t firstIndex = 0, int32_t vertexOffset = 0,
+                       uint32_t firstInstance = 0);
+      // VkDrawIndexedIndirectCommands written by the GPU, see IndirectDrawList.
+      // Issued one command at a time without
+      // VulkanDevice::Features::multiDrawIndirect.
+      void DrawIndexedIndirect(const Buffer& commands, uint32_t drawCount);
+      // Reads the number of draws from a uint32_t in `count`. Needs
+      // VulkanDevice::Features::drawIndirectCount, draws nothing without.
+      void DrawIndexedIndirectCount(const Buffer& commands, const Buffer& count,
+                                    uint32_t maxDrawCount);
+
+    private:
+      // Binds everything set so far, false when there is nothing to draw with
+      bool Record();
+
+    private:
+      struct VertexBinding {
+          uint32_t     binding;
+          VkBuffer     buffer;
+          VkDeviceSize offset;
+      };
+      struct BufferBinding {
+          uint32_t     binding;
+          VkBuffer     buffer;
+          VkDeviceSize offset;
+          VkDeviceSize range;
+      };
+
+      VkCommandBuffer            m_CommandBuffer;
+      VulkanRenderPipeline*      m_Pipeline;
+      std::vector<VertexBinding> m_VertexBuffers;
+      VkBuffer                   m_IndexBuffer = VK_NULL_HANDLE;
+      VkDeviceSize               m_IndexOffset = 0;
+      VkIndexType                m_IndexType   = VK_INDEX_TYPE_UINT32;
+      std::vector<BufferBinding> m_Buffers;
+      std::vector<uint8_t>       m_PushConstants;
+      VkViewport                 m_Viewport{};
+  };
+
+}  // namespace Sera
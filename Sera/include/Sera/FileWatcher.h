@@ -0,0 +1,37 @@
+#pragma once
+
+#include "Timer.h"
+
+#include <filesystem>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+namespace Sera {
+
+  // Reports files written in a directory (not recursive). Uses inotify on
+  // Linux, other platforms compare modification times a few times a second.
+  class FileWatcher {
+    public:
+      FileWatcher(const std::string &directory);
+      ~FileWatcher();
+
+      // Paths of files changed since the last call, never blocks
+      std::vector<std::string> Poll();
+
+      bool               IsWatching() const { return m_Watching; }
+      const std::string &GetDirectory() const { return m_Directory; }
+
+    private:
+      std::string m_Directory;
+      bool        m_Watching = false;
+#ifdef __linux__
+      int m_Fd    = -1;
+      int m_Watch = -1;
+#else
+      std::unordered_map<std::string, std::filesystem::file_time_type> m_Files;
+      Timer m_PollTimer;
+#endif
+  };
+
+}  // namespace Sera
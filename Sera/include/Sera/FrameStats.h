@@ -0,0 +1,70 @@
+#pragma once
+
+#include <cstdint>
+#include <string>
+
+namespace Sera {
+
+  // Timings and counters of the last frames, kept in a fixed ring buffer so
+  // recording a frame never allocates. Application records a sample per
+  // frame and draws ShowOverlay() while Application::IsFrameStatsVisible().
+  // Draws and uploads are counted by the engine code recording them.
+  class FrameStats {
+    public:
+      struct Sample {
+          uint64_t frame;
+          // Milliseconds between the ends of two frames
+          float    frameTime;
+          // Milliseconds the main thread worked on the frame, without the
+          // time it waited for the GPU or presentation
+          float    cpuTime;
+          // Milliseconds of the last frame the GpuProfiler read back, which
+          // lags behind by the frames in flight
+          float    gpuTime;
+          uint32_t drawCalls;
+          uint32_t uploads;
+          uint64_t uploadBytes;
+          // Resident memory of the process, 0 where it is unknown
+          uint64_t memory;
+          // Heap allocations on all threads, 0 unless built with
+          // SR_TRACK_ALLOCATIONS, see AllocationTracker
+          uint32_t allocations;
+          uint64_t allocatedBytes;
+      };
+
+      // Milliseconds over a window of frames
+      struct Summary {
+          float min     = 0.0f;
+          float average = 0.0f;
+          float max     = 0.0f;
+          float p50     = 0.0f;
+          float p95     = 0.0f;
+          float p99     = 0.0f;
+      };
+
+      static constexpr uint32_t HistorySize = 1024;
+
+      // Counted into the frame being recorded, from any thread
+      static void AddDrawCalls(uint32_t count = 1);
+      static void AddUpload(uint64_t bytes);
+
+      // Ends the frame's sample and restarts the counters, Application calls
+      // it once per frame
+      static void Record(float frameTime, float cpuTime, float gpuTime);
+
+      // Oldest first, `index` is below GetSampleCount()
+      static uint32_t      GetSampleCount();
+      static const Sample& GetSample(uint32_t index);
+      // Of the last `window` samples, e.g. Summarize(&Sample::cpuTime, 120).
+      // Main thread only.
+      static Summary       Summarize(float Sample::*time, uint32_t window);
+
+      // One line per sample in the history, for comparing runs offline
+      static bool ExportCsv(const std::string& path);
+
+      // Frame time graph and the summaries of the last frames, in the
+      // corner of the main viewport
+      static void ShowOverlay(bool* open = nullptr);
+  };
+
+}  // namespace Sera
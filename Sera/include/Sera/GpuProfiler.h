@@ -0,0 +1,156 @@
+#pragma once
+
+#include <cstdint>
+#include <vector>
+
+#include "vulkan/vulkan.h"
+
+#include "Profiler.h"
+
+namespace Sera {
+
+  // GPU time of the passes of a frame, measured with timestamp queries, and
+  // the pipeline statistics of the whole frame. Every frame in flight has its
+  // own queries, which are read back when the frame's slot comes around
+  // again and its fence has signalled, so reading never stalls. Results
+  // arrive Application::GetFramesInFlight() frames late.
+  //
+  // With SR_PROFILE the scopes are added to the Profiler as a "GPU" track,
+  // next to the CPU zones in its panel and trace export. Their durations are
+  // exact, where they start on the CPU timeline is estimated from when the
+  // frame was submitted.
+  class GpuProfiler {
+    public:
+      struct Scope {
+          const char* name;
+          const void* key;
+          uint32_t    depth;
+          // Milliseconds since the start of the frame
+          float       start;
+          float       time;
+      };
+
+      // Counts of every draw and dispatch in the frame, in the order
+      // Vulkan writes them
+      struct PipelineStatistics {
+          uint64_t inputVertices;
+          uint64_t inputPrimitives;
+          uint64_t vertexInvocations;
+          uint64_t clippingInvocations;
+          uint64_t clippingPrimitives;
+          uint64_t fragmentInvocations;
+          uint64_t computeInvocations;
+      };
+
+      struct Frame {
+          uint64_t           index = 0;
+          float              time  = 0.0f;
+          std::vector<Scope> scopes;
+          bool               hasStatistics = false;
+          PipelineStatistics statistics{};
+      };
+
+      GpuProfiler();
+      ~GpuProfiler();
+
+      // False when the queue has no timestamps, scopes then measure nothing
+      bool IsEnabled() const { return m_TimestampMask != 0; }
+
+      // Called by Application around the frame's command buffer. BeginFrame()
+      // reads back the results of the frame that used the slot before.
+      void BeginFrame(VkCommandBuffer commandBuffer, uint32_t frameInFlight,
+                      uint32_t framesInFlight);
+      void EndFrame(VkCommandBuffer commandBuffer);
+
+      // Scopes nest and may span passes, but only the frame's command
+      // buffer is timed, scopes in other command buffers are ignored. `key`
+      // finds the scope's result again with GetScopeTime(). Returns the
+      // index EndScope() takes. In SR_DEBUG builds every scope is also a
+      // debug label, so GPU captures show the same passes.
+      uint32_t BeginScope(VkCommandBuffer commandBuffer, const char* name,
+                          const void* key = nullptr);
+      void     EndScope(VkCommandBuffer commandBuffer, uint32_t scope);
+
+      // Results of the most recently read back frame
+      const Frame& GetLastFrame() const { return m_LastFrame; }
+      // Milliseconds of the scope begun with `key` in the results the
+      // current frame's BeginFrame() read back, negative when there were
+      // none or the scope was not recorded
+      float        GetScopeTime(const void* key) const;
+
+      // Draws the scopes and statistics of the last frame, call from
+      // Layer::OnUIRender()
+      void ShowPanel(bool* open = nullptr);
+
+    private:
+      struct ScopeRecord {
+          const char* name;
+          const void* key;
+          uint32_t    depth;
+      };
+
+      // Queries recorded into one frame in flight
+      struct FrameQueries {
+          std::vector<ScopeRecord> scopes;
+          uint64_t                 index      = 0;
+          uint64_t                 submitTime = 0;
+          bool                     pending    = false;
+      };
+
+      void CreateQueryPools(uint32_t framesInFlight);
+      void ReadResults(uint32_t slot);
+      void WriteTimestamp(VkCommandBuffer commandBuffer, uint32_t query,
+                          bool end);
+
+    private:
+      VkQueryPool               m_TimestampPool  = VK_NULL_HANDLE;
+      VkQueryPool               m_StatisticsPool = VK_NULL_HANDLE;
+      std::vector<FrameQueries> m_Frames;
+      FrameQueries*             m_Current        = nullptr;
+      uint32_t                  m_CurrentSlot    = 0;
+      // Scopes begun and not yet ended in the current frame
+      std::vector<uint32_t>     m_OpenScopes;
+      uint64_t                  m_FrameIndex     = 0;
+
+      float    m_TimestampPeriod  = 0.0f;  // Nanoseconds per tick
+      uint64_t m_TimestampMask    = 0;
+      bool     m_Synchronization2 = false;
+
+      Frame m_LastFrame;
+      bool  m_ResultsFresh = false;
+
+      // Profiler track and where its last frame ended, in Profiler::Now()
+      // nanoseconds
+      uint32_t m_Track   = 0;
+      uint64_t m_LastEnd = 0;
+  };
+
+  class GpuScope {
+    public:
+      GpuScope(GpuProfiler& profiler, VkCommandBuffer commandBuffer,
+               const char* name, const void* key = nullptr)
+          : m_Profiler(profiler),
+            m_CommandBuffer(commandBuffer),
+            m_Scope(profiler.BeginScope(commandBuffer, name, key)) {}
+      ~GpuScope() { m_Profiler.EndScope(m_CommandBuffer, m_Scope); }
+
+      GpuScope(const GpuScope&)            = delete;
+      GpuScope& operator=(const GpuScope&) = delete;
+
+    private:
+      GpuProfiler&    m_Profiler;
+      VkCommandBuffer m_CommandBuffer;
+      uint32_t        m_Scope;
+  };
+
+}  // namespace Sera
+
+// Times the commands recorded into `commandBuffer` until the end of the
+// scope, needs Application.h
+#ifdef SR_PROFILE
+#define SR_GPU_SCOPE(commandBuffer, name)                   \
+  ::Sera::GpuScope SR_PROFILE_CONCAT(srGpuScope, __LINE__)( \
+      ::Sera::Application::GetGpuProfiler(), commandBuffer, name)
+#else
+#define SR_GPU_SCOPE(commandBuffer, name)
+#endif
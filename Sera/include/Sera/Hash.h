@@ -0,0 +1,28 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+
+namespace Sera {
+
+  // 64-bit FNV-1a. Stable across runs and platforms, so hashes may be stored
+  // in files.
+  inline uint64_t HashBytes(const void* data, size_t size,
+                            uint64_t seed = 14695981039346656037ull) {
+    const uint8_t* bytes = static_cast<const uint8_t*>(data);
+    uint64_t       hash  = seed;
+    for (size_t i = 0; i < size; i++) {
+      hash ^= bytes[i];
+      hash *= 1099511628211ull;
+    }
+    return hash;
+  }
+
+  // Folds a scalar into the hash. Structs are hashed member by member, their
+  // padding bytes are not guaranteed to be zero.
+  template <typename T>
+  inline void HashCombine(uint64_t& hash, const T& value) {
+    hash = HashBytes(&value, sizeof(T), hash);
+  }
+
+}  // namespace Sera
@@ -1,6 +1,7 @@
 #pragma once
 
 #include <string>
+#include <vector>
 
 #include "vulkan/vulkan.h"
 
@@ -15,17 +16,58 @@ namespace Sera {
             const void* data = nullptr);
       ~Image();
 
+      // Uploads the whole image and waits for the copy
       void SetData(const void* data);
+      // Uploads only `regions` of `data`, which holds the whole image. The
+      // rest of the image keeps its contents. Regions are clipped to the
+      // image.
+      void SetData(const void* data, const VkRect2D* regions,
+                   uint32_t regionCount);
+
+      // Staging memory laid out like the image, for writing pixels in place
+      // instead of through an intermediate buffer. UnmapStaging() uploads
+      // `regions`, or the whole image when there are none. The staging
+      // memory is a different one every frame and starts out with stale
+      // pixels, so every uploaded pixel must be written. Map and unmap
+      // within one frame.
+      //
+      // The upload does not wait, its copy is recorded at the start of the
+      // next frame's command buffer.
+      void* MapStaging();
+      void  UnmapStaging(const VkRect2D* regions = nullptr,
+                         uint32_t regionCount = 0);
+
+      // Records the copies queued by UnmapStaging() since the last call.
+      // Application calls it once per frame, first thing in the frame's
+      // command buffer.
+      static void RecordUploads(VkCommandBuffer commandBuffer);
 
       VkDescriptorSet GetDescriptorSet() const { return m_DescriptorSet; }
+      VkImage         GetImage() const { return m_Image; }
+      VkImageView     GetImageView() const { return m_ImageView; }
+      VkImageLayout   GetLayout() const { return m_Layout; }
+
+      // Records a barrier moving the image into `layout` for a use at
+      // `stage`. The previous use is tracked, so the barrier only waits for
+      // the work that last touched the image. The descriptor set expects
+      // VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL.
+      void TransitionLayout(VkCommandBuffer commandBuffer, VkImageLayout layout,
+                            VkPipelineStageFlags stage, VkAccessFlags access);
 
       void Resize(uint32_t width, uint32_t height);
 
       uint32_t GetWidth() const { return m_Width; }
       uint32_t GetHeight() const { return m_Height; }
 
+      ImageFormat GetFormat() const { return m_Format; }
+      uint32_t    GetBytesPerPixel() const;
+
     private:
       void AllocateMemory(uint64_t size);
+      void AllocateStagingBuffer(uint64_t size);
+      void ReleaseStagingBuffer();
+      void RecordPendingCopies(VkCommandBuffer commandBuffer);
+      void DropPendingCopies();
       void Release();
 
     private:
@@ -41,10 +83,22 @@ namespace Sera {
       VkBuffer       m_StagingBuffer       = nullptr;
       VkDeviceMemory m_StagingBufferMemory = nullptr;
 
-      size_t m_AlignedSize = 0;
+      // One slice per frame in flight and one for the frame being prepared,
+      // so a slice is only written once the GPU is done reading it
+      uint64_t m_StagingSliceSize = 0;
+      uint32_t m_StagingSlices    = 0;
+      uint32_t m_MappedSlice      = 0;
+
+      // Copies out of the staging memory waiting for the next frame
+      std::vector<VkBufferImageCopy> m_PendingCopies;
+      uint64_t                       m_PendingBytes = 0;
 
       VkDescriptorSet m_DescriptorSet = nullptr;
 
+      VkImageLayout        m_Layout     = VK_IMAGE_LAYOUT_UNDEFINED;
+      VkPipelineStageFlags m_LastStage  = VK_PIPELINE_STAGE_TOP_OF_PIPE_BIT;
+      VkAccessFlags        m_LastAccess = 0;
+
       std::string m_Filepath;
   };
 
@@ -0,0 +1,95 @@
+#pragma once
+
+#include <cstdint>
+#include <memory>
+#include <vector>
+
+#include <glm/glm.hpp>
+
+#include "vulkan/vulkan.h"
+
+namespace Sera {
+
+  class Buffer;
+  class ComputeShader;
+  class DrawCall;
+
+  // GPU-driven drawing of many objects sharing one pipeline and index buffer.
+  // A compute pass frustum culls the objects' bounding spheres and writes a
+  // VkDrawIndexedIndirectCommand for every visible one, which a single
+  // indirect draw then consumes. The draws are compacted and counted on the
+  // GPU when the device has drawIndirectCount, otherwise culled objects keep
+  // their command with an instance count of 0.
+  //
+  // Without drawIndirectFirstInstance every command's firstInstance is 0 and
+  // the vertex shader finds its object through GetDrawObjectBuffer() indexed
+  // by gl_DrawID, which needs shaderDrawParameters and more than one draw
+  // per command buffer call (multiDrawIndirect or drawIndirectCount).
+  class IndirectDrawList {
+    public:
+      // Matches the Object struct of cull.comp
+      struct Object {
+          glm::vec3 center;
+          float     radius;
+          uint32_t  indexCount;
+          uint32_t  firstIndex;
+          int32_t   vertexOffset;
+          // Becomes firstInstance, i.e. gl_InstanceIndex in the vertex
+          // shader, to look up per-object data. See UsesFirstInstance().
+          uint32_t  instanceIndex;
+      };
+
+      // Visible is counted on the GPU and read back once the frame slot
+      // comes around again, so it lags a few frames behind
+      struct Statistics {
+          uint32_t submitted = 0;
+          uint32_t visible   = 0;
+      };
+
+      IndirectDrawList();
+      ~IndirectDrawList();
+
+      // Uploaded into each frame's copy the next time it is culled
+      void SetObjects(const std::vector<Object>& objects);
+
+      // Records the culling dispatch, call from Layer::OnPreRender()
+      void Cull(VkCommandBuffer commandBuffer, const glm::mat4& viewProjection);
+      // Records the indirect draw with the pipeline and index buffer bound to
+      // `drawCall`, call from Layer::OnRender()
+      void Draw(DrawCall& drawCall);
+
+      uint32_t          GetObjectCount() const { return m_ObjectCount; }
+      const Statistics& GetStats() const { return m_Stats; }
+
+      // False when the device can not draw with a firstInstance, the vertex
+      // shader then reads Object::instanceIndex from GetDrawObjectBuffer()
+      bool          UsesFirstInstance() const { return m_FirstInstance; }
+      // The instanceIndex of every draw, a uint per command. Null until
+      // objects are set.
+      const Buffer* GetDrawObjectBuffer() const {
+        return m_DrawObjectBuffer.get();
+      }
+      // False when the device supports neither way, Draw() then draws
+      // nothing
+      bool          IsSupported() const { return m_Supported; }
+
+    private:
+      std::vector<Object>            m_Objects;
+      uint32_t                       m_ObjectCount = 0;
+      uint64_t                       m_Version     = 0;
+      // Version of m_Objects in each frame's copy of the object buffer,
+      // valid for the object buffer's generation they were uploaded to
+      std::vector<uint64_t>          m_UploadedVersions;
+      uint64_t                       m_UploadedGeneration = 0;
+      std::unique_ptr<Buffer>        m_ObjectBuffer;
+      std::unique_ptr<Buffer>        m_DrawBuffer;
+      std::unique_ptr<Buffer>        m_DrawObjectBuffer;
+      std::unique_ptr<Buffer>        m_CountBuffer;
+      std::unique_ptr<ComputeShader> m_CullShader;
+      bool                           m_Compact       = false;
+      bool                           m_FirstInstance = true;
+      bool                           m_Supported     = true;
+      Statistics                     m_Stats;
+  };
+
+}  // namespace Sera
@@ -0,0 +1,121 @@
+#pragma once
+
+#include <atomic>
+#include <condition_variable>
+#include <cstdint>
+#include <deque>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+namespace Sera {
+
+  using Job = std::function<void()>;
+
+  // Number of unfinished jobs. Jobs can wait for a counter to reach zero,
+  // either by JobSystem::Wait() or by being scheduled as its continuation.
+  // Reuse a counter only once it has reached zero.
+  class JobCounter {
+    public:
+      JobCounter() = default;
+      JobCounter(const JobCounter&)            = delete;
+      JobCounter& operator=(const JobCounter&) = delete;
+
+      bool     IsDone() const;
+      uint32_t GetValue() const { return m_Value.load(); }
+
+    private:
+      friend class JobSystem;
+
+      struct Continuation {
+          Job         job;
+          JobCounter* counter;
+          bool        mainThread;
+      };
+
+      std::atomic<uint32_t>     m_Value{0};
+      mutable std::mutex        m_Mutex;
+      std::vector<Continuation> m_Continuations;
+  };
+
+  // Worker pool with one deque per thread. Workers push and pop their own
+  // jobs at the back and steal from the front of the others' deques when
+  // they run dry. Threads waiting on a counter run jobs meanwhile instead
+  // of blocking, so jobs may wait on the jobs they spawned.
+  class JobSystem {
+    public:
+      // 0 starts one worker per core besides the calling thread, which
+      // becomes the main thread
+      JobSystem(uint32_t workerCount = 0);
+      ~JobSystem();
+
+      // `counter`, when given, stays above zero until the job has finished
+      void Run(Job job, JobCounter* counter = nullptr);
+      // Starts once `dependency` reaches zero
+      void Run(Job job, JobCounter& dependency, JobCounter* counter = nullptr);
+      // Queued for ExecuteMainThreadJobs(), for work touching ImGui, Vulkan
+      // objects owned by layers or anything else that is not thread safe
+      void RunOnMainThread(Job job);
+      void RunOnMainThread(Job job, JobCounter& dependency);
+
+      // Calls function(begin, end) for batches of [0, count) on all threads
+      // and returns when every batch has finished. 0 picks a batch size
+      // giving each thread a few batches to balance uneven work.
+      void ParallelForRange(
+          uint32_t count, uint32_t batchSize,
+          const std::function<void(uint32_t begin, uint32_t end)>& function);
+      template <typename F>
+      void ParallelFor(uint32_t count, F&& function, uint32_t batchSize = 0) {
+        ParallelForRange(count, batchSize, [&function](uint32_t begin,
+                                                       uint32_t end) {
+          for (uint32_t i = begin; i < end; i++) function(i);
+        });
+      }
+
+      // Runs other jobs until `counter` reaches zero
+      void Wait(const JobCounter& counter);
+
+      // Runs the queued main thread jobs, Application calls it once per
+      // frame before Layer::OnUpdate()
+      void ExecuteMainThreadJobs();
+
+      uint32_t GetWorkerCount() const { return (uint32_t)m_Workers.size(); }
+      // Workers plus the main thread
+      uint32_t GetThreadCount() const { return GetWorkerCount() + 1; }
+
+    private:
+      struct Entry {
+          Job         job;
+          JobCounter* counter;
+      };
+      struct Queue {
+          std::mutex        mutex;
+          std::deque<Entry> entries;
+      };
+
+      void Push(Entry&& entry);
+      bool Pop(Entry& entry);
+      void Execute(Entry& entry);
+      void Finish(JobCounter* counter);
+      void WorkerLoop(uint32_t index);
+
+    private:
+      // Index 0 belongs to the main thread
+      std::vector<std::unique_ptr<Queue>> m_Queues;
+      std::vector<std::thread>            m_Workers;
+      std::atomic<uint32_t>               m_NextQueue{0};
+
+      // Idle workers sleep until something is queued
+      std::atomic<uint32_t>   m_Queued{0};
+      std::atomic<uint32_t>   m_Sleeping{0};
+      std::mutex              m_SleepMutex;
+      std::condition_variable m_SleepCondition;
+      bool                    m_Stop = false;
+
+      std::mutex       m_MainThreadMutex;
+      std::vector<Job> m_MainThreadJobs;
+  };
+
+}  // namespace Sera
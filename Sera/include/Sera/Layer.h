@@ -1,5 +1,7 @@
 #pragma once
 
+#include <vulkan/vulkan.h>
+
 namespace Sera {
 
   class Layer {
@@ -11,6 +13,12 @@ namespace Sera {
 
       virtual void OnUpdate(float ts) {}
       virtual void OnUIRender() {}
+
+      // Records the layer's own passes (offscreen targets, compute) into the
+      // frame command buffer, before the main pass begins.
+      virtual void OnPreRender(VkCommandBuffer commandBuffer) {}
+      // Records draws into the main pass, underneath ImGui.
+      virtual void OnRender(VkCommandBuffer commandBuffer) {}
   };
 
 }  // namespace Sera
@@ -0,0 +1,84 @@
+#pragma once
+
+#include <cstdint>
+#include <functional>
+
+#include "vulkan/vulkan.h"
+
+namespace Sera {
+
+  struct VulkanPhysicalDevice;
+
+  // Where Sera's Vulkan memory goes. Host allocations the driver makes for
+  // Sera's objects are counted through VkAllocationCallbacks, by object
+  // type and allocation scope, when tracking was enabled before the device
+  // was created (ApplicationSpecification::TrackMemory). Device memory is
+  // always kept in a ledger by owner and heap, and compared each frame with
+  // the heap budgets of VK_EXT_memory_budget where the device has it.
+  class MemoryTracker {
+    public:
+      // Host memory of one object type, or of all of them
+      struct HostUsage {
+          uint64_t bytes       = 0;
+          uint64_t peak        = 0;
+          uint64_t allocations = 0;
+
+          // Indexed by VkSystemAllocationScope
+          uint64_t scopeBytes[VK_SYSTEM_ALLOCATION_SCOPE_INSTANCE + 1] = {};
+          // Memory the driver allocated itself and reported
+          uint64_t internalBytes = 0;
+      };
+
+      struct HeapUsage {
+          VkDeviceSize      size  = 0;
+          VkMemoryHeapFlags flags = 0;
+          // Allocated through the ledger
+          VkDeviceSize      tracked = 0;
+          // Used by the whole process and what the driver estimates it can
+          // use without degrading. Without VK_EXT_memory_budget usage is the
+          // tracked memory and the budget is the heap size.
+          VkDeviceSize      usage  = 0;
+          VkDeviceSize      budget = 0;
+      };
+
+      using BudgetCallback =
+          std::function<void(uint32_t heap, const HeapUsage& usage)>;
+
+      // Must be called before the device is created, objects created
+      // without callbacks can not be freed with them
+      static void SetEnabled(bool enabled);
+      static bool IsEnabled();
+
+      // Callbacks that count into the object type's usage, nullptr when
+      // tracking is disabled. Pass the same ones to the matching destroy.
+      static const VkAllocationCallbacks* GetAllocationCallbacks(
+          VkObjectType type = VK_OBJECT_TYPE_UNKNOWN);
+      static HostUsage GetHostUsage(VkObjectType type);
+      static HostUsage GetTotalHostUsage();
+
+      // Application calls it once the device exists
+      static void Init(const VulkanPhysicalDevice* physicalDevice,
+                       bool                        memoryBudget);
+
+      // Ledger of vkAllocateMemory() and vkFreeMemory(), from any thread.
+      // `owner` must outlive the allocation, e.g. a string literal.
+      static void TrackDeviceMemory(VkDeviceMemory memory, VkDeviceSize size,
+                                    uint32_t memoryType, const char* owner);
+      static void UntrackDeviceMemory(VkDeviceMemory memory);
+
+      // Polls the budgets, Application calls it once per frame. Warns and
+      // calls the callback when a heap's usage crosses `threshold` of its
+      // budget, again only after it fell back below.
+      static void UpdateBudget();
+      static void SetBudgetThreshold(float threshold);
+      static void SetBudgetCallback(const BudgetCallback& callback);
+
+      static uint32_t         GetHeapCount();
+      static const HeapUsage& GetHeapUsage(uint32_t heap);
+
+      // Draws the heaps, the ledger by owner and the host usage, call from
+      // Layer::OnUIRender()
+      static void ShowPanel(bool* open = nullptr);
+  };
+
+}  // namespace Sera
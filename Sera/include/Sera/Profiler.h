@@ -0,0 +1,112 @@
+#pragma once
+
+#include <cstdint>
+#include <string>
+#include <vector>
+
+namespace Sera {
+
+  // Instrumentation profiler. Zones are timed by scope and recorded into a
+  // ring buffer owned by the recording thread, so recording takes no lock
+  // and threads never contend. Application collects the rings once per
+  // frame into a history of recent frames, which ShowPanel() draws as a
+  // timeline and a call tree and ExportChromeTrace() writes for Perfetto or
+  // chrome://tracing.
+  //
+  // Zone names are stored as pointers and must outlive the profiler, e.g.
+  // string literals. Building without SR_PROFILE compiles the zone macros
+  // out entirely.
+  class Profiler {
+    public:
+      struct Zone {
+          const char* name;
+          // Nanoseconds since the profiler started
+          uint64_t    start;
+          uint64_t    end;
+          // Zones open on the thread when this one started
+          uint32_t    depth;
+          uint32_t    thread;
+          // Heap allocations on the thread while the zone was open, nested
+          // zones included. Zero unless built with SR_TRACK_ALLOCATIONS.
+          uint32_t    allocations;
+          uint64_t    allocatedBytes;
+      };
+
+      struct Frame {
+          uint64_t          start;
+          uint64_t          end;
+          std::vector<Zone> zones;
+      };
+
+      struct Thread {
+          uint32_t    id;
+          std::string name;
+      };
+
+      static uint64_t Now();
+
+      // Used by ProfileScope
+      static uint32_t BeginZone(const char* name);
+      static void     EndZone(const char* name, uint64_t start, uint32_t depth);
+
+      // Names the calling thread in the panel and the exported trace
+      static void SetThreadName(const char* name);
+
+      // Timeline of zones measured elsewhere, e.g. on the GPU, shown like a
+      // thread. Zones of a track are added from one thread only and may
+      // belong to frames that were already collected, they are filed under
+      // the frame they ended in.
+      static uint32_t AddTrack(const char* name);
+      static void     AddZone(uint32_t track, const char* name, uint64_t start,
+                              uint64_t end, uint32_t depth);
+
+      // Ends the current frame and collects the zones recorded since the
+      // last call, Application calls it once per frame. Nothing is
+      // collected while paused, so the history can be inspected.
+      static void MarkFrame();
+      static void SetPaused(bool paused);
+      static bool IsPaused();
+
+      // Oldest frame first
+      static const std::vector<Frame>& GetFrames();
+      static std::vector<Thread>       GetThreads();
+
+      // Writes the frames in the history as Chrome trace event JSON
+      static bool ExportChromeTrace(const std::string& path);
+
+      // Draws the profiler window, call from Layer::OnUIRender()
+      static void ShowPanel(bool* open = nullptr);
+  };
+
+  class ProfileScope {
+    public:
+      ProfileScope(const char* name)
+          : m_Name(name),
+            m_Depth(Profiler::BeginZone(name)),
+            m_Start(Profiler::Now()) {}
+      ~ProfileScope() { Profiler::EndZone(m_Name, m_Start, m_Depth); }
+
+      ProfileScope(const ProfileScope&)            = delete;
+      ProfileScope& operator=(const ProfileScope&) = delete;
+
+    private:
+      const char* m_Name;
+      uint32_t    m_Depth;
+      uint64_t    m_Start;
+  };
+
+}  // namespace Sera
+
+#define SR_PROFILE_CONCAT_IMPL(a, b) a##b
+#define SR_PROFILE_CONCAT(a, b)      SR_PROFILE_CONCAT_IMPL(a, b)
+
+#ifdef SR_PROFILE
+#define SR_PROFILE_SCOPE(name) \
+  ::Sera::ProfileScope SR_PROFILE_CONCAT(srProfileScope, __LINE__)(name)
+#define SR_PROFILE_FUNCTION()   SR_PROFILE_SCOPE(__func__)
+#define SR_PROFILE_THREAD(name) ::Sera::Profiler::SetThreadName(name)
+#else
+#define SR_PROFILE_SCOPE(name)
+#define SR_PROFILE_FUNCTION()
+#define SR_PROFILE_THREAD(name)
+#endif
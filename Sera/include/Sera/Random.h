@@ -1,25 +1,79 @@
 #pragma once
 
-#include <random>
+#include <cstddef>
+#include <cstdint>
 
 #include <glm/glm.hpp>
 
 namespace Sera {
 
+  // PCG-XSH-RR, 32-bit output from 64-bit state. Small, fast and with good
+  // statistical quality. Generators with different sequences are
+  // independent streams even for the same seed.
+  class PCG32 {
+    public:
+      PCG32(uint64_t seed = 0x853c49e6748fea9bull, uint64_t sequence = 0) {
+        Seed(seed, sequence);
+      }
+
+      void Seed(uint64_t seed, uint64_t sequence = 0) {
+        m_State     = 0;
+        m_Increment = (sequence << 1) | 1;
+        Next();
+        m_State += seed;
+        Next();
+      }
+
+      uint32_t Next() {
+        uint64_t state = m_State;
+        m_State        = state * 6364136223846793005ull + m_Increment;
+
+        uint32_t xorShifted = (uint32_t)(((state >> 18) ^ state) >> 27);
+        uint32_t rotation   = (uint32_t)(state >> 59);
+        return (xorShifted >> rotation) |
+               (xorShifted << ((32 - rotation) & 31));
+      }
+
+      // Unbiased in [0, bound), Lemire's multiply and reject
+      uint32_t Next(uint32_t bound) {
+        uint64_t m = (uint64_t)Next() * bound;
+        if ((uint32_t)m < bound) {
+          uint32_t threshold = (0u - bound) % bound;
+          while ((uint32_t)m < threshold) m = (uint64_t)Next() * bound;
+        }
+        return (uint32_t)(m >> 32);
+      }
+
+      // In [0, 1), the top 24 bits fill the mantissa exactly
+      float NextFloat() { return (Next() >> 8) * (1.0f / 16777216.0f); }
+
+    private:
+      uint64_t m_State     = 0;
+      uint64_t m_Increment = 1;
+  };
+
+  // Random numbers for CPU rendering and gameplay code. Every thread has its
+  // own generator, so all functions are thread safe without locking. Init()
+  // seeds the calling thread and the base seed of threads that draw their
+  // first number afterwards.
+  //
+  // The Fill functions generate many values at once with SSE2 or AVX2,
+  // whichever the build targets, and give the same values on every path.
   class Random {
     public:
-      static void Init() { s_RandomEngine.seed(std::random_device()()); }
+      static void Init();
+      static void Init(uint64_t seed);
 
-      static uint32_t UInt() { return s_Distribution(s_RandomEngine); }
+      static uint32_t UInt() { return s_Generator.Next(); }
 
+      // In [min, max], without the bias of a modulo
       static uint32_t UInt(uint32_t min, uint32_t max) {
-        return min + (s_Distribution(s_RandomEngine) % (max - min + 1));
+        if (max - min == 0xffffffffu) return s_Generator.Next();
+        return min + s_Generator.Next(max - min + 1);
       }
 
-      static float Float() {
-        return (float)s_Distribution(s_RandomEngine) /
-               (float)std::numeric_limits<uint32_t>::max();
-      }
+      // In [0, 1)
+      static float Float() { return s_Generator.NextFloat(); }
 
       static glm::vec3 Vec3() { return glm::vec3(Float(), Float(), Float()); }
 
@@ -29,14 +83,44 @@ namespace Sera {
                          Float() * (max - min) + min);
       }
 
-      static glm::vec3 InUnitSphere() {
-        return glm::normalize(Vec3(-1.0f, 1.0f));
+      // Uniform inside the unit ball
+      static glm::vec3 InUnitSphere();
+      // Uniform on the unit sphere
+      static glm::vec3 OnUnitSphere();
+      // Uniform on the unit hemisphere around `normal`
+      static glm::vec3 OnHemisphere(const glm::vec3& normal);
+
+      // Stateless counter-based numbers, the same inputs always give the
+      // same output on every thread. Seeds e.g. a per-pixel PCG32 from the
+      // pixel and frame so renders are reproducible regardless of which
+      // thread shades which pixel.
+      static uint32_t Hash(uint32_t x) {
+        // PCG output permutation applied to one LCG step of the input
+        uint32_t state = x * 747796405u + 2891336453u;
+        uint32_t word  = ((state >> ((state >> 28) + 4)) ^ state) * 277803737u;
+        return (word >> 22) ^ word;
+      }
+      static uint32_t Hash(uint32_t x, uint32_t y, uint32_t z = 0) {
+        return Hash(x + Hash(y + Hash(z)));
       }
+      static float    HashFloat(uint32_t x, uint32_t y, uint32_t z = 0) {
+        return (Hash(x, y, z) >> 8) * (1.0f / 16777216.0f);
+      }
+
+      // Batches drawn from the calling thread's generator
+      static void FillUInt(uint32_t* values, size_t count);
+      // In [min, max)
+      static void FillFloat(float* values, size_t count, float min = 0.0f,
+                            float max = 1.0f);
+      static void FillVec3(glm::vec3* values, size_t count, float min = 0.0f,
+                           float max = 1.0f);
+      static void FillInUnitSphere(glm::vec3* values, size_t count);
+      static void FillOnUnitSphere(glm::vec3* values, size_t count);
+      static void FillOnHemisphere(glm::vec3* values, size_t count,
+                                   const glm::vec3& normal);
 
     private:
-      static std::mt19937 s_RandomEngine;
-      static std::uniform_int_distribution<std::mt19937::result_type>
-          s_Distribution;
+      static thread_local PCG32 s_Generator;
   };
 
 }  // namespace Sera
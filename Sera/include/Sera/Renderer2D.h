@@ -0,0 +1,90 @@
+#pragma once
+
+#include <cstdint>
+#include <memory>
+#include <vector>
+
+#include <glm/glm.hpp>
+
+#include "Backend/VulkanPipelineRegistry.h"
+#include "vulkan/vulkan.h"
+
+namespace Sera {
+
+  class Buffer;
+  class Image;
+
+  enum class BlendMode { Alpha = 0, Opaque };
+
+  // Batched quads and sprites in the main pass, for content too large for
+  // ImGui draw lists. Quads collected between Begin() and End() are written
+  // into a persistently mapped instance buffer sorted by layer, blend mode
+  // and texture, and every run with the same state is one instanced draw.
+  // Coordinates are pixels with the origin at the top left of the
+  // framebuffer.
+  class Renderer2D {
+    public:
+      struct Quad {
+          glm::vec2    position = glm::vec2(0.0f);  // Center
+          glm::vec2    size     = glm::vec2(1.0f);
+          float        rotation = 0.0f;  // Radians, clockwise on screen
+          glm::vec4    color    = glm::vec4(1.0f);
+          // Sampled and tinted with `color`, nullptr draws a solid color
+          const Image* texture  = nullptr;
+          glm::vec2    uvMin    = glm::vec2(0.0f);
+          glm::vec2    uvMax    = glm::vec2(1.0f);
+          BlendMode    blend    = BlendMode::Alpha;
+          // Layers are drawn in ascending order. Quads of one layer are
+          // grouped by state, so overlapping translucent quads whose order
+          // matters belong on different layers.
+          int32_t      layer    = 0;
+      };
+
+      // Counted by End()
+      struct Statistics {
+          uint32_t quads     = 0;
+          uint32_t batches   = 0;
+          // Lower than batches while the pipelines are still compiling
+          uint32_t drawCalls = 0;
+      };
+
+      Renderer2D();
+      ~Renderer2D();
+
+      void Begin();
+      void DrawQuad(const glm::vec2& position, const glm::vec2& size,
+                    const glm::vec4& color);
+      void DrawQuad(const glm::vec2& position, const glm::vec2& size,
+                    const Image& texture,
+                    const glm::vec4& tint = glm::vec4(1.0f));
+      void DrawQuad(const Quad& quad);
+      // Records the batches, call from Layer::OnRender()
+      void End(VkCommandBuffer commandBuffer);
+
+      const Statistics& GetStats() const { return m_Stats; }
+
+    private:
+      // Matches the per-instance inputs of renderer2d.vert
+      struct Instance {
+          glm::vec2 position;
+          glm::vec2 size;
+          float     rotation;
+          glm::vec4 texCoords;
+          glm::vec4 color;
+      };
+      struct SortKey {
+          int32_t         layer;
+          BlendMode       blend;
+          VkDescriptorSet texture;
+          uint32_t        index;  // Keeps submission order within a batch
+      };
+
+      std::vector<Instance>   m_Instances;
+      std::vector<SortKey>    m_Keys;
+      std::unique_ptr<Buffer> m_InstanceBuffer;
+      std::unique_ptr<Image>  m_WhiteTexture;
+      PipelineHandle          m_Pipelines[2];  // Indexed by BlendMode
+      Statistics              m_Stats;
+  };
+
+}  // namespace Sera
@@ -0,0 +1,108 @@
+#pragma once
+
+#include <cstdint>
+#include <memory>
+
+#include "vulkan/vulkan.h"
+
+namespace Sera {
+
+  class ComputeShader;
+  class Image;
+  class VulkanRenderPass;
+
+  // Declared outside SceneViewport so it can be a default argument there
+  struct SceneViewportSettings {
+      bool  dynamicResolution = true;
+      // GPU milliseconds for the scene pass and its upscale
+      float targetTime        = 8.0f;
+      float minScale          = 0.5f;
+      // Fixed scale without dynamic resolution, above 1 supersamples
+      float maxScale          = 1.0f;
+      // Upscales through a sharpening compute pass instead of sampling
+      // the target bilinearly
+      bool  sharpen           = false;
+      float sharpness         = 0.5f;
+
+      VkClearColorValue clearColor = {
+          {0.0f, 0.0f, 0.0f, 1.0f}
+      };
+  };
+
+  // Offscreen scene target shown inside an ImGui window. The scene renders at
+  // a fraction of the window's resolution and is upscaled when displayed.
+  // With dynamic resolution the fraction follows the GPU time of the scene
+  // pass, measured as a GpuProfiler scope, against a budget. It shrinks as
+  // soon as the frames rendered at the current scale run over budget and
+  // grows back slowly once they run well under, with a dead band and a
+  // cooldown on growing so it does not oscillate.
+  //
+  // Pipelines drawing into the scene are created against GetColorFormat(),
+  // or GetRenderPass() when the main pass does not use dynamic rendering.
+  // The target has no depth attachment.
+  class SceneViewport {
+    public:
+      using Settings = SceneViewportSettings;
+
+      struct Statistics {
+          float      scale   = 1.0f;
+          // Last measured scene pass, 0 until the first result comes back
+          float      gpuTime = 0.0f;
+          VkExtent2D renderExtent{};
+          VkExtent2D displayExtent{};
+      };
+
+      SceneViewport(const Settings& settings = {});
+      ~SceneViewport();
+
+      // Draws the scene filling the rest of the current ImGui window, call
+      // from Layer::OnUIRender(). The window's size becomes the display
+      // extent of this frame.
+      void Show();
+
+      // Begins the scene pass with the viewport and scissor set to
+      // GetRenderExtent(), call from Layer::OnPreRender(). False when Show()
+      // was not called this frame, e.g. the window is collapsed, then there
+      // is nothing to record and no End().
+      bool Begin(VkCommandBuffer commandBuffer);
+      // Ends the pass and upscales the result for ImGui
+      void End(VkCommandBuffer commandBuffer);
+
+      // Size draws into the scene use, e.g. with DrawCall::SetViewport()
+      VkExtent2D   GetRenderExtent() const { return m_Stats.renderExtent; }
+      VkRenderPass GetRenderPass() const;
+
+      static VkFormat GetColorFormat();
+
+      Settings&         GetSettings() { return m_Settings; }
+      const Statistics& GetStats() const { return m_Stats; }
+
+    private:
+      void AllocateTargets();
+      void UpdateScale(float gpuTime);
+
+    private:
+      Settings   m_Settings;
+      Statistics m_Stats;
+
+      // Set from the measurements in Begin(), applied by the next Show() so
+      // the displayed and rendered regions always match
+      float    m_RequestedScale = 1.0f;
+      float    m_SmoothedTime   = 0.0f;
+      uint32_t m_Settle         = 0;
+      uint32_t m_Cooldown       = 0;
+      bool     m_Shown          = false;
+      bool     m_Sharpen        = false;
+      // GpuProfiler scope of the pass being recorded
+      uint32_t m_Scope          = UINT32_MAX;
+
+      // Reallocated only when the scene outgrows them or shrinks a lot, the
+      // rendered region is the top left corner
+      std::unique_ptr<Image>            m_Target;
+      std::unique_ptr<Image>            m_Upscaled;
+      std::unique_ptr<VulkanRenderPass> m_RenderPass;
+      VkFramebuffer                     m_Framebuffer = VK_NULL_HANDLE;
+      std::unique_ptr<ComputeShader>    m_SharpenShader;
+  };
+
+}  // namespace Sera
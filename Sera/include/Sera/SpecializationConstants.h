@@ -0,0 +1,107 @@
+#pragma once
+
+#include "Hash.h"
+
+#include <vulkan/vulkan.h>
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <vector>
+
+namespace Sera {
+
+  // The 32-bit scalar types GLSL allows for `layout(constant_id = N) const`
+  enum class SpecializationType { Bool = 0, Int, UInt, Float };
+
+  // Values for a shader's specialization constants, keyed by constant_id.
+  // Every pipeline variant gets its own constants folded in by the driver,
+  // so branches on them cost nothing at run time. Ids a stage does not
+  // declare are ignored by that stage.
+  class SpecializationConstants {
+    public:
+      struct Constant {
+          uint32_t           id;
+          SpecializationType type;
+          uint32_t           value;  // Bit pattern of the value
+      };
+
+      SpecializationConstants& Set(uint32_t id, bool value) {
+        return Set(id, SpecializationType::Bool, value ? VK_TRUE : VK_FALSE);
+      }
+      SpecializationConstants& Set(uint32_t id, int32_t value) {
+        uint32_t bits;
+        memcpy(&bits, &value, sizeof(bits));
+        return Set(id, SpecializationType::Int, bits);
+      }
+      SpecializationConstants& Set(uint32_t id, uint32_t value) {
+        return Set(id, SpecializationType::UInt, value);
+      }
+      SpecializationConstants& Set(uint32_t id, float value) {
+        uint32_t bits;
+        memcpy(&bits, &value, sizeof(bits));
+        return Set(id, SpecializationType::Float, bits);
+      }
+
+      bool IsEmpty() const { return m_Constants.empty(); }
+      const std::vector<Constant>& GetConstants() const { return m_Constants; }
+
+      // Points into `entries` and into this object, both have to outlive
+      // the pipeline creation call
+      VkSpecializationInfo GetInfo(
+          std::vector<VkSpecializationMapEntry>& entries) const {
+        entries.clear();
+        for (size_t i = 0; i < m_Constants.size(); i++) {
+          uint32_t offset = (uint32_t)(i * sizeof(Constant) +
+                                       offsetof(Constant, value));
+          entries.push_back({m_Constants[i].id, offset, sizeof(uint32_t)});
+        }
+        VkSpecializationInfo info{};
+        info.mapEntryCount = (uint32_t)entries.size();
+        info.pMapEntries   = entries.data();
+        info.dataSize      = m_Constants.size() * sizeof(Constant);
+        info.pData         = m_Constants.data();
+        return info;
+      }
+
+      void Hash(uint64_t& hash) const {
+        for (auto& constant : m_Constants) {
+          HashCombine(hash, constant.id);
+          HashCombine(hash, constant.type);
+          HashCombine(hash, constant.value);
+        }
+      }
+
+      bool operator==(const SpecializationConstants& other) const {
+        return std::equal(m_Constants.begin(), m_Constants.end(),
+                          other.m_Constants.begin(), other.m_Constants.end(),
+                          [](const Constant& a, const Constant& b) {
+                            return a.id == b.id && a.type == b.type &&
+                                   a.value == b.value;
+                          });
+      }
+      bool operator!=(const SpecializationConstants& other) const {
+        return !(*this == other);
+      }
+
+    private:
+      // Kept sorted by id, equal sets compare and hash equal regardless of
+      // the order they were set in
+      SpecializationConstants& Set(uint32_t id, SpecializationType type,
+                                   uint32_t value) {
+        auto it = std::lower_bound(
+            m_Constants.begin(), m_Constants.end(), id,
+            [](const Constant& c, uint32_t id) { return c.id < id; });
+        if (it != m_Constants.end() && it->id == id)
+          *it = {id, type, value};
+        else
+          m_Constants.insert(it, {id, type, value});
+        return *this;
+      }
+
+    private:
+      std::vector<Constant> m_Constants;
+  };
+
+}  // namespace Sera
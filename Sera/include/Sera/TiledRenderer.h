@@ -0,0 +1,113 @@
+#pragma once
+
+#include <atomic>
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <vector>
+
+#include "Image.h"
+#include "JobSystem.h"
+
+namespace Sera {
+
+  enum class TileOrder { RowMajor = 0, Morton, Spiral };
+
+  // Declared outside TiledRenderer so it can be a default argument there
+  struct TiledRendererSettings {
+      // Edge length in pixels. A 32x32 tile of RGBA is 4 KiB and of RGBA32F
+      // 16 KiB, small enough to stay in cache while it is shaded.
+      uint32_t    tileSize  = 32;
+      // Spiral resolves the center of the image first
+      TileOrder   order     = TileOrder::Spiral;
+      ImageFormat format    = ImageFormat::RGBA;
+      // Passes over the image before it stops refining, 0 never stops
+      uint32_t    maxPasses = 0;
+  };
+
+  // CPU rendering into an Image, split into tiles shaded in parallel on the
+  // application's job system. The image is rendered in passes, e.g. one
+  // sample per pixel each, and every tile is uploaded as soon as it is
+  // finished so the image fills in progressively. Only the tiles that
+  // changed since the last Update() are copied to the GPU.
+  //
+  // The tile function runs on worker threads and writes the tile's pixels
+  // into GetPixels(). Tiles never overlap, so it only has to be thread safe
+  // for the data it reads.
+  class TiledRenderer {
+    public:
+      using Settings = TiledRendererSettings;
+
+      struct Tile {
+          uint32_t x, y;
+          uint32_t width, height;
+          // Number of passes finished before this one
+          uint32_t pass;
+
+          // True once the renderer was reset or resized after the tile
+          // started. Long running tile functions can check it and return,
+          // the tile is then not uploaded.
+          bool IsCancelled() const {
+            return generation->load(std::memory_order_relaxed) != expected;
+          }
+
+          const std::atomic<uint32_t>* generation;
+          uint32_t                     expected;
+      };
+
+      using TileFunction = std::function<void(const Tile& tile)>;
+
+      TiledRenderer(uint32_t width, uint32_t height, TileFunction function,
+                    const Settings& settings = {});
+      ~TiledRenderer();
+
+      // Uploads the finished tiles and starts the next pass once the current
+      // one is done. Call once per frame from Layer::OnUpdate().
+      void Update();
+
+      // Cancels the pass in flight and starts over from the first pass,
+      // e.g. when the camera moved
+      void Reset();
+      // Same as Reset(), the pixels are cleared
+      void Resize(uint32_t width, uint32_t height);
+
+      // Row-major pixels in the settings' format, written by the tile
+      // function and read by the uploads
+      void* GetPixels() { return m_Pixels.data(); }
+
+      Image&   GetImage() { return *m_Image; }
+      uint32_t GetWidth() const { return m_Image->GetWidth(); }
+      uint32_t GetHeight() const { return m_Image->GetHeight(); }
+      // Passes finished since the last reset
+      uint32_t GetPassCount() const { return m_PassCount; }
+      bool     IsComplete() const;
+
+    private:
+      void BuildTiles();
+      void StartPass();
+      void RenderNextTile(uint32_t generation);
+      void Cancel();
+
+    private:
+      Settings     m_Settings;
+      TileFunction m_Function;
+      JobSystem&   m_JobSystem;
+
+      std::unique_ptr<Image> m_Image;
+      std::vector<uint8_t>   m_Pixels;
+
+      // In the settings' order
+      std::vector<VkRect2D>                m_Tiles;
+      std::unique_ptr<std::atomic<bool>[]> m_Dirty;
+      std::vector<VkRect2D>                m_Uploads;
+
+      // Tiles are handed out in order from m_NextTile, so the order holds
+      // no matter which thread picks up which job
+      std::atomic<uint32_t> m_NextTile{0};
+      std::atomic<uint32_t> m_Generation{0};
+      JobCounter            m_Counter;
+      uint32_t              m_PassCount  = 0;
+      bool                  m_PassActive = false;
+  };
+
+}  // namespace Sera
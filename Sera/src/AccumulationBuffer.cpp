@@ -0,0 +1,155 @@
+#include "AccumulationBuffer.h"
+
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+
+#include "Image.h"
+
+#if defined(__SSE2__) || defined(_M_X64) || \
+    (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#include <emmintrin.h>
+#define SR_ACCUMULATION_SSE2
+#endif
+
+namespace Sera {
+
+  namespace Utils {
+
+    static float Luminance(const glm::vec4& color) {
+      return 0.2126f * color.r + 0.7152f * color.g + 0.0722f * color.b;
+    }
+
+  }  // namespace Utils
+
+  AccumulationBuffer::AccumulationBuffer(Image& image, const Settings& settings)
+      : m_Image(image), m_Settings(settings) {}
+
+  void AccumulationBuffer::Begin() {
+    if (m_Image.GetWidth() != m_Width || m_Image.GetHeight() != m_Height) {
+      m_Width      = m_Image.GetWidth();
+      m_Height     = m_Image.GetHeight();
+      size_t count = (size_t)m_Width * m_Height;
+      m_Sums.resize(count);
+      m_Counts.resize(count);
+      m_M2.resize(m_Settings.variance ? count : 0);
+      m_Pixels.assign(count * m_Image.GetBytesPerPixel(), 0);
+      m_ResetPending = true;
+    }
+    if (m_ResetPending) {
+      // A pixel's first sample overwrites its sum, only the counts need
+      // clearing
+      std::fill(m_Counts.begin(), m_Counts.end(), 0);
+      m_FrameIndex   = 0;
+      m_ResetPending = false;
+    }
+
+    m_PixelSize = m_Image.GetBytesPerPixel();
+    m_Target    = m_Pixels.data();
+  }
+
+  void AccumulationBuffer::Begin(const glm::mat4& view) {
+    if (view != m_View) {
+      m_View = view;
+      Reset();
+    }
+    Begin();
+  }
+
+  void AccumulationBuffer::End() {
+    // The image's staging memory changes every frame, skipped pixels would
+    // upload stale values from it
+    memcpy(m_Image.MapStaging(), m_Pixels.data(), m_Pixels.size());
+    m_Image.UnmapStaging();
+    m_Target = nullptr;
+    m_FrameIndex++;
+  }
+
+  void AccumulationBuffer::Add(uint32_t x, uint32_t y,
+                               const glm::vec4& sample) {
+    Accumulate(y * m_Width + x, sample);
+  }
+
+  void AccumulationBuffer::AddRow(uint32_t x, uint32_t y,
+                                  const glm::vec4* samples, uint32_t count) {
+    uint32_t index = y * m_Width + x;
+    for (uint32_t i = 0; i < count; i++) Accumulate(index + i, samples[i]);
+  }
+
+  glm::vec4 AccumulationBuffer::GetAverage(uint32_t x, uint32_t y) const {
+    uint32_t index = y * m_Width + x;
+    uint32_t count = m_Counts[index];
+    return count ? m_Sums[index] / (float)count : glm::vec4(0.0f);
+  }
+
+  float AccumulationBuffer::GetVariance(uint32_t x, uint32_t y) const {
+    uint32_t index = y * m_Width + x;
+    uint32_t count = m_Counts[index];
+    if (!m_Settings.variance || count < 2) return 0.0f;
+    return m_M2[index] / (count - 1);
+  }
+
+  float AccumulationBuffer::GetStandardError(uint32_t x, uint32_t y) const {
+    uint32_t count = GetSampleCount(x, y);
+    if (count < 2) return 0.0f;
+    return std::sqrt(GetVariance(x, y) / count);
+  }
+
+  void AccumulationBuffer::Accumulate(uint32_t index, const glm::vec4& sample) {
+    uint32_t   count   = ++m_Counts[index];
+    glm::vec4& sum     = m_Sums[index];
+    float      inverse = 1.0f / count;
+    uint8_t*   target  = m_Target + (size_t)index * m_PixelSize;
+
+    // Mean luminance before this sample, for the variance
+    float meanBefore = 0.0f;
+    if (m_Settings.variance && count > 1)
+      meanBefore = Utils::Luminance(sum) / (count - 1);
+
+#ifdef SR_ACCUMULATION_SSE2
+    __m128 value = _mm_loadu_ps(&sample.x);
+    if (count > 1) value = _mm_add_ps(_mm_loadu_ps(&sum.x), value);
+    _mm_storeu_ps(&sum.x, value);
+
+    __m128 average = _mm_mul_ps(value, _mm_set1_ps(inverse));
+    if (m_PixelSize == 16) {
+      _mm_storeu_ps((float*)target, average);
+    } else if (m_PixelSize == 4) {
+      // Clamping with the value first turns NaNs into 0
+      __m128 clamped = _mm_min_ps(_mm_max_ps(average, _mm_setzero_ps()),
+                                  _mm_set1_ps(1.0f));
+      __m128 scaled  = _mm_mul_ps(clamped, _mm_set1_ps(255.0f));
+
+      __m128i bytes = _mm_cvtps_epi32(scaled);
+      bytes         = _mm_packs_epi32(bytes, bytes);
+      bytes         = _mm_packus_epi16(bytes, bytes);
+
+      uint32_t packed = (uint32_t)_mm_cvtsi128_si32(bytes);
+      memcpy(target, &packed, sizeof(packed));
+    }
+#else
+    sum               = count == 1 ? sample : sum + sample;
+    glm::vec4 average = sum * inverse;
+    if (m_PixelSize == 16) {
+      memcpy(target, &average.x, sizeof(average));
+    } else if (m_PixelSize == 4) {
+      for (int i = 0; i < 4; i++) {
+        float value = std::min(std::max(average[i], 0.0f), 1.0f);
+        target[i]   = (uint8_t)(value * 255.0f + 0.5f);
+      }
+    }
+#endif
+
+    if (m_Settings.variance) {
+      // Welford's update of the luminance's squared deviations
+      float  luminance = Utils::Luminance(sample);
+      float  mean      = Utils::Luminance(sum) * inverse;
+      float& m2        = m_M2[index];
+      if (count == 1)
+        m2 = 0.0f;
+      else
+        m2 += (luminance - meanBefore) * (luminance - mean);
+    }
+  }
+
+}  // namespace Sera
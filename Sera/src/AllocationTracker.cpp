@@ -0,0 +1,250 @@
+#include "AllocationTracker.h"
+
+#include <atomic>
+#include <cstdio>
+#include <cstdlib>
+#include <new>
+
+#include "Log.h"
+
+namespace Sera {
+
+  namespace Utils {
+
+    static std::atomic<uint64_t>    s_FrameAllocations{0};
+    static std::atomic<uint64_t>    s_FrameFrees{0};
+    static std::atomic<uint64_t>    s_FrameBytes{0};
+    static AllocationTracker::Usage s_LastFrame;
+    static uint64_t                 s_Frame = 0;
+
+    static std::atomic<bool>                         s_SteadyState{false};
+    static std::atomic<AllocationTracker::Assertion> s_Assertion{
+        AllocationTracker::Assertion::Warn};
+    // Steady-state allocations of the current frame and the first of them
+    static std::atomic<uint64_t>    s_Violations{0};
+    static std::atomic<uint64_t>    s_ViolationSize{0};
+    static std::atomic<const char*> s_ViolationZone{nullptr};
+
+    // Constant initialized, so the hooks can use them on any thread at any
+    // time without running a constructor
+    static thread_local AllocationTracker::Usage s_ThreadUsage;
+    static thread_local const char*              s_Zone    = nullptr;
+    static thread_local uint32_t                 s_Allowed = 0;
+
+    static void FlagAllocation(size_t size) {
+      if (s_Violations.fetch_add(1, std::memory_order_relaxed) == 0) {
+        s_ViolationSize.store(size, std::memory_order_relaxed);
+        s_ViolationZone.store(s_Zone, std::memory_order_relaxed);
+      }
+      if (s_Assertion.load(std::memory_order_relaxed) !=
+          AllocationTracker::Assertion::Abort)
+        return;
+
+      // The logger may be what allocated and hold its lock, stdio does not
+      // allocate for a short unbuffered message
+      fprintf(stderr,
+              "[Sera] Allocated %zu bytes in a steady-state frame, in zone "
+              "%s\n",
+              size, s_Zone ? s_Zone : "(none)");
+      abort();
+    }
+
+    static void CountAllocation(size_t size) {
+      s_ThreadUsage.allocations++;
+      s_ThreadUsage.bytes += size;
+      s_FrameAllocations.fetch_add(1, std::memory_order_relaxed);
+      s_FrameBytes.fetch_add(size, std::memory_order_relaxed);
+      if (s_SteadyState.load(std::memory_order_relaxed) && s_Allowed == 0)
+        FlagAllocation(size);
+    }
+
+    static void CountFree() {
+      s_ThreadUsage.frees++;
+      s_FrameFrees.fetch_add(1, std::memory_order_relaxed);
+    }
+
+#ifdef SR_TRACK_ALLOCATIONS
+    static void* Allocate(size_t size) {
+      CountAllocation(size);
+      return malloc(size ? size : 1);
+    }
+
+    static void* AllocateAligned(size_t size, std::align_val_t align) {
+      CountAllocation(size);
+      size_t alignment = (size_t)align;
+#ifdef _WIN32
+      return _aligned_malloc(size ? size : 1, alignment);
+#else
+      // aligned_alloc() wants a multiple of the alignment
+      size_t rounded = (size + alignment - 1) / alignment * alignment;
+      return aligned_alloc(alignment, rounded ? rounded : alignment);
+#endif
+    }
+
+    static void* AllocateOrThrow(size_t size) {
+      void* memory = Allocate(size);
+      if (!memory) throw std::bad_alloc();
+      return memory;
+    }
+
+    static void* AllocateAlignedOrThrow(size_t size, std::align_val_t align) {
+      void* memory = AllocateAligned(size, align);
+      if (!memory) throw std::bad_alloc();
+      return memory;
+    }
+
+    static void Free(void* memory) {
+      if (!memory) return;
+      CountFree();
+      free(memory);
+    }
+
+    static void FreeAligned(void* memory) {
+      if (!memory) return;
+      CountFree();
+#ifdef _WIN32
+      _aligned_free(memory);
+#else
+      free(memory);
+#endif
+    }
+#endif
+
+  }  // namespace Utils
+
+#ifdef SR_TRACK_ALLOCATIONS
+  bool AllocationTracker::IsEnabled() { return true; }
+#else
+  bool AllocationTracker::IsEnabled() { return false; }
+#endif
+
+  AllocationTracker::Usage AllocationTracker::GetThreadUsage() {
+    return Utils::s_ThreadUsage;
+  }
+
+  AllocationTracker::Usage AllocationTracker::GetFrameUsage() {
+    return Utils::s_LastFrame;
+  }
+
+  void AllocationTracker::MarkFrame() {
+    Utils::s_LastFrame.allocations = Utils::s_FrameAllocations.exchange(0);
+    Utils::s_LastFrame.frees       = Utils::s_FrameFrees.exchange(0);
+    Utils::s_LastFrame.bytes       = Utils::s_FrameBytes.exchange(0);
+
+    uint64_t violations = Utils::s_Violations.exchange(0);
+    if (violations && Utils::s_Assertion.load() != Assertion::None) {
+      // Logging allocates, which must not count against the next frame
+      AllowAllocations allow;
+      const char*      zone = Utils::s_ViolationZone.load();
+      SR_CORE_WARN(
+          "Frame {} made {} allocations in steady state, the first of {} "
+          "bytes in zone {}",
+          Utils::s_Frame, violations, Utils::s_ViolationSize.load(),
+          zone ? zone : "(none)");
+    }
+    Utils::s_Frame++;
+  }
+
+  void AllocationTracker::SetAssertion(Assertion assertion) {
+    Utils::s_Assertion.store(assertion);
+  }
+
+  void AllocationTracker::SetSteadyState(bool steadyState) {
+    Utils::s_SteadyState.store(steadyState);
+    // Allocations before the switch are not the steady state's
+    Utils::s_Violations.store(0);
+  }
+
+  bool AllocationTracker::IsSteadyState() {
+    return Utils::s_SteadyState.load();
+  }
+
+  void AllocationTracker::SetZone(const char* name) { Utils::s_Zone = name; }
+
+  void* AllocationTracker::Allocate(size_t size, void* userData) {
+    Utils::CountAllocation(size);
+    return malloc(size);
+  }
+
+  void AllocationTracker::Free(void* memory, void* userData) {
+    if (memory) Utils::CountFree();
+    free(memory);
+  }
+
+  void AllocationTracker::Allow(bool allow) {
+    if (allow)
+      Utils::s_Allowed++;
+    else
+      Utils::s_Allowed--;
+  }
+
+}  // namespace Sera
+
+#ifdef SR_TRACK_ALLOCATIONS
+
+// Replacements of the global allocation functions. Linked into every
+// executable using Sera, as long as Sera is a static library. A shared Sera
+// only counts what it allocates itself on Windows.
+void* operator new(size_t size) {
+  return Sera::Utils::AllocateOrThrow(size);
+}
+void* operator new[](size_t size) {
+  return Sera::Utils::AllocateOrThrow(size);
+}
+void* operator new(size_t size, const std::nothrow_t&) noexcept {
+  return Sera::Utils::Allocate(size);
+}
+void* operator new[](size_t size, const std::nothrow_t&) noexcept {
+  return Sera::Utils::Allocate(size);
+}
+void* operator new(size_t size, std::align_val_t align) {
+  return Sera::Utils::AllocateAlignedOrThrow(size, align);
+}
+void* operator new[](size_t size, std::align_val_t align) {
+  return Sera::Utils::AllocateAlignedOrThrow(size, align);
+}
+void* operator new(size_t size, std::align_val_t align,
+                   const std::nothrow_t&) noexcept {
+  return Sera::Utils::AllocateAligned(size, align);
+}
+void* operator new[](size_t size, std::align_val_t align,
+                     const std::nothrow_t&) noexcept {
+  return Sera::Utils::AllocateAligned(size, align);
+}
+
+void operator delete(void* memory) noexcept { Sera::Utils::Free(memory); }
+void operator delete[](void* memory) noexcept { Sera::Utils::Free(memory); }
+void operator delete(void* memory, size_t) noexcept {
+  Sera::Utils::Free(memory);
+}
+void operator delete[](void* memory, size_t) noexcept {
+  Sera::Utils::Free(memory);
+}
+void operator delete(void* memory, const std::nothrow_t&) noexcept {
+  Sera::Utils::Free(memory);
+}
+void operator delete[](void* memory, const std::nothrow_t&) noexcept {
+  Sera::Utils::Free(memory);
+}
+void operator delete(void* memory, std::align_val_t) noexcept {
+  Sera::Utils::FreeAligned(memory);
+}
+void operator delete[](void* memory, std::align_val_t) noexcept {
+  Sera::Utils::FreeAligned(memory);
+}
+void operator delete(void* memory, size_t, std::align_val_t) noexcept {
+  Sera::Utils::FreeAligned(memory);
+}
+void operator delete[](void* memory, size_t, std::align_val_t) noexcept {
+  Sera::Utils::FreeAligned(memory);
+}
+void operator delete(void* memory, std::align_val_t,
+                     const std::nothrow_t&) noexcept {
+  Sera::Utils::FreeAligned(memory);
+}
+void operator delete[](void* memory, std::align_val_t,
+                       const std::nothrow_t&) noexcept {
+  Sera::Utils::FreeAligned(memory);
+}
+
+#endif
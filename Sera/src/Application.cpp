@@ -1,6 +1,21 @@
 #include "Application.h"
+#include "AllocationTracker.h"
+#include "FileWatcher.h"
+#include "FrameStats.h"
+#include "GpuProfiler.h"
+#include "Image.h"
+#include "JobSystem.h"
+#include "MemoryTracker.h"
+#include "Profiler.h"
+#include "Backend/VulkanDebug.h"
+#include "Backend/VulkanDescriptorAllocator.h"
+#include "Backend/VulkanLayoutCache.h"
+#include "Backend/VulkanPipelineCache.h"
+#include "Backend/VulkanPipelineRegistry.h"
 #include "Backend/VulkanRenderPipeline.h"
 #include "Backend/VulkanRenderpass.h"
+#include "Backend/VulkanRendering.h"
+#include "Backend/VulkanShader.h"
 #include "Backend/VulkanSwapchain.h"
 #include "Log.h"
 #include "Backend/VulkanInstance.h"
@@ -13,13 +28,21 @@
 #include "backends/imgui_impl_glfw.h"
 #include "backends/imgui_impl_vulkan.h"
 #include "vulkan/vulkan_core.h"
+#include <filesystem>
 #include <fstream>
 #include <imgui_internal.h>
 #include <stdio.h>   // printf, fprintf
 #include <stdlib.h>  // abort
+#include <algorithm>
 #include <array>
+#include <iterator>
+#include <thread>
 #include <vector>
 
+#ifndef SR_SHADER_DIR
+#define SR_SHADER_DIR "shaders"
+#endif
+
 #define GLFW_INCLUDE_NONE
 #define GLFW_INCLUDE_VULKAN
 #include <GLFW/glfw3.h>
@@ -31,6 +54,10 @@
 // Emedded font
 #include "ImGui/Roboto-Regular.embed"
 
+// Embedded SPIR-V, generated by sera_compile_shaders
+#include "Shaders/triangle_frag.h"
+#include "Shaders/triangle_vert.h"
+
 extern bool g_ApplicationRunning;
 
 // [Win32] Our example includes a copy of glfw3.lib pre-compiled with VS2010 to
@@ -49,16 +76,22 @@ extern bool g_ApplicationRunning;
 #define IMGUI_VULKAN_DEBUG_REPORT
 #endif
 
-static VkAllocationCallbacks      *g_Allocator      = NULL;
-static Sera::VulkanInstance       *g_Instance       = nullptr;
-static Sera::VulkanPhysicalDevice *g_PhysicalDevice = nullptr;
-static Sera::VulkanDevice         *g_Device         = nullptr;
-static uint32_t                    g_QueueFamily    = (uint32_t)-1;
-static VkQueue                     g_Queue          = VK_NULL_HANDLE;
-static VkDebugReportCallbackEXT    g_DebugReport    = VK_NULL_HANDLE;
-static VkPipelineCache             g_PipelineCache  = VK_NULL_HANDLE;
-static VkDescriptorPool            g_DescriptorPool = VK_NULL_HANDLE;
-static Sera::VulkanRenderPipeline *g_Pipeline       = nullptr;
+static const VkAllocationCallbacks  *g_Allocator        = NULL;
+static Sera::VulkanInstance         *g_Instance         = nullptr;
+static Sera::VulkanPhysicalDevice   *g_PhysicalDevice   = nullptr;
+static Sera::VulkanDevice           *g_Device           = nullptr;
+static uint32_t                      g_QueueFamily      = (uint32_t)-1;
+static VkQueue                       g_Queue            = VK_NULL_HANDLE;
+static VkDebugReportCallbackEXT      g_DebugReport      = VK_NULL_HANDLE;
+static Sera::VulkanPipelineCache    *g_PipelineCache    = nullptr;
+static Sera::VulkanPipelineRegistry *g_PipelineRegistry = nullptr;
+static Sera::VulkanLayoutCache      *g_LayoutCache      = nullptr;
+static VkDescriptorPool              g_DescriptorPool   = VK_NULL_HANDLE;
+static Sera::PipelineHandle          g_Pipeline;
+static Sera::FileWatcher            *g_ShaderWatcher    = nullptr;
+static Sera::JobSystem              *g_JobSystem        = nullptr;
+static Sera::GpuProfiler            *g_GpuProfiler      = nullptr;
+static std::string                   g_ShaderDirectory;
 // static VkPipeline                   g_GraphicPipeline        =
 // VK_NULL_HANDLE; static VkPipelineLayout             g_GraphicsPipelineLayout
 // = VK_NULL_HANDLE;
@@ -70,10 +103,21 @@ static Sera::VulkanSwapchain       *g_Swapchain = nullptr;
 
 static ImGui_ImplVulkanH_Window g_MainWindowData;
 static bool                     g_SwapChainRebuild = false;
+// Main pass uses vkCmdBeginRendering instead of g_Renderpass and framebuffers
+static bool                     g_UseDynamicRendering = false;
+
+// Seconds between saves of a grown pipeline cache, besides the one at shutdown
+static constexpr float s_PipelineCacheSaveInterval = 30.0f;
+
+// Milliseconds the main loop waited for the GPU or presentation this frame,
+// FrameStats counts the rest of the frame as CPU time
+static float s_FrameWaitTime = 0.0f;
 
 // Per-frame-in-flight
 static std::vector<std::vector<VkCommandBuffer>> s_AllocatedCommandBuffers;
 static std::vector<std::vector<std::function<void()>>> s_ResourceFreeQueue;
+// Transient descriptor sets, recycled when their frame comes around again
+static std::vector<Sera::VulkanDescriptorAllocator *> s_FrameDescriptors;
 
 static Sera::Application *s_Instance = nullptr;
 
@@ -83,12 +127,16 @@ void check_vk_result(VkResult err) {
   if (err < 0) abort();
 }
 
-static void SetupVulkan(const char **extensions, uint32_t extensions_count) {
+static void SetupVulkan(const char **extensions, uint32_t extensions_count,
+                        bool headless, bool dynamicRendering) {
   VkResult err;
 
   // Create Vulkan Instance
   {
     Sera::VulkanInstance::Specs instanceSpecs;
+    instanceSpecs.enableSurface = !headless;
+    for (uint32_t i = 0; i < extensions_count; i++)
+      instanceSpecs.additionalExtensions.push_back(extensions[i]);
     instanceSpecs.additionalExtensions.push_back(
         VK_EXT_DEBUG_UTILS_EXTENSION_NAME);
 
@@ -106,9 +154,31 @@ static void SetupVulkan(const char **extensions, uint32_t extensions_count) {
   // Create Logical Device (with 1 queue)
   {
     std::vector<const char *> ext;
+    if (!headless) ext.push_back(VK_KHR_SWAPCHAIN_EXTENSION_NAME);
+    Sera::VulkanDevice::Features features;
+#ifdef IMGUI_IMPL_VULKAN_HAS_DYNAMIC_RENDERING
+    features.dynamicRendering = dynamicRendering;
+#endif
+    features.pipelineCreationFeedback     = true;
+    features.pipelineCreationCacheControl = true;
+    features.bufferDeviceAddress          = true;
+    features.drawIndirectCount            = true;
+    features.multiDrawIndirect            = true;
+    features.drawIndirectFirstInstance    = true;
+    features.shaderDrawParameters         = true;
+    features.synchronization2             = true;
+    features.pipelineStatisticsQuery      = true;
+    features.memoryBudget                 = true;
     g_Device = new Sera::VulkanDevice(g_PhysicalDevice, g_Allocator,
-                                      g_QueueFamily, ext);
+                                      g_QueueFamily, ext, features);
     g_Queue  = g_Device->queue;
+    SR_DEBUG_NAME(g_Device->device, VK_OBJECT_TYPE_QUEUE, g_Queue, "Queue");
+    Sera::MemoryTracker::Init(g_PhysicalDevice,
+                              g_Device->features.memoryBudget);
+
+    g_UseDynamicRendering = g_Device->features.dynamicRendering;
+    if (dynamicRendering && !g_UseDynamicRendering)
+      SR_CORE_WARN("Dynamic rendering is not supported, using render passes");
   }
 
   // Create Descriptor Pool for imgui
@@ -137,12 +207,79 @@ static void SetupVulkan(const char **extensions, uint32_t extensions_count) {
     check_vk_result(err);
   }
 }
+static void SetupPipelineCache(const std::string &path) {
+  Sera::VulkanPipelineCache::CreateInfo info{};
+  info.device     = g_Device;
+  info.allocator  = g_Allocator;
+  info.path       = path;
+  g_PipelineCache = Sera::VulkanPipelineCache::Create(info);
+  g_LayoutCache   = Sera::VulkanLayoutCache::Create({g_Device, g_Allocator});
+
+  // Leave most cores to the application, compiles are rare after warmup
+  uint32_t cores = std::thread::hardware_concurrency();
+  Sera::VulkanPipelineRegistry::CreateInfo registryInfo{};
+  registryInfo.device        = g_Device;
+  registryInfo.pipelineCache = g_PipelineCache;
+  registryInfo.layoutCache   = g_LayoutCache;
+  registryInfo.workerCount   = std::max(1u, std::min(4u, cores / 2));
+  g_PipelineRegistry = Sera::VulkanPipelineRegistry::Create(registryInfo);
+}
+
+static void CleanupPipelineCache() {
+  g_PipelineCache->Save();
+
+  auto stats = g_PipelineCache->GetStats();
+  if (stats.withFeedback > 0)
+    SR_CORE_INFO("Pipeline cache: {0}/{1} pipelines hit, {2:.1f} ms compiling",
+                 stats.cacheHits, stats.withFeedback, stats.creationTimeMs);
+  else
+    SR_CORE_INFO("Pipeline cache: {0} pipelines, {1:.1f} ms compiling",
+                 stats.pipelines, stats.creationTimeMs);
+
+  delete g_PipelineCache;
+  g_PipelineCache = nullptr;
+  delete g_LayoutCache;
+  g_LayoutCache = nullptr;
+}
+
+static VkFormat SelectDepthFormat(Sera::DepthFormat format) {
+  VkFormat candidates[3] = {};
+  switch (format) {
+    case Sera::DepthFormat::None:
+      return VK_FORMAT_UNDEFINED;
+    case Sera::DepthFormat::D16:
+      candidates[0] = VK_FORMAT_D16_UNORM;
+      candidates[1] = VK_FORMAT_D32_SFLOAT;
+      break;
+    case Sera::DepthFormat::D32:
+      candidates[0] = VK_FORMAT_D32_SFLOAT;
+      candidates[1] = VK_FORMAT_D16_UNORM;
+      break;
+    case Sera::DepthFormat::D24S8:
+      // D24S8 is not available on every GPU, D32S8 keeps the stencil
+      candidates[0] = VK_FORMAT_D24_UNORM_S8_UINT;
+      candidates[1] = VK_FORMAT_D32_SFLOAT_S8_UINT;
+      candidates[2] = VK_FORMAT_D16_UNORM_S8_UINT;
+      break;
+  }
+  for (VkFormat candidate : candidates) {
+    if (candidate == VK_FORMAT_UNDEFINED) break;
+    if (g_PhysicalDevice->IsDepthFormatSupported(candidate)) return candidate;
+  }
+  SR_CORE_WARN("Requested depth format is not supported, depth disabled");
+  return VK_FORMAT_UNDEFINED;
+}
 static void SetupRenderpass() {
+  if (g_UseDynamicRendering) return;
+
   Sera::VulkanRenderPass::CreateInfo info{};
   info.allocator     = g_Allocator;
   info.device        = g_Device;
   info.surfaceFormat = g_Swapchain->SurfaceFormat;
-  g_Renderpass       = Sera::VulkanRenderPass::Create(info);
+  info.depthFormat   = g_Swapchain->GetDepthFormat();
+  if (g_Swapchain->IsHeadless())
+    info.finalLayout = VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL;
+  g_Renderpass = Sera::VulkanRenderPass::Create(info);
   g_Swapchain->CreateFramebuffer(g_Renderpass->GetHandle());
 }
 // All the ImGui_ImplVulkanH_XXX structures/functions are optional helpers used
@@ -170,9 +307,16 @@ static void InitPools() {
                                      &frame->CommandBuffer);
       check_vk_result(err);
     }
+#ifdef SR_DEBUG
+    std::string index = " " + std::to_string(i);
+    Sera::SetObjectName(g_Device->device, VK_OBJECT_TYPE_COMMAND_POOL,
+                        frame->CommandPool, ("Frame pool" + index).c_str());
+    Sera::SetObjectName(g_Device->device, VK_OBJECT_TYPE_COMMAND_BUFFER,
+                        frame->CommandBuffer, ("Frame" + index).c_str());
+#endif
   }
 }
-static void SetupVulkanWindow(int width, int height) {
+static void SetupVulkanWindow(int width, int height, VkFormat depthFormat) {
   // Check for WSI support
   VkBool32 res;
   vkGetPhysicalDeviceSurfaceSupportKHR(g_PhysicalDevice->physicalDevice,
@@ -197,9 +341,23 @@ static void SetupVulkanWindow(int width, int height) {
   auto             presentMode     = ImGui_ImplVulkanH_SelectPresentMode(
       g_PhysicalDevice->physicalDevice, g_Surface, &present_modes[0],
       IM_ARRAYSIZE(present_modes));
-  g_Swapchain =
-      Sera::VulkanSwapchain::Create(g_Instance, g_PhysicalDevice, g_Allocator,
-                                    g_Device, true, g_SurfaceFormat, g_Surface);
+  g_Swapchain = Sera::VulkanSwapchain::Create(g_Instance, g_PhysicalDevice,
+                                              g_Allocator, g_Device, true,
+                                              g_SurfaceFormat, g_Surface,
+                                              depthFormat);
+  g_Swapchain->Resize(width, height);
+  g_CommandBuffers.resize(g_Swapchain->ImageCount, VK_NULL_HANDLE);
+  InitPools();
+}
+// Headless applications render into offscreen images owned by the swapchain
+// object instead of a surface
+static void SetupHeadlessTarget(int width, int height, VkFormat depthFormat) {
+  g_SurfaceFormat.format     = VK_FORMAT_R8G8B8A8_UNORM;
+  g_SurfaceFormat.colorSpace = VK_COLORSPACE_SRGB_NONLINEAR_KHR;
+  g_Swapchain = Sera::VulkanSwapchain::Create(g_Instance, g_PhysicalDevice,
+                                              g_Allocator, g_Device, true,
+                                              g_SurfaceFormat, VK_NULL_HANDLE,
+                                              depthFormat);
   g_Swapchain->Resize(width, height);
   g_CommandBuffers.resize(g_Swapchain->ImageCount, VK_NULL_HANDLE);
   InitPools();
@@ -214,48 +372,146 @@ static inline VkSemaphore GetRenderCompleteSemaphore() {
       .RenderCompleteSemaphore;
 }
 
+// Called with the device idle, sets from before are no longer in use
+static void ResizeFrameDescriptors(uint32_t count) {
+  for (auto *descriptors : s_FrameDescriptors) descriptors->Reset();
+  while (s_FrameDescriptors.size() > count) {
+    delete s_FrameDescriptors.back();
+    s_FrameDescriptors.pop_back();
+  }
+  while (s_FrameDescriptors.size() < count) {
+    Sera::VulkanDescriptorAllocator::CreateInfo info{};
+    info.device    = g_Device;
+    info.allocator = g_Allocator;
+    s_FrameDescriptors.push_back(Sera::VulkanDescriptorAllocator::Create(info));
+  }
+}
+
 static void CleanupVulkan() {
   vkDestroyDescriptorPool(g_Device->device, g_DescriptorPool, g_Allocator);
+  ResizeFrameDescriptors(0);
   delete g_Renderpass;
   delete g_Swapchain;
-  vkDestroySurfaceKHR(g_Instance->instance, g_Surface, g_Allocator);
-  delete g_Pipeline;
+  if (g_Surface != VK_NULL_HANDLE)
+    vkDestroySurfaceKHR(g_Instance->instance, g_Surface, g_Allocator);
+  g_Pipeline = {};
+  delete g_ShaderWatcher;
+  delete g_PipelineRegistry;
+  CleanupPipelineCache();
   delete g_Device;
   delete g_Instance;
 }
 
-void read_file(const char *path, std::vector<char> &out) {
-  std::ifstream fileStream{path, std::ios::ate | std::ios::binary};
-  if (!fileStream.is_open()) {
-    SR_CORE_ERROR("Could not open file: {0}", path);
-    fileStream.close();
+static void CleanupVulkanWindow() {
+  ImGui_ImplVulkanH_DestroyWindow(g_Instance->instance, g_Device->device,
+                                  &g_MainWindowData, g_Allocator);
+}
+
+using LayerStack = std::vector<std::shared_ptr<Sera::Layer>>;
+
+static bool HasDepthAttachment() {
+  return g_Swapchain->GetDepthFormat() != VK_FORMAT_UNDEFINED;
+}
+
+static bool HasStencilAttachment() {
+  return Sera::IsStencilFormat(g_Swapchain->GetDepthFormat());
+}
+
+static void BeginMainPass(VkCommandBuffer commandBuffer) {
+  Sera::Frame *backbuffer = &g_Swapchain->Frames[g_Swapchain->ImageIndex];
+  VkExtent2D   extent     = {(uint32_t)g_Swapchain->GetWidth(),
+                             (uint32_t)g_Swapchain->GetHeight()};
+
+  std::array<VkClearValue, 2> clearValues{};
+  clearValues[0].color = {
+      {0.0f, 0.0f, 0.0f, 1.0f}
+  };
+  clearValues[1].depthStencil = {1.0f, 0};
+
+  if (!g_UseDynamicRendering) {
+    VkRenderPassBeginInfo info = {};
+    info.sType                 = VK_STRUCTURE_TYPE_RENDER_PASS_BEGIN_INFO;
+    info.renderPass            = g_Renderpass->GetHandle();
+    info.framebuffer           = backbuffer->Framebuffer;
+    info.renderArea.extent     = extent;
+    info.clearValueCount       = HasDepthAttachment() ? 2 : 1;
+    info.pClearValues          = clearValues.data();
+    vkCmdBeginRenderPass(commandBuffer, &info, VK_SUBPASS_CONTENTS_INLINE);
     return;
   }
-  size_t fileSize = (size_t)fileStream.tellg();
-  out.resize(fileSize);
-  fileStream.seekg(0);
-  fileStream.read(out.data(), fileSize);
-  fileStream.close();
+
+  // Without a render pass the layout transitions are recorded by hand
+  Sera::TransitionImageLayout(
+      commandBuffer, backbuffer->Backbuffer, VK_IMAGE_ASPECT_COLOR_BIT,
+      VK_IMAGE_LAYOUT_UNDEFINED, VK_IMAGE_LAYOUT_COLOR_ATTACHMENT_OPTIMAL,
+      VK_PIPELINE_STAGE_COLOR_ATTACHMENT_OUTPUT_BIT, 0,
+      VK_PIPELINE_STAGE_COLOR_ATTACHMENT_OUTPUT_BIT,
+      VK_ACCESS_COLOR_ATTACHMENT_WRITE_BIT);
+
+  Sera::RenderingAttachment color;
+  color.view       = backbuffer->BackbufferView;
+  color.layout     = VK_IMAGE_LAYOUT_COLOR_ATTACHMENT_OPTIMAL;
+  color.clearValue = clearValues[0];
+
+  Sera::RenderingAttachment depth;
+  if (HasDepthAttachment()) {
+    VkImageAspectFlags aspect = VK_IMAGE_ASPECT_DEPTH_BIT;
+    if (HasStencilAttachment()) aspect |= VK_IMAGE_ASPECT_STENCIL_BIT;
+    Sera::TransitionImageLayout(
+        commandBuffer, g_Swapchain->GetDepthImage(), aspect,
+        VK_IMAGE_LAYOUT_UNDEFINED,
+        VK_IMAGE_LAYOUT_DEPTH_STENCIL_ATTACHMENT_OPTIMAL,
+        VK_PIPELINE_STAGE_EARLY_FRAGMENT_TESTS_BIT |
+            VK_PIPELINE_STAGE_LATE_FRAGMENT_TESTS_BIT,
+        VK_ACCESS_DEPTH_STENCIL_ATTACHMENT_WRITE_BIT,
+        VK_PIPELINE_STAGE_EARLY_FRAGMENT_TESTS_BIT |
+            VK_PIPELINE_STAGE_LATE_FRAGMENT_TESTS_BIT,
+        VK_ACCESS_DEPTH_STENCIL_ATTACHMENT_READ_BIT |
+            VK_ACCESS_DEPTH_STENCIL_ATTACHMENT_WRITE_BIT);
+    depth.view       = g_Swapchain->GetDepthView();
+    depth.layout     = VK_IMAGE_LAYOUT_DEPTH_STENCIL_ATTACHMENT_OPTIMAL;
+    depth.storeOp    = VK_ATTACHMENT_STORE_OP_DONT_CARE;
+    depth.clearValue = clearValues[1];
+  }
+
+  Sera::BeginRendering(commandBuffer, extent, &color, 1,
+                       HasDepthAttachment() ? &depth : nullptr,
+                       HasStencilAttachment());
 }
 
-static void CleanupVulkanWindow() {
-  ImGui_ImplVulkanH_DestroyWindow(g_Instance->instance, g_Device->device,
-                                  &g_MainWindowData, g_Allocator);
+static void EndMainPass(VkCommandBuffer commandBuffer) {
+  if (!g_UseDynamicRendering) {
+    vkCmdEndRenderPass(commandBuffer);
+    return;
+  }
+
+  Sera::EndRendering(commandBuffer);
+
+  Sera::Frame  *backbuffer = &g_Swapchain->Frames[g_Swapchain->ImageIndex];
+  VkImageLayout finalLayout =
+      g_Swapchain->IsHeadless() ? VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL
+                                : VK_IMAGE_LAYOUT_PRESENT_SRC_KHR;
+  Sera::TransitionImageLayout(
+      commandBuffer, backbuffer->Backbuffer, VK_IMAGE_ASPECT_COLOR_BIT,
+      VK_IMAGE_LAYOUT_COLOR_ATTACHMENT_OPTIMAL, finalLayout,
+      VK_PIPELINE_STAGE_COLOR_ATTACHMENT_OUTPUT_BIT,
+      VK_ACCESS_COLOR_ATTACHMENT_WRITE_BIT,
+      VK_PIPELINE_STAGE_BOTTOM_OF_PIPE_BIT, 0);
 }
 
-static void FrameRender(ImDrawData *draw_data) {
+static void FrameRender(ImDrawData *draw_data, const LayerStack &layers) {
   VkResult err;
 
   Sera::Frame *frameData = &g_Swapchain->Frames[g_Swapchain->CurrentFrame];
 
   auto image_acquired_semaphore = GetImageAcquiredSemaphore();
 
+  Sera::Timer waitTimer;
   err = vkWaitForFences(g_Device->device, 1, &frameData->Fence, VK_TRUE,
                         UINT64_MAX);
 
-  err = vkAcquireNextImageKHR(g_Device->device, g_Swapchain->Get(), UINT64_MAX,
-                              image_acquired_semaphore, VK_NULL_HANDLE,
-                              &g_Swapchain->ImageIndex);
+  err = g_Swapchain->AcquireNextImage(image_acquired_semaphore);
+  s_FrameWaitTime += waitTimer.ElapsedMillis();
   if (err == VK_ERROR_OUT_OF_DATE_KHR || err == VK_SUBOPTIMAL_KHR) {
     g_SwapChainRebuild = true;
     return;
@@ -269,6 +525,7 @@ static void FrameRender(ImDrawData *draw_data) {
     // Free resources in queue
     for (auto &func : s_ResourceFreeQueue[g_Swapchain->CurrentFrame]) func();
     s_ResourceFreeQueue[g_Swapchain->CurrentFrame].clear();
+    s_FrameDescriptors[g_Swapchain->CurrentFrame]->Reset();
   }
   {
     // Free command buffers allocated by Application::GetCommandBuffer
@@ -291,27 +548,25 @@ static void FrameRender(ImDrawData *draw_data) {
     err = vkBeginCommandBuffer(frameData->CommandBuffer, &info);
     check_vk_result(err);
   }
-  {
-    std::array<VkClearValue, 2> clearValues{};
-    clearValues[0].color = {
-        {0.0f, 0.0f, 0.0f, 1.0f}
-    };
-    clearValues[1].depthStencil   = {1.0f, 0};
-    VkRenderPassBeginInfo info    = {};
-    info.sType                    = VK_STRUCTURE_TYPE_RENDER_PASS_BEGIN_INFO;
-    info.renderPass               = g_Renderpass->GetHandle();
-    info.framebuffer              = frameData->Framebuffer;
-    info.renderArea.extent.width  = g_Swapchain->GetWidth();
-    info.renderArea.extent.height = g_Swapchain->GetHeight();
-    info.clearValueCount          = clearValues.size();
-    info.pClearValues             = clearValues.data();
-    vkCmdBeginRenderPass(frameData->CommandBuffer, &info,
-                         VK_SUBPASS_CONTENTS_INLINE);
-  }
+  g_GpuProfiler->BeginFrame(frameData->CommandBuffer,
+                            g_Swapchain->CurrentFrame, g_Swapchain->ImageCount);
+
+  uint32_t scope =
+      g_GpuProfiler->BeginScope(frameData->CommandBuffer, "Uploads");
+  Sera::Image::RecordUploads(frameData->CommandBuffer);
+  g_GpuProfiler->EndScope(frameData->CommandBuffer, scope);
+
+  scope = g_GpuProfiler->BeginScope(frameData->CommandBuffer, "OnPreRender");
+  for (auto &layer : layers) layer->OnPreRender(frameData->CommandBuffer);
+  g_GpuProfiler->EndScope(frameData->CommandBuffer, scope);
+
+  uint32_t mainPass =
+      g_GpuProfiler->BeginScope(frameData->CommandBuffer, "Main Pass");
+  BeginMainPass(frameData->CommandBuffer);
   // DRAW COMMANDS
-  {
+  if (Sera::VulkanRenderPipeline *pipeline = g_Pipeline.Get()) {
     vkCmdBindPipeline(frameData->CommandBuffer, VK_PIPELINE_BIND_POINT_GRAPHICS,
-                      g_Pipeline->GetHandle());
+                      pipeline->GetHandle());
     VkViewport viewport{};
     viewport.x        = 0.0f;
     viewport.y        = 0.0f;
@@ -327,29 +582,43 @@ static void FrameRender(ImDrawData *draw_data) {
     vkCmdSetScissor(frameData->CommandBuffer, 0, 1, &scissor);
 
     vkCmdDraw(frameData->CommandBuffer, 3, 1, 0, 0);
+    Sera::FrameStats::AddDrawCalls();
   }
 
+  scope = g_GpuProfiler->BeginScope(frameData->CommandBuffer, "OnRender");
+  for (auto &layer : layers) layer->OnRender(frameData->CommandBuffer);
+  g_GpuProfiler->EndScope(frameData->CommandBuffer, scope);
+
   // Record dear imgui primitives into command buffer
+  scope = g_GpuProfiler->BeginScope(frameData->CommandBuffer, "ImGui");
   ImGui_ImplVulkan_RenderDrawData(draw_data, frameData->CommandBuffer);
+  g_GpuProfiler->EndScope(frameData->CommandBuffer, scope);
+  for (int i = 0; i < draw_data->CmdListsCount; i++)
+    Sera::FrameStats::AddDrawCalls(draw_data->CmdLists[i]->CmdBuffer.Size);
 
   // Submit command buffer
-  vkCmdEndRenderPass(frameData->CommandBuffer);
+  EndMainPass(frameData->CommandBuffer);
+  g_GpuProfiler->EndScope(frameData->CommandBuffer, mainPass);
+  g_GpuProfiler->EndFrame(frameData->CommandBuffer);
   {
     auto render_complete_semaphore = GetRenderCompleteSemaphore();
     VkPipelineStageFlags wait_stage =
         VK_PIPELINE_STAGE_COLOR_ATTACHMENT_OUTPUT_BIT;
-    VkSubmitInfo info         = {};
-    info.sType                = VK_STRUCTURE_TYPE_SUBMIT_INFO;
-    info.waitSemaphoreCount   = 1;
-    info.pWaitSemaphores      = &image_acquired_semaphore;
-    info.pWaitDstStageMask    = &wait_stage;
-    info.commandBufferCount   = 1;
-    info.pCommandBuffers      = &frameData->CommandBuffer;
-    info.signalSemaphoreCount = 1;
-    info.pSignalSemaphores    = &render_complete_semaphore;
+    // Offscreen images are neither acquired nor presented
+    uint32_t     semaphoreCount = g_Swapchain->IsHeadless() ? 0 : 1;
+    VkSubmitInfo info           = {};
+    info.sType                  = VK_STRUCTURE_TYPE_SUBMIT_INFO;
+    info.waitSemaphoreCount     = semaphoreCount;
+    info.pWaitSemaphores        = &image_acquired_semaphore;
+    info.pWaitDstStageMask      = &wait_stage;
+    info.commandBufferCount     = 1;
+    info.pCommandBuffers        = &frameData->CommandBuffer;
+    info.signalSemaphoreCount   = semaphoreCount;
+    info.pSignalSemaphores      = &render_complete_semaphore;
 
     err = vkEndCommandBuffer(frameData->CommandBuffer);
     check_vk_result(err);
+    SR_QUEUE_DEBUG_LABEL(g_Queue, "Frame");
     err = vkQueueSubmit(g_Queue, 1, &info, frameData->Fence);
     check_vk_result(err);
   }
@@ -372,41 +641,42 @@ static void glfw_error_callback(int error, const char *description) {
   SR_CORE_ERROR("GLFW Error: {0}: {1}", error, description);
 }
 static void SetuPipeline() {
-  auto create_shader_module = [&](const std::vector<char> &code) {
-    VkShaderModuleCreateInfo ci{};
-    ci.sType              = VK_STRUCTURE_TYPE_SHADER_MODULE_CREATE_INFO;
-    ci.codeSize           = code.size();
-    ci.pCode              = reinterpret_cast<const uint32_t *>(code.data());
-    VkShaderModule module = {};
-    if (vkCreateShaderModule(g_Device->device, &ci, nullptr, &module)) {
-      SR_CORE_ERROR("Could not load Shader");
-    }
-    return module;
-  };
-  std::vector<char> vertShaderCode;
-  std::vector<char> fragShaderCode;
-
-  read_file("Assets/shaders/triangle-vert.spv", vertShaderCode);
-  read_file("Assets/shaders/triangle-frag.spv", fragShaderCode);
-
-  auto vertModule = create_shader_module(vertShaderCode);
-  auto fragModule = create_shader_module(fragShaderCode);
-
   Sera::VulkanRenderPipeline::CreateInfo info;
   info.device         = g_Device;
   info.allocator      = g_Allocator;
-  info.vertexShader   = vertModule;
-  info.fragmentShader = fragModule;
-  info.renderPass     = g_Renderpass->GetHandle();
-  g_Pipeline          = Sera::VulkanRenderPipeline::Create(info);
+  info.vertexShader   = Sera::Application::LoadShader(
+      "triangle-vert.spv", Sera::Shaders::triangle_vert,
+      std::size(Sera::Shaders::triangle_vert), VK_SHADER_STAGE_VERTEX_BIT);
+  info.fragmentShader = Sera::Application::LoadShader(
+      "triangle-frag.spv", Sera::Shaders::triangle_frag,
+      std::size(Sera::Shaders::triangle_frag), VK_SHADER_STAGE_FRAGMENT_BIT);
+  info.depthTest      = HasDepthAttachment();
+  info.depthWrite     = HasDepthAttachment();
+  if (g_UseDynamicRendering) {
+    info.colorFormats  = {g_Swapchain->SurfaceFormat.format};
+    info.depthFormat   = g_Swapchain->GetDepthFormat();
+    info.stencilFormat = HasStencilAttachment() ? info.depthFormat
+                                                : VK_FORMAT_UNDEFINED;
+  } else {
+    info.renderPass = g_Renderpass->GetHandle();
+  }
+  // Compiled in the background, the triangle is skipped until it is ready
+  g_Pipeline = g_PipelineRegistry->Get(info);
+}
 
-  vkDestroyShaderModule(g_Device->device, fragModule, nullptr);
-  vkDestroyShaderModule(g_Device->device, vertModule, nullptr);
+static void ReloadChangedShaders() {
+  if (!g_ShaderWatcher) return;
+  for (auto &path : g_ShaderWatcher->Poll()) {
+    if (std::filesystem::path(path).extension() != ".spv") continue;
+    SR_CORE_INFO("Shader {0} changed, rebuilding pipelines", path);
+    g_PipelineRegistry->ReloadShader(path);
+  }
 }
 namespace Sera {
 
   Application::Application(const ApplicationSpecification &specification)
-      : m_Specification(specification) {
+      : m_Specification(specification),
+        m_ShowFrameStats(specification.ShowFrameStats) {
     s_Instance = this;
 
     Init();
@@ -421,41 +691,68 @@ namespace Sera {
   Application &Application::Get() { return *s_Instance; }
 
   void Application::Init() {
-    // Setup GLFW window
-    glfwSetErrorCallback(glfw_error_callback);
-    if (!glfwInit()) {
-      SR_CORE_CRITICAL("Could not initialize GLFW!");
-      return;
-    }
+    SR_PROFILE_THREAD("Main");
+    g_JobSystem = new JobSystem(m_Specification.JobWorkerCount);
+
+    // Everything created with g_Allocator counts as "Other"
+    MemoryTracker::SetEnabled(m_Specification.TrackMemory);
+    g_Allocator = MemoryTracker::GetAllocationCallbacks();
+
+    if (m_Specification.Headless) {
+      SetupVulkan(nullptr, 0, true, m_Specification.DynamicRendering);
+      SetupHeadlessTarget(m_Specification.Width, m_Specification.Height,
+                          SelectDepthFormat(m_Specification.DepthAttachment));
+    } else {
+      // Setup GLFW window
+      glfwSetErrorCallback(glfw_error_callback);
+      if (!glfwInit()) {
+        SR_CORE_CRITICAL("Could not initialize GLFW!");
+        return;
+      }
 
-    glfwWindowHint(GLFW_CLIENT_API, GLFW_NO_API);
+      glfwWindowHint(GLFW_CLIENT_API, GLFW_NO_API);
 
-    // Setup Vulkan
-    if (!glfwVulkanSupported()) {
-      SR_CORE_CRITICAL("GLFW: Vulkan not supported");
-      return;
+      // Setup Vulkan
+      if (!glfwVulkanSupported()) {
+        SR_CORE_CRITICAL("GLFW: Vulkan not supported");
+        return;
+      }
+      uint32_t     extensions_count = 0;
+      const char **extensions =
+          glfwGetRequiredInstanceExtensions(&extensions_count);
+      SetupVulkan(extensions, extensions_count, false,
+                  m_Specification.DynamicRendering);
+
+      m_WindowHandle =
+          glfwCreateWindow(m_Specification.Width, m_Specification.Height,
+                           m_Specification.Name.c_str(), nullptr, nullptr);
+
+      auto err = glfwCreateWindowSurface(g_Instance->instance, m_WindowHandle,
+                                         g_Allocator, &g_Surface);
+      check_vk_result(err);
+      SetupVulkanWindow(m_Specification.Width, m_Specification.Height,
+                        SelectDepthFormat(m_Specification.DepthAttachment));
     }
-    uint32_t     extensions_count = 0;
-    const char **extensions =
-        glfwGetRequiredInstanceExtensions(&extensions_count);
-    SetupVulkan(extensions, extensions_count);
-
-    m_WindowHandle =
-        glfwCreateWindow(m_Specification.Width, m_Specification.Height,
-                         m_Specification.Name.c_str(), nullptr, nullptr);
-
-    auto err = glfwCreateWindowSurface(g_Instance->instance, m_WindowHandle,
-                                       g_Allocator, &g_Surface);
-    SetupVulkanWindow(m_Specification.Width, m_Specification.Height);
+    g_ShaderDirectory = m_Specification.ShaderDirectory.empty()
+                            ? SR_SHADER_DIR
+                            : m_Specification.ShaderDirectory;
+    SetupPipelineCache(m_Specification.PipelineCachePath);
     SetupRenderpass();
+    g_GpuProfiler = new GpuProfiler();
 
     s_AllocatedCommandBuffers.resize(g_Swapchain->ImageCount);
     s_ResourceFreeQueue.resize(g_Swapchain->ImageCount);
+    ResizeFrameDescriptors(g_Swapchain->ImageCount);
 
     VkBool32                  res;
     ImGui_ImplVulkanH_Window *wd = &g_MainWindowData;
     // Setup Dear ImGui context
     IMGUI_CHECKVERSION();
+#ifdef SR_TRACK_ALLOCATIONS
+    // ImGui allocates with malloc, not operator new
+    ImGui::SetAllocatorFunctions(AllocationTracker::Allocate,
+                                 AllocationTracker::Free);
+#endif
     ImGui::CreateContext();
     ImGuiIO &io = ImGui::GetIO();
     (void)io;
@@ -464,9 +761,10 @@ namespace Sera {
     // io.ConfigFlags |= ImGuiConfigFlags_NavEnableGamepad;      // Enable
     // Gamepad Controls
     io.ConfigFlags |= ImGuiConfigFlags_DockingEnable;  // Enable Docking
-    io.ConfigFlags |=
-        ImGuiConfigFlags_ViewportsEnable;  // Enable Multi-Viewport
-                                           // / Platform Windows
+    if (!m_Specification.Headless)
+      io.ConfigFlags |=
+          ImGuiConfigFlags_ViewportsEnable;  // Enable Multi-Viewport
+                                             // / Platform Windows
     // io.ConfigViewportsNoAutoMerge = true;
     // io.ConfigViewportsNoTaskBarIcon = true;
 
@@ -483,14 +781,22 @@ namespace Sera {
     }
 
     // Setup Platform/Renderer backends
-    ImGui_ImplGlfw_InitForVulkan(GetWindowHandle(), true);
+    if (m_Specification.Headless) {
+      // No platform backend, the display size is fixed and settings are not
+      // persisted between runs
+      io.DisplaySize = ImVec2((float)m_Specification.Width,
+                              (float)m_Specification.Height);
+      io.IniFilename = nullptr;
+    } else {
+      ImGui_ImplGlfw_InitForVulkan(GetWindowHandle(), true);
+    }
     ImGui_ImplVulkan_InitInfo init_info = {};
     init_info.Instance                  = g_Instance->instance;
     init_info.PhysicalDevice            = g_PhysicalDevice->physicalDevice;
     init_info.Device                    = g_Device->device;
     init_info.QueueFamily               = g_QueueFamily;
     init_info.Queue                     = g_Queue;
-    init_info.PipelineCache             = g_PipelineCache;
+    init_info.PipelineCache             = g_PipelineCache->GetHandle();
     init_info.DescriptorPool            = g_DescriptorPool;
     init_info.Subpass                   = 0;
     init_info.MinImageCount             = g_Swapchain->ImageCount;
@@ -498,7 +804,26 @@ namespace Sera {
     init_info.MSAASamples               = VK_SAMPLE_COUNT_1_BIT;
     init_info.Allocator                 = g_Allocator;
     init_info.CheckVkResultFn           = check_vk_result;
-    init_info.RenderPass = g_Renderpass->GetHandle();  // wd->RenderPass;
+#ifdef IMGUI_IMPL_VULKAN_HAS_DYNAMIC_RENDERING
+    // The ImGui pipeline must match the attachment formats of the main pass
+    static VkFormat colorFormat;
+    if (g_UseDynamicRendering) {
+      colorFormat                   = g_Swapchain->SurfaceFormat.format;
+      init_info.UseDynamicRendering = true;
+      init_info.PipelineRenderingCreateInfo.sType =
+          VK_STRUCTURE_TYPE_PIPELINE_RENDERING_CREATE_INFO_KHR;
+      init_info.PipelineRenderingCreateInfo.colorAttachmentCount    = 1;
+      init_info.PipelineRenderingCreateInfo.pColorAttachmentFormats =
+          &colorFormat;
+      init_info.PipelineRenderingCreateInfo.depthAttachmentFormat =
+          g_Swapchain->GetDepthFormat();
+      if (HasStencilAttachment())
+        init_info.PipelineRenderingCreateInfo.stencilAttachmentFormat =
+            g_Swapchain->GetDepthFormat();
+    }
+#endif
+    if (!g_UseDynamicRendering)
+      init_info.RenderPass = g_Renderpass->GetHandle();  // wd->RenderPass;
     ImGui_ImplVulkan_Init(&init_info);
 
     // Load default font
@@ -516,7 +841,7 @@ namespace Sera {
       VkCommandBuffer command_buffer =
           g_Swapchain->Frames[g_Swapchain->CurrentFrame].CommandBuffer;
 
-      err = vkResetCommandPool(g_Device->device, command_pool, 0);
+      VkResult err = vkResetCommandPool(g_Device->device, command_pool, 0);
       check_vk_result(err);
       VkCommandBufferBeginInfo begin_info = {};
       begin_info.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_BEGIN_INFO;
@@ -542,13 +867,29 @@ namespace Sera {
       // ImGui_ImplVulkan_DestroyFontUploadObjects();
     }
     SetuPipeline();
+
+    // Outside debug builds the default directory is the build tree of the
+    // machine that built Sera, only an explicit ShaderDirectory is watched
+#ifdef SR_DEBUG
+    bool watchShaders = m_Specification.ShaderHotReload;
+#else
+    bool watchShaders = m_Specification.ShaderHotReload &&
+                        !m_Specification.ShaderDirectory.empty();
+#endif
+    if (watchShaders && std::filesystem::is_directory(g_ShaderDirectory))
+      g_ShaderWatcher = new FileWatcher(g_ShaderDirectory);
   }
 
   void Application::Shutdown() {
+    AllocationTracker::SetSteadyState(false);
     for (auto &layer : m_LayerStack) layer->OnDetach();
 
     m_LayerStack.clear();
 
+    // Finishes the jobs still queued, they may free GPU resources
+    delete g_JobSystem;
+    g_JobSystem = nullptr;
+
     // Cleanup
     VkResult err = vkDeviceWaitIdle(g_Device->device);
     check_vk_result(err);
@@ -559,35 +900,54 @@ namespace Sera {
     }
     s_ResourceFreeQueue.clear();
 
+    delete g_GpuProfiler;
+    g_GpuProfiler = nullptr;
+
     ImGui_ImplVulkan_Shutdown();
-    ImGui_ImplGlfw_Shutdown();
+    if (!m_Specification.Headless) ImGui_ImplGlfw_Shutdown();
     ImGui::DestroyContext();
 
     CleanupVulkanWindow();
     CleanupVulkan();
 
-    glfwDestroyWindow(m_WindowHandle);
-    glfwTerminate();
+    if (!m_Specification.Headless) {
+      glfwDestroyWindow(m_WindowHandle);
+      glfwTerminate();
+    }
 
     g_ApplicationRunning = false;
   }
 
   void Application::Run() {
     m_Running = true;
+    // The first frame has no previous one to measure
+    m_TimeStep = m_Specification.FixedTimestep;
 
     ImGui_ImplVulkanH_Window *wd          = &g_MainWindowData;
     ImVec4                    clear_color = ImVec4(0.45f, 0.55f, 0.60f, 1.00f);
     ImGuiIO                  &io          = ImGui::GetIO();
 
     // Main loop
-    while (!glfwWindowShouldClose(m_WindowHandle) && m_Running) {
-      glfwPollEvents();
+    while (m_Running && (m_Specification.Headless ||
+                         !glfwWindowShouldClose(m_WindowHandle))) {
+      if (!m_Specification.Headless) glfwPollEvents();
+
+      // Frame boundary, no command buffer is being recorded
+      Profiler::MarkFrame();
+      MemoryTracker::UpdateBudget();
+      ReloadChangedShaders();
+      g_PipelineRegistry->Update(g_Swapchain->ImageCount);
+      g_JobSystem->ExecuteMainThreadJobs();
 
-      for (auto &layer : m_LayerStack) layer->OnUpdate(m_TimeStep);
+      {
+        SR_PROFILE_SCOPE("OnUpdate");
+        for (auto &layer : m_LayerStack) layer->OnUpdate(m_TimeStep);
+      }
 
       // Resize swap chain?
       if (g_SwapChainRebuild) {
-        int width, height;
+        AllowAllocations allow;
+        int              width, height;
         glfwGetFramebufferSize(m_WindowHandle, &width, &height);
         if (width > 0 && height > 0) {
           g_Device->WaitIdle();
@@ -597,7 +957,8 @@ namespace Sera {
           // Clear allocated command buffers from here since entire pool is
           // destroyed
           s_AllocatedCommandBuffers.clear();
-          s_AllocatedCommandBuffers.resize(g_MainWindowData.ImageCount);
+          s_AllocatedCommandBuffers.resize(g_Swapchain->ImageCount);
+          ResizeFrameDescriptors(g_Swapchain->ImageCount);
 
           g_SwapChainRebuild = false;
         }
@@ -605,7 +966,13 @@ namespace Sera {
 
       // Start the Dear ImGui frame
       ImGui_ImplVulkan_NewFrame();
-      ImGui_ImplGlfw_NewFrame();
+      if (m_Specification.Headless) {
+        io.DisplaySize = ImVec2((float)m_Specification.Width,
+                                (float)m_Specification.Height);
+        io.DeltaTime   = m_TimeStep > 0.0f ? m_TimeStep : 1.0f / 60.0f;
+      } else {
+        ImGui_ImplGlfw_NewFrame();
+      }
       ImGui::NewFrame();
 
       {
@@ -662,10 +1029,14 @@ namespace Sera {
           }
         }
 
-        for (auto &layer : m_LayerStack) layer->OnUIRender();
+        {
+          SR_PROFILE_SCOPE("OnUIRender");
+          for (auto &layer : m_LayerStack) layer->OnUIRender();
+        }
 
         ImGui::End();
       }
+      if (m_ShowFrameStats) FrameStats::ShowOverlay(&m_ShowFrameStats);
 
       // Rendering
       ImGui::Render();
@@ -676,7 +1047,10 @@ namespace Sera {
       wd->ClearValue.color.float32[1] = clear_color.y * clear_color.w;
       wd->ClearValue.color.float32[2] = clear_color.z * clear_color.w;
       wd->ClearValue.color.float32[3] = clear_color.w;
-      if (!main_is_minimized) FrameRender(main_draw_data);
+      if (!main_is_minimized) {
+        SR_PROFILE_SCOPE("FrameRender");
+        FrameRender(main_draw_data, m_LayerStack);
+      }
 
       // Update and Render additional Platform Windows
       if (io.ConfigFlags & ImGuiConfigFlags_ViewportsEnable) {
@@ -685,18 +1059,48 @@ namespace Sera {
       }
 
       // Present Main Platform Window
-      if (!main_is_minimized) FramePresent(wd);
+      if (!main_is_minimized) {
+        SR_PROFILE_SCOPE("FramePresent");
+        Timer presentTimer;
+        FramePresent(wd);
+        s_FrameWaitTime += presentTimer.ElapsedMillis();
+      }
 
       float time      = GetTime();
       m_FrameTime     = time - m_LastFrameTime;
-      m_TimeStep      = glm::min<float>(m_FrameTime, 0.0333f);
+      m_TimeStep      = m_Specification.FixedTimestep > 0.0f
+                            ? m_Specification.FixedTimestep
+                            : glm::min<float>(m_FrameTime, 0.0333f);
       m_LastFrameTime = time;
+
+      float frameTime = m_FrameTime * 1000.0f;
+      AllocationTracker::MarkFrame();
+      FrameStats::Record(frameTime,
+                         glm::max(frameTime - s_FrameWaitTime, 0.0f),
+                         g_GpuProfiler->GetLastFrame().time);
+      s_FrameWaitTime = 0.0f;
+
+      if (time - m_LastCacheSaveTime > s_PipelineCacheSaveInterval) {
+        g_PipelineCache->SaveIfGrown();
+        m_LastCacheSaveTime = time;
+      }
+
+      m_FrameIndex++;
+      if (m_Specification.FrameCount != 0 &&
+          m_FrameIndex >= m_Specification.FrameCount)
+        m_Running = false;
+      if (m_Specification.SteadyStateFrame != 0 &&
+          m_FrameIndex == m_Specification.SteadyStateFrame)
+        AllocationTracker::SetSteadyState(true);
     }
   }
 
   void Application::Close() { m_Running = false; }
 
-  float Application::GetTime() { return (float)glfwGetTime(); }
+  float Application::GetTime() {
+    if (m_Specification.Headless) return m_HeadlessTimer.Elapsed();
+    return (float)glfwGetTime();
+  }
 
   VkInstance Application::GetInstance() { return g_Instance->instance; }
 
@@ -706,11 +1110,89 @@ namespace Sera {
 
   VkDevice Application::GetDevice() { return g_Device->device; }
 
-  VkCommandBuffer Application::GetCommandBuffer(bool begin) {
-    ImGui_ImplVulkanH_Window *wd = &g_MainWindowData;
+  VkPipelineCache Application::GetPipelineCache() {
+    return g_PipelineCache->GetHandle();
+  }
+
+  VulkanPipelineRegistry *Application::GetPipelineRegistry() {
+    return g_PipelineRegistry;
+  }
+
+  VulkanLayoutCache *Application::GetLayoutCache() { return g_LayoutCache; }
 
+  VulkanDevice *Application::GetVulkanDevice() { return g_Device; }
+
+  VulkanPipelineCache *Application::GetVulkanPipelineCache() {
+    return g_PipelineCache;
+  }
+
+  JobSystem &Application::GetJobSystem() { return *g_JobSystem; }
+
+  GpuProfiler &Application::GetGpuProfiler() { return *g_GpuProfiler; }
+
+  bool Application::IsDebugBuild() {
+#ifdef SR_DEBUG
+    return true;
+#else
+    return false;
+#endif
+  }
+
+  bool Application::IsDynamicRenderingEnabled() {
+    return g_UseDynamicRendering;
+  }
+
+  VkRenderPass Application::GetRenderPass() {
+    return g_Renderpass ? g_Renderpass->GetHandle() : VK_NULL_HANDLE;
+  }
+
+  VkFormat Application::GetColorFormat() {
+    return g_Swapchain->SurfaceFormat.format;
+  }
+
+  VkFormat Application::GetDepthFormat() {
+    return g_Swapchain->GetDepthFormat();
+  }
+
+  VkFormat Application::GetStencilFormat() {
+    return HasStencilAttachment() ? g_Swapchain->GetDepthFormat()
+                                  : VK_FORMAT_UNDEFINED;
+  }
+
+  VkExtent2D Application::GetFramebufferExtent() {
+    return {(uint32_t)g_Swapchain->GetWidth(),
+            (uint32_t)g_Swapchain->GetHeight()};
+  }
+
+  // Shaders are embedded at build time. With SR_SHADER_DISK_OVERRIDE the .spv
+  // in the shader directory wins when it exists, the path is kept either way
+  // so hot reload finds the shader.
+  std::shared_ptr<VulkanShader> Application::LoadShader(
+      const char *name, const uint32_t *spirv, size_t wordCount,
+      VkShaderStageFlagBits stage) {
+    VulkanShader::CreateInfo info{};
+    info.device    = g_Device;
+    info.allocator = g_Allocator;
+    info.stage     = stage;
+    info.path = (std::filesystem::path(g_ShaderDirectory) / name).string();
+#ifdef SR_SHADER_DISK_OVERRIDE
+    if (!std::filesystem::exists(info.path) ||
+        !VulkanShader::ReadSpirv(info.path, info.code))
+#endif
+      info.code.assign(spirv, spirv + wordCount);
+    return std::shared_ptr<VulkanShader>(VulkanShader::Create(info));
+  }
+
+  uint32_t Application::GetFramesInFlight() { return g_Swapchain->ImageCount; }
+
+  uint32_t Application::GetCurrentFrameInFlight() {
+    return g_Swapchain->CurrentFrame;
+  }
+
+  VkCommandBuffer Application::GetCommandBuffer(bool begin) {
     // Use any command queue
-    VkCommandPool command_pool = wd->Frames[wd->FrameIndex].CommandPool;
+    VkCommandPool command_pool =
+        g_Swapchain->Frames[g_Swapchain->CurrentFrame].CommandPool;
 
     VkCommandBufferAllocateInfo cmdBufAllocateInfo = {};
     cmdBufAllocateInfo.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_ALLOCATE_INFO;
@@ -723,6 +1205,12 @@ namespace Sera {
          command_buffer;  //= s_AllocatedCommandBuffers[wd->FrameIndex];
     auto err = vkAllocateCommandBuffers(g_Device->device, &cmdBufAllocateInfo,
                                         &command_buffer);
+    check_vk_result(err);
+    // Freed once the frame that owns the pool comes around again
+    s_AllocatedCommandBuffers[g_Swapchain->CurrentFrame].push_back(
+        command_buffer);
+    SR_DEBUG_NAME(g_Device->device, VK_OBJECT_TYPE_COMMAND_BUFFER,
+                  command_buffer, "Upload");
 
     VkCommandBufferBeginInfo begin_info = {};
     begin_info.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_BEGIN_INFO;
@@ -734,6 +1222,8 @@ namespace Sera {
   }
 
   void Application::FlushCommandBuffer(VkCommandBuffer commandBuffer) {
+    // Waits for the GPU, so uploads show up in the CPU timeline
+    SR_PROFILE_FUNCTION();
     const uint64_t DEFAULT_FENCE_TIMEOUT = 100000000000;
 
     VkSubmitInfo end_info       = {};
@@ -748,9 +1238,11 @@ namespace Sera {
     fenceCreateInfo.sType             = VK_STRUCTURE_TYPE_FENCE_CREATE_INFO;
     fenceCreateInfo.flags             = 0;
     VkFence fence;
-    err = vkCreateFence(g_Device->device, &fenceCreateInfo, nullptr, &fence);
+    err = vkCreateFence(g_Device->device, &fenceCreateInfo, g_Allocator,
+                        &fence);
     check_vk_result(err);
 
+    SR_QUEUE_DEBUG_LABEL(g_Queue, "Upload");
     err = vkQueueSubmit(g_Queue, 1, &end_info, fence);
     check_vk_result(err);
 
@@ -758,7 +1250,12 @@ namespace Sera {
                           DEFAULT_FENCE_TIMEOUT);
     check_vk_result(err);
 
-    vkDestroyFence(g_Device->device, fence, nullptr);
+    vkDestroyFence(g_Device->device, fence, g_Allocator);
+  }
+
+  VkDescriptorSet Application::AllocateFrameDescriptorSet(
+      VkDescriptorSetLayout layout) {
+    return s_FrameDescriptors[g_Swapchain->CurrentFrame]->Allocate(layout);
   }
 
   void Application::SubmitResourceFree(std::function<void()> &&func) {
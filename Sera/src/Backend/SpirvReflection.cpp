@@ -0,0 +1,456 @@
+#include "Backend/SpirvReflection.h"
+#include <algorithm>
+#include <unordered_map>
+namespace Sera {
+  // Subset of the SPIR-V grammar the reflection needs, values from the
+  // SPIR-V specification
+  namespace Spv {
+    enum Op : uint32_t {
+      EntryPoint          = 15,
+      ExecutionMode       = 16,
+      TypeBool            = 20,
+      TypeInt             = 21,
+      TypeFloat           = 22,
+      TypeVector          = 23,
+      TypeMatrix          = 24,
+      TypeImage           = 25,
+      TypeSampler         = 26,
+      TypeSampledImage    = 27,
+      TypeArray           = 28,
+      TypeRuntimeArray    = 29,
+      TypeStruct          = 30,
+      TypePointer         = 32,
+      Constant            = 43,
+      SpecConstantTrue    = 48,
+      SpecConstantFalse   = 49,
+      SpecConstant        = 50,
+      Variable            = 59,
+      Decorate            = 71,
+      MemberDecorate      = 72,
+      TypeAccelerationKHR = 5341,
+    };
+    enum Decoration : uint32_t {
+      SpecId        = 1,
+      Block         = 2,
+      BufferBlock   = 3,
+      ArrayStride   = 6,
+      MatrixStride  = 7,
+      BuiltIn       = 11,
+      Location      = 30,
+      Binding       = 33,
+      DescriptorSet = 34,
+      Offset        = 35,
+    };
+    enum StorageClass : uint32_t {
+      UniformConstant = 0,
+      Input           = 1,
+      Uniform         = 2,
+      PushConstant    = 9,
+      StorageBuffer   = 12,
+    };
+    enum ExecutionModel : uint32_t {
+      Vertex                 = 0,
+      TessellationControl    = 1,
+      TessellationEvaluation = 2,
+      Geometry               = 3,
+      Fragment               = 4,
+      GLCompute              = 5,
+    };
+    constexpr uint32_t LocalSize  = 17;
+    constexpr uint32_t DimBuffer  = 5;
+    constexpr uint32_t DimSubpass = 6;
+  }  // namespace Spv
+
+  struct SpirvId {
+      uint32_t opcode = 0;
+      // Operands after the result id, or after the result type for values
+      std::vector<uint32_t> operands;
+      uint32_t              resultType = 0;
+      // Decorations
+      uint32_t set         = UINT32_MAX;
+      uint32_t binding     = UINT32_MAX;
+      uint32_t location    = UINT32_MAX;
+      uint32_t specId      = UINT32_MAX;
+      uint32_t arrayStride = 0;
+      bool     builtIn     = false;
+      bool     bufferBlock = false;
+      // Per struct member
+      std::vector<uint32_t> memberOffsets;
+      std::vector<uint32_t> memberMatrixStrides;
+  };
+
+  using SpirvIds = std::unordered_map<uint32_t, SpirvId>;
+
+  // Types referenced before their definition or not at all are treated as
+  // malformed input
+  static const SpirvId* Find(const SpirvIds& ids, uint32_t id) {
+    auto it = ids.find(id);
+    if (it == ids.end() || it->second.opcode == 0) return nullptr;
+    return &it->second;
+  }
+
+  // Operands after the result id a type needs, the ones TypeSize(),
+  // ToVertexFormat() and ToDescriptorType() read
+  static uint32_t MinTypeOperands(uint32_t opcode) {
+    switch (opcode) {
+      case Spv::TypeFloat:
+      case Spv::TypeSampledImage:
+      case Spv::TypeRuntimeArray:
+        return 1;
+      case Spv::TypeInt:
+      case Spv::TypeVector:
+      case Spv::TypeMatrix:
+      case Spv::TypeArray:
+      case Spv::TypePointer:
+        return 2;
+      case Spv::TypeImage:
+        // Sampled type, dim, depth, arrayed, multisampled, sampled, format
+        return 7;
+    }
+    return 0;
+  }
+
+  static VkShaderStageFlagBits ToStage(uint32_t model) {
+    switch (model) {
+      case Spv::Vertex:
+        return VK_SHADER_STAGE_VERTEX_BIT;
+      case Spv::TessellationControl:
+        return VK_SHADER_STAGE_TESSELLATION_CONTROL_BIT;
+      case Spv::TessellationEvaluation:
+        return VK_SHADER_STAGE_TESSELLATION_EVALUATION_BIT;
+      case Spv::Geometry:
+        return VK_SHADER_STAGE_GEOMETRY_BIT;
+      case Spv::Fragment:
+        return VK_SHADER_STAGE_FRAGMENT_BIT;
+      case Spv::GLCompute:
+        return VK_SHADER_STAGE_COMPUTE_BIT;
+    }
+    return VK_SHADER_STAGE_ALL;
+  }
+
+  static uint32_t ConstantValue(const SpirvIds& ids, uint32_t id) {
+    const SpirvId* constant = Find(ids, id);
+    if (!constant || constant->operands.empty()) return 1;
+    return constant->operands[0];
+  }
+
+  // Size of a type in a std140/std430 block, using the strides the compiler
+  // decorated the block with
+  static uint32_t TypeSize(const SpirvIds& ids, uint32_t typeId) {
+    const SpirvId* found = Find(ids, typeId);
+    if (!found) return 0;
+    const SpirvId& type = *found;
+    switch (type.opcode) {
+      case Spv::TypeBool:
+        return 4;
+      case Spv::TypeInt:
+      case Spv::TypeFloat:
+        return type.operands[0] / 8;
+      case Spv::TypeVector:
+        return TypeSize(ids, type.operands[0]) * type.operands[1];
+      case Spv::TypeMatrix:
+        return TypeSize(ids, type.operands[0]) * type.operands[1];
+      case Spv::TypeArray: {
+        uint32_t length = ConstantValue(ids, type.operands[1]);
+        uint32_t stride = type.arrayStride ? type.arrayStride
+                                           : TypeSize(ids, type.operands[0]);
+        return stride * length;
+      }
+      case Spv::TypeRuntimeArray:
+        return 0;
+      case Spv::TypeStruct: {
+        uint32_t size = 0;
+        for (size_t i = 0; i < type.operands.size(); i++) {
+          uint32_t offset =
+              i < type.memberOffsets.size() ? type.memberOffsets[i] : size;
+          uint32_t       memberSize = TypeSize(ids, type.operands[i]);
+          const SpirvId* member     = Find(ids, type.operands[i]);
+          // Column stride may be larger than the packed column
+          if (member && member->opcode == Spv::TypeMatrix &&
+              i < type.memberMatrixStrides.size() &&
+              type.memberMatrixStrides[i] != 0)
+            memberSize = type.memberMatrixStrides[i] * member->operands[1];
+          size = std::max(size, offset + memberSize);
+        }
+        return size;
+      }
+    }
+    return 0;
+  }
+
+  static VkFormat ToVertexFormat(const SpirvIds& ids, uint32_t typeId,
+                                 uint32_t& size) {
+    const SpirvId* type = Find(ids, typeId);
+    if (!type) return VK_FORMAT_UNDEFINED;
+
+    uint32_t       components = 1;
+    const SpirvId* scalar     = type;
+    if (type->opcode == Spv::TypeVector) {
+      scalar     = Find(ids, type->operands[0]);
+      components = type->operands[1];
+    }
+    if (!scalar || scalar->operands.empty() || scalar->operands[0] != 32)
+      return VK_FORMAT_UNDEFINED;
+    size = 4 * components;
+
+    static const VkFormat floats[] = {
+        VK_FORMAT_R32_SFLOAT, VK_FORMAT_R32G32_SFLOAT,
+        VK_FORMAT_R32G32B32_SFLOAT, VK_FORMAT_R32G32B32A32_SFLOAT};
+    static const VkFormat sints[]  = {
+        VK_FORMAT_R32_SINT, VK_FORMAT_R32G32_SINT, VK_FORMAT_R32G32B32_SINT,
+        VK_FORMAT_R32G32B32A32_SINT};
+    static const VkFormat uints[]  = {
+        VK_FORMAT_R32_UINT, VK_FORMAT_R32G32_UINT, VK_FORMAT_R32G32B32_UINT,
+        VK_FORMAT_R32G32B32A32_UINT};
+    if (components < 1 || components > 4) return VK_FORMAT_UNDEFINED;
+    if (scalar->opcode == Spv::TypeFloat) return floats[components - 1];
+    if (scalar->opcode == Spv::TypeInt && scalar->operands.size() > 1)
+      return scalar->operands[1] ? sints[components - 1]
+                                 : uints[components - 1];
+    return VK_FORMAT_UNDEFINED;
+  }
+
+  static VkDescriptorType ToDescriptorType(const SpirvIds& ids,
+                                           uint32_t        storageClass,
+                                           uint32_t typeId, uint32_t& count) {
+    // Arrays of resources become descriptor counts
+    count               = 1;
+    const SpirvId* type = Find(ids, typeId);
+    while (type && (type->opcode == Spv::TypeArray ||
+                    type->opcode == Spv::TypeRuntimeArray)) {
+      if (type->opcode == Spv::TypeArray)
+        count *= ConstantValue(ids, type->operands[1]);
+      type = Find(ids, type->operands[0]);
+    }
+    if (!type) return VK_DESCRIPTOR_TYPE_MAX_ENUM;
+
+    switch (storageClass) {
+      case Spv::Uniform:
+        return type->bufferBlock ? VK_DESCRIPTOR_TYPE_STORAGE_BUFFER
+                                 : VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER;
+      case Spv::StorageBuffer:
+        return VK_DESCRIPTOR_TYPE_STORAGE_BUFFER;
+      case Spv::UniformConstant:
+        break;
+      default:
+        return VK_DESCRIPTOR_TYPE_MAX_ENUM;
+    }
+
+    switch (type->opcode) {
+      case Spv::TypeSampler:
+        return VK_DESCRIPTOR_TYPE_SAMPLER;
+      case Spv::TypeSampledImage:
+        return VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER;
+      case Spv::TypeAccelerationKHR:
+        return VK_DESCRIPTOR_TYPE_ACCELERATION_STRUCTURE_KHR;
+      case Spv::TypeImage: {
+        uint32_t dim     = type->operands[1];
+        uint32_t sampled = type->operands[5];
+        if (dim == Spv::DimSubpass) return VK_DESCRIPTOR_TYPE_INPUT_ATTACHMENT;
+        if (dim == Spv::DimBuffer)
+          return sampled == 2 ? VK_DESCRIPTOR_TYPE_STORAGE_TEXEL_BUFFER
+                              : VK_DESCRIPTOR_TYPE_UNIFORM_TEXEL_BUFFER;
+        return sampled == 2 ? VK_DESCRIPTOR_TYPE_STORAGE_IMAGE
+                            : VK_DESCRIPTOR_TYPE_SAMPLED_IMAGE;
+      }
+    }
+    return VK_DESCRIPTOR_TYPE_MAX_ENUM;
+  }
+
+  bool ReflectSpirv(const std::vector<uint32_t>& code,
+                    SpirvReflection&             reflection) {
+    constexpr uint32_t headerWords = 5;
+    if (code.size() < headerWords || code[0] != 0x07230203) return false;
+
+    SpirvIds              ids;
+    std::vector<uint32_t> variables;
+    std::vector<uint32_t> specConstants;
+
+    for (size_t i = headerWords; i < code.size();) {
+      uint32_t wordCount = code[i] >> 16;
+      uint32_t opcode    = code[i] & 0xFFFF;
+      if (wordCount == 0 || i + wordCount > code.size()) return false;
+      const uint32_t* args     = &code[i + 1];
+      uint32_t        argCount = wordCount - 1;
+      i += wordCount;
+
+      switch (opcode) {
+        case Spv::EntryPoint:
+          if (argCount < 1) return false;
+          // Only the first entry point is reflected
+          if (reflection.stage == VK_SHADER_STAGE_ALL)
+            reflection.stage = ToStage(args[0]);
+          break;
+        case Spv::ExecutionMode:
+          if (argCount >= 5 && args[1] == Spv::LocalSize) {
+            reflection.localSize[0] = args[2];
+            reflection.localSize[1] = args[3];
+            reflection.localSize[2] = args[4];
+          }
+          break;
+        case Spv::Decorate: {
+          if (argCount < 2) break;
+          SpirvId& target = ids[args[0]];
+          uint32_t value  = argCount > 2 ? args[2] : 0;
+          switch (args[1]) {
+            case Spv::DescriptorSet:
+              target.set = value;
+              break;
+            case Spv::Binding:
+              target.binding = value;
+              break;
+            case Spv::Location:
+              target.location = value;
+              break;
+            case Spv::SpecId:
+              target.specId = value;
+              break;
+            case Spv::ArrayStride:
+              target.arrayStride = value;
+              break;
+            case Spv::BuiltIn:
+              target.builtIn = true;
+              break;
+            case Spv::BufferBlock:
+              target.bufferBlock = true;
+              break;
+          }
+          break;
+        }
+        case Spv::MemberDecorate: {
+          if (argCount < 4) break;
+          SpirvId& target = ids[args[0]];
+          uint32_t member = args[1];
+          if (args[2] == Spv::BuiltIn) target.builtIn = true;
+          std::vector<uint32_t>* values = nullptr;
+          if (args[2] == Spv::Offset) values = &target.memberOffsets;
+          if (args[2] == Spv::MatrixStride)
+            values = &target.memberMatrixStrides;
+          if (!values) break;
+          if (values->size() <= member) values->resize(member + 1, 0);
+          (*values)[member] = args[3];
+          break;
+        }
+        case Spv::TypeBool:
+        case Spv::TypeInt:
+        case Spv::TypeFloat:
+        case Spv::TypeVector:
+        case Spv::TypeMatrix:
+        case Spv::TypeImage:
+        case Spv::TypeSampler:
+        case Spv::TypeSampledImage:
+        case Spv::TypeArray:
+        case Spv::TypeRuntimeArray:
+        case Spv::TypeStruct:
+        case Spv::TypePointer:
+        case Spv::TypeAccelerationKHR: {
+          if (argCount < 1 || argCount - 1 < MinTypeOperands(opcode))
+            return false;
+          SpirvId& type = ids[args[0]];
+          type.opcode   = opcode;
+          type.operands.assign(args + 1, args + argCount);
+          break;
+        }
+        case Spv::Constant:
+        case Spv::SpecConstantTrue:
+        case Spv::SpecConstantFalse:
+        case Spv::SpecConstant:
+        case Spv::Variable: {
+          if (argCount < 2) break;
+          SpirvId& value   = ids[args[1]];
+          value.opcode     = opcode;
+          value.resultType = args[0];
+          value.operands.assign(args + 2, args + argCount);
+          if (opcode == Spv::Variable) variables.push_back(args[1]);
+          if (opcode != Spv::Constant && opcode != Spv::Variable)
+            specConstants.push_back(args[1]);
+          break;
+        }
+      }
+    }
+
+    for (uint32_t id : variables) {
+      const SpirvId& variable = ids[id];
+      if (variable.operands.empty()) continue;
+      uint32_t storageClass = variable.operands[0];
+
+      const SpirvId* pointer = Find(ids, variable.resultType);
+      if (!pointer || pointer->opcode != Spv::TypePointer ||
+          pointer->operands.size() < 2)
+        return false;
+      uint32_t       typeId = pointer->operands[1];
+      const SpirvId* type   = Find(ids, typeId);
+      if (!type) return false;
+
+      if (storageClass == Spv::PushConstant) {
+        reflection.pushConstantSize =
+            std::max(reflection.pushConstantSize, TypeSize(ids, typeId));
+        continue;
+      }
+
+      if (storageClass == Spv::Input) {
+        if (reflection.stage != VK_SHADER_STAGE_VERTEX_BIT) continue;
+        if (variable.builtIn || type->builtIn) continue;
+        if (variable.location == UINT32_MAX) continue;
+        // A matrix takes one location per column
+        uint32_t columns = 1;
+        if (type->opcode == Spv::TypeMatrix) {
+          columns = type->operands[1];
+          typeId  = type->operands[0];
+        }
+        for (uint32_t column = 0; column < columns; column++) {
+          SpirvReflection::VertexInput input;
+          input.location = variable.location + column;
+          input.format   = ToVertexFormat(ids, typeId, input.size);
+          reflection.vertexInputs.push_back(input);
+        }
+        continue;
+      }
+
+      if (variable.set == UINT32_MAX || variable.binding == UINT32_MAX)
+        continue;
+      SpirvReflection::Binding binding;
+      binding.set     = variable.set;
+      binding.binding = variable.binding;
+      binding.type =
+          ToDescriptorType(ids, storageClass, typeId, binding.count);
+      if (binding.type == VK_DESCRIPTOR_TYPE_MAX_ENUM) continue;
+      reflection.bindings.push_back(binding);
+    }
+
+    for (uint32_t id : specConstants) {
+      const SpirvId& constant = ids[id];
+      // Without a SpecId the constant cannot be set through the API
+      if (constant.specId == UINT32_MAX) continue;
+      const SpirvId* type = Find(ids, constant.resultType);
+      if (!type) return false;
+      SpirvReflection::SpecConstant spec;
+      spec.id = constant.specId;
+      if (type->opcode == Spv::TypeBool)
+        spec.type = SpecializationType::Bool;
+      else if (type->operands.empty() || type->operands[0] != 32)
+        continue;
+      else if (type->opcode == Spv::TypeFloat)
+        spec.type = SpecializationType::Float;
+      else if (type->opcode == Spv::TypeInt && type->operands.size() > 1)
+        spec.type = type->operands[1] ? SpecializationType::Int
+                                      : SpecializationType::UInt;
+      else
+        continue;
+      reflection.specConstants.push_back(spec);
+    }
+
+    std::sort(reflection.specConstants.begin(),
+              reflection.specConstants.end(),
+              [](const auto& a, const auto& b) { return a.id < b.id; });
+    std::sort(reflection.vertexInputs.begin(), reflection.vertexInputs.end(),
+              [](const auto& a, const auto& b) {
+                return a.location < b.location;
+              });
+    std::sort(reflection.bindings.begin(), reflection.bindings.end(),
+              [](const auto& a, const auto& b) {
+                return a.set != b.set ? a.set < b.set : a.binding < b.binding;
+              });
+    return true;
+  }
+}  // namespace Sera
@@ -0,0 +1,76 @@
+#include "Backend/VulkanComputePipeline.h"
+#include "Backend/VulkanDebug.h"
+#include "Backend/VulkanDevice.h"
+#include "Backend/VulkanPipelineCache.h"
+#include "Backend/VulkanShader.h"
+#include "Log.h"
+#include "Timer.h"
+namespace Sera {
+
+  VulkanComputePipeline* VulkanComputePipeline::Create(CreateInfo info) {
+    return new VulkanComputePipeline(info);
+  }
+
+  VulkanComputePipeline::~VulkanComputePipeline() {
+    // The layout belongs to the layout cache
+    vkDestroyPipeline(m_Info.device->device, m_Handle, m_Info.allocator);
+  }
+
+  const uint32_t* VulkanComputePipeline::GetLocalSize() const {
+    return m_Info.shader->GetReflection().localSize;
+  }
+
+  VulkanComputePipeline::VulkanComputePipeline(CreateInfo info)
+      : m_Info(info) {
+    VulkanLayoutCache* layoutCache = m_Info.layoutCache;
+    if (!layoutCache) {
+      m_OwnedLayoutCache.reset(
+          VulkanLayoutCache::Create({m_Info.device, m_Info.allocator}));
+      layoutCache = m_OwnedLayoutCache.get();
+    }
+    m_Layout = layoutCache->GetLayout({&m_Info.shader->GetReflection()});
+    if (m_Layout.layout == VK_NULL_HANDLE) {
+      m_Result = VK_ERROR_INITIALIZATION_FAILED;
+      return;
+    }
+
+    m_Info.shader->CheckSpecialization(m_Info.specialization);
+    std::vector<VkSpecializationMapEntry> specializationEntries;
+    VkSpecializationInfo                  specialization =
+        m_Info.specialization.GetInfo(specializationEntries);
+
+    VkComputePipelineCreateInfo pipelineInfo{};
+    pipelineInfo.sType  = VK_STRUCTURE_TYPE_COMPUTE_PIPELINE_CREATE_INFO;
+    pipelineInfo.flags  = m_Info.flags;
+    pipelineInfo.layout = m_Layout.layout;
+    pipelineInfo.stage.sType =
+        VK_STRUCTURE_TYPE_PIPELINE_SHADER_STAGE_CREATE_INFO;
+    pipelineInfo.stage.stage  = VK_SHADER_STAGE_COMPUTE_BIT;
+    pipelineInfo.stage.module = m_Info.shader->GetHandle();
+    pipelineInfo.stage.pName  = m_Info.shader->GetEntryPoint().c_str();
+    if (!m_Info.specialization.IsEmpty())
+      pipelineInfo.stage.pSpecializationInfo = &specialization;
+
+    VkPipelineCache               cache = VK_NULL_HANDLE;
+    VulkanPipelineCache::Feedback feedback;
+    if (m_Info.pipelineCache) {
+      cache = m_Info.pipelineCache->GetHandle();
+      m_Info.pipelineCache->Attach(feedback, &pipelineInfo.pNext);
+    }
+
+    Timer timer;
+    m_Result = vkCreateComputePipelines(m_Info.device->device, cache, 1,
+                                        &pipelineInfo, m_Info.allocator,
+                                        &m_Handle);
+    if (m_Result == VK_PIPELINE_COMPILE_REQUIRED) return;
+    if (m_Result != VK_SUCCESS) {
+      SR_CORE_ERROR("Failed to create compute pipeline {0}",
+                    m_Info.shader->GetPath());
+      return;
+    }
+    SR_DEBUG_NAME(m_Info.device->device, VK_OBJECT_TYPE_PIPELINE, m_Handle,
+                  m_Info.shader->GetPath().c_str());
+    if (m_Info.pipelineCache)
+      m_Info.pipelineCache->Record(feedback, timer.ElapsedMillis());
+  }
+}  // namespace Sera
@@ -11,6 +11,8 @@ namespace Sera {
   PFN_vkQueueBeginDebugUtilsLabelEXT  QueueBeginDebugUtilsLabelEXT  = nullptr;
   PFN_vkQueueEndDebugUtilsLabelEXT    QueueEndDebugUtilsLabelEXT    = nullptr;
   PFN_vkQueueInsertDebugUtilsLabelEXT QueueInsertDebugUtilsLabelEXT = nullptr;
+  PFN_vkCmdBeginDebugUtilsLabelEXT    CmdBeginDebugUtilsLabelEXT    = nullptr;
+  PFN_vkCmdEndDebugUtilsLabelEXT      CmdEndDebugUtilsLabelEXT      = nullptr;
 
   VkDebugUtilsMessengerEXT DbgMessenger = VK_NULL_HANDLE;
 
@@ -134,6 +136,13 @@ namespace Sera {
         reinterpret_cast<PFN_vkQueueInsertDebugUtilsLabelEXT>(
             vkGetInstanceProcAddr(instance, "vkQueueInsertDebugUtilsLabelEXT"));
     assert(QueueInsertDebugUtilsLabelEXT != nullptr);
+    CmdBeginDebugUtilsLabelEXT =
+        reinterpret_cast<PFN_vkCmdBeginDebugUtilsLabelEXT>(
+            vkGetInstanceProcAddr(instance, "vkCmdBeginDebugUtilsLabelEXT"));
+    assert(CmdBeginDebugUtilsLabelEXT != nullptr);
+    CmdEndDebugUtilsLabelEXT = reinterpret_cast<PFN_vkCmdEndDebugUtilsLabelEXT>(
+        vkGetInstanceProcAddr(instance, "vkCmdEndDebugUtilsLabelEXT"));
+    assert(CmdEndDebugUtilsLabelEXT != nullptr);
 
     return err == VK_SUCCESS;
   }
@@ -143,6 +152,42 @@ namespace Sera {
       DestroyDebugUtilsMessengerEXT(instance, DbgMessenger, nullptr);
     }
   }
+
+  void SetObjectName(VkDevice device, VkObjectType type, uint64_t handle,
+                     const char* name) {
+    if (!SetDebugUtilsObjectNameEXT || !handle) return;
+    VkDebugUtilsObjectNameInfoEXT info{};
+    info.sType        = VK_STRUCTURE_TYPE_DEBUG_UTILS_OBJECT_NAME_INFO_EXT;
+    info.objectType   = type;
+    info.objectHandle = handle;
+    info.pObjectName  = name;
+    SetDebugUtilsObjectNameEXT(device, &info);
+  }
+
+  void BeginDebugLabel(VkCommandBuffer commandBuffer, const char* name) {
+    if (!CmdBeginDebugUtilsLabelEXT) return;
+    VkDebugUtilsLabelEXT label{};
+    label.sType      = VK_STRUCTURE_TYPE_DEBUG_UTILS_LABEL_EXT;
+    label.pLabelName = name;
+    CmdBeginDebugUtilsLabelEXT(commandBuffer, &label);
+  }
+
+  void EndDebugLabel(VkCommandBuffer commandBuffer) {
+    if (CmdEndDebugUtilsLabelEXT) CmdEndDebugUtilsLabelEXT(commandBuffer);
+  }
+
+  void BeginQueueDebugLabel(VkQueue queue, const char* name) {
+    if (!QueueBeginDebugUtilsLabelEXT) return;
+    VkDebugUtilsLabelEXT label{};
+    label.sType      = VK_STRUCTURE_TYPE_DEBUG_UTILS_LABEL_EXT;
+    label.pLabelName = name;
+    QueueBeginDebugUtilsLabelEXT(queue, &label);
+  }
+
+  void EndQueueDebugLabel(VkQueue queue) {
+    if (QueueEndDebugUtilsLabelEXT) QueueEndDebugUtilsLabelEXT(queue);
+  }
+
   const char* VkObjectTypeToString(VkObjectType ObjectType) {
     switch (ObjectType) {
         // clang-format off
@@ -0,0 +1,84 @@
+#include "Backend/VulkanDescriptorAllocator.h"
+#include "Backend/VulkanDevice.h"
+#include "Log.h"
+namespace Sera {
+  // Descriptors per set and type, most transient sets bind a handful of
+  // images and buffers
+  static constexpr struct {
+      VkDescriptorType type;
+      uint32_t         perSet;
+  } s_PoolRatios[] = {
+      {VK_DESCRIPTOR_TYPE_SAMPLER, 1},
+      {VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER, 4},
+      {VK_DESCRIPTOR_TYPE_SAMPLED_IMAGE, 2},
+      {VK_DESCRIPTOR_TYPE_STORAGE_IMAGE, 4},
+      {VK_DESCRIPTOR_TYPE_UNIFORM_TEXEL_BUFFER, 1},
+      {VK_DESCRIPTOR_TYPE_STORAGE_TEXEL_BUFFER, 1},
+      {VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER, 2},
+      {VK_DESCRIPTOR_TYPE_STORAGE_BUFFER, 4},
+  };
+
+  VulkanDescriptorAllocator* VulkanDescriptorAllocator::Create(
+      CreateInfo info) {
+    return new VulkanDescriptorAllocator(info);
+  }
+
+  VulkanDescriptorAllocator::VulkanDescriptorAllocator(CreateInfo info)
+      : m_Info(info) {}
+
+  VulkanDescriptorAllocator::~VulkanDescriptorAllocator() {
+    for (VkDescriptorPool pool : m_Pools)
+      vkDestroyDescriptorPool(m_Info.device->device, pool, m_Info.allocator);
+  }
+
+  VkDescriptorPool VulkanDescriptorAllocator::CreatePool() {
+    std::vector<VkDescriptorPoolSize> sizes;
+    for (auto& ratio : s_PoolRatios)
+      sizes.push_back({ratio.type, ratio.perSet * m_Info.setsPerPool});
+
+    VkDescriptorPoolCreateInfo createInfo{};
+    createInfo.sType   = VK_STRUCTURE_TYPE_DESCRIPTOR_POOL_CREATE_INFO;
+    createInfo.maxSets = m_Info.setsPerPool;
+    createInfo.poolSizeCount = (uint32_t)sizes.size();
+    createInfo.pPoolSizes    = sizes.data();
+    VkDescriptorPool pool    = VK_NULL_HANDLE;
+    if (vkCreateDescriptorPool(m_Info.device->device, &createInfo,
+                               m_Info.allocator, &pool) != VK_SUCCESS) {
+      SR_CORE_ERROR("Failed to create descriptor pool");
+      return VK_NULL_HANDLE;
+    }
+    m_Pools.push_back(pool);
+    return pool;
+  }
+
+  VkDescriptorSet VulkanDescriptorAllocator::Allocate(
+      VkDescriptorSetLayout layout) {
+    VkDescriptorSetAllocateInfo allocInfo{};
+    allocInfo.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_SET_ALLOCATE_INFO;
+    allocInfo.descriptorSetCount = 1;
+    allocInfo.pSetLayouts        = &layout;
+
+    VkDescriptorSet set = VK_NULL_HANDLE;
+    while (true) {
+      bool fresh = m_Current == m_Pools.size();
+      if (fresh && !CreatePool()) return VK_NULL_HANDLE;
+      allocInfo.descriptorPool = m_Pools[m_Current];
+      VkResult err =
+          vkAllocateDescriptorSets(m_Info.device->device, &allocInfo, &set);
+      if (err == VK_SUCCESS) return set;
+      // A fresh pool that cannot hold the set never will
+      if (fresh || (err != VK_ERROR_OUT_OF_POOL_MEMORY &&
+                    err != VK_ERROR_FRAGMENTED_POOL)) {
+        SR_CORE_ERROR("Failed to allocate descriptor set");
+        return VK_NULL_HANDLE;
+      }
+      m_Current++;
+    }
+  }
+
+  void VulkanDescriptorAllocator::Reset() {
+    for (VkDescriptorPool pool : m_Pools)
+      vkResetDescriptorPool(m_Info.device->device, pool, 0);
+    m_Current = 0;
+  }
+}  // namespace Sera
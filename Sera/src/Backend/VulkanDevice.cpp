@@ -5,12 +5,90 @@ namespace Sera {
   VulkanDevice::VulkanDevice(const VulkanPhysicalDevice*  pDevice,
                              const VkAllocationCallbacks* vkAllocator,
                              uint32_t                     queueFamily,
-                             std::vector<const char*>& extensions, void* pNext)
+                             std::vector<const char*>& extensions,
+                             const Features&           requestedFeatures,
+                             void*                     pNext)
       : physicalDevice(pDevice),
         allocator(vkAllocator),
         queueFamily(queueFamily) {
-    int device_extension_count = 1;
-    extensions.push_back(VK_KHR_SWAPCHAIN_EXTENSION_NAME);
+    const auto& supported   = physicalDevice->features;
+    const auto& supported11 = physicalDevice->features11;
+    const auto& supported12 = physicalDevice->features12;
+    const auto& supported13 = physicalDevice->features13;
+    features.bufferDeviceAddress =
+        requestedFeatures.bufferDeviceAddress &&
+        supported12.bufferDeviceAddress;
+    features.drawIndirectCount =
+        requestedFeatures.drawIndirectCount && supported12.drawIndirectCount;
+    features.multiDrawIndirect =
+        requestedFeatures.multiDrawIndirect && supported.multiDrawIndirect;
+    features.drawIndirectFirstInstance =
+        requestedFeatures.drawIndirectFirstInstance &&
+        supported.drawIndirectFirstInstance;
+    features.shaderDrawParameters =
+        requestedFeatures.shaderDrawParameters &&
+        supported11.shaderDrawParameters;
+    features.dynamicRendering =
+        requestedFeatures.dynamicRendering && supported13.dynamicRendering;
+    features.pipelineCreationCacheControl =
+        requestedFeatures.pipelineCreationCacheControl &&
+        supported13.pipelineCreationCacheControl;
+    features.synchronization2 =
+        requestedFeatures.synchronization2 && supported13.synchronization2;
+    features.pipelineStatisticsQuery =
+        requestedFeatures.pipelineStatisticsQuery &&
+        supported.pipelineStatisticsQuery;
+
+    if (requestedFeatures.pipelineCreationFeedback) {
+      const char* feedbackExt =
+          VK_EXT_PIPELINE_CREATION_FEEDBACK_EXTENSION_NAME;
+      if (physicalDevice->properties.apiVersion >= VK_API_VERSION_1_3) {
+        features.pipelineCreationFeedback = true;
+      } else if (physicalDevice->IsExtensionSupported(feedbackExt)) {
+        extensions.push_back(feedbackExt);
+        features.pipelineCreationFeedback = true;
+      }
+    }
+    if (requestedFeatures.memoryBudget &&
+        physicalDevice->properties.apiVersion >= VK_API_VERSION_1_1 &&
+        physicalDevice->IsExtensionSupported(
+            VK_EXT_MEMORY_BUDGET_EXTENSION_NAME)) {
+      extensions.push_back(VK_EXT_MEMORY_BUDGET_EXTENSION_NAME);
+      features.memoryBudget = true;
+    }
+
+    VkPhysicalDeviceVulkan13Features enabled13{};
+    enabled13.sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_VULKAN_1_3_FEATURES;
+    enabled13.pNext = pNext;
+    enabled13.dynamicRendering = features.dynamicRendering;
+    enabled13.pipelineCreationCacheControl =
+        features.pipelineCreationCacheControl;
+    enabled13.synchronization2 = features.synchronization2;
+
+    VkPhysicalDeviceVulkan12Features enabled12{};
+    enabled12.sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_VULKAN_1_2_FEATURES;
+    enabled12.pNext = pNext;
+    enabled12.bufferDeviceAddress = features.bufferDeviceAddress;
+    enabled12.drawIndirectCount   = features.drawIndirectCount;
+
+    VkPhysicalDeviceVulkan11Features enabled11{};
+    enabled11.sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_VULKAN_1_1_FEATURES;
+    enabled11.pNext = &enabled12;
+    enabled11.shaderDrawParameters = features.shaderDrawParameters;
+
+    VkPhysicalDeviceFeatures2 enabledFeatures{};
+    enabledFeatures.sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_FEATURES_2;
+    enabledFeatures.pNext = pNext;
+    enabledFeatures.features.pipelineStatisticsQuery =
+        features.pipelineStatisticsQuery;
+    enabledFeatures.features.multiDrawIndirect = features.multiDrawIndirect;
+    enabledFeatures.features.drawIndirectFirstInstance =
+        features.drawIndirectFirstInstance;
+    // The 1.1-1.3 structs may only be chained on devices that know about them
+    if (physicalDevice->properties.apiVersion >= VK_API_VERSION_1_2)
+      enabledFeatures.pNext = &enabled11;
+    if (physicalDevice->properties.apiVersion >= VK_API_VERSION_1_3)
+      enabled12.pNext = &enabled13;
 
     const float             queue_priority[] = {1.0f};
     VkDeviceQueueCreateInfo queue_info[1]    = {};
@@ -26,6 +104,10 @@ namespace Sera {
     create_info.enabledExtensionCount   = extensions.size();
     create_info.ppEnabledExtensionNames = extensions.data();
     create_info.pNext                   = pNext;
+    if (physicalDevice->properties.apiVersion >= VK_API_VERSION_1_1)
+      create_info.pNext = &enabledFeatures;
+    else
+      create_info.pEnabledFeatures = &enabledFeatures.features;
     auto err = vkCreateDevice(physicalDevice->physicalDevice, &create_info,
                               allocator, &device);
     if (err != VK_SUCCESS) {
@@ -2,6 +2,7 @@
 #include "Backend/VulkanDebug.h"
 #include "Log.h"
 #include <array>
+#include <cstring>
 namespace Sera {
   static constexpr std::array<const char*, 1> ValidationLayerNames = {
       "VK_LAYER_KHRONOS_validation"};
@@ -32,9 +33,12 @@ namespace Sera {
       SR_CORE_TRACE("\t {0}:", l.extensionName);
     }
     std::vector<const char*> instanceExtensions;
-    if (IsExtensionAvailable(extensions, VK_KHR_SURFACE_EXTENSION_NAME)) {
+    if (instanceSpecs.enableSurface &&
+        IsExtensionAvailable(extensions, VK_KHR_SURFACE_EXTENSION_NAME)) {
       instanceExtensions.push_back(VK_KHR_SURFACE_EXTENSION_NAME);
+#ifdef _WIN32
       instanceExtensions.push_back("VK_KHR_win32_surface");
+#endif
     }
     if (IsExtensionAvailable(
             extensions,
@@ -47,8 +51,14 @@ namespace Sera {
       if (!IsExtensionAvailable(extensions, ExtName))
         SR_CORE_ERROR("Required extension {0} is not available", ExtName);
 
+    const auto IsRequested = [&](const char* ext) {
+      for (const auto* requested : instanceExtensions)
+        if (strcmp(requested, ext) == 0) return true;
+      return false;
+    };
     if (!instanceSpecs.additionalExtensions.empty()) {
       for (const auto& ext : instanceSpecs.additionalExtensions) {
+        if (IsRequested(ext)) continue;
         if (IsExtensionAvailable(extensions, ext)) {
           instanceExtensions.push_back(ext);
         } else {
@@ -68,7 +78,8 @@ namespace Sera {
       }
     }
     if (instanceSpecs.enableValidation) {
-      if (IsExtensionAvailable(extensions, VK_EXT_DEBUG_UTILS_EXTENSION_NAME)) {
+      if (!IsRequested(VK_EXT_DEBUG_UTILS_EXTENSION_NAME) &&
+          IsExtensionAvailable(extensions, VK_EXT_DEBUG_UTILS_EXTENSION_NAME)) {
         instanceExtensions.push_back(VK_EXT_DEBUG_UTILS_EXTENSION_NAME);
       }
       for (const auto& layer : ValidationLayerNames) {
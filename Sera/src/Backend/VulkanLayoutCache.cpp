@@ -0,0 +1,148 @@
+#include "Backend/VulkanLayoutCache.h"
+#include "Backend/SpirvReflection.h"
+#include "Backend/VulkanDevice.h"
+#include "Log.h"
+#include <algorithm>
+namespace Sera {
+  VulkanLayoutCache* VulkanLayoutCache::Create(CreateInfo info) {
+    return new VulkanLayoutCache(info);
+  }
+
+  VulkanLayoutCache::VulkanLayoutCache(CreateInfo info) : m_Info(info) {}
+
+  VulkanLayoutCache::~VulkanLayoutCache() {
+    for (auto& [key, layout] : m_Layouts)
+      vkDestroyPipelineLayout(m_Info.device->device, layout.layout,
+                              m_Info.allocator);
+    for (auto& [key, setLayout] : m_SetLayouts)
+      vkDestroyDescriptorSetLayout(m_Info.device->device, setLayout,
+                                   m_Info.allocator);
+  }
+
+  VulkanLayoutCache::Layout VulkanLayoutCache::GetLayout(
+      const std::vector<const SpirvReflection*>& stages) {
+    // Sets of bindings, each binding visible to every stage using it
+    std::vector<std::vector<VkDescriptorSetLayoutBinding>> sets;
+    VkPushConstantRange                                    pushConstants{};
+    for (const SpirvReflection* stage : stages) {
+      if (!stage) continue;
+      for (auto& binding : stage->bindings) {
+        if (binding.set >= sets.size()) sets.resize(binding.set + 1);
+        auto& set      = sets[binding.set];
+        auto  existing = std::find_if(
+            set.begin(), set.end(),
+            [&](const VkDescriptorSetLayoutBinding& other) {
+              return other.binding == binding.binding;
+            });
+        if (existing == set.end()) {
+          VkDescriptorSetLayoutBinding layoutBinding{};
+          layoutBinding.binding         = binding.binding;
+          layoutBinding.descriptorType  = binding.type;
+          layoutBinding.descriptorCount = binding.count;
+          layoutBinding.stageFlags      = stage->stage;
+          set.push_back(layoutBinding);
+          continue;
+        }
+        if (existing->descriptorType != binding.type ||
+            existing->descriptorCount != binding.count)
+          SR_CORE_WARN("Stages disagree on set {0} binding {1}", binding.set,
+                       binding.binding);
+        existing->stageFlags |= stage->stage;
+      }
+      if (stage->pushConstantSize > 0) {
+        pushConstants.stageFlags |= stage->stage;
+        pushConstants.size =
+            std::max(pushConstants.size, stage->pushConstantSize);
+      }
+    }
+
+    std::lock_guard<std::mutex> lock(m_Mutex);
+    Layout                      result;
+    for (auto& set : sets) {
+      VkDescriptorSetLayout setLayout = FindOrCreateSetLayout(set);
+      if (setLayout == VK_NULL_HANDLE) {
+        SR_CORE_ERROR("Failed to create pipeline layout, set {0} has no "
+                      "layout", result.setLayouts.size());
+        return {};
+      }
+      result.setLayouts.push_back(setLayout);
+    }
+    result.pushConstants = pushConstants;
+
+    // Set layouts are already deduplicated, their handles identify them
+    Key key;
+    for (VkDescriptorSetLayout setLayout : result.setLayouts)
+      key.push_back((uint64_t)setLayout);
+    key.push_back(pushConstants.stageFlags);
+    key.push_back(pushConstants.size);
+    auto it = m_Layouts.find(key);
+    if (it != m_Layouts.end()) return it->second;
+
+    VkPipelineLayoutCreateInfo createInfo{};
+    createInfo.sType = VK_STRUCTURE_TYPE_PIPELINE_LAYOUT_CREATE_INFO;
+    createInfo.setLayoutCount = (uint32_t)result.setLayouts.size();
+    createInfo.pSetLayouts    = result.setLayouts.data();
+    if (pushConstants.size > 0) {
+      createInfo.pushConstantRangeCount = 1;
+      createInfo.pPushConstantRanges    = &pushConstants;
+    }
+    if (vkCreatePipelineLayout(m_Info.device->device, &createInfo,
+                               m_Info.allocator,
+                               &result.layout) != VK_SUCCESS) {
+      SR_CORE_ERROR("Failed to create pipeline layout");
+      return {};
+    }
+    m_Layouts[key] = result;
+    return result;
+  }
+
+  VkDescriptorSetLayout VulkanLayoutCache::GetSetLayout(
+      const std::vector<VkDescriptorSetLayoutBinding>& bindings) {
+    std::lock_guard<std::mutex> lock(m_Mutex);
+    return FindOrCreateSetLayout(bindings);
+  }
+
+  VkDescriptorSetLayout VulkanLayoutCache::FindOrCreateSetLayout(
+      const std::vector<VkDescriptorSetLayoutBinding>& bindings) {
+    std::vector<VkDescriptorSetLayoutBinding> sorted = bindings;
+    std::sort(sorted.begin(), sorted.end(),
+              [](const VkDescriptorSetLayoutBinding& a,
+                 const VkDescriptorSetLayoutBinding& b) {
+                return a.binding < b.binding;
+              });
+
+    Key key;
+    for (auto& binding : sorted) {
+      key.push_back(binding.binding);
+      key.push_back(binding.descriptorType);
+      key.push_back(binding.descriptorCount);
+      key.push_back(binding.stageFlags);
+    }
+    auto it = m_SetLayouts.find(key);
+    if (it != m_SetLayouts.end()) return it->second;
+
+    VkDescriptorSetLayoutCreateInfo createInfo{};
+    createInfo.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_SET_LAYOUT_CREATE_INFO;
+    createInfo.bindingCount = (uint32_t)sorted.size();
+    createInfo.pBindings    = sorted.data();
+    VkDescriptorSetLayout setLayout = VK_NULL_HANDLE;
+    if (vkCreateDescriptorSetLayout(m_Info.device->device, &createInfo,
+                                    m_Info.allocator,
+                                    &setLayout) != VK_SUCCESS) {
+      SR_CORE_ERROR("Failed to create descriptor set layout");
+      return VK_NULL_HANDLE;
+    }
+    m_SetLayouts[key] = setLayout;
+    return setLayout;
+  }
+
+  uint32_t VulkanLayoutCache::GetSetLayoutCount() const {
+    std::lock_guard<std::mutex> lock(m_Mutex);
+    return (uint32_t)m_SetLayouts.size();
+  }
+
+  uint32_t VulkanLayoutCache::GetPipelineLayoutCount() const {
+    std::lock_guard<std::mutex> lock(m_Mutex);
+    return (uint32_t)m_Layouts.size();
+  }
+}  // namespace Sera
@@ -1,8 +1,38 @@
 #include "Backend/VulkanPhysicalDevice.h"
+#include <cstdint>
+#include <cstring>
 #include <vector>
 namespace Sera {
   VulkanPhysicalDevice::VulkanPhysicalDevice(VkPhysicalDevice device)
-      : physicalDevice(device) {}
+      : physicalDevice(device) {
+    vkGetPhysicalDeviceProperties(physicalDevice, &properties);
+    vkGetPhysicalDeviceMemoryProperties(physicalDevice, &memoryProperties);
+
+    features11.sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_VULKAN_1_1_FEATURES;
+    features12.sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_VULKAN_1_2_FEATURES;
+    features13.sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_VULKAN_1_3_FEATURES;
+    if (properties.apiVersion >= VK_API_VERSION_1_2) {
+      VkPhysicalDeviceFeatures2 features2{};
+      features2.sType  = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_FEATURES_2;
+      features2.pNext  = &features11;
+      features11.pNext = &features12;
+      if (properties.apiVersion >= VK_API_VERSION_1_3)
+        features12.pNext = &features13;
+      vkGetPhysicalDeviceFeatures2(physicalDevice, &features2);
+      features         = features2.features;
+      features11.pNext = nullptr;
+      features12.pNext = nullptr;
+    } else {
+      vkGetPhysicalDeviceFeatures(physicalDevice, &features);
+    }
+
+    uint32_t extensionCount = 0;
+    vkEnumerateDeviceExtensionProperties(physicalDevice, nullptr,
+                                         &extensionCount, nullptr);
+    extensions.resize(extensionCount);
+    vkEnumerateDeviceExtensionProperties(physicalDevice, nullptr,
+                                         &extensionCount, extensions.data());
+  }
 
   void VulkanPhysicalDevice::SelectGraphicsQueueFamily() {
     uint32_t count;
@@ -16,4 +46,29 @@ namespace Sera {
         break;
       }
   }
-}  // namespace Sera
\ No newline at end of file
+
+  uint32_t VulkanPhysicalDevice::FindMemoryType(
+      uint32_t typeFilter, VkMemoryPropertyFlags properties) const {
+    for (uint32_t i = 0; i < memoryProperties.memoryTypeCount; i++) {
+      if ((typeFilter & (1 << i)) &&
+          (memoryProperties.memoryTypes[i].propertyFlags & properties) ==
+              properties)
+        return i;
+    }
+    return UINT32_MAX;
+  }
+
+  bool VulkanPhysicalDevice::IsExtensionSupported(
+      const char* extension) const {
+    for (const auto& ext : extensions)
+      if (strcmp(ext.extensionName, extension) == 0) return true;
+    return false;
+  }
+
+  bool VulkanPhysicalDevice::IsDepthFormatSupported(VkFormat format) const {
+    VkFormatProperties props;
+    vkGetPhysicalDeviceFormatProperties(physicalDevice, format, &props);
+    return (props.optimalTilingFeatures &
+            VK_FORMAT_FEATURE_DEPTH_STENCIL_ATTACHMENT_BIT) != 0;
+  }
+}  // namespace Sera
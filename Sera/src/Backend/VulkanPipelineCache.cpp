@@ -0,0 +1,203 @@
+#include "Backend/VulkanPipelineCache.h"
+#include "Backend/VulkanDevice.h"
+#include "Hash.h"
+#include "Log.h"
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+namespace Sera {
+  // Prepended to the driver blob, VkPipelineCacheHeaderVersionOne is checked
+  // again by the driver but some implementations crash on foreign data.
+  struct PipelineCacheFileHeader {
+      uint32_t magic;
+      uint32_t version;
+      uint32_t vendorID;
+      uint32_t deviceID;
+      uint32_t driverVersion;
+      uint8_t  uuid[VK_UUID_SIZE];
+      uint64_t dataSize;
+      uint64_t checksum;
+  };
+
+  static constexpr uint32_t s_CacheMagic   = 0x43505253;  // "SRPC"
+  static constexpr uint32_t s_CacheVersion = 1;
+
+  static PipelineCacheFileHeader MakeHeader(
+      const VkPhysicalDeviceProperties& props) {
+    PipelineCacheFileHeader header{};
+    header.magic         = s_CacheMagic;
+    header.version       = s_CacheVersion;
+    header.vendorID      = props.vendorID;
+    header.deviceID      = props.deviceID;
+    header.driverVersion = props.driverVersion;
+    memcpy(header.uuid, props.pipelineCacheUUID, VK_UUID_SIZE);
+    return header;
+  }
+
+  VulkanPipelineCache* VulkanPipelineCache::Create(CreateInfo info) {
+    return new VulkanPipelineCache(info);
+  }
+
+  VulkanPipelineCache::~VulkanPipelineCache() {
+    vkDestroyPipelineCache(m_Info.device->device, m_Handle, m_Info.allocator);
+  }
+
+  VulkanPipelineCache::VulkanPipelineCache(CreateInfo info) : m_Info(info) {
+    std::string data;
+    if (!m_Info.path.empty() && Load(data))
+      SR_CORE_INFO("Loaded pipeline cache {0} ({1} bytes)", m_Info.path,
+                   data.size());
+
+    VkPipelineCacheCreateInfo createInfo{};
+    createInfo.sType           = VK_STRUCTURE_TYPE_PIPELINE_CACHE_CREATE_INFO;
+    createInfo.initialDataSize = data.size();
+    createInfo.pInitialData    = data.empty() ? nullptr : data.data();
+    auto err = vkCreatePipelineCache(m_Info.device->device, &createInfo,
+                                     m_Info.allocator, &m_Handle);
+    if (err != VK_SUCCESS && !data.empty()) {
+      SR_CORE_WARN("Pipeline cache data rejected by driver, starting empty");
+      createInfo.initialDataSize = 0;
+      createInfo.pInitialData    = nullptr;
+      err = vkCreatePipelineCache(m_Info.device->device, &createInfo,
+                                  m_Info.allocator, &m_Handle);
+    }
+    if (err != VK_SUCCESS) {
+      SR_CORE_ERROR("Pipeline cache could not created");
+      return;
+    }
+    m_SavedSize = QueryDataSize();
+  }
+
+  bool VulkanPipelineCache::Load(std::string& data) const {
+    std::ifstream file{m_Info.path, std::ios::binary};
+    if (!file.is_open()) return false;
+
+    PipelineCacheFileHeader header{};
+    file.read(reinterpret_cast<char*>(&header), sizeof(header));
+    if (!file) {
+      SR_CORE_WARN("Pipeline cache {0} is truncated", m_Info.path);
+      return false;
+    }
+
+    PipelineCacheFileHeader expected =
+        MakeHeader(m_Info.device->physicalDevice->properties);
+    if (header.magic != expected.magic || header.version != expected.version) {
+      SR_CORE_WARN("Pipeline cache {0} has unknown format", m_Info.path);
+      return false;
+    }
+    if (header.vendorID != expected.vendorID ||
+        header.deviceID != expected.deviceID ||
+        header.driverVersion != expected.driverVersion ||
+        memcmp(header.uuid, expected.uuid, VK_UUID_SIZE) != 0) {
+      SR_CORE_INFO("Pipeline cache {0} is from another device or driver",
+                   m_Info.path);
+      return false;
+    }
+
+    // The size comes from the file, a corrupted one must not make us
+    // allocate more than the file holds
+    std::error_code ec;
+    uintmax_t       fileSize = std::filesystem::file_size(m_Info.path, ec);
+    if (ec || header.dataSize > fileSize - sizeof(header)) {
+      SR_CORE_WARN("Pipeline cache {0} is corrupted", m_Info.path);
+      return false;
+    }
+
+    data.resize(header.dataSize);
+    file.read(data.data(), data.size());
+    if (!file || HashBytes(data.data(), data.size()) != header.checksum) {
+      SR_CORE_WARN("Pipeline cache {0} is corrupted", m_Info.path);
+      data.clear();
+      return false;
+    }
+    return true;
+  }
+
+  size_t VulkanPipelineCache::QueryDataSize() const {
+    size_t size = 0;
+    vkGetPipelineCacheData(m_Info.device->device, m_Handle, &size, nullptr);
+    return size;
+  }
+
+  bool VulkanPipelineCache::Save() {
+    if (m_Info.path.empty() || m_Handle == VK_NULL_HANDLE) return false;
+
+    size_t      size = QueryDataSize();
+    std::string data(size, '\0');
+    auto err = vkGetPipelineCacheData(m_Info.device->device, m_Handle, &size,
+                                      data.data());
+    if (err != VK_SUCCESS) {
+      SR_CORE_WARN("Could not read pipeline cache data");
+      return false;
+    }
+    data.resize(size);
+
+    PipelineCacheFileHeader header =
+        MakeHeader(m_Info.device->physicalDevice->properties);
+    header.dataSize = data.size();
+    header.checksum = HashBytes(data.data(), data.size());
+
+    namespace fs = std::filesystem;
+    std::error_code ec;
+    fs::path        path = m_Info.path;
+    if (path.has_parent_path()) fs::create_directories(path.parent_path(), ec);
+
+    fs::path tempPath = path;
+    tempPath += ".tmp";
+    {
+      std::ofstream file{tempPath, std::ios::binary | std::ios::trunc};
+      file.write(reinterpret_cast<const char*>(&header), sizeof(header));
+      file.write(data.data(), data.size());
+      if (!file) {
+        SR_CORE_WARN("Could not write pipeline cache {0}", tempPath.string());
+        return false;
+      }
+    }
+    fs::rename(tempPath, path, ec);
+    if (ec) {
+      SR_CORE_WARN("Could not replace pipeline cache {0}: {1}", m_Info.path,
+                   ec.message());
+      fs::remove(tempPath, ec);
+      return false;
+    }
+    m_SavedSize = data.size();
+    return true;
+  }
+
+  bool VulkanPipelineCache::SaveIfGrown() {
+    if (m_Info.path.empty() || m_Handle == VK_NULL_HANDLE) return false;
+    if (QueryDataSize() <= m_SavedSize) return false;
+    return Save();
+  }
+
+  void VulkanPipelineCache::Attach(Feedback& feedback,
+                                   const void** pNext) const {
+    if (!m_Info.device->features.pipelineCreationFeedback) return;
+    feedback.createInfo.sType =
+        VK_STRUCTURE_TYPE_PIPELINE_CREATION_FEEDBACK_CREATE_INFO;
+    feedback.createInfo.pNext                     = *pNext;
+    feedback.createInfo.pPipelineCreationFeedback = &feedback.pipeline;
+    *pNext                                        = &feedback.createInfo;
+  }
+
+  void VulkanPipelineCache::Record(const Feedback& feedback,
+                                   double          creationTimeMs) {
+    m_Pipelines++;
+    m_CreationTimeUs += (uint64_t)(creationTimeMs * 1000.0);
+    if (!(feedback.pipeline.flags & VK_PIPELINE_CREATION_FEEDBACK_VALID_BIT))
+      return;
+    m_WithFeedback++;
+    if (feedback.pipeline.flags &
+        VK_PIPELINE_CREATION_FEEDBACK_APPLICATION_PIPELINE_CACHE_HIT_BIT)
+      m_CacheHits++;
+  }
+
+  VulkanPipelineCache::Stats VulkanPipelineCache::GetStats() const {
+    Stats stats;
+    stats.pipelines      = m_Pipelines;
+    stats.cacheHits      = m_CacheHits;
+    stats.withFeedback   = m_WithFeedback;
+    stats.creationTimeMs = m_CreationTimeUs / 1000.0;
+    return stats;
+  }
+}  // namespace Sera
@@ -0,0 +1,342 @@
+#include "Backend/VulkanPipelineRegistry.h"
+#include "Backend/VulkanDevice.h"
+#include "Backend/VulkanShader.h"
+#include "Hash.h"
+#include "Log.h"
+#include "Profiler.h"
+#include <algorithm>
+#include <filesystem>
+namespace Sera {
+  static void Publish(PipelineHandle::Entry& entry,
+                      VulkanRenderPipeline*  pipeline) {
+    entry.pipeline = pipeline;
+    entry.ready    = true;
+    entry.compiled.set_value();
+  }
+
+  static uint64_t ShaderHash(const std::shared_ptr<VulkanShader>& shader) {
+    return shader ? shader->GetHash() : 0;
+  }
+
+  static bool IsSameBinding(const VkVertexInputBindingDescription& a,
+                            const VkVertexInputBindingDescription& b) {
+    return a.binding == b.binding && a.stride == b.stride &&
+           a.inputRate == b.inputRate;
+  }
+
+  static bool IsSameAttribute(const VkVertexInputAttributeDescription& a,
+                              const VkVertexInputAttributeDescription& b) {
+    return a.location == b.location && a.binding == b.binding &&
+           a.format == b.format && a.offset == b.offset;
+  }
+
+  VulkanPipelineRegistry* VulkanPipelineRegistry::Create(CreateInfo info) {
+    return new VulkanPipelineRegistry(info);
+  }
+
+  VulkanPipelineRegistry::VulkanPipelineRegistry(CreateInfo info)
+      : m_Info(info) {
+    if (m_Info.workerCount == 0) m_Info.workerCount = 1;
+    for (uint32_t i = 0; i < m_Info.workerCount; i++)
+      m_Workers.emplace_back([this]() { WorkerLoop(); });
+  }
+
+  VulkanPipelineRegistry::~VulkanPipelineRegistry() {
+    {
+      std::lock_guard<std::mutex> lock(m_QueueMutex);
+      m_Stop = true;
+    }
+    m_QueueCondition.notify_all();
+    for (auto& worker : m_Workers) worker.join();
+
+    m_Queue.clear();
+
+    for (auto& swap : m_Swaps) delete swap.pipeline;
+    m_Swaps.clear();
+    for (auto& retired : m_Retired) delete retired.pipeline;
+    m_Retired.clear();
+
+    // Handles may outlive the registry, drop their Vulkan objects now
+    std::lock_guard<std::mutex> lock(m_Mutex);
+    for (auto& [hash, bucket] : m_Entries) {
+      for (auto& entry : bucket) {
+        // Never compiled, release anyone waiting on it
+        if (!entry->ready) Publish(*entry, nullptr);
+        delete entry->pipeline.exchange(nullptr);
+        entry->info.vertexShader.reset();
+        entry->info.fragmentShader.reset();
+      }
+    }
+    m_Entries.clear();
+    m_Reloaded.clear();
+  }
+
+  PipelineHandle VulkanPipelineRegistry::Get(
+      const VulkanRenderPipeline::CreateInfo& createInfo) {
+    EntryRef entry;
+    {
+      std::lock_guard<std::mutex> lock(m_Mutex);
+      // Callers still loading a shader that has since been reloaded get the
+      // rebuilt pipeline
+      VulkanRenderPipeline::CreateInfo info = createInfo;
+      ResolveReloaded(info);
+      uint64_t hash   = Hash(info);
+      auto&    bucket = m_Entries[hash];
+      for (auto& existing : bucket)
+        if (IsSameState(existing->info, info)) return PipelineHandle(existing);
+
+      entry       = std::make_shared<PipelineHandle::Entry>();
+      entry->info = info;
+      if (!entry->info.pipelineCache)
+        entry->info.pipelineCache = m_Info.pipelineCache;
+      if (!entry->info.layoutCache)
+        entry->info.layoutCache = m_Info.layoutCache;
+      entry->hash   = hash;
+      entry->future = entry->compiled.get_future().share();
+      bucket.push_back(entry);
+    }
+
+    // A cache hit is cheap enough for the calling thread, only real
+    // compilations go to the workers
+    if (entry->info.pipelineCache &&
+        m_Info.device->features.pipelineCreationCacheControl) {
+      VulkanRenderPipeline::CreateInfo probe = entry->info;
+      probe.flags |= VK_PIPELINE_CREATE_FAIL_ON_PIPELINE_COMPILE_REQUIRED_BIT;
+      VulkanRenderPipeline* pipeline = VulkanRenderPipeline::Create(probe);
+      if (pipeline->GetResult() == VK_SUCCESS) {
+        Publish(*entry, pipeline);
+        return PipelineHandle(entry);
+      }
+      delete pipeline;
+    }
+
+    Enqueue([this, entry]() { Compile(*entry); });
+    return PipelineHandle(entry);
+  }
+
+  void VulkanPipelineRegistry::Enqueue(std::function<void()>&& job) {
+    m_Pending++;
+    {
+      std::lock_guard<std::mutex> lock(m_QueueMutex);
+      m_Queue.push_back(std::move(job));
+    }
+    m_QueueCondition.notify_one();
+  }
+
+  static bool IsSamePath(const std::string& a, const std::string& b) {
+    return std::filesystem::path(a).lexically_normal() ==
+           std::filesystem::path(b).lexically_normal();
+  }
+
+  void VulkanPipelineRegistry::ReloadShader(const std::string& path) {
+    Enqueue([this, path]() { Rebuild(path); });
+  }
+
+  void VulkanPipelineRegistry::Rebuild(const std::string& path) {
+    auto usesFile = [&](const std::shared_ptr<VulkanShader>& shader) {
+      return shader && IsSamePath(shader->GetPath(), path);
+    };
+
+    std::vector<EntryRef> affected;
+    {
+      std::lock_guard<std::mutex> lock(m_Mutex);
+      // Pipelines still in their first compile are left alone
+      for (auto& [hash, bucket] : m_Entries)
+        for (auto& entry : bucket)
+          if (entry->ready && (usesFile(entry->info.vertexShader) ||
+                               usesFile(entry->info.fragmentShader)))
+            affected.push_back(entry);
+    }
+    if (affected.empty()) return;
+
+    std::vector<uint32_t> code;
+    if (!VulkanShader::ReadSpirv(path, code)) return;
+
+    // Entries sharing a shader keep sharing the reloaded one
+    std::unordered_map<VulkanShader*, std::shared_ptr<VulkanShader>> reloaded;
+    auto reload = [&](std::shared_ptr<VulkanShader>& shader) {
+      if (!usesFile(shader)) return true;
+      auto& replacement = reloaded[shader.get()];
+      if (!replacement) {
+        VulkanShader::CreateInfo shaderInfo = shader->GetInfo();
+        shaderInfo.code                     = code;
+        replacement.reset(VulkanShader::Create(shaderInfo));
+      }
+      shader = replacement;
+      return shader->GetHandle() != VK_NULL_HANDLE;
+    };
+
+    for (auto& entry : affected) {
+      VulkanRenderPipeline::CreateInfo info;
+      {
+        std::lock_guard<std::mutex> lock(m_Mutex);
+        info = entry->info;
+      }
+      if (!reload(info.vertexShader) || !reload(info.fragmentShader)) {
+        SR_CORE_ERROR("Reloading {0} failed, keeping previous pipeline", path);
+        continue;
+      }
+      VulkanRenderPipeline* pipeline = VulkanRenderPipeline::Create(info);
+      if (pipeline->GetResult() != VK_SUCCESS) {
+        SR_CORE_ERROR("Reloading {0} failed, keeping previous pipeline", path);
+        delete pipeline;
+        continue;
+      }
+      std::lock_guard<std::mutex> lock(m_SwapMutex);
+      m_Swaps.push_back({entry, info, pipeline});
+    }
+  }
+
+  void VulkanPipelineRegistry::Update(uint32_t framesInFlight) {
+    m_Frame++;
+
+    std::vector<Swap> swaps;
+    {
+      std::lock_guard<std::mutex> lock(m_SwapMutex);
+      swaps.swap(m_Swaps);
+    }
+    for (auto& swap : swaps) {
+      {
+        // Moves the entry to the bucket of its new state
+        std::lock_guard<std::mutex> lock(m_Mutex);
+        auto found = m_Entries.find(swap.entry->hash);
+        if (found != m_Entries.end()) {
+          auto& bucket = found->second;
+          bucket.erase(std::remove(bucket.begin(), bucket.end(), swap.entry),
+                       bucket.end());
+          if (bucket.empty()) m_Entries.erase(found);
+        }
+        AddReloaded(swap.entry->info.vertexShader, swap.info.vertexShader);
+        AddReloaded(swap.entry->info.fragmentShader,
+                    swap.info.fragmentShader);
+        swap.entry->info = swap.info;
+        swap.entry->hash = Hash(swap.info);
+        m_Entries[swap.entry->hash].push_back(swap.entry);
+      }
+      VulkanRenderPipeline* old = swap.entry->pipeline.exchange(swap.pipeline);
+      if (old) m_Retired.push_back({old, m_Frame});
+    }
+    if (!swaps.empty())
+      SR_CORE_INFO("Swapped in {0} rebuilt pipelines", swaps.size());
+
+    auto expired = [&](const Retired& retired) {
+      if (m_Frame - retired.frame <= framesInFlight) return false;
+      delete retired.pipeline;
+      return true;
+    };
+    m_Retired.erase(
+        std::remove_if(m_Retired.begin(), m_Retired.end(), expired),
+        m_Retired.end());
+  }
+
+  void VulkanPipelineRegistry::ResolveReloaded(
+      VulkanRenderPipeline::CreateInfo& info) const {
+    for (auto* shader : {&info.vertexShader, &info.fragmentShader}) {
+      if (!*shader) continue;
+      auto found = m_Reloaded.find((*shader)->GetHash());
+      if (found != m_Reloaded.end()) *shader = found->second;
+    }
+  }
+
+  void VulkanPipelineRegistry::AddReloaded(
+      const std::shared_ptr<VulkanShader>& previous,
+      const std::shared_ptr<VulkanShader>& replacement) {
+    if (!previous || previous == replacement) return;
+    uint64_t hash = previous->GetHash();
+    if (hash == replacement->GetHash()) return;
+    // Earlier versions skip straight to the latest one
+    for (auto& [reloadedHash, latest] : m_Reloaded)
+      if (latest->GetHash() == hash) latest = replacement;
+    m_Reloaded[hash] = replacement;
+  }
+
+  uint32_t VulkanPipelineRegistry::GetPipelineCount() const {
+    std::lock_guard<std::mutex> lock(m_Mutex);
+    uint32_t                    count = 0;
+    for (auto& [hash, bucket] : m_Entries) count += (uint32_t)bucket.size();
+    return count;
+  }
+
+  void VulkanPipelineRegistry::WorkerLoop() {
+    SR_PROFILE_THREAD("Pipeline Compiler");
+    while (true) {
+      std::function<void()> job;
+      {
+        std::unique_lock<std::mutex> lock(m_QueueMutex);
+        m_QueueCondition.wait(lock,
+                              [this]() { return m_Stop || !m_Queue.empty(); });
+        if (m_Stop) return;
+        job = std::move(m_Queue.front());
+        m_Queue.pop_front();
+      }
+      job();
+      m_Pending--;
+    }
+  }
+
+  void VulkanPipelineRegistry::Compile(PipelineHandle::Entry& entry) {
+    SR_PROFILE_FUNCTION();
+    VulkanRenderPipeline* pipeline = VulkanRenderPipeline::Create(entry.info);
+    if (pipeline->GetResult() != VK_SUCCESS) {
+      SR_CORE_ERROR("Pipeline {0:x} failed to compile", entry.hash);
+      delete pipeline;
+      pipeline = nullptr;
+    }
+    Publish(entry, pipeline);
+  }
+
+  uint64_t VulkanPipelineRegistry::Hash(
+      const VulkanRenderPipeline::CreateInfo& info) {
+    uint64_t hash = ShaderHash(info.vertexShader);
+    HashCombine(hash, ShaderHash(info.fragmentShader));
+    for (auto& binding : info.vertexBindings) {
+      HashCombine(hash, binding.binding);
+      HashCombine(hash, binding.stride);
+      HashCombine(hash, binding.inputRate);
+    }
+    for (auto& attribute : info.vertexAttributes) {
+      HashCombine(hash, attribute.location);
+      HashCombine(hash, attribute.binding);
+      HashCombine(hash, attribute.format);
+      HashCombine(hash, attribute.offset);
+    }
+    HashCombine(hash, info.firstInstanceLocation);
+    info.specialization.Hash(hash);
+    HashCombine(hash, info.cullMode);
+    HashCombine(hash, info.frontFace);
+    HashCombine(hash, info.lineWidth);
+    HashCombine(hash, info.sampleCount);
+    HashCombine(hash, info.blendEnable);
+    HashCombine(hash, info.depthTest);
+    HashCombine(hash, info.depthWrite);
+    HashCombine(hash, info.depthCompareOp);
+    HashCombine(hash, info.renderPass);
+    for (VkFormat format : info.colorFormats) HashCombine(hash, format);
+    HashCombine(hash, info.depthFormat);
+    HashCombine(hash, info.stencilFormat);
+    return hash;
+  }
+
+  bool VulkanPipelineRegistry::IsSameState(
+      const VulkanRenderPipeline::CreateInfo& a,
+      const VulkanRenderPipeline::CreateInfo& b) {
+    return ShaderHash(a.vertexShader) == ShaderHash(b.vertexShader) &&
+           ShaderHash(a.fragmentShader) == ShaderHash(b.fragmentShader) &&
+           std::equal(a.vertexBindings.begin(), a.vertexBindings.end(),
+                      b.vertexBindings.begin(), b.vertexBindings.end(),
+                      IsSameBinding) &&
+           std::equal(a.vertexAttributes.begin(), a.vertexAttributes.end(),
+                      b.vertexAttributes.begin(), b.vertexAttributes.end(),
+                      IsSameAttribute) &&
+           a.firstInstanceLocation == b.firstInstanceLocation &&
+           a.specialization == b.specialization &&
+           a.cullMode == b.cullMode && a.frontFace == b.frontFace &&
+           a.lineWidth == b.lineWidth && a.sampleCount == b.sampleCount &&
+           a.blendEnable == b.blendEnable && a.depthTest == b.depthTest &&
+           a.depthWrite == b.depthWrite &&
+           a.depthCompareOp == b.depthCompareOp &&
+           a.renderPass == b.renderPass && a.colorFormats == b.colorFormats &&
+           a.depthFormat == b.depthFormat &&
+           a.stencilFormat == b.stencilFormat;
+  }
+}  // namespace Sera
@@ -1,7 +1,13 @@
 #include "Backend/VulkanRenderPipeline.h"
+#include "Backend/VulkanDebug.h"
 #include "Backend/VulkanDevice.h"
+#include "Backend/VulkanPipelineCache.h"
+#include "Backend/VulkanShader.h"
 #include "Log.h"
+#include "Timer.h"
 #include <array>
+#include <filesystem>
+#include <vector>
 namespace Sera {
 
   VulkanRenderPipeline* VulkanRenderPipeline::Create(CreateInfo info) {
@@ -9,32 +15,75 @@ namespace Sera {
   }
 
   VulkanRenderPipeline::~VulkanRenderPipeline() {
-    vkDestroyPipelineLayout(m_Info.device->device, m_Layout, m_Info.allocator);
+    // The layout belongs to the layout cache
     vkDestroyPipeline(m_Info.device->device, m_Handle, m_Info.allocator);
   }
 
   VulkanRenderPipeline::VulkanRenderPipeline(CreateInfo info) : m_Info(info) {
+    m_Info.vertexShader->CheckSpecialization(m_Info.specialization);
+    m_Info.fragmentShader->CheckSpecialization(m_Info.specialization);
+    std::vector<VkSpecializationMapEntry> specializationEntries;
+    VkSpecializationInfo                  specialization =
+        m_Info.specialization.GetInfo(specializationEntries);
+    const VkSpecializationInfo* pSpecialization =
+        m_Info.specialization.IsEmpty() ? nullptr : &specialization;
+
     VkPipelineShaderStageCreateInfo vertShaderStageInfo{};
     vertShaderStageInfo.sType =
         VK_STRUCTURE_TYPE_PIPELINE_SHADER_STAGE_CREATE_INFO;
     vertShaderStageInfo.stage  = VK_SHADER_STAGE_VERTEX_BIT;
-    vertShaderStageInfo.module = m_Info.vertexShader;
-    vertShaderStageInfo.pName  = "main";
+    vertShaderStageInfo.module = m_Info.vertexShader->GetHandle();
+    vertShaderStageInfo.pName  = m_Info.vertexShader->GetEntryPoint().c_str();
+    vertShaderStageInfo.pSpecializationInfo = pSpecialization;
 
     VkPipelineShaderStageCreateInfo fragShaderStageInfo{};
     fragShaderStageInfo.sType =
         VK_STRUCTURE_TYPE_PIPELINE_SHADER_STAGE_CREATE_INFO;
     fragShaderStageInfo.stage  = VK_SHADER_STAGE_FRAGMENT_BIT;
-    fragShaderStageInfo.module = m_Info.fragmentShader;
-    fragShaderStageInfo.pName  = "main";
+    fragShaderStageInfo.module = m_Info.fragmentShader->GetHandle();
+    fragShaderStageInfo.pName = m_Info.fragmentShader->GetEntryPoint().c_str();
+    fragShaderStageInfo.pSpecializationInfo = pSpecialization;
 
     VkPipelineShaderStageCreateInfo      shaderStages[] = {vertShaderStageInfo,
                                                            fragShaderStageInfo};
     VkPipelineVertexInputStateCreateInfo vertexInputInfo{};
     vertexInputInfo.sType =
         VK_STRUCTURE_TYPE_PIPELINE_VERTEX_INPUT_STATE_CREATE_INFO;
-    vertexInputInfo.vertexBindingDescriptionCount   = 0;
-    vertexInputInfo.vertexAttributeDescriptionCount = 0;
+    auto vertexBindings   = m_Info.vertexBindings;
+    auto vertexAttributes = m_Info.vertexAttributes;
+    if (vertexBindings.empty() && vertexAttributes.empty()) {
+      uint32_t strides[2] = {0, 0};
+      for (auto& input : m_Info.vertexShader->GetReflection().vertexInputs) {
+        if (input.format == VK_FORMAT_UNDEFINED) {
+          SR_CORE_ERROR(
+              "{}: vertex input at location {} has no 32-bit vertex format, "
+              "pass the vertex attributes explicitly",
+              m_Info.vertexShader->GetPath(), input.location);
+          m_Result = VK_ERROR_INITIALIZATION_FAILED;
+          return;
+        }
+        uint32_t binding =
+            input.location >= m_Info.firstInstanceLocation ? 1 : 0;
+        VkVertexInputAttributeDescription attribute{};
+        attribute.location = input.location;
+        attribute.binding  = binding;
+        attribute.format   = input.format;
+        attribute.offset   = strides[binding];
+        vertexAttributes.push_back(attribute);
+        strides[binding] += input.size;
+      }
+      if (strides[0] > 0)
+        vertexBindings.push_back({0, strides[0], VK_VERTEX_INPUT_RATE_VERTEX});
+      if (strides[1] > 0)
+        vertexBindings.push_back(
+            {1, strides[1], VK_VERTEX_INPUT_RATE_INSTANCE});
+    }
+    vertexInputInfo.vertexBindingDescriptionCount =
+        static_cast<uint32_t>(vertexBindings.size());
+    vertexInputInfo.pVertexBindingDescriptions = vertexBindings.data();
+    vertexInputInfo.vertexAttributeDescriptionCount =
+        static_cast<uint32_t>(vertexAttributes.size());
+    vertexInputInfo.pVertexAttributeDescriptions = vertexAttributes.data();
 
     VkPipelineInputAssemblyStateCreateInfo inputAssembly{};
     inputAssembly.sType =
@@ -67,9 +116,9 @@ namespace Sera {
     VkPipelineDepthStencilStateCreateInfo depthStencil{};
     depthStencil.sType =
         VK_STRUCTURE_TYPE_PIPELINE_DEPTH_STENCIL_STATE_CREATE_INFO;
-    depthStencil.depthTestEnable       = VK_TRUE;
-    depthStencil.depthWriteEnable      = VK_TRUE;
-    depthStencil.depthCompareOp        = VK_COMPARE_OP_LESS;
+    depthStencil.depthTestEnable  = m_Info.depthTest ? VK_TRUE : VK_FALSE;
+    depthStencil.depthWriteEnable = m_Info.depthWrite ? VK_TRUE : VK_FALSE;
+    depthStencil.depthCompareOp   = m_Info.depthCompareOp;
     depthStencil.depthBoundsTestEnable = VK_FALSE;
     depthStencil.stencilTestEnable     = VK_FALSE;
 
@@ -77,15 +126,30 @@ namespace Sera {
     colorBlendAttachment.colorWriteMask =
         VK_COLOR_COMPONENT_R_BIT | VK_COLOR_COMPONENT_G_BIT |
         VK_COLOR_COMPONENT_B_BIT | VK_COLOR_COMPONENT_A_BIT;
-    colorBlendAttachment.blendEnable = VK_FALSE;
+    colorBlendAttachment.blendEnable = m_Info.blendEnable ? VK_TRUE : VK_FALSE;
+    colorBlendAttachment.srcColorBlendFactor = VK_BLEND_FACTOR_SRC_ALPHA;
+    colorBlendAttachment.dstColorBlendFactor =
+        VK_BLEND_FACTOR_ONE_MINUS_SRC_ALPHA;
+    colorBlendAttachment.colorBlendOp        = VK_BLEND_OP_ADD;
+    colorBlendAttachment.srcAlphaBlendFactor = VK_BLEND_FACTOR_ONE;
+    colorBlendAttachment.dstAlphaBlendFactor =
+        VK_BLEND_FACTOR_ONE_MINUS_SRC_ALPHA;
+    colorBlendAttachment.alphaBlendOp = VK_BLEND_OP_ADD;
+
+    // One blend state per color attachment of the pass
+    uint32_t colorAttachmentCount = 1;
+    if (m_Info.renderPass == VK_NULL_HANDLE)
+      colorAttachmentCount = static_cast<uint32_t>(m_Info.colorFormats.size());
+    std::vector<VkPipelineColorBlendAttachmentState> colorBlendAttachments(
+        colorAttachmentCount, colorBlendAttachment);
 
     VkPipelineColorBlendStateCreateInfo colorBlending{};
     colorBlending.sType =
         VK_STRUCTURE_TYPE_PIPELINE_COLOR_BLEND_STATE_CREATE_INFO;
     colorBlending.logicOpEnable     = VK_FALSE;
     colorBlending.logicOp           = VK_LOGIC_OP_COPY;
-    colorBlending.attachmentCount   = 1;
-    colorBlending.pAttachments      = &colorBlendAttachment;
+    colorBlending.attachmentCount   = colorAttachmentCount;
+    colorBlending.pAttachments      = colorBlendAttachments.data();
     colorBlending.blendConstants[0] = 0.0f;
     colorBlending.blendConstants[1] = 0.0f;
     colorBlending.blendConstants[2] = 0.0f;
@@ -99,19 +163,23 @@ namespace Sera {
         static_cast<uint32_t>(dynamicStates.size());
     dynamicState.pDynamicStates = dynamicStates.data();
 
-    VkPipelineLayoutCreateInfo pipelineLayoutInfo{};
-    pipelineLayoutInfo.sType = VK_STRUCTURE_TYPE_PIPELINE_LAYOUT_CREATE_INFO;
-    pipelineLayoutInfo.setLayoutCount         = 0;
-    pipelineLayoutInfo.pushConstantRangeCount = 0;
-
-    if (vkCreatePipelineLayout(m_Info.device->device, &pipelineLayoutInfo,
-                               nullptr, &m_Layout) != VK_SUCCESS) {
-      SR_CORE_ERROR("Failed to create pipeline layout");
+    VulkanLayoutCache* layoutCache = m_Info.layoutCache;
+    if (!layoutCache) {
+      m_OwnedLayoutCache.reset(
+          VulkanLayoutCache::Create({m_Info.device, m_Info.allocator}));
+      layoutCache = m_OwnedLayoutCache.get();
+    }
+    m_Layout = layoutCache->GetLayout(
+        {&m_Info.vertexShader->GetReflection(),
+         &m_Info.fragmentShader->GetReflection()});
+    if (m_Layout.layout == VK_NULL_HANDLE) {
+      m_Result = VK_ERROR_INITIALIZATION_FAILED;
       return;
     }
 
     VkGraphicsPipelineCreateInfo pipelineInfo{};
     pipelineInfo.sType      = VK_STRUCTURE_TYPE_GRAPHICS_PIPELINE_CREATE_INFO;
+    pipelineInfo.flags      = m_Info.flags;
     pipelineInfo.stageCount = 2;
     pipelineInfo.pStages    = shaderStages;
     pipelineInfo.pVertexInputState   = &vertexInputInfo;
@@ -121,16 +189,52 @@ namespace Sera {
     pipelineInfo.pMultisampleState   = &multisampling;
     pipelineInfo.pColorBlendState    = &colorBlending;
     pipelineInfo.pDynamicState       = &dynamicState;
-    pipelineInfo.layout              = m_Layout;
+    pipelineInfo.layout              = m_Layout.layout;
     pipelineInfo.renderPass          = m_Info.renderPass;
     pipelineInfo.subpass             = 0;
     pipelineInfo.basePipelineHandle  = VK_NULL_HANDLE;
     pipelineInfo.pDepthStencilState  = &depthStencil;
 
-    if (vkCreateGraphicsPipelines(m_Info.device->device, VK_NULL_HANDLE, 1,
-                                  &pipelineInfo, nullptr,
-                                  &m_Handle) != VK_SUCCESS) {
+    VkPipelineRenderingCreateInfo renderingInfo{};
+    if (m_Info.renderPass == VK_NULL_HANDLE) {
+      renderingInfo.sType = VK_STRUCTURE_TYPE_PIPELINE_RENDERING_CREATE_INFO;
+      renderingInfo.colorAttachmentCount    = colorAttachmentCount;
+      renderingInfo.pColorAttachmentFormats = m_Info.colorFormats.data();
+      renderingInfo.depthAttachmentFormat   = m_Info.depthFormat;
+      renderingInfo.stencilAttachmentFormat = m_Info.stencilFormat;
+      pipelineInfo.pNext                    = &renderingInfo;
+    }
+
+    VkPipelineCache               cache = VK_NULL_HANDLE;
+    VulkanPipelineCache::Feedback feedback;
+    if (m_Info.pipelineCache) {
+      cache = m_Info.pipelineCache->GetHandle();
+      m_Info.pipelineCache->Attach(feedback, &pipelineInfo.pNext);
+    }
+
+    Timer timer;
+    m_Result = vkCreateGraphicsPipelines(m_Info.device->device, cache, 1,
+                                         &pipelineInfo, m_Info.allocator,
+                                         &m_Handle);
+    if (m_Result == VK_PIPELINE_COMPILE_REQUIRED) return;
+    if (m_Result != VK_SUCCESS) {
       SR_CORE_ERROR("Failed to create graphics pipeline");
+      return;
     }
+#ifdef SR_DEBUG
+    // Named after its shader files, e.g. "scene.vert.spv + scene.frag.spv"
+    std::string name =
+        std::filesystem::path(m_Info.vertexShader->GetPath())
+            .filename()
+            .string() +
+        " + " +
+        std::filesystem::path(m_Info.fragmentShader->GetPath())
+            .filename()
+            .string();
+    SetObjectName(m_Info.device->device, VK_OBJECT_TYPE_PIPELINE, m_Handle,
+                  name.c_str());
+#endif
+    if (m_Info.pipelineCache)
+      m_Info.pipelineCache->Record(feedback, timer.ElapsedMillis());
   }
 }  // namespace Sera
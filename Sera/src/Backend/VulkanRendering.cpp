@@ -0,0 +1,75 @@
+#include "Backend/VulkanRendering.h"
+namespace Sera {
+  static VkRenderingAttachmentInfo ToAttachmentInfo(
+      const RenderingAttachment& attachment) {
+    VkRenderingAttachmentInfo info{};
+    info.sType       = VK_STRUCTURE_TYPE_RENDERING_ATTACHMENT_INFO;
+    info.imageView   = attachment.view;
+    info.imageLayout = attachment.layout;
+    info.resolveMode = VK_RESOLVE_MODE_NONE;
+    info.loadOp      = attachment.loadOp;
+    info.storeOp     = attachment.storeOp;
+    info.clearValue  = attachment.clearValue;
+    return info;
+  }
+
+  void BeginRendering(VkCommandBuffer commandBuffer, VkExtent2D extent,
+                      const RenderingAttachment* colorAttachments,
+                      uint32_t                   colorAttachmentCount,
+                      const RenderingAttachment* depthAttachment,
+                      bool                       hasStencil) {
+    // Passes rarely have more than a handful of color targets
+    VkRenderingAttachmentInfo colors[8] = {};
+    if (colorAttachmentCount > 8) colorAttachmentCount = 8;
+    for (uint32_t i = 0; i < colorAttachmentCount; i++)
+      colors[i] = ToAttachmentInfo(colorAttachments[i]);
+
+    VkRenderingAttachmentInfo depth{};
+    if (depthAttachment) depth = ToAttachmentInfo(*depthAttachment);
+
+    VkRenderingInfo info{};
+    info.sType                = VK_STRUCTURE_TYPE_RENDERING_INFO;
+    info.renderArea.offset    = {0, 0};
+    info.renderArea.extent    = extent;
+    info.layerCount           = 1;
+    info.colorAttachmentCount = colorAttachmentCount;
+    info.pColorAttachments    = colors;
+    info.pDepthAttachment     = depthAttachment ? &depth : nullptr;
+    info.pStencilAttachment =
+        depthAttachment && hasStencil ? &depth : nullptr;
+    vkCmdBeginRendering(commandBuffer, &info);
+  }
+
+  void EndRendering(VkCommandBuffer commandBuffer) {
+    vkCmdEndRendering(commandBuffer);
+  }
+
+  void TransitionImageLayout(VkCommandBuffer commandBuffer, VkImage image,
+                             VkImageAspectFlags aspectMask,
+                             VkImageLayout oldLayout, VkImageLayout newLayout,
+                             VkPipelineStageFlags srcStage,
+                             VkAccessFlags        srcAccess,
+                             VkPipelineStageFlags dstStage,
+                             VkAccessFlags        dstAccess) {
+    VkImageMemoryBarrier barrier = {};
+    barrier.sType = VK_STRUCTURE_TYPE_IMAGE_MEMORY_BARRIER;
+    barrier.srcAccessMask               = srcAccess;
+    barrier.dstAccessMask               = dstAccess;
+    barrier.oldLayout                   = oldLayout;
+    barrier.newLayout                   = newLayout;
+    barrier.srcQueueFamilyIndex         = VK_QUEUE_FAMILY_IGNORED;
+    barrier.dstQueueFamilyIndex         = VK_QUEUE_FAMILY_IGNORED;
+    barrier.image                       = image;
+    barrier.subresourceRange.aspectMask = aspectMask;
+    barrier.subresourceRange.levelCount = VK_REMAINING_MIP_LEVELS;
+    barrier.subresourceRange.layerCount = VK_REMAINING_ARRAY_LAYERS;
+    vkCmdPipelineBarrier(commandBuffer, srcStage, dstStage, 0, 0, nullptr, 0,
+                         nullptr, 1, &barrier);
+  }
+
+  bool IsStencilFormat(VkFormat format) {
+    return format == VK_FORMAT_D16_UNORM_S8_UINT ||
+           format == VK_FORMAT_D24_UNORM_S8_UINT ||
+           format == VK_FORMAT_D32_SFLOAT_S8_UINT;
+  }
+}  // namespace Sera
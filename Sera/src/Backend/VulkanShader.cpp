@@ -0,0 +1,79 @@
+#include "Backend/VulkanShader.h"
+#include "Backend/VulkanDebug.h"
+#include "Backend/VulkanDevice.h"
+#include "Hash.h"
+#include "Log.h"
+#include <fstream>
+namespace Sera {
+  static constexpr uint32_t s_SpirvMagic = 0x07230203;
+
+  bool VulkanShader::ReadSpirv(const std::string&     path,
+                               std::vector<uint32_t>& code) {
+    std::ifstream file{path, std::ios::ate | std::ios::binary};
+    if (!file.is_open()) {
+      SR_CORE_ERROR("Could not open file: {0}", path);
+      return false;
+    }
+    size_t size = (size_t)file.tellg();
+    if (size < sizeof(uint32_t) * 5 || size % sizeof(uint32_t) != 0) {
+      SR_CORE_ERROR("{0} is not a SPIR-V module", path);
+      return false;
+    }
+    code.resize(size / sizeof(uint32_t));
+    file.seekg(0);
+    file.read(reinterpret_cast<char*>(code.data()), size);
+    if (!file || code[0] != s_SpirvMagic) {
+      SR_CORE_ERROR("{0} is not a SPIR-V module", path);
+      return false;
+    }
+    return true;
+  }
+
+  VulkanShader* VulkanShader::Create(CreateInfo info) {
+    return new VulkanShader(info);
+  }
+
+  VulkanShader::~VulkanShader() {
+    vkDestroyShaderModule(m_Info.device->device, m_Handle, m_Info.allocator);
+  }
+
+  VulkanShader::VulkanShader(CreateInfo info) : m_Info(std::move(info)) {
+    size_t codeSize = m_Info.code.size() * sizeof(uint32_t);
+    m_Hash          = HashBytes(m_Info.code.data(), codeSize);
+    HashCombine(m_Hash, m_Info.stage);
+    m_Hash = HashBytes(m_Info.entryPoint.data(), m_Info.entryPoint.size(),
+                       m_Hash);
+
+    if (!ReflectSpirv(m_Info.code, m_Reflection))
+      SR_CORE_WARN("Could not reflect shader {0}", m_Info.path);
+    else if (m_Reflection.stage != m_Info.stage)
+      SR_CORE_WARN("Shader {0} is not a {1} stage shader", m_Info.path,
+                   (uint32_t)m_Info.stage);
+
+    VkShaderModuleCreateInfo ci{};
+    ci.sType    = VK_STRUCTURE_TYPE_SHADER_MODULE_CREATE_INFO;
+    ci.codeSize = codeSize;
+    ci.pCode    = m_Info.code.data();
+    if (vkCreateShaderModule(m_Info.device->device, &ci, m_Info.allocator,
+                             &m_Handle) != VK_SUCCESS) {
+      SR_CORE_ERROR("Could not load Shader {0}", m_Info.path);
+    }
+    SR_DEBUG_NAME(m_Info.device->device, VK_OBJECT_TYPE_SHADER_MODULE,
+                  m_Handle, m_Info.path.c_str());
+  }
+
+  void VulkanShader::CheckSpecialization(
+      const SpecializationConstants& constants) const {
+    static const char* typeNames[] = {"bool", "int", "uint", "float"};
+    for (auto& constant : constants.GetConstants()) {
+      for (auto& declared : m_Reflection.specConstants) {
+        if (declared.id != constant.id || declared.type == constant.type)
+          continue;
+        SR_CORE_WARN("Specialization constant {0} of {1} is a {2}, set as {3}",
+                     constant.id, m_Info.path,
+                     typeNames[(int)declared.type],
+                     typeNames[(int)constant.type]);
+      }
+    }
+  }
+}  // namespace Sera
@@ -1,11 +1,16 @@
 #include "Backend/VulkanSwapchain.h"
-#include <Backends/imgui_impl_vulkan.h>
+#include "backends/imgui_impl_vulkan.h"
 #include <cstdlib>
+#include <cstring>
+#include <string>
+#include "Backend/VulkanDebug.h"
 #include "Backend/VulkanPhysicalDevice.h"
+#include "Backend/VulkanRendering.h"
 #include "Log.h"
+#include "MemoryTracker.h"
 namespace Sera {
   static void DestroyFrame(VkDevice device, Frame* frame,
-                           VkAllocationCallbacks* allocator) {
+                           const VkAllocationCallbacks* allocator) {
     vkDestroyFence(device, frame->Fence, allocator);
     vkFreeCommandBuffers(device, frame->CommandPool, 1, &frame->CommandBuffer);
     vkDestroyCommandPool(device, frame->CommandPool, allocator);
@@ -15,9 +20,16 @@ namespace Sera {
 
     vkDestroyImageView(device, frame->BackbufferView, allocator);
     vkDestroyFramebuffer(device, frame->Framebuffer, allocator);
+
+    // Offscreen backbuffers are owned by us, swapchain images are not
+    if (frame->BackbufferMemory != VK_NULL_HANDLE) {
+      vkDestroyImage(device, frame->Backbuffer, allocator);
+      MemoryTracker::UntrackDeviceMemory(frame->BackbufferMemory);
+      vkFreeMemory(device, frame->BackbufferMemory, allocator);
+    }
   }
   static void DestroyFrameSemaphores(VkDevice device, FrameSemaphores* frame,
-                                     VkAllocationCallbacks* allocator) {
+                                     const VkAllocationCallbacks* allocator) {
     vkDestroySemaphore(device, frame->ImageAvailableSemaphore, allocator);
     vkDestroySemaphore(device, frame->RenderCompleteSemaphore, allocator);
     frame->ImageAvailableSemaphore = frame->RenderCompleteSemaphore =
@@ -33,26 +45,125 @@ namespace Sera {
 
     free(Frames);
     free(FrameSemaphoress);
-    vkDestroySwapchainKHR(m_Device->device, m_Swapchain, m_Allocator);
-    vkDestroyImage(m_Device->device, m_DepthBuffer.Image, m_Allocator);
-    vkDestroyImageView(m_Device->device, m_DepthBuffer.ImageView, m_Allocator);
-    vkFreeMemory(m_Device->device, m_DepthBuffer.Memory, m_Allocator);
+    if (m_Swapchain != VK_NULL_HANDLE)
+      vkDestroySwapchainKHR(m_Device->device, m_Swapchain, m_Allocator);
+    DestroyDepths();
   }
 
-  VulkanSwapchain::VulkanSwapchain(VulkanInstance*        instance,
-                                   VulkanPhysicalDevice*  pDevice,
-                                   VkAllocationCallbacks* allocator,
+  VulkanSwapchain::VulkanSwapchain(VulkanInstance*              instance,
+                                   VulkanPhysicalDevice*        pDevice,
+                                   const VkAllocationCallbacks* allocator,
                                    VulkanDevice* device, bool isVsync,
                                    VkSurfaceFormatKHR surfaceFormat,
-                                   VkSurfaceKHR       surface)
+                                   VkSurfaceKHR       surface,
+                                   VkFormat           depthFormat)
       : m_VkInstance(instance),
         m_Allocator(allocator),
         m_PhysicalDevice(pDevice),
         m_Vsync(isVsync),
         m_Device(device),
         m_Surface(surface),
-        SurfaceFormat(surfaceFormat) {}
+        SurfaceFormat(surfaceFormat),
+        m_DepthFormat(depthFormat) {}
   void VulkanSwapchain::ReCreate() {
+    auto err = m_Device->WaitIdle();
+
+    auto device = m_Device->device;
+    for (uint32_t i = 0; i < ImageCount; i++)
+      DestroyFrame(device, &Frames[i], m_Allocator);
+
+    for (uint32_t i = 0; i < SemaphoreCount; i++)
+      DestroyFrameSemaphores(device, &FrameSemaphoress[i], m_Allocator);
+
+    free(Frames);
+    free(FrameSemaphoress);
+
+    VkImage backbuffers[16] = {};
+    if (IsHeadless())
+      ImageCount = OffscreenImageCount;
+    else
+      CreateSwapchainImages(backbuffers);
+
+    SemaphoreCount = ImageCount;  //+ 1;
+    Frames         = (Frame*)malloc(sizeof(Frame) * ImageCount);
+    FrameSemaphoress =
+        (FrameSemaphores*)malloc(sizeof(FrameSemaphores) * SemaphoreCount);
+
+    memset(Frames, 0, sizeof(Frames[0]) * ImageCount);
+    memset(FrameSemaphoress, 0, sizeof(FrameSemaphoress[0]) * SemaphoreCount);
+
+    if (IsHeadless())
+      CreateOffscreenImages();
+    else
+      for (uint32_t i = 0; i < ImageCount; i++)
+        Frames[i].Backbuffer = backbuffers[i];
+
+    {
+      VkImageViewCreateInfo info = {};
+      info.sType                 = VK_STRUCTURE_TYPE_IMAGE_VIEW_CREATE_INFO;
+      info.viewType              = VK_IMAGE_VIEW_TYPE_2D;
+      info.format                = SurfaceFormat.format;
+      info.components.r          = VK_COMPONENT_SWIZZLE_R;
+      info.components.g          = VK_COMPONENT_SWIZZLE_G;
+      info.components.b          = VK_COMPONENT_SWIZZLE_B;
+      info.components.a          = VK_COMPONENT_SWIZZLE_A;
+      VkImageSubresourceRange image_range = {VK_IMAGE_ASPECT_COLOR_BIT, 0, 1, 0,
+                                             1};
+      info.subresourceRange               = image_range;
+      for (uint32_t i = 0; i < ImageCount; i++) {
+        auto* fd   = &Frames[i];
+        info.image = fd->Backbuffer;
+        err        = vkCreateImageView(m_Device->device, &info, m_Allocator,
+                                       &fd->BackbufferView);
+        if (err != VK_SUCCESS) SR_CORE_ERROR("Could not create image view");
+      }
+    }
+    DestroyDepths();
+    CreateDepths();
+    CreateFramebuffer(VK_NULL_HANDLE);
+    InitializeFenceSemaphore();
+#ifdef SR_DEBUG
+    NameObjects();
+#endif
+  }
+
+#ifdef SR_DEBUG
+  void VulkanSwapchain::NameObjects() {
+    VkDevice device = m_Device->device;
+    SetObjectName(device, VK_OBJECT_TYPE_SWAPCHAIN_KHR, m_Swapchain,
+                  "Swapchain");
+    for (uint32_t i = 0; i < ImageCount; i++) {
+      const Frame& frame = Frames[i];
+      std::string  index = " " + std::to_string(i);
+      SetObjectName(device, VK_OBJECT_TYPE_IMAGE, frame.Backbuffer,
+                    ("Backbuffer" + index).c_str());
+      SetObjectName(device, VK_OBJECT_TYPE_IMAGE_VIEW, frame.BackbufferView,
+                    ("Backbuffer view" + index).c_str());
+      SetObjectName(device, VK_OBJECT_TYPE_DEVICE_MEMORY,
+                    frame.BackbufferMemory,
+                    ("Backbuffer memory" + index).c_str());
+      SetObjectName(device, VK_OBJECT_TYPE_FENCE, frame.Fence,
+                    ("Frame fence" + index).c_str());
+    }
+    for (uint32_t i = 0; i < SemaphoreCount; i++) {
+      const FrameSemaphores& semaphores = FrameSemaphoress[i];
+      std::string            index      = " " + std::to_string(i);
+      SetObjectName(device, VK_OBJECT_TYPE_SEMAPHORE,
+                    semaphores.ImageAvailableSemaphore,
+                    ("Image available" + index).c_str());
+      SetObjectName(device, VK_OBJECT_TYPE_SEMAPHORE,
+                    semaphores.RenderCompleteSemaphore,
+                    ("Render complete" + index).c_str());
+    }
+    SetObjectName(device, VK_OBJECT_TYPE_IMAGE, m_DepthBuffer.Image,
+                  "Depth buffer");
+    SetObjectName(device, VK_OBJECT_TYPE_IMAGE_VIEW, m_DepthBuffer.ImageView,
+                  "Depth buffer view");
+    SetObjectName(device, VK_OBJECT_TYPE_DEVICE_MEMORY, m_DepthBuffer.Memory,
+                  "Depth buffer memory");
+  }
+#endif
+  void VulkanSwapchain::CreateSwapchainImages(VkImage* backbuffers) {
     if (m_Vsync) {
       VkPresentModeKHR present_modes[] = {VK_PRESENT_MODE_FIFO_KHR};
       m_PresentMode                    = ImGui_ImplVulkanH_SelectPresentMode(
@@ -69,17 +180,6 @@ namespace Sera {
     }
     VkSwapchainKHR oldSwapchain = m_Swapchain;
     m_Swapchain                 = VK_NULL_HANDLE;
-    auto err                    = m_Device->WaitIdle();
-
-    auto device = m_Device->device;
-    for (uint32_t i = 0; i < ImageCount; i++)
-      DestroyFrame(device, &Frames[i], m_Allocator);
-
-    for (uint32_t i = 0; i < SemaphoreCount; i++)
-      DestroyFrameSemaphores(device, &FrameSemaphoress[i], m_Allocator);
-
-    free(Frames);
-    free(FrameSemaphoress);
 
     uint32_t minImageCount = 3;
 
@@ -101,7 +201,7 @@ namespace Sera {
     info.oldSwapchain   = oldSwapchain;
 
     VkSurfaceCapabilitiesKHR cap;
-    err = vkGetPhysicalDeviceSurfaceCapabilitiesKHR(
+    auto err = vkGetPhysicalDeviceSurfaceCapabilitiesKHR(
         m_PhysicalDevice->physicalDevice, m_Surface, &cap);
     if (err != VK_SUCCESS) {
       SR_CORE_ERROR("Could not get device surface capabilities");
@@ -126,52 +226,63 @@ namespace Sera {
     if (err != VK_SUCCESS)
       SR_CORE_ERROR("Could not get swapchain swapchain images");
 
-    VkImage backbuffers[16] = {};
     err = vkGetSwapchainImagesKHR(m_Device->device, m_Swapchain, &ImageCount,
                                   backbuffers);
     if (err != VK_SUCCESS)
       SR_CORE_ERROR("Could not get swapchain swapchain images");
 
-    SemaphoreCount = ImageCount;  //+ 1;
-    Frames         = (Frame*)malloc(sizeof(Frame) * ImageCount);
-    FrameSemaphoress =
-        (FrameSemaphores*)malloc(sizeof(FrameSemaphores) * SemaphoreCount);
-
-    memset(Frames, 0, sizeof(Frames[0]) * ImageCount);
-    memset(FrameSemaphoress, 0, sizeof(FrameSemaphoress[0]) * SemaphoreCount);
-
-    for (uint32_t i = 0; i < ImageCount; i++)
-      Frames[i].Backbuffer = backbuffers[i];
-
     if (oldSwapchain)
       vkDestroySwapchainKHR(m_Device->device, oldSwapchain, m_Allocator);
+  }
 
-    {
-      VkImageViewCreateInfo info = {};
-      info.sType                 = VK_STRUCTURE_TYPE_IMAGE_VIEW_CREATE_INFO;
-      info.viewType              = VK_IMAGE_VIEW_TYPE_2D;
-      info.format                = SurfaceFormat.format;
-      info.components.r          = VK_COMPONENT_SWIZZLE_R;
-      info.components.g          = VK_COMPONENT_SWIZZLE_G;
-      info.components.b          = VK_COMPONENT_SWIZZLE_B;
-      info.components.a          = VK_COMPONENT_SWIZZLE_A;
-      VkImageSubresourceRange image_range = {VK_IMAGE_ASPECT_COLOR_BIT, 0, 1, 0,
-                                             1};
-      info.subresourceRange               = image_range;
-      for (uint32_t i = 0; i < ImageCount; i++) {
-        auto* fd   = &Frames[i];
-        info.image = fd->Backbuffer;
-        err        = vkCreateImageView(m_Device->device, &info, m_Allocator,
-                                       &fd->BackbufferView);
-        if (err != VK_SUCCESS) SR_CORE_ERROR("Could not create image view");
-      }
+  void VulkanSwapchain::CreateOffscreenImages() {
+    VkImageCreateInfo imageInfo{};
+    imageInfo.sType         = VK_STRUCTURE_TYPE_IMAGE_CREATE_INFO;
+    imageInfo.imageType     = VK_IMAGE_TYPE_2D;
+    imageInfo.extent.width  = m_Width;
+    imageInfo.extent.height = m_Height;
+    imageInfo.extent.depth  = 1;
+    imageInfo.mipLevels     = 1;
+    imageInfo.arrayLayers   = 1;
+    imageInfo.format        = SurfaceFormat.format;
+    imageInfo.tiling        = VK_IMAGE_TILING_OPTIMAL;
+    imageInfo.initialLayout = VK_IMAGE_LAYOUT_UNDEFINED;
+    imageInfo.usage         = VK_IMAGE_USAGE_COLOR_ATTACHMENT_BIT |
+                      VK_IMAGE_USAGE_TRANSFER_SRC_BIT;
+    imageInfo.samples       = VK_SAMPLE_COUNT_1_BIT;
+    imageInfo.sharingMode   = VK_SHARING_MODE_EXCLUSIVE;
+
+    for (uint32_t i = 0; i < ImageCount; i++) {
+      auto* fd  = &Frames[i];
+      auto  err = vkCreateImage(m_Device->device, &imageInfo, m_Allocator,
+                                &fd->Backbuffer);
+      if (err != VK_SUCCESS) SR_CORE_ERROR("Could not create offscreen image");
+
+      VkMemoryRequirements memRequirements;
+      vkGetImageMemoryRequirements(m_Device->device, fd->Backbuffer,
+                                   &memRequirements);
+      VkMemoryAllocateInfo allocInfo{};
+      allocInfo.sType           = VK_STRUCTURE_TYPE_MEMORY_ALLOCATE_INFO;
+      allocInfo.allocationSize  = memRequirements.size;
+      allocInfo.memoryTypeIndex = m_PhysicalDevice->FindMemoryType(
+          memRequirements.memoryTypeBits, VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT);
+      err = vkAllocateMemory(m_Device->device, &allocInfo, m_Allocator,
+                             &fd->BackbufferMemory);
+      if (err != VK_SUCCESS)
+        SR_CORE_ERROR("Could not allocate offscreen image memory");
+      MemoryTracker::TrackDeviceMemory(fd->BackbufferMemory,
+                                       memRequirements.size,
+                                       allocInfo.memoryTypeIndex, "Swapchain");
+      vkBindImageMemory(m_Device->device, fd->Backbuffer, fd->BackbufferMemory,
+                        0);
     }
-    // FIXME: ! DONT FORGET TO FREE OLD DEPTHS
-    CreateDepths();
-    CreateFramebuffer(VK_NULL_HANDLE);
-    InitializeFenceSemaphore();
   }
+
   void VulkanSwapchain::CreateDepths() {
+    if (m_DepthFormat == VK_FORMAT_UNDEFINED) return;
+
+    // The depth buffer is cleared on load and never stored, so it can live in
+    // lazily allocated (tile) memory on GPUs that expose it.
     VkImageCreateInfo imageInfo{};
     imageInfo.sType         = VK_STRUCTURE_TYPE_IMAGE_CREATE_INFO;
     imageInfo.imageType     = VK_IMAGE_TYPE_2D;
@@ -180,40 +291,43 @@ namespace Sera {
     imageInfo.extent.depth  = 1;
     imageInfo.mipLevels     = 1;
     imageInfo.arrayLayers   = 1;
-    imageInfo.format        = VK_FORMAT_D32_SFLOAT;
+    imageInfo.format        = m_DepthFormat;
     imageInfo.tiling        = VK_IMAGE_TILING_OPTIMAL;
     imageInfo.initialLayout = VK_IMAGE_LAYOUT_UNDEFINED;
-    imageInfo.usage         = VK_IMAGE_USAGE_DEPTH_STENCIL_ATTACHMENT_BIT;
+    imageInfo.usage         = VK_IMAGE_USAGE_DEPTH_STENCIL_ATTACHMENT_BIT |
+                      VK_IMAGE_USAGE_TRANSIENT_ATTACHMENT_BIT;
     imageInfo.samples       = VK_SAMPLE_COUNT_1_BIT;
     imageInfo.sharingMode   = VK_SHARING_MODE_EXCLUSIVE;
 
-    auto err = vkCreateImage(m_Device->device, &imageInfo, nullptr,
+    auto err = vkCreateImage(m_Device->device, &imageInfo, m_Allocator,
                              &m_DepthBuffer.Image);
+    if (err != VK_SUCCESS) SR_CORE_ERROR("Could not create depth image");
+
     VkMemoryRequirements memRequirements;
     vkGetImageMemoryRequirements(m_Device->device, m_DepthBuffer.Image,
                                  &memRequirements);
-    auto findMemoryType = [&](VkPhysicalDevice d, uint32_t filter) {
-      VkPhysicalDeviceMemoryProperties memProperties;
-      vkGetPhysicalDeviceMemoryProperties(d, &memProperties);
-
-      for (uint32_t i = 0; i < memProperties.memoryTypeCount; i++) {
-        if ((filter & (1 << i)) && (memProperties.memoryTypes[i].propertyFlags &
-                                    VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT) ==
-                                       VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT) {
-          return i;
-        }
-      }
+    uint32_t memoryType = m_PhysicalDevice->FindMemoryType(
+        memRequirements.memoryTypeBits,
+        VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT |
+            VK_MEMORY_PROPERTY_LAZILY_ALLOCATED_BIT);
+    if (memoryType == UINT32_MAX)
+      memoryType = m_PhysicalDevice->FindMemoryType(
+          memRequirements.memoryTypeBits, VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT);
+    if (memoryType == UINT32_MAX) {
       SR_CORE_ERROR("Could not found memory type for depth image");
-      return 0u;
-    };
+      memoryType = 0;
+    }
+
     VkMemoryAllocateInfo allocInfo{};
     allocInfo.sType           = VK_STRUCTURE_TYPE_MEMORY_ALLOCATE_INFO;
     allocInfo.allocationSize  = memRequirements.size;
-    allocInfo.memoryTypeIndex = findMemoryType(m_PhysicalDevice->physicalDevice,
-                                               memRequirements.memoryTypeBits);
+    allocInfo.memoryTypeIndex = memoryType;
 
-    err = vkAllocateMemory(m_Device->device, &allocInfo, nullptr,
+    err = vkAllocateMemory(m_Device->device, &allocInfo, m_Allocator,
                            &m_DepthBuffer.Memory);
+    if (err != VK_SUCCESS) SR_CORE_ERROR("Could not allocate depth memory");
+    MemoryTracker::TrackDeviceMemory(m_DepthBuffer.Memory, memRequirements.size,
+                                     memoryType, "Swapchain depth");
 
     vkBindImageMemory(m_Device->device, m_DepthBuffer.Image,
                       m_DepthBuffer.Memory, 0);
@@ -222,8 +336,10 @@ namespace Sera {
       dci.image    = m_DepthBuffer.Image;
       dci.viewType = VK_IMAGE_VIEW_TYPE_2D;
       dci.sType    = VK_STRUCTURE_TYPE_IMAGE_VIEW_CREATE_INFO;
-      dci.format   = VK_FORMAT_D32_SFLOAT;
-      dci.subresourceRange.aspectMask     = VK_IMAGE_ASPECT_DEPTH_BIT;
+      dci.format   = m_DepthFormat;
+      dci.subresourceRange.aspectMask = VK_IMAGE_ASPECT_DEPTH_BIT;
+      if (IsStencilFormat(m_DepthFormat))
+        dci.subresourceRange.aspectMask |= VK_IMAGE_ASPECT_STENCIL_BIT;
       dci.subresourceRange.baseMipLevel   = 0;
       dci.subresourceRange.levelCount     = 1;
       dci.subresourceRange.baseArrayLayer = 0;
@@ -233,11 +349,18 @@ namespace Sera {
     }
   }
 
+  void VulkanSwapchain::DestroyDepths() {
+    vkDestroyImageView(m_Device->device, m_DepthBuffer.ImageView, m_Allocator);
+    vkDestroyImage(m_Device->device, m_DepthBuffer.Image, m_Allocator);
+    MemoryTracker::UntrackDeviceMemory(m_DepthBuffer.Memory);
+    vkFreeMemory(m_Device->device, m_DepthBuffer.Memory, m_Allocator);
+    m_DepthBuffer = {};
+  }
+
   void VulkanSwapchain::CreateFramebuffer(VkRenderPass rp) {
-    if (rp == VK_NULL_HANDLE && m_RenderPass == VK_NULL_HANDLE) {
-      SR_CORE_WARN("Render pass null provieded");
-      return;
-    }
+    // No render pass registered means dynamic rendering, which needs no
+    // framebuffer objects
+    if (rp == VK_NULL_HANDLE && m_RenderPass == VK_NULL_HANDLE) return;
     if (rp != VK_NULL_HANDLE && rp != m_RenderPass) {
       m_RenderPass = rp;
     }
@@ -249,18 +372,35 @@ namespace Sera {
       VkFramebufferCreateInfo framebufferInfo{};
       framebufferInfo.sType      = VK_STRUCTURE_TYPE_FRAMEBUFFER_CREATE_INFO;
       framebufferInfo.renderPass = m_RenderPass;
-      framebufferInfo.attachmentCount = 2;
+      framebufferInfo.attachmentCount =
+          m_DepthBuffer.ImageView != VK_NULL_HANDLE ? 2 : 1;
       framebufferInfo.pAttachments    = attachments;
       framebufferInfo.width           = m_Width;
       framebufferInfo.height          = m_Height;
       framebufferInfo.layers          = 1;
 
       auto err = vkCreateFramebuffer(m_Device->device, &framebufferInfo,
-                                     nullptr, &fb->Framebuffer);
+                                     m_Allocator, &fb->Framebuffer);
       if (err != VK_SUCCESS) SR_CORE_ERROR("Could not create framebuffer");
+      SR_DEBUG_NAME(m_Device->device, VK_OBJECT_TYPE_FRAMEBUFFER,
+                    fb->Framebuffer,
+                    ("Framebuffer " + std::to_string(i)).c_str());
     }
   }
+  VkResult VulkanSwapchain::AcquireNextImage(VkSemaphore imageAvailable) {
+    if (IsHeadless()) {
+      // Offscreen images are reused in order, the frame fence already
+      // guarantees the GPU is done with them
+      ImageIndex = CurrentFrame;
+      return VK_SUCCESS;
+    }
+    return vkAcquireNextImageKHR(m_Device->device, m_Swapchain, UINT64_MAX,
+                                 imageAvailable, VK_NULL_HANDLE, &ImageIndex);
+  }
+
   VkResult VulkanSwapchain::Present(VkQueue queue) {
+    if (IsHeadless()) return VK_SUCCESS;
+
     VkSemaphore render_complete_semaphore =
         FrameSemaphoress[CurrentFrame].RenderCompleteSemaphore;
     VkPresentInfoKHR info = {};
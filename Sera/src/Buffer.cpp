@@ -0,0 +1,323 @@
+#include "Buffer.h"
+
+#include "Application.h"
+#include "FrameStats.h"
+#include "MemoryTracker.h"
+#include "Backend/VulkanDebug.h"
+#include "Backend/VulkanDevice.h"
+#include "Log.h"
+
+#include <algorithm>
+#include <cstring>
+
+namespace Sera {
+
+  namespace Utils {
+
+    static VkBufferUsageFlags BufferUsageToVulkan(BufferUsage usage) {
+      VkBufferUsageFlags flags = 0;
+      if (usage & BufferUsage::Vertex)
+        flags |= VK_BUFFER_USAGE_VERTEX_BUFFER_BIT;
+      if (usage & BufferUsage::Index) flags |= VK_BUFFER_USAGE_INDEX_BUFFER_BIT;
+      if (usage & BufferUsage::Uniform)
+        flags |= VK_BUFFER_USAGE_UNIFORM_BUFFER_BIT;
+      if (usage & BufferUsage::Storage)
+        flags |= VK_BUFFER_USAGE_STORAGE_BUFFER_BIT;
+      if (usage & BufferUsage::Indirect)
+        flags |= VK_BUFFER_USAGE_INDIRECT_BUFFER_BIT;
+      return flags;
+    }
+
+    // Stages and accesses that may read a buffer after an upload
+    static void BufferConsumers(BufferUsage usage, VkPipelineStageFlags& stages,
+                                VkAccessFlags& access) {
+      const VkPipelineStageFlags shaders =
+          VK_PIPELINE_STAGE_VERTEX_SHADER_BIT |
+          VK_PIPELINE_STAGE_FRAGMENT_SHADER_BIT |
+          VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT;
+      stages = 0;
+      access = 0;
+      if (usage & BufferUsage::Vertex) {
+        stages |= VK_PIPELINE_STAGE_VERTEX_INPUT_BIT;
+        access |= VK_ACCESS_VERTEX_ATTRIBUTE_READ_BIT;
+      }
+      if (usage & BufferUsage::Index) {
+        stages |= VK_PIPELINE_STAGE_VERTEX_INPUT_BIT;
+        access |= VK_ACCESS_INDEX_READ_BIT;
+      }
+      if (usage & BufferUsage::Uniform) {
+        stages |= shaders;
+        access |= VK_ACCESS_UNIFORM_READ_BIT;
+      }
+      if (usage & BufferUsage::Storage) {
+        stages |= shaders;
+        access |= VK_ACCESS_SHADER_READ_BIT | VK_ACCESS_SHADER_WRITE_BIT;
+      }
+      if (usage & BufferUsage::Indirect) {
+        stages |= VK_PIPELINE_STAGE_DRAW_INDIRECT_BIT;
+        access |= VK_ACCESS_INDIRECT_COMMAND_READ_BIT;
+      }
+      if (!stages) stages = VK_PIPELINE_STAGE_BOTTOM_OF_PIPE_BIT;
+    }
+
+#ifdef SR_DEBUG
+    // Debug name after the first usage, buffers have no names of their own
+    static const char* BufferName(BufferUsage usage) {
+      if (usage & BufferUsage::Vertex) return "Vertex buffer";
+      if (usage & BufferUsage::Index) return "Index buffer";
+      if (usage & BufferUsage::Uniform) return "Uniform buffer";
+      if (usage & BufferUsage::Storage) return "Storage buffer";
+      if (usage & BufferUsage::Indirect) return "Indirect buffer";
+      return "Buffer";
+    }
+#endif
+
+  }  // namespace Utils
+
+  Buffer::Buffer(uint64_t size, BufferUsage usage, BufferMemory memory,
+                 const void* data)
+      : m_Size(size), m_Usage(usage), m_MemoryType(memory) {
+    Allocate(Application::GetFramesInFlight());
+    if (!data) return;
+    if (m_MemoryType == BufferMemory::Static) {
+      SetData(data, size);
+      return;
+    }
+    // Every frame starts out with the same contents
+    for (uint32_t i = 0; i < m_Copies; i++)
+      memcpy(m_Mapped + i * m_Stride, data, size);
+  }
+
+  Buffer::~Buffer() { Release(); }
+
+  void Buffer::Allocate(uint32_t copies) {
+    m_Generation++;
+    if (m_Size == 0) return;
+
+    VulkanDevice* device = Application::GetVulkanDevice();
+    const VkPhysicalDeviceLimits& limits =
+        device->physicalDevice->properties.limits;
+    bool deviceAddress = device->features.bufferDeviceAddress;
+    bool dynamic       = m_MemoryType == BufferMemory::Dynamic;
+
+    // Copies have to start where uniform and storage descriptors may point
+    VkDeviceSize alignment =
+        std::max<VkDeviceSize>({16, limits.minUniformBufferOffsetAlignment,
+                                limits.minStorageBufferOffsetAlignment});
+    m_Copies = dynamic ? std::max(copies, 1u) : 1;
+    m_Stride = (m_Size + alignment - 1) / alignment * alignment;
+
+    VkResult err;
+
+    VkBufferCreateInfo info = {};
+    info.sType              = VK_STRUCTURE_TYPE_BUFFER_CREATE_INFO;
+    info.size               = m_Stride * m_Copies;
+    info.usage              = Utils::BufferUsageToVulkan(m_Usage);
+    if (!dynamic) info.usage |= VK_BUFFER_USAGE_TRANSFER_DST_BIT;
+    if (deviceAddress) info.usage |= VK_BUFFER_USAGE_SHADER_DEVICE_ADDRESS_BIT;
+    info.sharingMode = VK_SHARING_MODE_EXCLUSIVE;
+    err = vkCreateBuffer(
+        device->device, &info,
+        MemoryTracker::GetAllocationCallbacks(VK_OBJECT_TYPE_BUFFER),
+        &m_Buffer);
+    check_vk_result(err);
+
+    VkMemoryRequirements req;
+    vkGetBufferMemoryRequirements(device->device, m_Buffer, &req);
+    uint32_t memoryType = UINT32_MAX;
+    if (dynamic) {
+      // Resizable BAR lets the CPU write straight into VRAM, fall back to
+      // system memory the GPU reads over PCIe
+      memoryType = device->physicalDevice->FindMemoryType(
+          req.memoryTypeBits, VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT |
+                                  VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT |
+                                  VK_MEMORY_PROPERTY_HOST_COHERENT_BIT);
+      if (memoryType == UINT32_MAX)
+        memoryType = device->physicalDevice->FindMemoryType(
+            req.memoryTypeBits, VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT |
+                                    VK_MEMORY_PROPERTY_HOST_COHERENT_BIT);
+    } else {
+      memoryType = device->physicalDevice->FindMemoryType(
+          req.memoryTypeBits, VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT);
+    }
+
+    VkMemoryAllocateFlagsInfo flagsInfo = {};
+    flagsInfo.sType = VK_STRUCTURE_TYPE_MEMORY_ALLOCATE_FLAGS_INFO;
+    flagsInfo.flags = VK_MEMORY_ALLOCATE_DEVICE_ADDRESS_BIT;
+    VkMemoryAllocateInfo alloc_info = {};
+    alloc_info.sType                = VK_STRUCTURE_TYPE_MEMORY_ALLOCATE_INFO;
+    alloc_info.pNext                = deviceAddress ? &flagsInfo : nullptr;
+    alloc_info.allocationSize       = req.size;
+    alloc_info.memoryTypeIndex      = memoryType;
+    err = vkAllocateMemory(
+        device->device, &alloc_info,
+        MemoryTracker::GetAllocationCallbacks(VK_OBJECT_TYPE_DEVICE_MEMORY),
+        &m_Memory);
+    check_vk_result(err);
+    MemoryTracker::TrackDeviceMemory(m_Memory, req.size, memoryType, "Buffer");
+    err = vkBindBufferMemory(device->device, m_Buffer, m_Memory, 0);
+    check_vk_result(err);
+    SR_DEBUG_NAME(device->device, VK_OBJECT_TYPE_BUFFER, m_Buffer,
+                  Utils::BufferName(m_Usage));
+    SR_DEBUG_NAME(device->device, VK_OBJECT_TYPE_DEVICE_MEMORY, m_Memory,
+                  Utils::BufferName(m_Usage));
+
+    if (dynamic) {
+      err = vkMapMemory(device->device, m_Memory, 0, VK_WHOLE_SIZE, 0,
+                        (void**)&m_Mapped);
+      check_vk_result(err);
+    }
+
+    if (deviceAddress) {
+      VkBufferDeviceAddressInfo addressInfo = {};
+      addressInfo.sType  = VK_STRUCTURE_TYPE_BUFFER_DEVICE_ADDRESS_INFO;
+      addressInfo.buffer = m_Buffer;
+      m_DeviceAddress = vkGetBufferDeviceAddress(device->device, &addressInfo);
+    }
+  }
+
+  void Buffer::Release() {
+    // Freeing the memory unmaps it
+    Application::SubmitResourceFree([buffer = m_Buffer, memory = m_Memory]() {
+      VkDevice device = Application::GetDevice();
+
+      vkDestroyBuffer(
+          device, buffer,
+          MemoryTracker::GetAllocationCallbacks(VK_OBJECT_TYPE_BUFFER));
+      MemoryTracker::UntrackDeviceMemory(memory);
+      vkFreeMemory(
+          device, memory,
+          MemoryTracker::GetAllocationCallbacks(VK_OBJECT_TYPE_DEVICE_MEMORY));
+    });
+
+    m_Buffer        = nullptr;
+    m_Memory        = nullptr;
+    m_Mapped        = nullptr;
+    m_DeviceAddress = 0;
+  }
+
+  void Buffer::SetData(const void* data, uint64_t size, uint64_t offset) {
+    if (offset + size > m_Size) {
+      SR_CORE_ERROR("Writing {0} bytes at {1} into a buffer of {2} bytes",
+                    size, offset, m_Size);
+      return;
+    }
+    if (size == 0) return;
+
+    if (m_MemoryType == BufferMemory::Dynamic) {
+      memcpy((uint8_t*)GetMappedData() + offset, data, size);
+      return;
+    }
+
+    VkDevice device = Application::GetDevice();
+
+    VkResult err;
+
+    // Only needed for this copy, FlushCommandBuffer() waits for it
+    VkBuffer       stagingBuffer;
+    VkDeviceMemory stagingBufferMemory;
+    {
+      VkBufferCreateInfo buffer_info = {};
+      buffer_info.sType              = VK_STRUCTURE_TYPE_BUFFER_CREATE_INFO;
+      buffer_info.size               = size;
+      buffer_info.usage              = VK_BUFFER_USAGE_TRANSFER_SRC_BIT;
+      buffer_info.sharingMode        = VK_SHARING_MODE_EXCLUSIVE;
+      err = vkCreateBuffer(
+          device, &buffer_info,
+          MemoryTracker::GetAllocationCallbacks(VK_OBJECT_TYPE_BUFFER),
+          &stagingBuffer);
+      check_vk_result(err);
+      VkMemoryRequirements req;
+      vkGetBufferMemoryRequirements(device, stagingBuffer, &req);
+      VkMemoryAllocateInfo alloc_info = {};
+      alloc_info.sType          = VK_STRUCTURE_TYPE_MEMORY_ALLOCATE_INFO;
+      alloc_info.allocationSize = req.size;
+      alloc_info.memoryTypeIndex =
+          Application::GetVulkanDevice()->physicalDevice->FindMemoryType(
+              req.memoryTypeBits, VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT |
+                                      VK_MEMORY_PROPERTY_HOST_COHERENT_BIT);
+      err = vkAllocateMemory(
+          device, &alloc_info,
+          MemoryTracker::GetAllocationCallbacks(VK_OBJECT_TYPE_DEVICE_MEMORY),
+          &stagingBufferMemory);
+      check_vk_result(err);
+      MemoryTracker::TrackDeviceMemory(stagingBufferMemory, req.size,
+                                       alloc_info.memoryTypeIndex,
+                                       "Buffer staging");
+      err = vkBindBufferMemory(device, stagingBuffer, stagingBufferMemory, 0);
+      check_vk_result(err);
+      SR_DEBUG_NAME(device, VK_OBJECT_TYPE_BUFFER, stagingBuffer,
+                    "Buffer staging");
+
+      void* map = nullptr;
+      err = vkMapMemory(device, stagingBufferMemory, 0, size, 0, &map);
+      check_vk_result(err);
+      memcpy(map, data, size);
+      vkUnmapMemory(device, stagingBufferMemory);
+    }
+
+    // Copy to Buffer
+    {
+      VkCommandBuffer command_buffer = Application::GetCommandBuffer(true);
+
+      VkBufferCopy region = {};
+      region.srcOffset    = 0;
+      region.dstOffset    = offset;
+      region.size         = size;
+      vkCmdCopyBuffer(command_buffer, stagingBuffer, m_Buffer, 1, &region);
+
+      VkPipelineStageFlags stages;
+      VkAccessFlags        access;
+      Utils::BufferConsumers(m_Usage, stages, access);
+      VkMemoryBarrier use_barrier = {};
+      use_barrier.sType           = VK_STRUCTURE_TYPE_MEMORY_BARRIER;
+      use_barrier.srcAccessMask   = VK_ACCESS_TRANSFER_WRITE_BIT;
+      use_barrier.dstAccessMask   = access;
+      vkCmdPipelineBarrier(command_buffer, VK_PIPELINE_STAGE_TRANSFER_BIT,
+                           stages, 0, 1, &use_barrier, 0, NULL, 0, NULL);
+
+      Application::FlushCommandBuffer(command_buffer);
+      FrameStats::AddUpload(size);
+    }
+
+    vkDestroyBuffer(
+        device, stagingBuffer,
+        MemoryTracker::GetAllocationCallbacks(VK_OBJECT_TYPE_BUFFER));
+    MemoryTracker::UntrackDeviceMemory(stagingBufferMemory);
+    vkFreeMemory(
+        device, stagingBufferMemory,
+        MemoryTracker::GetAllocationCallbacks(VK_OBJECT_TYPE_DEVICE_MEMORY));
+  }
+
+  void* Buffer::GetMappedData() {
+    if (m_MemoryType != BufferMemory::Dynamic) return nullptr;
+
+    // The swapchain was recreated with more images, the old copies stay
+    // alive until the frames using them are done
+    uint32_t frame = Application::GetCurrentFrameInFlight();
+    if (frame >= m_Copies) {
+      Release();
+      Allocate(Application::GetFramesInFlight());
+    }
+    return m_Mapped ? m_Mapped + frame * m_Stride : nullptr;
+  }
+
+  void Buffer::Resize(uint64_t size) {
+    if (m_Buffer && m_Size == size) return;
+
+    m_Size = size;
+
+    Release();
+    Allocate(Application::GetFramesInFlight());
+  }
+
+  VkDeviceSize Buffer::GetOffset() const {
+    if (m_MemoryType == BufferMemory::Static) return 0;
+    return Application::GetCurrentFrameInFlight() % m_Copies * m_Stride;
+  }
+
+  VkDeviceAddress Buffer::GetDeviceAddress() const {
+    return m_DeviceAddress ? m_DeviceAddress + GetOffset() : 0;
+  }
+
+}  // namespace Sera
@@ -0,0 +1,245 @@
+#include "Compute.h"
+
+#include "Application.h"
+#include "Buffer.h"
+#include "Image.h"
+#include "Log.h"
+
+#include "Backend/VulkanComputePipeline.h"
+#include "Backend/VulkanShader.h"
+
+#include <algorithm>
+
+namespace Sera {
+
+  namespace Utils {
+
+    static const SpirvReflection::Binding* FindBinding(
+        const VulkanComputePipeline* pipeline, uint32_t binding) {
+      const auto& shader = pipeline->GetInfo().shader;
+      for (auto& reflected : shader->GetReflection().bindings)
+        if (reflected.set == 0 && reflected.binding == binding)
+          return &reflected;
+      return nullptr;
+    }
+
+  }  // namespace Utils
+
+  ComputeShader::ComputeShader(
+      const uint32_t* spirv, size_t wordCount, std::string_view name,
+      const SpecializationConstants& specialization) {
+    Create(std::vector<uint32_t>(spirv, spirv + wordCount), std::string(name),
+           specialization);
+  }
+
+  ComputeShader::ComputeShader(std::string_view               path,
+                               const SpecializationConstants& specialization) {
+    std::string           filepath(path);
+    std::vector<uint32_t> code;
+    if (VulkanShader::ReadSpirv(filepath, code))
+      Create(std::move(code), filepath, specialization);
+  }
+
+  ComputeShader::~ComputeShader() {
+    // Frames in flight may still dispatch it
+    Application::SubmitResourceFree(
+        [pipeline = m_Pipeline]() { delete pipeline; });
+  }
+
+  void ComputeShader::Create(std::vector<uint32_t>&&        code,
+                             const std::string&             path,
+                             const SpecializationConstants& specialization) {
+    VulkanShader::CreateInfo shaderInfo{};
+    shaderInfo.device = Application::GetVulkanDevice();
+    shaderInfo.stage  = VK_SHADER_STAGE_COMPUTE_BIT;
+    shaderInfo.code   = std::move(code);
+    shaderInfo.path   = path;
+    std::shared_ptr<VulkanShader> shader(VulkanShader::Create(shaderInfo));
+    if (shader->GetHandle() == VK_NULL_HANDLE) return;
+
+    VulkanComputePipeline::CreateInfo info{};
+    info.device         = Application::GetVulkanDevice();
+    info.shader         = shader;
+    info.pipelineCache  = Application::GetVulkanPipelineCache();
+    info.layoutCache    = Application::GetLayoutCache();
+    info.specialization = specialization;
+    m_Pipeline          = VulkanComputePipeline::Create(info);
+    if (m_Pipeline->GetResult() != VK_SUCCESS) {
+      delete m_Pipeline;
+      m_Pipeline = nullptr;
+    }
+  }
+
+  bool ComputeShader::IsValid() const { return m_Pipeline != nullptr; }
+
+  uint32_t ComputeShader::GetLocalSizeX() const {
+    return m_Pipeline ? m_Pipeline->GetLocalSize()[0] : 1;
+  }
+
+  uint32_t ComputeShader::GetLocalSizeY() const {
+    return m_Pipeline ? m_Pipeline->GetLocalSize()[1] : 1;
+  }
+
+  uint32_t ComputeShader::GetLocalSizeZ() const {
+    return m_Pipeline ? m_Pipeline->GetLocalSize()[2] : 1;
+  }
+
+  ComputeDispatch::ComputeDispatch(VkCommandBuffer      commandBuffer,
+                                   const ComputeShader& shader)
+      : m_CommandBuffer(commandBuffer), m_Shader(shader) {}
+
+  ComputeDispatch& ComputeDispatch::Bind(uint32_t binding, Image& image) {
+    m_Images.push_back({binding, &image});
+    return *this;
+  }
+
+  ComputeDispatch& ComputeDispatch::Bind(uint32_t binding, VkBuffer buffer,
+                                         VkDeviceSize offset,
+                                         VkDeviceSize range) {
+    m_Buffers.push_back({binding, buffer, offset, range});
+    return *this;
+  }
+
+  ComputeDispatch& ComputeDispatch::Bind(uint32_t      binding,
+                                         const Buffer& buffer) {
+    return Bind(binding, buffer.GetBuffer(), buffer.GetOffset(),
+                buffer.GetSize());
+  }
+
+  ComputeDispatch& ComputeDispatch::Push(const void* data, uint32_t size) {
+    const uint8_t* bytes = static_cast<const uint8_t*>(data);
+    m_PushConstants.assign(bytes, bytes + size);
+    return *this;
+  }
+
+  void ComputeDispatch::Dispatch(const Image& target) {
+    uint32_t localX = m_Shader.GetLocalSizeX();
+    uint32_t localY = m_Shader.GetLocalSizeY();
+    Dispatch((target.GetWidth() + localX - 1) / localX,
+             (target.GetHeight() + localY - 1) / localY);
+  }
+
+  void ComputeDispatch::Dispatch(uint32_t groupsX, uint32_t groupsY,
+                                 uint32_t groupsZ) {
+    VulkanComputePipeline* pipeline = m_Shader.GetPipeline();
+    if (!pipeline) return;
+
+    // Allocated before anything is recorded, so a failure skips the whole
+    // dispatch
+    const auto&     setLayouts = pipeline->GetSetLayouts();
+    VkDescriptorSet set        = VK_NULL_HANDLE;
+    if (!setLayouts.empty()) {
+      set = Application::AllocateFrameDescriptorSet(setLayouts[0]);
+      if (set == VK_NULL_HANDLE) {
+        SR_CORE_ERROR("Could not allocate a descriptor set, skipping dispatch");
+        return;
+      }
+    }
+
+    // Whoever used the resources last, e.g. last frame's draw sampling the
+    // image, finishes before the shader writes them
+    for (auto& [binding, image] : m_Images)
+      image->TransitionLayout(
+          m_CommandBuffer, VK_IMAGE_LAYOUT_GENERAL,
+          VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT,
+          VK_ACCESS_SHADER_READ_BIT | VK_ACCESS_SHADER_WRITE_BIT);
+    if (!m_Buffers.empty()) {
+      VkMemoryBarrier barrier = {};
+      barrier.sType           = VK_STRUCTURE_TYPE_MEMORY_BARRIER;
+      barrier.srcAccessMask   = VK_ACCESS_MEMORY_WRITE_BIT;
+      barrier.dstAccessMask =
+          VK_ACCESS_SHADER_READ_BIT | VK_ACCESS_SHADER_WRITE_BIT;
+      vkCmdPipelineBarrier(m_CommandBuffer, VK_PIPELINE_STAGE_ALL_COMMANDS_BIT,
+                           VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT, 0, 1, &barrier,
+                           0, nullptr, 0, nullptr);
+    }
+
+    vkCmdBindPipeline(m_CommandBuffer, VK_PIPELINE_BIND_POINT_COMPUTE,
+                      pipeline->GetHandle());
+
+    if (set != VK_NULL_HANDLE) {
+      // Reserved up front, the writes point into the info arrays
+      std::vector<VkDescriptorImageInfo>  imageInfos;
+      std::vector<VkDescriptorBufferInfo> bufferInfos;
+      std::vector<VkWriteDescriptorSet>   writes;
+      imageInfos.reserve(m_Images.size());
+      bufferInfos.reserve(m_Buffers.size());
+      writes.reserve(m_Images.size() + m_Buffers.size());
+
+      auto write = [&](uint32_t binding, VkDescriptorType type) {
+        VkWriteDescriptorSet w = {};
+        w.sType                = VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET;
+        w.dstSet               = set;
+        w.dstBinding           = binding;
+        w.descriptorCount      = 1;
+        w.descriptorType       = type;
+        writes.push_back(w);
+        return &writes.back();
+      };
+
+      for (auto& [binding, image] : m_Images) {
+        auto* reflected = Utils::FindBinding(pipeline, binding);
+        if (!reflected || reflected->type != VK_DESCRIPTOR_TYPE_STORAGE_IMAGE) {
+          SR_CORE_WARN("Binding {0} is not a storage image", binding);
+          continue;
+        }
+        imageInfos.push_back(
+            {VK_NULL_HANDLE, image->GetImageView(), VK_IMAGE_LAYOUT_GENERAL});
+        write(binding, reflected->type)->pImageInfo = &imageInfos.back();
+      }
+      for (auto& buffer : m_Buffers) {
+        auto* reflected = Utils::FindBinding(pipeline, buffer.binding);
+        if (!reflected ||
+            (reflected->type != VK_DESCRIPTOR_TYPE_STORAGE_BUFFER &&
+             reflected->type != VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER)) {
+          SR_CORE_WARN("Binding {0} is not a buffer", buffer.binding);
+          continue;
+        }
+        bufferInfos.push_back({buffer.buffer, buffer.offset, buffer.range});
+        write(buffer.binding, reflected->type)->pBufferInfo =
+            &bufferInfos.back();
+      }
+
+      vkUpdateDescriptorSets(Application::GetDevice(), (uint32_t)writes.size(),
+                             writes.data(), 0, nullptr);
+      vkCmdBindDescriptorSets(m_CommandBuffer, VK_PIPELINE_BIND_POINT_COMPUTE,
+                              pipeline->GetLayout(), 0, 1, &set, 0, nullptr);
+    }
+
+    const VkPushConstantRange& range = pipeline->GetPushConstantRange();
+    if (!m_PushConstants.empty() && range.size > 0) {
+      uint32_t size = std::min((uint32_t)m_PushConstants.size(), range.size);
+      vkCmdPushConstants(m_CommandBuffer, pipeline->GetLayout(),
+                         range.stageFlags, 0, size, m_PushConstants.data());
+    }
+
+    vkCmdDispatch(m_CommandBuffer, groupsX, groupsY, groupsZ);
+
+    // Results are visible to the sampling draw and to vertex, index,
+    // indirect and transfer reads of the buffers
+    for (auto& [binding, image] : m_Images)
+      image->TransitionLayout(m_CommandBuffer,
+                              VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL,
+                              VK_PIPELINE_STAGE_FRAGMENT_SHADER_BIT,
+                              VK_ACCESS_SHADER_READ_BIT);
+    if (!m_Buffers.empty()) {
+      VkMemoryBarrier barrier = {};
+      barrier.sType           = VK_STRUCTURE_TYPE_MEMORY_BARRIER;
+      barrier.srcAccessMask   = VK_ACCESS_SHADER_WRITE_BIT;
+      barrier.dstAccessMask =
+          VK_ACCESS_INDIRECT_COMMAND_READ_BIT | VK_ACCESS_INDEX_READ_BIT |
+          VK_ACCESS_VERTEX_ATTRIBUTE_READ_BIT | VK_ACCESS_UNIFORM_READ_BIT |
+          VK_ACCESS_SHADER_READ_BIT | VK_ACCESS_TRANSFER_READ_BIT;
+      VkPipelineStageFlags dstStages =
+          VK_PIPELINE_STAGE_DRAW_INDIRECT_BIT |
+          VK_PIPELINE_STAGE_VERTEX_INPUT_BIT |
+          VK_PIPELINE_STAGE_VERTEX_SHADER_BIT |
+          VK_PIPELINE_STAGE_FRAGMENT_SHADER_BIT |
+          VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT | VK_PIPELINE_STAGE_TRANSFER_BIT;
+      vkCmdPipelineBarrier(m_CommandBuffer,
+                           VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT, dstStages, 0,
+                           1, &barrier, 0, nullptr, 0, nullptr);
+    }
+  }
+
+}  // namespace Sera
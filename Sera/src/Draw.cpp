@@ -0,0 +1,211 @@
+#include "Draw.h"
+
+#include "Application.h"
+#include "Buffer.h"
+#include "FrameStats.h"
+#include "Log.h"
+
+#include "Backend/VulkanDevice.h"
+#include "Backend/VulkanRenderPipeline.h"
+#include "Backend/VulkanShader.h"
+
+#include <algorithm>
+
+namespace Sera {
+
+  namespace Utils {
+
+    static const SpirvReflection::Binding* FindBinding(
+        const VulkanRenderPipeline* pipeline, uint32_t binding) {
+      for (const auto* shader : {pipeline->GetInfo().vertexShader.get(),
+                                 pipeline->GetInfo().fragmentShader.get()})
+        for (auto& reflected : shader->GetReflection().bindings)
+          if (reflected.set == 0 && reflected.binding == binding)
+            return &reflected;
+      return nullptr;
+    }
+
+  }  // namespace Utils
+
+  DrawCall::DrawCall(VkCommandBuffer       commandBuffer,
+                     VulkanRenderPipeline* pipeline)
+      : m_CommandBuffer(commandBuffer), m_Pipeline(pipeline) {
+    VkExtent2D extent   = Application::GetFramebufferExtent();
+    m_Viewport.width    = (float)extent.width;
+    m_Viewport.height   = (float)extent.height;
+    m_Viewport.maxDepth = 1.0f;
+  }
+
+  DrawCall& DrawCall::BindVertexBuffer(uint32_t binding, const Buffer& buffer) {
+    m_VertexBuffers.push_back(
+        {binding, buffer.GetBuffer(), buffer.GetOffset()});
+    return *this;
+  }
+
+  DrawCall& DrawCall::BindIndexBuffer(const Buffer& buffer, VkIndexType type) {
+    m_IndexBuffer = buffer.GetBuffer();
+    m_IndexOffset = buffer.GetOffset();
+    m_IndexType   = type;
+    return *this;
+  }
+
+  DrawCall& DrawCall::Bind(uint32_t binding, const Buffer& buffer) {
+    m_Buffers.push_back(
+        {binding, buffer.GetBuffer(), buffer.GetOffset(), buffer.GetSize()});
+    return *this;
+  }
+
+  DrawCall& DrawCall::Push(const void* data, uint32_t size) {
+    const uint8_t* bytes = static_cast<const uint8_t*>(data);
+    m_PushConstants.assign(bytes, bytes + size);
+    return *this;
+  }
+
+  DrawCall& DrawCall::SetViewport(float x, float y, float width,
+                                  float height) {
+    m_Viewport.x      = x;
+    m_Viewport.y      = y;
+    m_Viewport.width  = width;
+    m_Viewport.height = height;
+    return *this;
+  }
+
+  void DrawCall::Draw(uint32_t vertexCount, uint32_t instanceCount,
+                      uint32_t firstVertex, uint32_t firstInstance) {
+    if (!Record()) return;
+    vkCmdDraw(m_CommandBuffer, vertexCount, instanceCount, firstVertex,
+              firstInstance);
+    FrameStats::AddDrawCalls();
+  }
+
+  void DrawCall::DrawIndexed(uint32_t indexCount, uint32_t instanceCount,
+                             uint32_t firstIndex, int32_t vertexOffset,
+                             uint32_t firstInstance) {
+    if (!m_IndexBuffer) {
+      SR_CORE_WARN("DrawIndexed without an index buffer");
+      return;
+    }
+    if (!Record()) return;
+    vkCmdBindIndexBuffer(m_CommandBuffer, m_IndexBuffer, m_IndexOffset,
+                         m_IndexType);
+    vkCmdDrawIndexed(m_CommandBuffer, indexCount, instanceCount, firstIndex,
+                     vertexOffset, firstInstance);
+    FrameStats::AddDrawCalls();
+  }
+
+  void DrawCall::DrawIndexedIndirect(const Buffer& commands,
+                                     uint32_t      drawCount) {
+    if (!m_IndexBuffer) {
+      SR_CORE_WARN("DrawIndexedIndirect without an index buffer");
+      return;
+    }
+    if (!Record()) return;
+    vkCmdBindIndexBuffer(m_CommandBuffer, m_IndexBuffer, m_IndexOffset,
+                         m_IndexType);
+    const uint32_t stride = sizeof(VkDrawIndexedIndirectCommand);
+    if (drawCount <= 1 ||
+        Application::GetVulkanDevice()->features.multiDrawIndirect) {
+      vkCmdDrawIndexedIndirect(m_CommandBuffer, commands.GetBuffer(),
+                               commands.GetOffset(), drawCount, stride);
+    } else {
+      // One command per draw, the bindings stay
+      for (uint32_t i = 0; i < drawCount; i++)
+        vkCmdDrawIndexedIndirect(m_CommandBuffer, commands.GetBuffer(),
+                                 commands.GetOffset() + i * stride, 1,
+                                 stride);
+    }
+    FrameStats::AddDrawCalls();
+  }
+
+  void DrawCall::DrawIndexedIndirectCount(const Buffer& commands,
+                                          const Buffer& count,
+                                          uint32_t      maxDrawCount) {
+    if (!m_IndexBuffer) {
+      SR_CORE_WARN("DrawIndexedIndirectCount without an index buffer");
+      return;
+    }
+    if (!Application::GetVulkanDevice()->features.drawIndirectCount) {
+      SR_CORE_WARN("DrawIndexedIndirectCount without drawIndirectCount");
+      return;
+    }
+    if (!Record()) return;
+    vkCmdBindIndexBuffer(m_CommandBuffer, m_IndexBuffer, m_IndexOffset,
+                         m_IndexType);
+    vkCmdDrawIndexedIndirectCount(m_CommandBuffer, commands.GetBuffer(),
+                                  commands.GetOffset(), count.GetBuffer(),
+                                  count.GetOffset(), maxDrawCount,
+                                  sizeof(VkDrawIndexedIndirectCommand));
+    FrameStats::AddDrawCalls();
+  }
+
+  bool DrawCall::Record() {
+    if (!m_Pipeline) return false;
+
+    // Allocated before anything is recorded, so a failure skips the whole
+    // draw
+    const auto&     setLayouts = m_Pipeline->GetSetLayouts();
+    VkDescriptorSet set        = VK_NULL_HANDLE;
+    if (!setLayouts.empty() && !m_Buffers.empty()) {
+      set = Application::AllocateFrameDescriptorSet(setLayouts[0]);
+      if (set == VK_NULL_HANDLE) {
+        SR_CORE_ERROR("Could not allocate a descriptor set, skipping draw");
+        return false;
+      }
+    }
+
+    vkCmdBindPipeline(m_CommandBuffer, VK_PIPELINE_BIND_POINT_GRAPHICS,
+                      m_Pipeline->GetHandle());
+
+    VkRect2D scissor{};
+    scissor.offset = {(int32_t)m_Viewport.x, (int32_t)m_Viewport.y};
+    scissor.extent = {(uint32_t)m_Viewport.width,
+                      (uint32_t)m_Viewport.height};
+    vkCmdSetViewport(m_CommandBuffer, 0, 1, &m_Viewport);
+    vkCmdSetScissor(m_CommandBuffer, 0, 1, &scissor);
+
+    for (auto& vertex : m_VertexBuffers)
+      vkCmdBindVertexBuffers(m_CommandBuffer, vertex.binding, 1,
+                             &vertex.buffer, &vertex.offset);
+
+    if (set != VK_NULL_HANDLE) {
+      // Reserved up front, the writes point into the info array
+      std::vector<VkDescriptorBufferInfo> bufferInfos;
+      std::vector<VkWriteDescriptorSet>   writes;
+      bufferInfos.reserve(m_Buffers.size());
+      writes.reserve(m_Buffers.size());
+
+      for (auto& buffer : m_Buffers) {
+        auto* reflected = Utils::FindBinding(m_Pipeline, buffer.binding);
+        if (!reflected ||
+            (reflected->type != VK_DESCRIPTOR_TYPE_STORAGE_BUFFER &&
+             reflected->type != VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER)) {
+          SR_CORE_WARN("Binding {0} is not a buffer", buffer.binding);
+          continue;
+        }
+        bufferInfos.push_back({buffer.buffer, buffer.offset, buffer.range});
+        VkWriteDescriptorSet w = {};
+        w.sType                = VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET;
+        w.dstSet               = set;
+        w.dstBinding           = buffer.binding;
+        w.descriptorCount      = 1;
+        w.descriptorType       = reflected->type;
+        w.pBufferInfo          = &bufferInfos.back();
+        writes.push_back(w);
+      }
+
+      vkUpdateDescriptorSets(Application::GetDevice(), (uint32_t)writes.size(),
+                             writes.data(), 0, nullptr);
+      vkCmdBindDescriptorSets(m_CommandBuffer, VK_PIPELINE_BIND_POINT_GRAPHICS,
+                              m_Pipeline->GetLayout(), 0, 1, &set, 0, nullptr);
+    }
+
+    const VkPushConstantRange& range = m_Pipeline->GetPushConstantRange();
+    if (!m_PushConstants.empty() && range.size > 0) {
+      uint32_t size = std::min((uint32_t)m_PushConstants.size(), range.size);
+      vkCmdPushConstants(m_CommandBuffer, m_Pipeline->GetLayout(),
+                         range.stageFlags, 0, size, m_PushConstants.data());
+    }
+    return true;
+  }
+
+}  // namespace Sera
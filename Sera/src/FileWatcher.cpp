@@ -0,0 +1,94 @@
+#include "FileWatcher.h"
+#include "Log.h"
+
+#include <algorithm>
+
+#ifdef __linux__
+#include <sys/inotify.h>
+#include <unistd.h>
+#include <cerrno>
+#endif
+
+namespace Sera {
+
+#ifdef __linux__
+  FileWatcher::FileWatcher(const std::string &directory)
+      : m_Directory(directory) {
+    m_Fd = inotify_init1(IN_NONBLOCK | IN_CLOEXEC);
+    if (m_Fd < 0) {
+      SR_CORE_WARN("inotify unavailable, not watching {0}", m_Directory);
+      return;
+    }
+    // Compilers either write in place or rename a finished temporary file
+    m_Watch = inotify_add_watch(m_Fd, m_Directory.c_str(),
+                                IN_CLOSE_WRITE | IN_MOVED_TO);
+    if (m_Watch < 0) {
+      SR_CORE_WARN("Could not watch {0}", m_Directory);
+      return;
+    }
+    m_Watching = true;
+  }
+
+  FileWatcher::~FileWatcher() {
+    if (m_Fd >= 0) close(m_Fd);
+  }
+
+  std::vector<std::string> FileWatcher::Poll() {
+    std::vector<std::string> changed;
+    if (!m_Watching) return changed;
+
+    alignas(inotify_event) char buffer[4096];
+    while (true) {
+      ssize_t length = read(m_Fd, buffer, sizeof(buffer));
+      if (length <= 0) break;
+      for (ssize_t offset = 0; offset < length;) {
+        auto *event = reinterpret_cast<inotify_event *>(buffer + offset);
+        if (event->len > 0) {
+          std::string path =
+              (std::filesystem::path(m_Directory) / event->name).string();
+          if (std::find(changed.begin(), changed.end(), path) == changed.end())
+            changed.push_back(path);
+        }
+        offset += sizeof(inotify_event) + event->len;
+      }
+    }
+    return changed;
+  }
+#else
+  // Below this the check would cost more than the reload latency it saves
+  static constexpr float s_PollInterval = 0.5f;
+
+  FileWatcher::FileWatcher(const std::string &directory)
+      : m_Directory(directory) {
+    std::error_code ec;
+    for (auto &entry : std::filesystem::directory_iterator(m_Directory, ec))
+      m_Files[entry.path().string()] = entry.last_write_time(ec);
+    if (ec) {
+      SR_CORE_WARN("Could not watch {0}", m_Directory);
+      return;
+    }
+    m_Watching = true;
+  }
+
+  FileWatcher::~FileWatcher() {}
+
+  std::vector<std::string> FileWatcher::Poll() {
+    std::vector<std::string> changed;
+    if (!m_Watching || m_PollTimer.Elapsed() < s_PollInterval) return changed;
+    m_PollTimer.Reset();
+
+    std::error_code ec;
+    for (auto &entry : std::filesystem::directory_iterator(m_Directory, ec)) {
+      auto time = entry.last_write_time(ec);
+      if (ec) continue;
+      auto [it, inserted] = m_Files.try_emplace(entry.path().string(), time);
+      if (inserted || it->second != time) {
+        it->second = time;
+        changed.push_back(it->first);
+      }
+    }
+    return changed;
+  }
+#endif
+
+}  // namespace Sera
@@ -0,0 +1,246 @@
+#include "FrameStats.h"
+
+#include <algorithm>
+#include <atomic>
+#include <cmath>
+#include <cstdio>
+#include <fstream>
+
+#include "imgui.h"
+
+#include "AllocationTracker.h"
+#include "Log.h"
+
+#if defined(__linux__)
+#include <fcntl.h>
+#include <unistd.h>
+#elif defined(_WIN32)
+#ifndef NOMINMAX
+#define NOMINMAX
+#endif
+#include <windows.h>
+#include <psapi.h>
+#endif
+
+namespace Sera {
+
+  namespace Utils {
+
+    // Reading the resident memory takes system calls, it is sampled every
+    // this many frames
+    static constexpr uint32_t s_MemoryInterval = 16;
+
+    static FrameStats::Sample s_Samples[FrameStats::HistorySize];
+    static uint32_t           s_Next     = 0;
+    static uint32_t           s_Count    = 0;
+    static uint64_t           s_Recorded = 0;
+    static uint64_t           s_Memory   = 0;
+    // Frames the overlay summarizes
+    static int                s_Window   = 240;
+
+    static std::atomic<uint32_t> s_DrawCalls{0};
+    static std::atomic<uint32_t> s_Uploads{0};
+    static std::atomic<uint64_t> s_UploadBytes{0};
+
+    // Scratch for sorting a window, avoids allocating per call
+    static float s_Sorted[FrameStats::HistorySize];
+
+    static uint64_t GetResidentMemory() {
+#if defined(__linux__)
+      // The second field is the resident set in pages
+      int fd = open("/proc/self/statm", O_RDONLY | O_CLOEXEC);
+      if (fd < 0) return 0;
+      char    buffer[128];
+      ssize_t length = read(fd, buffer, sizeof(buffer) - 1);
+      close(fd);
+      if (length <= 0) return 0;
+      buffer[length] = '\0';
+
+      unsigned long long size, resident;
+      if (sscanf(buffer, "%llu %llu", &size, &resident) != 2) return 0;
+      return resident * (uint64_t)sysconf(_SC_PAGESIZE);
+#elif defined(_WIN32)
+      PROCESS_MEMORY_COUNTERS counters;
+      if (!GetProcessMemoryInfo(GetCurrentProcess(), &counters,
+                                sizeof(counters)))
+        return 0;
+      return counters.WorkingSetSize;
+#else
+      return 0;
+#endif
+    }
+
+    // Nearest rank of sorted values
+    static float Percentile(const float* sorted, uint32_t count,
+                            float percentile) {
+      uint32_t rank = (uint32_t)std::ceil(percentile * count);
+      return sorted[std::min(std::max(rank, 1u), count) - 1];
+    }
+
+    static void SummaryRow(const char* name, const FrameStats::Summary& s) {
+      ImGui::TableNextRow();
+      ImGui::TableNextColumn();
+      ImGui::TextUnformatted(name);
+      for (float value : {s.min, s.average, s.max, s.p50, s.p95, s.p99}) {
+        ImGui::TableNextColumn();
+        ImGui::Text("%.2f", value);
+      }
+    }
+
+  }  // namespace Utils
+
+  void FrameStats::AddDrawCalls(uint32_t count) {
+    Utils::s_DrawCalls.fetch_add(count, std::memory_order_relaxed);
+  }
+
+  void FrameStats::AddUpload(uint64_t bytes) {
+    Utils::s_Uploads.fetch_add(1, std::memory_order_relaxed);
+    Utils::s_UploadBytes.fetch_add(bytes, std::memory_order_relaxed);
+  }
+
+  void FrameStats::Record(float frameTime, float cpuTime, float gpuTime) {
+    if (Utils::s_Recorded % Utils::s_MemoryInterval == 0)
+      Utils::s_Memory = Utils::GetResidentMemory();
+
+    AllocationTracker::Usage allocations = AllocationTracker::GetFrameUsage();
+
+    Sample& sample        = Utils::s_Samples[Utils::s_Next];
+    sample.frame          = Utils::s_Recorded++;
+    sample.frameTime      = frameTime;
+    sample.cpuTime        = cpuTime;
+    sample.gpuTime        = gpuTime;
+    sample.drawCalls      = Utils::s_DrawCalls.exchange(0);
+    sample.uploads        = Utils::s_Uploads.exchange(0);
+    sample.uploadBytes    = Utils::s_UploadBytes.exchange(0);
+    sample.memory         = Utils::s_Memory;
+    sample.allocations    = (uint32_t)allocations.allocations;
+    sample.allocatedBytes = allocations.bytes;
+
+    Utils::s_Next  = (Utils::s_Next + 1) % HistorySize;
+    Utils::s_Count = std::min(Utils::s_Count + 1, HistorySize);
+  }
+
+  uint32_t FrameStats::GetSampleCount() { return Utils::s_Count; }
+
+  const FrameStats::Sample& FrameStats::GetSample(uint32_t index) {
+    uint32_t first = Utils::s_Next + HistorySize - Utils::s_Count;
+    return Utils::s_Samples[(first + index) % HistorySize];
+  }
+
+  FrameStats::Summary FrameStats::Summarize(float Sample::*time,
+                                            uint32_t window) {
+    Summary  summary;
+    uint32_t count = std::min(window, Utils::s_Count);
+    if (count == 0) return summary;
+
+    float* values = Utils::s_Sorted;
+    float  total  = 0.0f;
+    for (uint32_t i = 0; i < count; i++) {
+      values[i] = GetSample(Utils::s_Count - count + i).*time;
+      total += values[i];
+    }
+    std::sort(values, values + count);
+
+    summary.min     = values[0];
+    summary.average = total / count;
+    summary.max     = values[count - 1];
+    summary.p50     = Utils::Percentile(values, count, 0.50f);
+    summary.p95     = Utils::Percentile(values, count, 0.95f);
+    summary.p99     = Utils::Percentile(values, count, 0.99f);
+    return summary;
+  }
+
+  bool FrameStats::ExportCsv(const std::string& path) {
+    std::ofstream stream(path);
+    if (!stream) {
+      SR_CORE_ERROR("Could not write frame statistics to {}", path);
+      return false;
+    }
+
+    stream << "frame,frame_ms,cpu_ms,gpu_ms,draw_calls,uploads,upload_bytes,"
+              "memory_bytes,allocations,allocated_bytes\n";
+    for (uint32_t i = 0; i < Utils::s_Count; i++) {
+      const Sample& sample = GetSample(i);
+      stream << sample.frame << ',' << sample.frameTime << ','
+             << sample.cpuTime << ',' << sample.gpuTime << ','
+             << sample.drawCalls << ',' << sample.uploads << ','
+             << sample.uploadBytes << ',' << sample.memory << ','
+             << sample.allocations << ',' << sample.allocatedBytes << '\n';
+    }
+
+    SR_CORE_INFO("Wrote {} frames of statistics to {}", Utils::s_Count, path);
+    return true;
+  }
+
+  void FrameStats::ShowOverlay(bool* open) {
+    const ImGuiViewport* viewport = ImGui::GetMainViewport();
+    ImGui::SetNextWindowPos(
+        ImVec2(viewport->WorkPos.x + viewport->WorkSize.x - 10.0f,
+               viewport->WorkPos.y + 10.0f),
+        ImGuiCond_Always, ImVec2(1.0f, 0.0f));
+    ImGui::SetNextWindowViewport(viewport->ID);
+    ImGui::SetNextWindowBgAlpha(0.8f);
+    ImGuiWindowFlags flags =
+        ImGuiWindowFlags_NoDecoration | ImGuiWindowFlags_AlwaysAutoResize |
+        ImGuiWindowFlags_NoSavedSettings | ImGuiWindowFlags_NoDocking |
+        ImGuiWindowFlags_NoFocusOnAppearing | ImGuiWindowFlags_NoNav |
+        ImGuiWindowFlags_NoMove;
+    if (!ImGui::Begin("Frame Stats", open, flags)) {
+      ImGui::End();
+      return;
+    }
+    if (open && ImGui::BeginPopupContextWindow()) {
+      if (ImGui::MenuItem("Close")) *open = false;
+      ImGui::EndPopup();
+    }
+
+    uint32_t count  = Utils::s_Count;
+    uint32_t window = std::min((uint32_t)Utils::s_Window, count);
+    if (window == 0) {
+      ImGui::TextUnformatted("No frames recorded yet");
+      ImGui::End();
+      return;
+    }
+
+    Summary frame = Summarize(&Sample::frameTime, window);
+    float   fps   = frame.average > 0.0f ? 1000.0f / frame.average : 0.0f;
+    ImGui::Text("%.1f FPS, %.2f ms", fps, frame.average);
+
+    // The getter gets the index of the window's first sample
+    uint32_t first = count - window;
+    ImGui::PlotLines(
+        "##FrameTime",
+        [](void* data, int index) {
+          return GetSample(*(uint32_t*)data + (uint32_t)index).frameTime;
+        },
+        &first, (int)window, 0, nullptr, 0.0f, frame.max * 1.1f,
+        ImVec2(320.0f, 60.0f));
+    ImGui::SliderInt("Frames", &Utils::s_Window, 10, HistorySize);
+
+    if (ImGui::BeginTable("Summary", 7, ImGuiTableFlags_SizingFixedFit)) {
+      for (const char* header :
+           {"ms", "min", "avg", "max", "p50", "p95", "p99"})
+        ImGui::TableSetupColumn(header);
+      ImGui::TableHeadersRow();
+      Utils::SummaryRow("Frame", frame);
+      Utils::SummaryRow("CPU", Summarize(&Sample::cpuTime, window));
+      Utils::SummaryRow("GPU", Summarize(&Sample::gpuTime, window));
+      ImGui::EndTable();
+    }
+
+    const Sample& last = GetSample(count - 1);
+    ImGui::Text("Draw calls: %u", last.drawCalls);
+    ImGui::Text("Uploads: %u, %.1f KiB", last.uploads,
+                last.uploadBytes / 1024.0);
+    if (last.memory)
+      ImGui::Text("Memory: %.1f MiB", last.memory / (1024.0 * 1024.0));
+    if (AllocationTracker::IsEnabled())
+      ImGui::Text("Allocations: %u, %.1f KiB%s", last.allocations,
+                  last.allocatedBytes / 1024.0,
+                  AllocationTracker::IsSteadyState() ? " (steady state)" : "");
+
+    if (ImGui::Button("Export CSV")) ExportCsv("sera_frame_stats.csv");
+    ImGui::End();
+  }
+
+}  // namespace Sera
@@ -0,0 +1,298 @@
+#include "GpuProfiler.h"
+
+#include <algorithm>
+
+#include "imgui.h"
+
+#include "Application.h"
+#include "Log.h"
+#include "MemoryTracker.h"
+
+#include "Backend/VulkanDebug.h"
+#include "Backend/VulkanDevice.h"
+
+namespace Sera {
+
+  // Scopes one frame can record, each takes a start and an end timestamp
+  static constexpr uint32_t s_MaxScopes    = 256;
+  // Per frame in flight, the frame's own start and end come first
+  static constexpr uint32_t s_FrameQueries = 2 + s_MaxScopes * 2;
+
+  // Written in the order of their bits, matching PipelineStatistics
+  static constexpr VkQueryPipelineStatisticFlags s_Statistics =
+      VK_QUERY_PIPELINE_STATISTIC_INPUT_ASSEMBLY_VERTICES_BIT |
+      VK_QUERY_PIPELINE_STATISTIC_INPUT_ASSEMBLY_PRIMITIVES_BIT |
+      VK_QUERY_PIPELINE_STATISTIC_VERTEX_SHADER_INVOCATIONS_BIT |
+      VK_QUERY_PIPELINE_STATISTIC_CLIPPING_INVOCATIONS_BIT |
+      VK_QUERY_PIPELINE_STATISTIC_CLIPPING_PRIMITIVES_BIT |
+      VK_QUERY_PIPELINE_STATISTIC_FRAGMENT_SHADER_INVOCATIONS_BIT |
+      VK_QUERY_PIPELINE_STATISTIC_COMPUTE_SHADER_INVOCATIONS_BIT;
+
+  GpuProfiler::GpuProfiler() {
+    VulkanDevice* device = Application::GetVulkanDevice();
+    uint32_t      familyCount;
+    vkGetPhysicalDeviceQueueFamilyProperties(
+        device->physicalDevice->physicalDevice, &familyCount, nullptr);
+    std::vector<VkQueueFamilyProperties> families(familyCount);
+    vkGetPhysicalDeviceQueueFamilyProperties(
+        device->physicalDevice->physicalDevice, &familyCount, families.data());
+    uint32_t validBits = families[device->queueFamily].timestampValidBits;
+    if (validBits == 0) {
+      SR_CORE_WARN("Queue has no timestamps, GPU profiling is disabled");
+      return;
+    }
+    m_TimestampMask = validBits >= 64 ? UINT64_MAX : (1ull << validBits) - 1;
+    m_TimestampPeriod =
+        device->physicalDevice->properties.limits.timestampPeriod;
+    m_Synchronization2 = device->features.synchronization2;
+#ifdef SR_PROFILE
+    m_Track = Profiler::AddTrack("GPU");
+#endif
+  }
+
+  GpuProfiler::~GpuProfiler() {
+    // Application destroys the profiler once the device is idle
+    VkDevice                     device = Application::GetDevice();
+    const VkAllocationCallbacks* allocator =
+        MemoryTracker::GetAllocationCallbacks(VK_OBJECT_TYPE_QUERY_POOL);
+    vkDestroyQueryPool(device, m_TimestampPool, allocator);
+    vkDestroyQueryPool(device, m_StatisticsPool, allocator);
+  }
+
+  void GpuProfiler::BeginFrame(VkCommandBuffer commandBuffer,
+                               uint32_t frameInFlight,
+                               uint32_t framesInFlight) {
+    m_ResultsFresh = false;
+    if (!IsEnabled()) return;
+    if (m_Frames.size() != framesInFlight) CreateQueryPools(framesInFlight);
+
+    m_CurrentSlot = frameInFlight;
+    if (m_Frames[frameInFlight].pending) ReadResults(frameInFlight);
+
+    m_Current = &m_Frames[frameInFlight];
+    m_Current->scopes.clear();
+    m_Current->index = m_FrameIndex++;
+    m_OpenScopes.clear();
+
+    uint32_t first = frameInFlight * s_FrameQueries;
+    vkCmdResetQueryPool(commandBuffer, m_TimestampPool, first, s_FrameQueries);
+    WriteTimestamp(commandBuffer, first, false);
+    if (m_StatisticsPool) {
+      vkCmdResetQueryPool(commandBuffer, m_StatisticsPool, frameInFlight, 1);
+      vkCmdBeginQuery(commandBuffer, m_StatisticsPool, frameInFlight, 0);
+    }
+  }
+
+  void GpuProfiler::EndFrame(VkCommandBuffer commandBuffer) {
+    if (!m_Current) return;
+
+    // The results of a scope left open would never become available. Its
+    // debug label stays open until the caller's EndScope().
+    for (auto scope = m_OpenScopes.rbegin(); scope != m_OpenScopes.rend();
+         ++scope)
+      WriteTimestamp(commandBuffer,
+                     m_CurrentSlot * s_FrameQueries + 3 + *scope * 2, true);
+    m_OpenScopes.clear();
+    if (m_StatisticsPool)
+      vkCmdEndQuery(commandBuffer, m_StatisticsPool, m_CurrentSlot);
+    WriteTimestamp(commandBuffer, m_CurrentSlot * s_FrameQueries + 1, true);
+
+    m_Current->submitTime = Profiler::Now();
+    m_Current->pending    = true;
+    m_Current             = nullptr;
+  }
+
+  uint32_t GpuProfiler::BeginScope(VkCommandBuffer commandBuffer,
+                                   const char* name, const void* key) {
+#ifdef SR_DEBUG
+    // Labelled in captures whether or not the scope is timed
+    BeginDebugLabel(commandBuffer, name);
+#endif
+    if (!m_Current || m_Current->scopes.size() >= s_MaxScopes)
+      return UINT32_MAX;
+
+    uint32_t scope = (uint32_t)m_Current->scopes.size();
+    m_Current->scopes.push_back({name, key, (uint32_t)m_OpenScopes.size()});
+    m_OpenScopes.push_back(scope);
+    WriteTimestamp(commandBuffer,
+                   m_CurrentSlot * s_FrameQueries + 2 + scope * 2, false);
+    return scope;
+  }
+
+  void GpuProfiler::EndScope(VkCommandBuffer commandBuffer, uint32_t scope) {
+#ifdef SR_DEBUG
+    EndDebugLabel(commandBuffer);
+#endif
+    if (!m_Current || scope == UINT32_MAX) return;
+
+    // Already ended when the frame ended
+    auto open = std::find(m_OpenScopes.begin(), m_OpenScopes.end(), scope);
+    if (open == m_OpenScopes.end()) return;
+    m_OpenScopes.erase(open);
+    WriteTimestamp(commandBuffer,
+                   m_CurrentSlot * s_FrameQueries + 3 + scope * 2, true);
+  }
+
+  float GpuProfiler::GetScopeTime(const void* key) const {
+    if (!m_ResultsFresh || !key) return -1.0f;
+    for (const Scope& scope : m_LastFrame.scopes)
+      if (scope.key == key) return scope.time;
+    return -1.0f;
+  }
+
+  void GpuProfiler::ShowPanel(bool* open) {
+    if (!ImGui::Begin("GPU Profiler", open)) {
+      ImGui::End();
+      return;
+    }
+    if (!IsEnabled()) {
+      ImGui::TextUnformatted("The queue has no timestamps");
+      ImGui::End();
+      return;
+    }
+
+    const Frame& frame = m_LastFrame;
+    ImGui::Text("Frame %llu: %.3f ms", (unsigned long long)frame.index,
+                frame.time);
+    ImGui::Separator();
+    for (const Scope& scope : frame.scopes)
+      ImGui::Text("%*s%s  %.3f ms", (int)scope.depth * 2, "", scope.name,
+                  scope.time);
+
+    if (frame.hasStatistics) {
+      const PipelineStatistics& stats = frame.statistics;
+      ImGui::Separator();
+      ImGui::Text("Input vertices: %llu",
+                  (unsigned long long)stats.inputVertices);
+      ImGui::Text("Input primitives: %llu",
+                  (unsigned long long)stats.inputPrimitives);
+      ImGui::Text("Vertex invocations: %llu",
+                  (unsigned long long)stats.vertexInvocations);
+      ImGui::Text("Clipping invocations: %llu",
+                  (unsigned long long)stats.clippingInvocations);
+      ImGui::Text("Clipped primitives: %llu",
+                  (unsigned long long)stats.clippingPrimitives);
+      ImGui::Text("Fragment invocations: %llu",
+                  (unsigned long long)stats.fragmentInvocations);
+      ImGui::Text("Compute invocations: %llu",
+                  (unsigned long long)stats.computeInvocations);
+    }
+
+    ImGui::End();
+  }
+
+  void GpuProfiler::CreateQueryPools(uint32_t framesInFlight) {
+    // The old pools may still be written by frames in flight
+    Application::SubmitResourceFree([timestamps = m_TimestampPool,
+                                     statistics = m_StatisticsPool]() {
+      VkDevice                     device = Application::GetDevice();
+      const VkAllocationCallbacks* allocator =
+          MemoryTracker::GetAllocationCallbacks(VK_OBJECT_TYPE_QUERY_POOL);
+      vkDestroyQueryPool(device, timestamps, allocator);
+      vkDestroyQueryPool(device, statistics, allocator);
+    });
+    m_StatisticsPool = VK_NULL_HANDLE;
+
+    const VkAllocationCallbacks* allocator =
+        MemoryTracker::GetAllocationCallbacks(VK_OBJECT_TYPE_QUERY_POOL);
+
+    VkQueryPoolCreateInfo info = {};
+    info.sType                 = VK_STRUCTURE_TYPE_QUERY_POOL_CREATE_INFO;
+    info.queryType             = VK_QUERY_TYPE_TIMESTAMP;
+    info.queryCount            = framesInFlight * s_FrameQueries;
+    VkResult err = vkCreateQueryPool(Application::GetDevice(), &info,
+                                     allocator, &m_TimestampPool);
+    check_vk_result(err);
+
+    if (Application::GetVulkanDevice()->features.pipelineStatisticsQuery) {
+      info.queryType          = VK_QUERY_TYPE_PIPELINE_STATISTICS;
+      info.queryCount         = framesInFlight;
+      info.pipelineStatistics = s_Statistics;
+      err = vkCreateQueryPool(Application::GetDevice(), &info, allocator,
+                              &m_StatisticsPool);
+      check_vk_result(err);
+    }
+    m_Frames.assign(framesInFlight, {});
+  }
+
+  void GpuProfiler::ReadResults(uint32_t slot) {
+    FrameQueries& queries = m_Frames[slot];
+    queries.pending       = false;
+
+    // The slot's fence has been waited on, the results are there unless the
+    // device was lost
+    uint32_t              count = 2 + (uint32_t)queries.scopes.size() * 2;
+    std::vector<uint64_t> timestamps(count);
+    VkResult              err = vkGetQueryPoolResults(
+        Application::GetDevice(), m_TimestampPool, slot * s_FrameQueries,
+        count, count * sizeof(uint64_t), timestamps.data(), sizeof(uint64_t),
+        VK_QUERY_RESULT_64_BIT);
+    if (err != VK_SUCCESS) return;
+
+    // Nanoseconds since the frame started, the mask handles the counter
+    // wrapping around
+    auto elapsed = [&](uint64_t timestamp) {
+      return (uint64_t)(((timestamp - timestamps[0]) & m_TimestampMask) *
+                        (double)m_TimestampPeriod);
+    };
+
+    Frame& frame = m_LastFrame;
+    frame.index  = queries.index;
+    frame.time   = elapsed(timestamps[1]) * 1e-6f;
+    frame.scopes.clear();
+    for (uint32_t i = 0; i < (uint32_t)queries.scopes.size(); i++) {
+      const ScopeRecord& record = queries.scopes[i];
+      uint64_t           start  = elapsed(timestamps[2 + i * 2]);
+      uint64_t           end    = elapsed(timestamps[3 + i * 2]);
+      frame.scopes.push_back({record.name, record.key, record.depth,
+                              start * 1e-6f,
+                              (end - std::min(start, end)) * 1e-6f});
+    }
+
+    frame.hasStatistics = false;
+    if (m_StatisticsPool) {
+      err = vkGetQueryPoolResults(
+          Application::GetDevice(), m_StatisticsPool, slot, 1,
+          sizeof(PipelineStatistics), &frame.statistics,
+          sizeof(PipelineStatistics), VK_QUERY_RESULT_64_BIT);
+      frame.hasStatistics = err == VK_SUCCESS;
+    }
+    m_ResultsFresh = true;
+
+#ifdef SR_PROFILE
+    // Without calibrated timestamps the GPU clock is unrelated to the CPU's.
+    // The frame started after it was submitted and after the previous frame
+    // ended on the queue, and it has finished by now.
+    uint64_t now      = Profiler::Now();
+    uint64_t duration = std::min(elapsed(timestamps[1]), now);
+    uint64_t start    = std::max(queries.submitTime, m_LastEnd);
+    start             = std::min(start, now - duration);
+    m_LastEnd         = start + duration;
+    Profiler::AddZone(m_Track, "Frame", start, m_LastEnd, 0);
+    for (uint32_t i = 0; i < (uint32_t)queries.scopes.size(); i++) {
+      Profiler::AddZone(m_Track, queries.scopes[i].name,
+                        start + elapsed(timestamps[2 + i * 2]),
+                        start + elapsed(timestamps[3 + i * 2]),
+                        queries.scopes[i].depth + 1);
+    }
+#endif
+  }
+
+  void GpuProfiler::WriteTimestamp(VkCommandBuffer commandBuffer,
+                                   uint32_t query, bool end) {
+    // An end waits for every earlier command to finish, a start only for
+    // them to begin
+    if (m_Synchronization2) {
+      vkCmdWriteTimestamp2(commandBuffer,
+                           end ? VK_PIPELINE_STAGE_2_ALL_COMMANDS_BIT
+                               : VK_PIPELINE_STAGE_2_TOP_OF_PIPE_BIT,
+                           m_TimestampPool, query);
+    } else {
+      vkCmdWriteTimestamp(commandBuffer,
+                          end ? VK_PIPELINE_STAGE_BOTTOM_OF_PIPE_BIT
+                              : VK_PIPELINE_STAGE_TOP_OF_PIPE_BIT,
+                          m_TimestampPool, query);
+    }
+  }
+
+}  // namespace Sera
@@ -1,9 +1,19 @@
 #include "Image.h"
 
+#include <algorithm>
+#include <atomic>
+#include <cstring>
+#include <mutex>
+#include <vector>
+
 #include "imgui.h"
 #include "backends/imgui_impl_vulkan.h"
 
 #include "Application.h"
+#include "FrameStats.h"
+#include "MemoryTracker.h"
+#include "Backend/VulkanDebug.h"
+#include "Backend/VulkanRendering.h"
 
 #define STB_IMAGE_IMPLEMENTATION
 #include "stb_image.h"
@@ -46,6 +56,28 @@ namespace Sera {
       return (VkFormat)0;
     }
 
+    // Clips `region` to a width x height image, false when nothing is left
+    static bool ClipRegion(VkRect2D& region, uint32_t width, uint32_t height) {
+      int64_t left   = std::max<int64_t>(region.offset.x, 0);
+      int64_t top    = std::max<int64_t>(region.offset.y, 0);
+      int64_t right  = std::min<int64_t>(
+          (int64_t)region.offset.x + region.extent.width, width);
+      int64_t bottom = std::min<int64_t>(
+          (int64_t)region.offset.y + region.extent.height, height);
+      if (right <= left || bottom <= top) return false;
+
+      region.offset = {(int32_t)left, (int32_t)top};
+      region.extent = {(uint32_t)(right - left), (uint32_t)(bottom - top)};
+      return true;
+    }
+
+    // Images with copies queued for the next frame, and their copies
+    static std::mutex          s_UploadMutex;
+    static std::vector<Image*> s_PendingUploads;
+    // Frames that recorded the queued copies so far. Picks the staging
+    // slice, which the GPU is done with once the frame before is recorded.
+    static std::atomic<uint64_t> s_UploadFrame{0};
+
   }  // namespace Utils
 
   Image::Image(std::string_view path) : m_Filepath(path) {
@@ -98,10 +130,19 @@ namespace Sera {
       info.arrayLayers       = 1;
       info.samples           = VK_SAMPLE_COUNT_1_BIT;
       info.tiling            = VK_IMAGE_TILING_OPTIMAL;
-      info.usage = VK_IMAGE_USAGE_SAMPLED_BIT | VK_IMAGE_USAGE_TRANSFER_DST_BIT;
+      // Storage lets compute shaders write the image directly and color
+      // attachment makes it a render target, both formats are required to
+      // support them
+      info.usage         = VK_IMAGE_USAGE_SAMPLED_BIT |
+                           VK_IMAGE_USAGE_TRANSFER_DST_BIT |
+                           VK_IMAGE_USAGE_STORAGE_BIT |
+                           VK_IMAGE_USAGE_COLOR_ATTACHMENT_BIT;
       info.sharingMode   = VK_SHARING_MODE_EXCLUSIVE;
       info.initialLayout = VK_IMAGE_LAYOUT_UNDEFINED;
-      err                = vkCreateImage(device, &info, nullptr, &m_Image);
+      err                = vkCreateImage(
+          device, &info,
+          MemoryTracker::GetAllocationCallbacks(VK_OBJECT_TYPE_IMAGE),
+          &m_Image);
       check_vk_result(err);
       VkMemoryRequirements req;
       vkGetImageMemoryRequirements(device, m_Image, &req);
@@ -110,8 +151,13 @@ namespace Sera {
       alloc_info.allocationSize       = req.size;
       alloc_info.memoryTypeIndex      = Utils::GetVulkanMemoryType(
           VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT, req.memoryTypeBits);
-      err = vkAllocateMemory(device, &alloc_info, nullptr, &m_Memory);
+      err = vkAllocateMemory(
+          device, &alloc_info,
+          MemoryTracker::GetAllocationCallbacks(VK_OBJECT_TYPE_DEVICE_MEMORY),
+          &m_Memory);
       check_vk_result(err);
+      MemoryTracker::TrackDeviceMemory(m_Memory, req.size,
+                                       alloc_info.memoryTypeIndex, "Image");
       err = vkBindImageMemory(device, m_Image, m_Memory, 0);
       check_vk_result(err);
     }
@@ -126,7 +172,10 @@ namespace Sera {
       info.subresourceRange.aspectMask = VK_IMAGE_ASPECT_COLOR_BIT;
       info.subresourceRange.levelCount = 1;
       info.subresourceRange.layerCount = 1;
-      err = vkCreateImageView(device, &info, nullptr, &m_ImageView);
+      err = vkCreateImageView(
+          device, &info,
+          MemoryTracker::GetAllocationCallbacks(VK_OBJECT_TYPE_IMAGE_VIEW),
+          &m_ImageView);
       check_vk_result(err);
     }
 
@@ -143,134 +192,304 @@ namespace Sera {
       info.minLod              = -1000;
       info.maxLod              = 1000;
       info.maxAnisotropy       = 1.0f;
-      VkResult err = vkCreateSampler(device, &info, nullptr, &m_Sampler);
+      VkResult err = vkCreateSampler(
+          device, &info,
+          MemoryTracker::GetAllocationCallbacks(VK_OBJECT_TYPE_SAMPLER),
+          &m_Sampler);
       check_vk_result(err);
     }
 
+#ifdef SR_DEBUG
+    // Loaded images go by their file, the others by their size
+    std::string name = !m_Filepath.empty()
+                           ? m_Filepath
+                           : "Image " + std::to_string(m_Width) + "x" +
+                                 std::to_string(m_Height);
+#endif
+    SR_DEBUG_NAME(device, VK_OBJECT_TYPE_IMAGE, m_Image, name.c_str());
+    SR_DEBUG_NAME(device, VK_OBJECT_TYPE_IMAGE_VIEW, m_ImageView,
+                  (name + " view").c_str());
+    SR_DEBUG_NAME(device, VK_OBJECT_TYPE_SAMPLER, m_Sampler,
+                  (name + " sampler").c_str());
+    SR_DEBUG_NAME(device, VK_OBJECT_TYPE_DEVICE_MEMORY, m_Memory,
+                  (name + " memory").c_str());
+
     // Create the Descriptor Set:
     m_DescriptorSet = (VkDescriptorSet)ImGui_ImplVulkan_AddTexture(
         m_Sampler, m_ImageView, VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL);
+
+    m_Layout     = VK_IMAGE_LAYOUT_UNDEFINED;
+    m_LastStage  = VK_PIPELINE_STAGE_TOP_OF_PIPE_BIT;
+    m_LastAccess = 0;
+  }
+
+  void Image::TransitionLayout(VkCommandBuffer      commandBuffer,
+                               VkImageLayout        layout,
+                               VkPipelineStageFlags stage,
+                               VkAccessFlags        access) {
+    TransitionImageLayout(commandBuffer, m_Image, VK_IMAGE_ASPECT_COLOR_BIT,
+                          m_Layout, layout, m_LastStage, m_LastAccess, stage,
+                          access);
+    m_Layout     = layout;
+    m_LastStage  = stage;
+    m_LastAccess = access;
   }
 
   void Image::Release() {
+    DropPendingCopies();
+    ReleaseStagingBuffer();
+
     Application::SubmitResourceFree(
         [sampler = m_Sampler, imageView = m_ImageView, image = m_Image,
-         memory = m_Memory, stagingBuffer = m_StagingBuffer,
-         stagingBufferMemory = m_StagingBufferMemory]() {
+         memory = m_Memory]() {
           VkDevice device = Application::GetDevice();
 
-          vkDestroySampler(device, sampler, nullptr);
-          vkDestroyImageView(device, imageView, nullptr);
-          vkDestroyImage(device, image, nullptr);
-          vkFreeMemory(device, memory, nullptr);
-          vkDestroyBuffer(device, stagingBuffer, nullptr);
-          vkFreeMemory(device, stagingBufferMemory, nullptr);
+          vkDestroySampler(
+              device, sampler,
+              MemoryTracker::GetAllocationCallbacks(VK_OBJECT_TYPE_SAMPLER));
+          vkDestroyImageView(
+              device, imageView,
+              MemoryTracker::GetAllocationCallbacks(VK_OBJECT_TYPE_IMAGE_VIEW));
+          vkDestroyImage(
+              device, image,
+              MemoryTracker::GetAllocationCallbacks(VK_OBJECT_TYPE_IMAGE));
+          MemoryTracker::UntrackDeviceMemory(memory);
+          vkFreeMemory(device, memory,
+                       MemoryTracker::GetAllocationCallbacks(
+                           VK_OBJECT_TYPE_DEVICE_MEMORY));
         });
 
-    m_Sampler             = nullptr;
-    m_ImageView           = nullptr;
-    m_Image               = nullptr;
-    m_Memory              = nullptr;
+    m_Sampler   = nullptr;
+    m_ImageView = nullptr;
+    m_Image     = nullptr;
+    m_Memory    = nullptr;
+  }
+
+  void Image::ReleaseStagingBuffer() {
+    if (!m_StagingBuffer) return;
+
+    Application::SubmitResourceFree([buffer = m_StagingBuffer,
+                                     memory = m_StagingBufferMemory]() {
+      VkDevice device = Application::GetDevice();
+      vkDestroyBuffer(
+          device, buffer,
+          MemoryTracker::GetAllocationCallbacks(VK_OBJECT_TYPE_BUFFER));
+      MemoryTracker::UntrackDeviceMemory(memory);
+      vkFreeMemory(
+          device, memory,
+          MemoryTracker::GetAllocationCallbacks(VK_OBJECT_TYPE_DEVICE_MEMORY));
+    });
+
     m_StagingBuffer       = nullptr;
     m_StagingBufferMemory = nullptr;
+    m_StagingSlices       = 0;
   }
 
   void Image::SetData(const void* data) {
-    VkDevice device = Application::GetDevice();
+    uint64_t size = (uint64_t)m_Width * m_Height * GetBytesPerPixel();
+
+    // The whole image is replaced, regions still queued would overwrite it
+    DropPendingCopies();
+    memcpy(MapStaging(), data, size);
+    UnmapStaging();
+
+    std::lock_guard<std::mutex> lock(Utils::s_UploadMutex);
+    VkCommandBuffer             commandBuffer =
+        Application::GetCommandBuffer(true);
+    RecordPendingCopies(commandBuffer);
+    Application::FlushCommandBuffer(commandBuffer);
+  }
 
-    size_t upload_size = m_Width * m_Height * Utils::BytesPerPixel(m_Format);
+  void Image::SetData(const void* data, const VkRect2D* regions,
+                      uint32_t regionCount) {
+    if (regionCount == 0) return;
 
-    VkResult err;
+    uint32_t pixelSize = GetBytesPerPixel();
+    uint64_t rowPitch  = (uint64_t)m_Width * pixelSize;
+
+    char* map = (char*)MapStaging();
+    for (uint32_t i = 0; i < regionCount; i++) {
+      VkRect2D region = regions[i];
+      if (!Utils::ClipRegion(region, m_Width, m_Height)) continue;
 
-    if (!m_StagingBuffer) {
-      // Create the Upload Buffer
+      uint64_t offset = region.offset.y * rowPitch +
+                        (uint64_t)region.offset.x * pixelSize;
+      uint64_t size   = (uint64_t)region.extent.width * pixelSize;
+      for (uint32_t y = 0; y < region.extent.height; y++)
+        memcpy(map + offset + y * rowPitch,
+               (const char*)data + offset + y * rowPitch, size);
+    }
+    UnmapStaging(regions, regionCount);
+  }
+
+  void* Image::MapStaging() {
+    VkDevice device = Application::GetDevice();
+    uint32_t slices = Application::GetFramesInFlight() + 1;
+    if (m_StagingSlices != slices) {
+      // The swapchain's image count changed. Copies still queued read the
+      // old staging memory and are submitted before it goes.
       {
-        VkBufferCreateInfo buffer_info = {};
-        buffer_info.sType              = VK_STRUCTURE_TYPE_BUFFER_CREATE_INFO;
-        buffer_info.size               = upload_size;
-        buffer_info.usage              = VK_BUFFER_USAGE_TRANSFER_SRC_BIT;
-        buffer_info.sharingMode        = VK_SHARING_MODE_EXCLUSIVE;
-        err = vkCreateBuffer(device, &buffer_info, nullptr, &m_StagingBuffer);
-        check_vk_result(err);
-        VkMemoryRequirements req;
-        vkGetBufferMemoryRequirements(device, m_StagingBuffer, &req);
-        m_AlignedSize                   = req.size;
-        VkMemoryAllocateInfo alloc_info = {};
-        alloc_info.sType           = VK_STRUCTURE_TYPE_MEMORY_ALLOCATE_INFO;
-        alloc_info.allocationSize  = req.size;
-        alloc_info.memoryTypeIndex = Utils::GetVulkanMemoryType(
-            VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT, req.memoryTypeBits);
-        err = vkAllocateMemory(device, &alloc_info, nullptr,
-                               &m_StagingBufferMemory);
-        check_vk_result(err);
-        err = vkBindBufferMemory(device, m_StagingBuffer, m_StagingBufferMemory,
-                                 0);
-        check_vk_result(err);
+        std::lock_guard<std::mutex> lock(Utils::s_UploadMutex);
+        if (!m_PendingCopies.empty()) {
+          VkCommandBuffer commandBuffer = Application::GetCommandBuffer(true);
+          RecordPendingCopies(commandBuffer);
+          Application::FlushCommandBuffer(commandBuffer);
+        }
       }
+      ReleaseStagingBuffer();
+      AllocateStagingBuffer((uint64_t)m_Width * m_Height * GetBytesPerPixel());
     }
 
-    // Upload to Buffer
-    {
-      char* map = NULL;
-      err = vkMapMemory(device, m_StagingBufferMemory, 0, m_AlignedSize, 0,
-                        (void**)(&map));
-      check_vk_result(err);
-      memcpy(map, data, upload_size);
-      VkMappedMemoryRange range[1] = {};
-      range[0].sType               = VK_STRUCTURE_TYPE_MAPPED_MEMORY_RANGE;
-      range[0].memory              = m_StagingBufferMemory;
-      range[0].size                = m_AlignedSize;
-      err = vkFlushMappedMemoryRanges(device, 1, range);
-      check_vk_result(err);
-      vkUnmapMemory(device, m_StagingBufferMemory);
+    m_MappedSlice = (uint32_t)(Utils::s_UploadFrame.load() % m_StagingSlices);
+
+    void*    map = nullptr;
+    VkResult err =
+        vkMapMemory(device, m_StagingBufferMemory,
+                    m_MappedSlice * m_StagingSliceSize, m_StagingSliceSize, 0,
+                    &map);
+    check_vk_result(err);
+    return map;
+  }
+
+  void Image::UnmapStaging(const VkRect2D* regions, uint32_t regionCount) {
+    VkDevice device = Application::GetDevice();
+    uint64_t slice  = m_MappedSlice * m_StagingSliceSize;
+
+    VkMappedMemoryRange range = {};
+    range.sType               = VK_STRUCTURE_TYPE_MAPPED_MEMORY_RANGE;
+    range.memory              = m_StagingBufferMemory;
+    range.offset              = slice;
+    range.size                = m_StagingSliceSize;
+    VkResult err              = vkFlushMappedMemoryRanges(device, 1, &range);
+    check_vk_result(err);
+    vkUnmapMemory(device, m_StagingBufferMemory);
+
+    VkRect2D whole = {
+        {0, 0},
+        {m_Width, m_Height}
+    };
+    if (!regions) {
+      regions     = &whole;
+      regionCount = 1;
     }
 
-    // Copy to Image
-    {
-      VkCommandBuffer command_buffer = Application::GetCommandBuffer(true);
-
-      VkImageMemoryBarrier copy_barrier = {};
-      copy_barrier.sType               = VK_STRUCTURE_TYPE_IMAGE_MEMORY_BARRIER;
-      copy_barrier.dstAccessMask       = VK_ACCESS_TRANSFER_WRITE_BIT;
-      copy_barrier.oldLayout           = VK_IMAGE_LAYOUT_UNDEFINED;
-      copy_barrier.newLayout           = VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL;
-      copy_barrier.srcQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
-      copy_barrier.dstQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
-      copy_barrier.image               = m_Image;
-      copy_barrier.subresourceRange.aspectMask = VK_IMAGE_ASPECT_COLOR_BIT;
-      copy_barrier.subresourceRange.levelCount = 1;
-      copy_barrier.subresourceRange.layerCount = 1;
-      vkCmdPipelineBarrier(command_buffer, VK_PIPELINE_STAGE_HOST_BIT,
-                           VK_PIPELINE_STAGE_TRANSFER_BIT, 0, 0, NULL, 0, NULL,
-                           1, &copy_barrier);
-
-      VkBufferImageCopy region           = {};
-      region.imageSubresource.aspectMask = VK_IMAGE_ASPECT_COLOR_BIT;
-      region.imageSubresource.layerCount = 1;
-      region.imageExtent.width           = m_Width;
-      region.imageExtent.height          = m_Height;
-      region.imageExtent.depth           = 1;
-      vkCmdCopyBufferToImage(command_buffer, m_StagingBuffer, m_Image,
-                             VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL, 1, &region);
-
-      VkImageMemoryBarrier use_barrier = {};
-      use_barrier.sType                = VK_STRUCTURE_TYPE_IMAGE_MEMORY_BARRIER;
-      use_barrier.srcAccessMask        = VK_ACCESS_TRANSFER_WRITE_BIT;
-      use_barrier.dstAccessMask        = VK_ACCESS_SHADER_READ_BIT;
-      use_barrier.oldLayout            = VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL;
-      use_barrier.newLayout = VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL;
-      use_barrier.srcQueueFamilyIndex         = VK_QUEUE_FAMILY_IGNORED;
-      use_barrier.dstQueueFamilyIndex         = VK_QUEUE_FAMILY_IGNORED;
-      use_barrier.image                       = m_Image;
-      use_barrier.subresourceRange.aspectMask = VK_IMAGE_ASPECT_COLOR_BIT;
-      use_barrier.subresourceRange.levelCount = 1;
-      use_barrier.subresourceRange.layerCount = 1;
-      vkCmdPipelineBarrier(command_buffer, VK_PIPELINE_STAGE_TRANSFER_BIT,
-                           VK_PIPELINE_STAGE_FRAGMENT_SHADER_BIT, 0, 0, NULL, 0,
-                           NULL, 1, &use_barrier);
-
-      Application::FlushCommandBuffer(command_buffer);
+    // The staging slice mirrors the image's layout, so every region keeps
+    // its offset and the copies can share one buffer
+    uint32_t                    pixelSize = GetBytesPerPixel();
+    std::lock_guard<std::mutex> lock(Utils::s_UploadMutex);
+    for (uint32_t i = 0; i < regionCount; i++) {
+      VkRect2D region = regions[i];
+      if (!Utils::ClipRegion(region, m_Width, m_Height)) continue;
+
+      uint64_t pixel = (uint64_t)region.offset.y * m_Width + region.offset.x;
+      VkBufferImageCopy copy           = {};
+      copy.bufferOffset                = slice + pixel * pixelSize;
+      copy.bufferRowLength             = m_Width;
+      copy.imageSubresource.aspectMask = VK_IMAGE_ASPECT_COLOR_BIT;
+      copy.imageSubresource.layerCount = 1;
+      copy.imageOffset = {region.offset.x, region.offset.y, 0};
+      copy.imageExtent = {region.extent.width, region.extent.height, 1};
+      m_PendingCopies.push_back(copy);
+      m_PendingBytes +=
+          (uint64_t)region.extent.width * region.extent.height * pixelSize;
     }
+
+    auto& pending = Utils::s_PendingUploads;
+    if (!m_PendingCopies.empty() &&
+        std::find(pending.begin(), pending.end(), this) == pending.end())
+      pending.push_back(this);
+  }
+
+  void Image::RecordUploads(VkCommandBuffer commandBuffer) {
+    std::lock_guard<std::mutex> lock(Utils::s_UploadMutex);
+    for (Image* image : Utils::s_PendingUploads)
+      image->RecordPendingCopies(commandBuffer);
+    Utils::s_PendingUploads.clear();
+    Utils::s_UploadFrame++;
+  }
+
+  void Image::RecordPendingCopies(VkCommandBuffer commandBuffer) {
+    if (m_PendingCopies.empty()) return;
+
+    // Transitions from the tracked layout rather than UNDEFINED, which
+    // would discard the regions that are not uploaded
+    TransitionLayout(commandBuffer, VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL,
+                     VK_PIPELINE_STAGE_TRANSFER_BIT,
+                     VK_ACCESS_TRANSFER_WRITE_BIT);
+    vkCmdCopyBufferToImage(commandBuffer, m_StagingBuffer, m_Image,
+                           VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL,
+                           (uint32_t)m_PendingCopies.size(),
+                           m_PendingCopies.data());
+    TransitionLayout(commandBuffer, VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL,
+                     VK_PIPELINE_STAGE_FRAGMENT_SHADER_BIT,
+                     VK_ACCESS_SHADER_READ_BIT);
+    FrameStats::AddUpload(m_PendingBytes);
+
+    // Keeps the capacity, steady-state frames do not allocate
+    m_PendingCopies.clear();
+    m_PendingBytes = 0;
+  }
+
+  void Image::DropPendingCopies() {
+    std::lock_guard<std::mutex> lock(Utils::s_UploadMutex);
+    m_PendingCopies.clear();
+    m_PendingBytes = 0;
+
+    auto& pending = Utils::s_PendingUploads;
+    pending.erase(std::remove(pending.begin(), pending.end(), this),
+                  pending.end());
+  }
+
+  uint32_t Image::GetBytesPerPixel() const {
+    return Utils::BytesPerPixel(m_Format);
+  }
+
+  void Image::AllocateStagingBuffer(uint64_t size) {
+    VkDevice device = Application::GetDevice();
+
+    VkResult err;
+
+    // Slices start on a texel and on a non-coherent atom, so each can be
+    // flushed on its own
+    VkPhysicalDeviceProperties properties;
+    vkGetPhysicalDeviceProperties(Application::GetPhysicalDevice(),
+                                  &properties);
+    uint64_t alignment =
+        std::max<uint64_t>(properties.limits.nonCoherentAtomSize, 16);
+    m_StagingSliceSize = (size + alignment - 1) / alignment * alignment;
+    m_StagingSlices    = Application::GetFramesInFlight() + 1;
+
+    VkBufferCreateInfo buffer_info = {};
+    buffer_info.sType              = VK_STRUCTURE_TYPE_BUFFER_CREATE_INFO;
+    buffer_info.size               = m_StagingSliceSize * m_StagingSlices;
+    buffer_info.usage              = VK_BUFFER_USAGE_TRANSFER_SRC_BIT;
+    buffer_info.sharingMode        = VK_SHARING_MODE_EXCLUSIVE;
+    err = vkCreateBuffer(
+        device, &buffer_info,
+        MemoryTracker::GetAllocationCallbacks(VK_OBJECT_TYPE_BUFFER),
+        &m_StagingBuffer);
+    check_vk_result(err);
+    VkMemoryRequirements req;
+    vkGetBufferMemoryRequirements(device, m_StagingBuffer, &req);
+    VkMemoryAllocateInfo alloc_info = {};
+    alloc_info.sType                = VK_STRUCTURE_TYPE_MEMORY_ALLOCATE_INFO;
+    alloc_info.allocationSize       = req.size;
+    alloc_info.memoryTypeIndex      = Utils::GetVulkanMemoryType(
+        VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT, req.memoryTypeBits);
+    err = vkAllocateMemory(
+        device, &alloc_info,
+        MemoryTracker::GetAllocationCallbacks(VK_OBJECT_TYPE_DEVICE_MEMORY),
+        &m_StagingBufferMemory);
+    check_vk_result(err);
+    MemoryTracker::TrackDeviceMemory(m_StagingBufferMemory, req.size,
+                                     alloc_info.memoryTypeIndex,
+                                     "Image staging");
+    err = vkBindBufferMemory(device, m_StagingBuffer, m_StagingBufferMemory, 0);
+    check_vk_result(err);
+    SR_DEBUG_NAME(device, VK_OBJECT_TYPE_BUFFER, m_StagingBuffer,
+                  "Image staging");
+    SR_DEBUG_NAME(device, VK_OBJECT_TYPE_DEVICE_MEMORY, m_StagingBufferMemory,
+                  "Image staging memory");
   }
 
   void Image::Resize(uint32_t width, uint32_t height) {
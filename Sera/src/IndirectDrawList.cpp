@@ -0,0 +1,153 @@
+#include "IndirectDrawList.h"
+
+#include "Application.h"
+#include "Buffer.h"
+#include "Compute.h"
+#include "Draw.h"
+#include "Log.h"
+
+#include "Backend/VulkanDevice.h"
+
+#include "Shaders/cull_comp.h"
+
+#include <algorithm>
+#include <cstring>
+#include <iterator>
+
+namespace Sera {
+
+  namespace Utils {
+
+    // Gribb-Hartmann, planes point inwards and are normalized so the
+    // distance can be compared against a radius
+    static void ExtractFrustumPlanes(const glm::mat4& m, glm::vec4 planes[6]) {
+      auto row = [&m](int i) {
+        return glm::vec4(m[0][i], m[1][i], m[2][i], m[3][i]);
+      };
+      planes[0] = row(3) + row(0);  // Left
+      planes[1] = row(3) - row(0);  // Right
+      planes[2] = row(3) + row(1);  // Bottom
+      planes[3] = row(3) - row(1);  // Top
+      planes[4] = row(2);           // Near, Vulkan clip depth starts at 0
+      planes[5] = row(3) - row(2);  // Far
+      for (int i = 0; i < 6; i++)
+        planes[i] /= glm::length(glm::vec3(planes[i]));
+    }
+
+  }  // namespace Utils
+
+  IndirectDrawList::IndirectDrawList() {
+    const auto& features = Application::GetVulkanDevice()->features;
+    m_Compact            = features.drawIndirectCount;
+    m_FirstInstance      = features.drawIndirectFirstInstance;
+    // gl_DrawID only tells the objects apart when one call draws them all
+    if (!m_FirstInstance)
+      m_Supported = features.shaderDrawParameters &&
+                    (m_Compact || features.multiDrawIndirect);
+    if (!m_Supported)
+      SR_CORE_ERROR(
+          "Indirect draws need drawIndirectFirstInstance or "
+          "shaderDrawParameters, culled objects will not be drawn");
+
+    m_CullShader = std::make_unique<ComputeShader>(
+        Shaders::cull_comp, std::size(Shaders::cull_comp), "cull.comp",
+        SpecializationConstants().Set(0, m_Compact).Set(1, m_FirstInstance));
+
+    const uint32_t zero = 0;
+    m_CountBuffer       = std::make_unique<Buffer>(
+        sizeof(uint32_t), BufferUsage::Storage | BufferUsage::Indirect,
+        BufferMemory::Dynamic, &zero);
+  }
+
+  IndirectDrawList::~IndirectDrawList() = default;
+
+  void IndirectDrawList::SetObjects(const std::vector<Object>& objects) {
+    static_assert(sizeof(Object) == 8 * sizeof(uint32_t),
+                  "Objects are packed the way cull.comp reads them");
+
+    m_Objects     = objects;
+    m_ObjectCount = (uint32_t)objects.size();
+    m_Version++;
+    if (m_ObjectCount == 0) return;
+
+    uint64_t objectSize = m_ObjectCount * sizeof(Object);
+    uint64_t drawSize   = m_ObjectCount * sizeof(VkDrawIndexedIndirectCommand);
+    if (!m_ObjectBuffer || m_ObjectBuffer->GetSize() < objectSize) {
+      if (m_ObjectBuffer)
+        m_ObjectBuffer->Resize(objectSize);
+      else
+        m_ObjectBuffer = std::make_unique<Buffer>(
+            objectSize, BufferUsage::Storage, BufferMemory::Dynamic);
+    }
+    // Only the GPU writes the commands, one copy is enough since every
+    // frame's dispatch waits for the previous draws
+    if (!m_DrawBuffer || m_DrawBuffer->GetSize() < drawSize) {
+      if (m_DrawBuffer)
+        m_DrawBuffer->Resize(drawSize);
+      else
+        m_DrawBuffer = std::make_unique<Buffer>(
+            drawSize, BufferUsage::Storage | BufferUsage::Indirect);
+    }
+    // Bound to the culling dispatch even when firstInstance is used
+    uint64_t drawObjectSize = m_ObjectCount * sizeof(uint32_t);
+    if (!m_DrawObjectBuffer || m_DrawObjectBuffer->GetSize() < drawObjectSize) {
+      if (m_DrawObjectBuffer)
+        m_DrawObjectBuffer->Resize(drawObjectSize);
+      else
+        m_DrawObjectBuffer =
+            std::make_unique<Buffer>(drawObjectSize, BufferUsage::Storage);
+    }
+  }
+
+  void IndirectDrawList::Cull(VkCommandBuffer  commandBuffer,
+                              const glm::mat4& viewProjection) {
+    // The count this frame's copy got when it was last submitted, the fence
+    // of that frame has been waited on
+    uint32_t* count   = (uint32_t*)m_CountBuffer->GetMappedData();
+    m_Stats.submitted = m_ObjectCount;
+    m_Stats.visible   = std::min(*count, m_ObjectCount);
+    *count            = 0;
+    if (m_ObjectCount == 0 || !m_CullShader->IsValid()) return;
+
+    // Mapping first, it reallocates the copies when the swapchain got more
+    // images. Reallocated copies, like resized ones, start out empty.
+    uint32_t frame   = Application::GetCurrentFrameInFlight();
+    void*    objects = m_ObjectBuffer->GetMappedData();
+    if (m_ObjectBuffer->GetGeneration() != m_UploadedGeneration) {
+      m_UploadedVersions.clear();
+      m_UploadedGeneration = m_ObjectBuffer->GetGeneration();
+    }
+    if (m_UploadedVersions.size() <= frame)
+      m_UploadedVersions.resize(frame + 1, 0);
+    if (m_UploadedVersions[frame] != m_Version) {
+      memcpy(objects, m_Objects.data(), m_ObjectCount * sizeof(Object));
+      m_UploadedVersions[frame] = m_Version;
+    }
+
+    struct {
+        glm::vec4 planes[6];
+        uint32_t  objectCount;
+    } push;
+    Utils::ExtractFrustumPlanes(viewProjection, push.planes);
+    push.objectCount = m_ObjectCount;
+
+    ComputeDispatch(commandBuffer, *m_CullShader)
+        .Bind(0, *m_ObjectBuffer)
+        .Bind(1, *m_DrawBuffer)
+        .Bind(2, *m_CountBuffer)
+        .Bind(3, *m_DrawObjectBuffer)
+        .Push(push)
+        .Dispatch((m_ObjectCount + m_CullShader->GetLocalSizeX() - 1) /
+                  m_CullShader->GetLocalSizeX());
+  }
+
+  void IndirectDrawList::Draw(DrawCall& drawCall) {
+    if (m_ObjectCount == 0 || !m_Supported) return;
+    if (m_Compact)
+      drawCall.DrawIndexedIndirectCount(*m_DrawBuffer, *m_CountBuffer,
+                                        m_ObjectCount);
+    else
+      drawCall.DrawIndexedIndirect(*m_DrawBuffer, m_ObjectCount);
+  }
+
+}  // namespace Sera
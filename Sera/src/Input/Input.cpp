@@ -8,18 +8,21 @@ namespace Sera {
 
   bool Input::IsKeyDown(KeyCode keycode) {
     GLFWwindow *windowHandle = Application::Get().GetWindowHandle();
-    int         state        = glfwGetKey(windowHandle, (int)keycode);
+    if (!windowHandle) return false;
+    int state = glfwGetKey(windowHandle, (int)keycode);
     return state == GLFW_PRESS || state == GLFW_REPEAT;
   }
 
   bool Input::IsMouseButtonDown(MouseButton button) {
     GLFWwindow *windowHandle = Application::Get().GetWindowHandle();
-    int         state        = glfwGetMouseButton(windowHandle, (int)button);
+    if (!windowHandle) return false;
+    int state = glfwGetMouseButton(windowHandle, (int)button);
     return state == GLFW_PRESS;
   }
 
   glm::vec2 Input::GetMousePosition() {
     GLFWwindow *windowHandle = Application::Get().GetWindowHandle();
+    if (!windowHandle) return {0.0f, 0.0f};
 
     double x, y;
     glfwGetCursorPos(windowHandle, &x, &y);
@@ -28,6 +31,7 @@ namespace Sera {
 
   void Input::SetCursorMode(CursorMode mode) {
     GLFWwindow *windowHandle = Application::Get().GetWindowHandle();
+    if (!windowHandle) return;
     glfwSetInputMode(windowHandle, GLFW_CURSOR, GLFW_CURSOR_NORMAL + (int)mode);
   }
 
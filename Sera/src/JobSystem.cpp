@@ -0,0 +1,217 @@
+#include "JobSystem.h"
+
+#include <algorithm>
+
+#include "Profiler.h"
+
+namespace Sera {
+
+  namespace Utils {
+
+    // Queue of the current thread, threads of other job systems or threads
+    // the application started itself have none
+    struct ThreadQueue {
+        const JobSystem* system = nullptr;
+        uint32_t         index  = 0;
+    };
+    static thread_local ThreadQueue s_ThreadQueue;
+
+  }  // namespace Utils
+
+  bool JobCounter::IsDone() const {
+    // Finishing jobs decrement under the lock, after this returns true no
+    // job touches the counter anymore and it can be destroyed
+    std::lock_guard<std::mutex> lock(m_Mutex);
+    return m_Value.load() == 0;
+  }
+
+  JobSystem::JobSystem(uint32_t workerCount) {
+    if (workerCount == 0)
+      workerCount = std::max(1u, std::thread::hardware_concurrency()) - 1;
+
+    Utils::s_ThreadQueue = {this, 0};
+    for (uint32_t i = 0; i <= workerCount; i++)
+      m_Queues.push_back(std::make_unique<Queue>());
+    for (uint32_t i = 1; i <= workerCount; i++)
+      m_Workers.emplace_back([this, i]() { WorkerLoop(i); });
+  }
+
+  JobSystem::~JobSystem() {
+    // Workers drain the queues before they stop
+    {
+      std::lock_guard<std::mutex> lock(m_SleepMutex);
+      m_Stop = true;
+    }
+    m_SleepCondition.notify_all();
+    for (auto& worker : m_Workers) worker.join();
+
+    Entry entry;
+    while (Pop(entry)) Execute(entry);
+    ExecuteMainThreadJobs();
+  }
+
+  void JobSystem::Run(Job job, JobCounter* counter) {
+    if (counter) counter->m_Value++;
+    Push({std::move(job), counter});
+  }
+
+  void JobSystem::Run(Job job, JobCounter& dependency, JobCounter* counter) {
+    if (counter) counter->m_Value++;
+    {
+      std::lock_guard<std::mutex> lock(dependency.m_Mutex);
+      if (dependency.m_Value.load() != 0) {
+        dependency.m_Continuations.push_back({std::move(job), counter, false});
+        return;
+      }
+    }
+    Push({std::move(job), counter});
+  }
+
+  void JobSystem::RunOnMainThread(Job job) {
+    std::lock_guard<std::mutex> lock(m_MainThreadMutex);
+    m_MainThreadJobs.push_back(std::move(job));
+  }
+
+  void JobSystem::RunOnMainThread(Job job, JobCounter& dependency) {
+    {
+      std::lock_guard<std::mutex> lock(dependency.m_Mutex);
+      if (dependency.m_Value.load() != 0) {
+        dependency.m_Continuations.push_back({std::move(job), nullptr, true});
+        return;
+      }
+    }
+    RunOnMainThread(std::move(job));
+  }
+
+  void JobSystem::ParallelForRange(
+      uint32_t count, uint32_t batchSize,
+      const std::function<void(uint32_t begin, uint32_t end)>& function) {
+    if (count == 0) return;
+    if (batchSize == 0)
+      batchSize = std::max(1u, count / (GetThreadCount() * 4));
+
+    // The calling thread takes the first batch and steals the rest while
+    // it waits
+    JobCounter counter;
+    for (uint32_t begin = batchSize; begin < count; begin += batchSize) {
+      uint32_t end = std::min(begin + batchSize, count);
+      Run([&function, begin, end]() { function(begin, end); }, &counter);
+    }
+    function(0, std::min(batchSize, count));
+    Wait(counter);
+  }
+
+  void JobSystem::Wait(const JobCounter& counter) {
+    while (!counter.IsDone()) {
+      Entry entry;
+      if (Pop(entry))
+        Execute(entry);
+      else
+        std::this_thread::yield();
+    }
+  }
+
+  void JobSystem::ExecuteMainThreadJobs() {
+    // Jobs queued while these run wait for the next call
+    std::vector<Job> jobs;
+    {
+      std::lock_guard<std::mutex> lock(m_MainThreadMutex);
+      jobs.swap(m_MainThreadJobs);
+    }
+    for (auto& job : jobs) job();
+  }
+
+  void JobSystem::Push(Entry&& entry) {
+    uint32_t index = Utils::s_ThreadQueue.system == this
+                         ? Utils::s_ThreadQueue.index
+                         : m_NextQueue++ % (uint32_t)m_Queues.size();
+
+    // Counted before it is visible, so m_Queued never drops below the
+    // number of queued jobs
+    m_Queued++;
+    {
+      Queue&                      queue = *m_Queues[index];
+      std::lock_guard<std::mutex> lock(queue.mutex);
+      queue.entries.push_back(std::move(entry));
+    }
+    if (m_Sleeping.load() > 0) {
+      // Taking the lock orders this after a worker's check of m_Queued
+      { std::lock_guard<std::mutex> lock(m_SleepMutex); }
+      m_SleepCondition.notify_one();
+    }
+  }
+
+  bool JobSystem::Pop(Entry& entry) {
+    uint32_t count = (uint32_t)m_Queues.size();
+    uint32_t own =
+        Utils::s_ThreadQueue.system == this ? Utils::s_ThreadQueue.index : 0;
+
+    // Newest own job first, its data is most likely still in cache
+    {
+      Queue&                      queue = *m_Queues[own];
+      std::lock_guard<std::mutex> lock(queue.mutex);
+      if (!queue.entries.empty()) {
+        entry = std::move(queue.entries.back());
+        queue.entries.pop_back();
+        m_Queued--;
+        return true;
+      }
+    }
+    // Oldest job of another thread, usually the largest remaining piece
+    for (uint32_t i = 1; i < count; i++) {
+      Queue&                      queue = *m_Queues[(own + i) % count];
+      std::lock_guard<std::mutex> lock(queue.mutex);
+      if (!queue.entries.empty()) {
+        entry = std::move(queue.entries.front());
+        queue.entries.pop_front();
+        m_Queued--;
+        return true;
+      }
+    }
+    return false;
+  }
+
+  void JobSystem::Execute(Entry& entry) {
+    SR_PROFILE_SCOPE("Job");
+    entry.job();
+    entry.job = nullptr;
+    Finish(entry.counter);
+  }
+
+  void JobSystem::Finish(JobCounter* counter) {
+    if (!counter) return;
+
+    std::vector<JobCounter::Continuation> continuations;
+    {
+      std::lock_guard<std::mutex> lock(counter->m_Mutex);
+      if (--counter->m_Value != 0) return;
+      continuations.swap(counter->m_Continuations);
+    }
+    for (auto& continuation : continuations) {
+      if (continuation.mainThread)
+        RunOnMainThread(std::move(continuation.job));
+      else
+        Push({std::move(continuation.job), continuation.counter});
+    }
+  }
+
+  void JobSystem::WorkerLoop(uint32_t index) {
+    SR_PROFILE_THREAD("Job Worker");
+    Utils::s_ThreadQueue = {this, index};
+    while (true) {
+      Entry entry;
+      if (Pop(entry)) {
+        Execute(entry);
+        continue;
+      }
+
+      std::unique_lock<std::mutex> lock(m_SleepMutex);
+      if (m_Stop && m_Queued.load() == 0) return;
+      m_Sleeping++;
+      m_SleepCondition.wait(
+          lock, [this]() { return m_Stop || m_Queued.load() > 0; });
+      m_Sleeping--;
+    }
+  }
+
+}  // namespace Sera
@@ -0,0 +1,411 @@
+#include "MemoryTracker.h"
+
+#include <algorithm>
+#include <atomic>
+#include <cstdlib>
+#include <cstring>
+#include <mutex>
+#include <unordered_map>
+#include <vector>
+
+#include "imgui.h"
+
+#include "Log.h"
+
+#include "Backend/VulkanPhysicalDevice.h"
+
+namespace Sera {
+
+  namespace Utils {
+
+    static constexpr uint32_t s_ScopeCount =
+        VK_SYSTEM_ALLOCATION_SCOPE_INSTANCE + 1;
+
+    // Usage of the objects created with one set of callbacks
+    struct HostCounters {
+        VkObjectType          type;
+        const char*           name;
+        VkAllocationCallbacks callbacks;
+
+        std::atomic<uint64_t> bytes;
+        std::atomic<uint64_t> peak;
+        std::atomic<uint64_t> allocations;
+        std::atomic<uint64_t> scopeBytes[s_ScopeCount];
+        std::atomic<uint64_t> internalBytes;
+    };
+
+    // Unknown collects every type without its own counters
+    static HostCounters s_HostCounters[] = {
+        {VK_OBJECT_TYPE_UNKNOWN, "Other"},
+        {VK_OBJECT_TYPE_BUFFER, "Buffer"},
+        {VK_OBJECT_TYPE_IMAGE, "Image"},
+        {VK_OBJECT_TYPE_IMAGE_VIEW, "Image view"},
+        {VK_OBJECT_TYPE_SAMPLER, "Sampler"},
+        {VK_OBJECT_TYPE_DEVICE_MEMORY, "Device memory"},
+    };
+    static bool s_Enabled = false;
+
+    // Precedes every tracked allocation
+    struct AllocationHeader {
+        void*                   raw;
+        size_t                  size;
+        VkSystemAllocationScope scope;
+    };
+
+    struct DeviceAllocation {
+        VkDeviceSize size;
+        uint32_t     heap;
+        const char*  owner;
+    };
+
+    struct OwnerUsage {
+        const char*  owner;
+        VkDeviceSize bytes;
+        uint32_t     allocations;
+    };
+
+    static std::mutex                                           s_LedgerMutex;
+    static std::unordered_map<VkDeviceMemory, DeviceAllocation> s_Ledger;
+    static std::vector<OwnerUsage>                              s_Owners;
+    static VkDeviceSize s_HeapTracked[VK_MAX_MEMORY_HEAPS] = {};
+
+    static const VulkanPhysicalDevice* s_PhysicalDevice = nullptr;
+    static bool                        s_MemoryBudget   = false;
+    static MemoryTracker::HeapUsage    s_Heaps[VK_MAX_MEMORY_HEAPS];
+    static uint32_t                    s_HeapCount = 0;
+
+    // Heaps above the threshold, they warn again once they fell below it
+    // by the hysteresis
+    static bool                          s_Warned[VK_MAX_MEMORY_HEAPS] = {};
+    static float                         s_Threshold  = 0.9f;
+    static constexpr float               s_Hysteresis = 0.05f;
+    static MemoryTracker::BudgetCallback s_BudgetCallback;
+
+    static void AddHostUsage(HostCounters* counters, size_t size,
+                             VkSystemAllocationScope scope) {
+      uint64_t bytes = counters->bytes.fetch_add(size) + size;
+      uint64_t peak  = counters->peak.load(std::memory_order_relaxed);
+      while (bytes > peak && !counters->peak.compare_exchange_weak(peak, bytes))
+        ;
+      counters->allocations.fetch_add(1, std::memory_order_relaxed);
+      counters->scopeBytes[scope].fetch_add(size, std::memory_order_relaxed);
+    }
+
+    static void VKAPI_PTR Free(void* userData, void* memory) {
+      if (!memory) return;
+      auto* counters = (HostCounters*)userData;
+      auto* header   = (AllocationHeader*)memory - 1;
+      counters->bytes.fetch_sub(header->size);
+      counters->allocations.fetch_sub(1, std::memory_order_relaxed);
+      counters->scopeBytes[header->scope].fetch_sub(header->size,
+                                                    std::memory_order_relaxed);
+      free(header->raw);
+    }
+
+    static void* VKAPI_PTR Allocate(void* userData, size_t size,
+                                    size_t                  alignment,
+                                    VkSystemAllocationScope scope) {
+      // Alignments are powers of two, at least the header's keeps it aligned
+      // right before the returned memory
+      alignment = std::max(alignment, alignof(AllocationHeader));
+      void* raw = malloc(size + sizeof(AllocationHeader) + alignment - 1);
+      if (!raw) return nullptr;
+
+      uintptr_t address =
+          ((uintptr_t)raw + sizeof(AllocationHeader) + alignment - 1) &
+          ~(uintptr_t)(alignment - 1);
+      auto* header  = (AllocationHeader*)address - 1;
+      header->raw   = raw;
+      header->size  = size;
+      header->scope = scope;
+      AddHostUsage((HostCounters*)userData, size, scope);
+      return (void*)address;
+    }
+
+    static void* VKAPI_PTR Reallocate(void* userData, void* original,
+                                      size_t size, size_t alignment,
+                                      VkSystemAllocationScope scope) {
+      if (!original) return Allocate(userData, size, alignment, scope);
+      if (size == 0) {
+        Free(userData, original);
+        return nullptr;
+      }
+
+      // On failure the original must stay valid
+      void* memory = Allocate(userData, size, alignment, scope);
+      if (!memory) return nullptr;
+      auto* header = (AllocationHeader*)original - 1;
+      memcpy(memory, original, std::min(size, header->size));
+      Free(userData, original);
+      return memory;
+    }
+
+    static void VKAPI_PTR InternalAllocation(void* userData, size_t size,
+                                             VkInternalAllocationType,
+                                             VkSystemAllocationScope) {
+      ((HostCounters*)userData)->internalBytes.fetch_add(size);
+    }
+
+    static void VKAPI_PTR InternalFree(void* userData, size_t size,
+                                       VkInternalAllocationType,
+                                       VkSystemAllocationScope) {
+      ((HostCounters*)userData)->internalBytes.fetch_sub(size);
+    }
+
+    static HostCounters& FindHostCounters(VkObjectType type) {
+      for (auto& counters : s_HostCounters)
+        if (counters.type == type) return counters;
+      return s_HostCounters[0];
+    }
+
+    static MemoryTracker::HostUsage GetHostUsage(
+        const HostCounters& counters) {
+      MemoryTracker::HostUsage usage;
+      usage.bytes       = counters.bytes.load(std::memory_order_relaxed);
+      usage.peak        = counters.peak.load(std::memory_order_relaxed);
+      usage.allocations = counters.allocations.load(std::memory_order_relaxed);
+      for (uint32_t i = 0; i < s_ScopeCount; i++)
+        usage.scopeBytes[i] =
+            counters.scopeBytes[i].load(std::memory_order_relaxed);
+      usage.internalBytes =
+          counters.internalBytes.load(std::memory_order_relaxed);
+      return usage;
+    }
+
+    static double ToMiB(uint64_t bytes) { return bytes / (1024.0 * 1024.0); }
+
+  }  // namespace Utils
+
+  void MemoryTracker::SetEnabled(bool enabled) {
+    if (Utils::s_PhysicalDevice) {
+      SR_CORE_WARN("Memory tracking can only change before the device exists");
+      return;
+    }
+    Utils::s_Enabled = enabled;
+    for (auto& counters : Utils::s_HostCounters) {
+      VkAllocationCallbacks& callbacks = counters.callbacks;
+      callbacks.pUserData              = &counters;
+      callbacks.pfnAllocation          = Utils::Allocate;
+      callbacks.pfnReallocation        = Utils::Reallocate;
+      callbacks.pfnFree                = Utils::Free;
+      callbacks.pfnInternalAllocation  = Utils::InternalAllocation;
+      callbacks.pfnInternalFree        = Utils::InternalFree;
+    }
+  }
+
+  bool MemoryTracker::IsEnabled() { return Utils::s_Enabled; }
+
+  const VkAllocationCallbacks* MemoryTracker::GetAllocationCallbacks(
+      VkObjectType type) {
+    if (!Utils::s_Enabled) return nullptr;
+    return &Utils::FindHostCounters(type).callbacks;
+  }
+
+  MemoryTracker::HostUsage MemoryTracker::GetHostUsage(VkObjectType type) {
+    return Utils::GetHostUsage(Utils::FindHostCounters(type));
+  }
+
+  MemoryTracker::HostUsage MemoryTracker::GetTotalHostUsage() {
+    HostUsage total;
+    for (const auto& counters : Utils::s_HostCounters) {
+      HostUsage usage = Utils::GetHostUsage(counters);
+      total.bytes += usage.bytes;
+      // Peaks of different types need not coincide, their sum is a bound
+      total.peak += usage.peak;
+      total.allocations += usage.allocations;
+      for (uint32_t i = 0; i < Utils::s_ScopeCount; i++)
+        total.scopeBytes[i] += usage.scopeBytes[i];
+      total.internalBytes += usage.internalBytes;
+    }
+    return total;
+  }
+
+  void MemoryTracker::Init(const VulkanPhysicalDevice* physicalDevice,
+                           bool                        memoryBudget) {
+    Utils::s_PhysicalDevice = physicalDevice;
+    Utils::s_MemoryBudget   = memoryBudget;
+
+    const auto& properties = physicalDevice->memoryProperties;
+    Utils::s_HeapCount     = properties.memoryHeapCount;
+    for (uint32_t i = 0; i < Utils::s_HeapCount; i++) {
+      Utils::s_Heaps[i].size  = properties.memoryHeaps[i].size;
+      Utils::s_Heaps[i].flags = properties.memoryHeaps[i].flags;
+    }
+    if (!memoryBudget)
+      SR_CORE_INFO("VK_EXT_memory_budget is not supported, budgets are the "
+                   "heap sizes");
+  }
+
+  void MemoryTracker::TrackDeviceMemory(VkDeviceMemory memory,
+                                        VkDeviceSize   size,
+                                        uint32_t       memoryType,
+                                        const char*    owner) {
+    if (memory == VK_NULL_HANDLE) return;
+    uint32_t heap = 0;
+    if (Utils::s_PhysicalDevice && memoryType < VK_MAX_MEMORY_TYPES)
+      heap = Utils::s_PhysicalDevice->memoryProperties.memoryTypes[memoryType]
+                 .heapIndex;
+
+    std::lock_guard<std::mutex> lock(Utils::s_LedgerMutex);
+    Utils::s_Ledger[memory] = {size, heap, owner};
+    Utils::s_HeapTracked[heap] += size;
+
+    auto it = std::find_if(Utils::s_Owners.begin(), Utils::s_Owners.end(),
+                           [owner](const Utils::OwnerUsage& usage) {
+                             return strcmp(usage.owner, owner) == 0;
+                           });
+    if (it == Utils::s_Owners.end())
+      it = Utils::s_Owners.insert(it, {owner, 0, 0});
+    it->bytes += size;
+    it->allocations++;
+  }
+
+  void MemoryTracker::UntrackDeviceMemory(VkDeviceMemory memory) {
+    if (memory == VK_NULL_HANDLE) return;
+
+    std::lock_guard<std::mutex> lock(Utils::s_LedgerMutex);
+    auto allocation = Utils::s_Ledger.find(memory);
+    if (allocation == Utils::s_Ledger.end()) return;
+    const Utils::DeviceAllocation& tracked = allocation->second;
+    Utils::s_HeapTracked[tracked.heap] -= tracked.size;
+    for (auto& usage : Utils::s_Owners) {
+      if (strcmp(usage.owner, tracked.owner) != 0) continue;
+      usage.bytes -= tracked.size;
+      usage.allocations--;
+      break;
+    }
+    Utils::s_Ledger.erase(allocation);
+  }
+
+  void MemoryTracker::UpdateBudget() {
+    if (!Utils::s_PhysicalDevice) return;
+
+    VkPhysicalDeviceMemoryBudgetPropertiesEXT budget = {};
+    budget.sType =
+        VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_MEMORY_BUDGET_PROPERTIES_EXT;
+    if (Utils::s_MemoryBudget) {
+      VkPhysicalDeviceMemoryProperties2 properties = {};
+      properties.sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_MEMORY_PROPERTIES_2;
+      properties.pNext = &budget;
+      vkGetPhysicalDeviceMemoryProperties2(
+          Utils::s_PhysicalDevice->physicalDevice, &properties);
+    }
+
+    {
+      std::lock_guard<std::mutex> lock(Utils::s_LedgerMutex);
+      for (uint32_t i = 0; i < Utils::s_HeapCount; i++)
+        Utils::s_Heaps[i].tracked = Utils::s_HeapTracked[i];
+    }
+
+    for (uint32_t i = 0; i < Utils::s_HeapCount; i++) {
+      HeapUsage& heap = Utils::s_Heaps[i];
+      heap.usage  = Utils::s_MemoryBudget ? budget.heapUsage[i] : heap.tracked;
+      heap.budget = Utils::s_MemoryBudget ? budget.heapBudget[i] : heap.size;
+      if (heap.budget == 0) continue;
+
+      float fraction = (float)((double)heap.usage / heap.budget);
+      if (!Utils::s_Warned[i] && fraction >= Utils::s_Threshold) {
+        Utils::s_Warned[i] = true;
+        SR_CORE_WARN("Memory heap {} uses {:.1f} of its {:.1f} MiB budget", i,
+                     Utils::ToMiB(heap.usage), Utils::ToMiB(heap.budget));
+        if (Utils::s_BudgetCallback) Utils::s_BudgetCallback(i, heap);
+      } else if (Utils::s_Warned[i] &&
+                 fraction < Utils::s_Threshold - Utils::s_Hysteresis) {
+        Utils::s_Warned[i] = false;
+      }
+    }
+  }
+
+  void MemoryTracker::SetBudgetThreshold(float threshold) {
+    Utils::s_Threshold = threshold;
+  }
+
+  void MemoryTracker::SetBudgetCallback(const BudgetCallback& callback) {
+    Utils::s_BudgetCallback = callback;
+  }
+
+  uint32_t MemoryTracker::GetHeapCount() { return Utils::s_HeapCount; }
+
+  const MemoryTracker::HeapUsage& MemoryTracker::GetHeapUsage(uint32_t heap) {
+    return Utils::s_Heaps[heap];
+  }
+
+  void MemoryTracker::ShowPanel(bool* open) {
+    if (!ImGui::Begin("Memory", open)) {
+      ImGui::End();
+      return;
+    }
+
+    for (uint32_t i = 0; i < Utils::s_HeapCount; i++) {
+      const HeapUsage& heap = Utils::s_Heaps[i];
+      ImGui::Text("Heap %u%s, %.0f MiB", i,
+                  heap.flags & VK_MEMORY_HEAP_DEVICE_LOCAL_BIT
+                      ? " (device local)"
+                      : "",
+                  Utils::ToMiB(heap.size));
+      char overlay[64];
+      snprintf(overlay, sizeof(overlay), "%.1f / %.1f MiB",
+               Utils::ToMiB(heap.usage), Utils::ToMiB(heap.budget));
+      ImGui::ProgressBar(
+          heap.budget ? (float)((double)heap.usage / heap.budget) : 0.0f,
+          ImVec2(-1.0f, 0.0f), overlay);
+      ImGui::Text("Tracked: %.1f MiB", Utils::ToMiB(heap.tracked));
+    }
+
+    ImGui::Separator();
+    ImGui::TextUnformatted("Device memory");
+    if (ImGui::BeginTable("Owners", 3, ImGuiTableFlags_SizingFixedFit)) {
+      ImGui::TableSetupColumn("Owner");
+      ImGui::TableSetupColumn("Allocations");
+      ImGui::TableSetupColumn("MiB");
+      ImGui::TableHeadersRow();
+      std::lock_guard<std::mutex> lock(Utils::s_LedgerMutex);
+      for (const auto& usage : Utils::s_Owners) {
+        ImGui::TableNextRow();
+        ImGui::TableNextColumn();
+        ImGui::TextUnformatted(usage.owner);
+        ImGui::TableNextColumn();
+        ImGui::Text("%u", usage.allocations);
+        ImGui::TableNextColumn();
+        ImGui::Text("%.2f", Utils::ToMiB(usage.bytes));
+      }
+      ImGui::EndTable();
+    }
+
+    ImGui::Separator();
+    ImGui::TextUnformatted("Host memory");
+    if (!Utils::s_Enabled) {
+      ImGui::TextUnformatted("Tracking is disabled");
+      ImGui::End();
+      return;
+    }
+    if (ImGui::BeginTable("Types", 5, ImGuiTableFlags_SizingFixedFit)) {
+      for (const char* header :
+           {"Type", "Allocations", "KiB", "Peak KiB", "Internal KiB"})
+        ImGui::TableSetupColumn(header);
+      ImGui::TableHeadersRow();
+      for (const auto& counters : Utils::s_HostCounters) {
+        HostUsage usage = Utils::GetHostUsage(counters);
+        ImGui::TableNextRow();
+        ImGui::TableNextColumn();
+        ImGui::TextUnformatted(counters.name);
+        ImGui::TableNextColumn();
+        ImGui::Text("%llu", (unsigned long long)usage.allocations);
+        for (uint64_t bytes : {usage.bytes, usage.peak, usage.internalBytes}) {
+          ImGui::TableNextColumn();
+          ImGui::Text("%.1f", bytes / 1024.0);
+        }
+      }
+      ImGui::EndTable();
+    }
+
+    static const char* s_ScopeNames[] = {"Command", "Object", "Cache",
+                                         "Device", "Instance"};
+    HostUsage total = GetTotalHostUsage();
+    for (uint32_t i = 0; i < Utils::s_ScopeCount; i++)
+      ImGui::Text("%s scope: %.1f KiB", s_ScopeNames[i],
+                  total.scopeBytes[i] / 1024.0);
+    ImGui::End();
+  }
+
+}  // namespace Sera
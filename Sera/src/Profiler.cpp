@@ -0,0 +1,491 @@
+#include "Profiler.h"
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstdio>
+#include <cstring>
+#include <fstream>
+#include <memory>
+#include <mutex>
+
+#include "imgui.h"
+
+#include "AllocationTracker.h"
+#include "Log.h"
+
+namespace Sera {
+
+  namespace Utils {
+
+    // Zones a thread can record between two collections
+    static constexpr uint64_t s_RingSize      = 1 << 14;
+    static constexpr uint32_t s_HistoryFrames = 120;
+    // Open zones a thread keeps allocation counts for, deeper ones record
+    // none
+    static constexpr uint32_t s_MaxDepth      = 64;
+
+    struct ZoneRecord {
+        const char* name;
+        uint64_t    start;
+        uint64_t    end;
+        uint32_t    depth;
+        uint32_t    allocations;
+        uint64_t    allocatedBytes;
+    };
+
+    struct OpenZone {
+        const char*              name;
+        AllocationTracker::Usage usage;
+    };
+
+    // Single producer ring, only the owning thread writes records and
+    // head. The collector reads behind it and drops whatever the owner
+    // overwrote meanwhile.
+    struct ThreadRing {
+        uint32_t                      id;
+        std::unique_ptr<ZoneRecord[]> records;
+        std::atomic<uint64_t>         head{0};
+        uint64_t                      tail  = 0;
+        uint32_t                      depth = 0;
+        // Set when the thread exits, the ring is freed once collected
+        std::atomic<bool>             retired{false};
+#ifdef SR_TRACK_ALLOCATIONS
+        OpenZone                      open[s_MaxDepth];
+#endif
+    };
+
+    // Guards the ring list, thread names and the frame history
+    static std::mutex                               s_Mutex;
+    static std::vector<std::unique_ptr<ThreadRing>> s_Rings;
+    // Rings of Profiler::AddTrack(), never retired
+    static std::vector<ThreadRing*>                 s_Tracks;
+    // Indexed by thread id, kept after the thread exits for the history
+    static std::vector<std::string>                 s_ThreadNames;
+    static std::vector<Profiler::Frame>             s_Frames;
+    static uint64_t                                 s_FrameStart = 0;
+    static bool                                     s_Paused     = false;
+    static int                                      s_FramesBack = 0;
+
+    struct ThreadRingOwner {
+        ThreadRing* ring = nullptr;
+        ~ThreadRingOwner() {
+          if (ring) ring->retired.store(true, std::memory_order_release);
+        }
+    };
+    static thread_local ThreadRingOwner s_ThreadRing;
+
+    // Expects s_Mutex to be locked
+    static ThreadRing* CreateRing(const char* name) {
+      auto ring     = std::make_unique<ThreadRing>();
+      ring->records = std::make_unique<ZoneRecord[]>(s_RingSize);
+      ring->id      = (uint32_t)s_ThreadNames.size();
+      s_ThreadNames.push_back(name ? std::string(name)
+                                   : "Thread " + std::to_string(ring->id));
+      s_Rings.push_back(std::move(ring));
+      return s_Rings.back().get();
+    }
+
+    static ThreadRing& GetThreadRing() {
+      if (!s_ThreadRing.ring) {
+        std::lock_guard<std::mutex> lock(s_Mutex);
+        s_ThreadRing.ring = CreateRing(nullptr);
+      }
+      return *s_ThreadRing.ring;
+    }
+
+    static void WriteRecord(ThreadRing& ring, const ZoneRecord& record) {
+      uint64_t head = ring.head.load(std::memory_order_relaxed);
+      ring.records[head % s_RingSize] = record;
+      ring.head.store(head + 1, std::memory_order_release);
+    }
+
+    // Moves zones that ended before `frame` into the frames of the history
+    // they ended in, zones older than the history are dropped
+    static void FileLateZones(Profiler::Frame& frame) {
+      auto late = std::stable_partition(
+          frame.zones.begin(), frame.zones.end(),
+          [&](const Profiler::Zone& zone) { return zone.end >= frame.start; });
+      for (auto it = late; it != frame.zones.end(); it++) {
+        for (auto older = s_Frames.rbegin(); older != s_Frames.rend();
+             older++) {
+          if (it->end >= older->start) {
+            older->zones.push_back(*it);
+            break;
+          }
+        }
+      }
+      frame.zones.erase(late, frame.zones.end());
+    }
+
+    // Moves the records written since the last collection into `zones`
+    static void CollectRing(ThreadRing&                  ring,
+                            std::vector<Profiler::Zone>* zones) {
+      uint64_t head   = ring.head.load(std::memory_order_acquire);
+      uint64_t oldest = head > s_RingSize ? head - s_RingSize : 0;
+      uint64_t first  = std::max(ring.tail, oldest);
+      size_t   count  = zones ? zones->size() : 0;
+      if (zones) {
+        for (uint64_t i = first; i < head; i++) {
+          const ZoneRecord& record = ring.records[i % s_RingSize];
+          zones->push_back({record.name, record.start, record.end,
+                            record.depth, ring.id, record.allocations,
+                            record.allocatedBytes});
+        }
+
+        // Records the owner wrapped around onto while they were copied
+        uint64_t after = ring.head.load(std::memory_order_acquire);
+        if (after > first + s_RingSize) {
+          uint64_t lost = std::min(after - s_RingSize, head) - first;
+          zones->erase(zones->begin() + count,
+                       zones->begin() + count + lost);
+        }
+      }
+      ring.tail = head;
+    }
+
+    static void WriteJsonString(std::ofstream& stream, const char* text) {
+      stream << '"';
+      for (const char* c = text; *c; c++) {
+        if (*c == '"' || *c == '\\')
+          stream << '\\' << *c;
+        else if ((unsigned char)*c < 0x20)
+          stream << ' ';
+        else
+          stream << *c;
+      }
+      stream << '"';
+    }
+
+    static uint32_t ZoneColor(const char* name) {
+      // Stable per name, so a zone keeps its color from frame to frame
+      uint32_t hash = 2166136261u;
+      for (const char* c = name; *c; c++) hash = (hash ^ *c) * 16777619u;
+      uint32_t r = 80 + (hash & 0x7f);
+      uint32_t g = 80 + ((hash >> 8) & 0x7f);
+      uint32_t b = 80 + ((hash >> 16) & 0x7f);
+      return IM_COL32(r, g, b, 255);
+    }
+
+    struct TreeNode {
+        const char*           name;
+        uint64_t              time           = 0;
+        uint32_t              calls          = 0;
+        uint64_t              allocations    = 0;
+        uint64_t              allocatedBytes = 0;
+        std::vector<uint32_t> children;
+    };
+
+    // Rebuilds the call tree of one thread's zones, merging calls of the
+    // same zone under the same parent. Node 0 is the root.
+    static std::vector<TreeNode> BuildCallTree(
+        std::vector<const Profiler::Zone*>& zones) {
+      std::sort(zones.begin(), zones.end(),
+                [](const Profiler::Zone* a, const Profiler::Zone* b) {
+                  return a->start != b->start ? a->start < b->start
+                                              : a->depth < b->depth;
+                });
+
+      std::vector<TreeNode> nodes(1);
+      std::vector<uint32_t> stack;
+      for (const Profiler::Zone* zone : zones) {
+        // Parents of zones recorded before the frame started are gone, the
+        // zone then hangs off its closest known ancestor
+        while (stack.size() > zone->depth) stack.pop_back();
+        uint32_t parent = stack.empty() ? 0 : stack.back();
+
+        uint32_t node = 0;
+        for (uint32_t child : nodes[parent].children) {
+          if (strcmp(nodes[child].name, zone->name) == 0) node = child;
+        }
+        if (node == 0) {
+          node = (uint32_t)nodes.size();
+          nodes.push_back({zone->name});
+          nodes[parent].children.push_back(node);
+        }
+        nodes[node].time += zone->end - zone->start;
+        nodes[node].calls++;
+        nodes[node].allocations += zone->allocations;
+        nodes[node].allocatedBytes += zone->allocatedBytes;
+        stack.push_back(node);
+      }
+      return nodes;
+    }
+
+    static void DrawCallTree(const std::vector<TreeNode>& nodes,
+                             uint32_t                     index) {
+      for (uint32_t child : nodes[index].children) {
+        const TreeNode&    node  = nodes[child];
+        ImGuiTreeNodeFlags flags = node.children.empty()
+                                       ? ImGuiTreeNodeFlags_Leaf
+                                       : ImGuiTreeNodeFlags_None;
+        bool               open;
+        if (AllocationTracker::IsEnabled())
+          open = ImGui::TreeNodeEx(
+              (void*)(uintptr_t)child, flags,
+              "%s  %.3f ms  %u calls  %llu allocations, %.1f KiB", node.name,
+              node.time * 1e-6, node.calls,
+              (unsigned long long)node.allocations,
+              node.allocatedBytes / 1024.0);
+        else
+          open = ImGui::TreeNodeEx((void*)(uintptr_t)child, flags,
+                                   "%s  %.3f ms  %u calls", node.name,
+                                   node.time * 1e-6, node.calls);
+        if (open) {
+          DrawCallTree(nodes, child);
+          ImGui::TreePop();
+        }
+      }
+    }
+
+  }  // namespace Utils
+
+  uint64_t Profiler::Now() {
+    static const auto epoch = std::chrono::steady_clock::now();
+    return std::chrono::duration_cast<std::chrono::nanoseconds>(
+               std::chrono::steady_clock::now() - epoch)
+        .count();
+  }
+
+  uint32_t Profiler::BeginZone(const char* name) {
+    Utils::ThreadRing& ring = Utils::GetThreadRing();
+#ifdef SR_TRACK_ALLOCATIONS
+    if (ring.depth < Utils::s_MaxDepth)
+      ring.open[ring.depth] = {name, AllocationTracker::GetThreadUsage()};
+    AllocationTracker::SetZone(name);
+#endif
+    return ring.depth++;
+  }
+
+  void Profiler::EndZone(const char* name, uint64_t start, uint32_t depth) {
+    uint64_t           end  = Now();
+    Utils::ThreadRing& ring = Utils::GetThreadRing();
+    ring.depth              = depth;
+
+    Utils::ZoneRecord record{name, start, end, depth};
+#ifdef SR_TRACK_ALLOCATIONS
+    if (depth < Utils::s_MaxDepth) {
+      AllocationTracker::Usage usage = AllocationTracker::GetThreadUsage();
+      record.allocations =
+          (uint32_t)(usage.allocations - ring.open[depth].usage.allocations);
+      record.allocatedBytes = usage.bytes - ring.open[depth].usage.bytes;
+    }
+    // Back to the parent zone
+    AllocationTracker::SetZone(depth > 0 && depth <= Utils::s_MaxDepth
+                                   ? ring.open[depth - 1].name
+                                   : nullptr);
+#endif
+    Utils::WriteRecord(ring, record);
+  }
+
+  void Profiler::SetThreadName(const char* name) {
+    Utils::ThreadRing&          ring = Utils::GetThreadRing();
+    std::lock_guard<std::mutex> lock(Utils::s_Mutex);
+    Utils::s_ThreadNames[ring.id] = name;
+  }
+
+  uint32_t Profiler::AddTrack(const char* name) {
+    std::lock_guard<std::mutex> lock(Utils::s_Mutex);
+    Utils::s_Tracks.push_back(Utils::CreateRing(name));
+    return (uint32_t)Utils::s_Tracks.size() - 1;
+  }
+
+  void Profiler::AddZone(uint32_t track, const char* name, uint64_t start,
+                         uint64_t end, uint32_t depth) {
+    Utils::ThreadRing* ring;
+    {
+      std::lock_guard<std::mutex> lock(Utils::s_Mutex);
+      ring = Utils::s_Tracks[track];
+    }
+    Utils::WriteRecord(*ring, {name, start, end, depth});
+  }
+
+  void Profiler::MarkFrame() {
+    // The profiler's own bookkeeping is counted, but it is not the frame's
+    AllowAllocations            allow;
+    uint64_t                    now = Now();
+    std::lock_guard<std::mutex> lock(Utils::s_Mutex);
+
+    // The rings are drained while paused as well, so they hold no stale
+    // zones once collection resumes
+    Frame frame{Utils::s_FrameStart, now, {}};
+    auto& rings = Utils::s_Rings;
+    for (size_t i = 0; i < rings.size();) {
+      // Checked first, a retired ring gets no more records
+      bool retired = rings[i]->retired.load(std::memory_order_acquire);
+      Utils::CollectRing(*rings[i], Utils::s_Paused ? nullptr : &frame.zones);
+      if (retired)
+        rings.erase(rings.begin() + i);
+      else
+        i++;
+    }
+    Utils::s_FrameStart = now;
+    if (Utils::s_Paused) return;
+
+    Utils::FileLateZones(frame);
+    if (Utils::s_Frames.size() >= Utils::s_HistoryFrames)
+      Utils::s_Frames.erase(Utils::s_Frames.begin());
+    Utils::s_Frames.push_back(std::move(frame));
+  }
+
+  void Profiler::SetPaused(bool paused) {
+    std::lock_guard<std::mutex> lock(Utils::s_Mutex);
+    Utils::s_Paused = paused;
+  }
+
+  bool Profiler::IsPaused() {
+    std::lock_guard<std::mutex> lock(Utils::s_Mutex);
+    return Utils::s_Paused;
+  }
+
+  const std::vector<Profiler::Frame>& Profiler::GetFrames() {
+    return Utils::s_Frames;
+  }
+
+  std::vector<Profiler::Thread> Profiler::GetThreads() {
+    std::lock_guard<std::mutex> lock(Utils::s_Mutex);
+    std::vector<Thread>         threads;
+    for (uint32_t i = 0; i < (uint32_t)Utils::s_ThreadNames.size(); i++)
+      threads.push_back({i, Utils::s_ThreadNames[i]});
+    return threads;
+  }
+
+  bool Profiler::ExportChromeTrace(const std::string& path) {
+    std::ofstream stream(path);
+    if (!stream) {
+      SR_CORE_ERROR("Could not write profiler trace to {}", path);
+      return false;
+    }
+
+    std::lock_guard<std::mutex> lock(Utils::s_Mutex);
+    stream << "{\"displayTimeUnit\":\"ms\",\"traceEvents\":[";
+    bool first = true;
+    for (uint32_t i = 0; i < (uint32_t)Utils::s_ThreadNames.size(); i++) {
+      stream << (first ? "" : ",")
+             << "\n{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":0,\"tid\":"
+             << i << ",\"args\":{\"name\":";
+      Utils::WriteJsonString(stream, Utils::s_ThreadNames[i].c_str());
+      stream << "}}";
+      first = false;
+    }
+    char number[64];
+    for (const Frame& frame : Utils::s_Frames) {
+      for (const Zone& zone : frame.zones) {
+        // Microseconds, with the nanoseconds as fraction
+        stream << (first ? "" : ",") << "\n{\"name\":";
+        Utils::WriteJsonString(stream, zone.name);
+        snprintf(number, sizeof(number), "%.3f", zone.start * 1e-3);
+        stream << ",\"ph\":\"X\",\"pid\":0,\"tid\":" << zone.thread
+               << ",\"ts\":" << number;
+        snprintf(number, sizeof(number), "%.3f",
+                 (zone.end - zone.start) * 1e-3);
+        stream << ",\"dur\":" << number;
+        if (AllocationTracker::IsEnabled())
+          stream << ",\"args\":{\"allocations\":" << zone.allocations
+                 << ",\"bytes\":" << zone.allocatedBytes << "}";
+        stream << "}";
+        first = false;
+      }
+    }
+    stream << "\n]}\n";
+
+    SR_CORE_INFO("Wrote profiler trace of {} frames to {}",
+                 Utils::s_Frames.size(), path);
+    return true;
+  }
+
+  void Profiler::ShowPanel(bool* open) {
+    if (!ImGui::Begin("Profiler", open)) {
+      ImGui::End();
+      return;
+    }
+
+#ifndef SR_PROFILE
+    ImGui::TextUnformatted("Built without SR_PROFILE, zones are compiled out");
+#endif
+
+    bool paused = IsPaused();
+    if (ImGui::Checkbox("Pause", &paused)) SetPaused(paused);
+    ImGui::SameLine();
+    if (ImGui::Button("Export trace")) ExportChromeTrace("sera_trace.json");
+
+    // Only the main thread changes the history, which is the one drawing
+    // the panel, so it is read without the lock
+    const std::vector<Frame>& frames = Utils::s_Frames;
+    if (frames.empty()) {
+      ImGui::End();
+      return;
+    }
+    int& back = Utils::s_FramesBack;
+    back      = std::min(back, (int)frames.size() - 1);
+    ImGui::SliderInt("Frames back", &back, 0, (int)frames.size() - 1);
+
+    const Frame& frame    = frames[frames.size() - 1 - back];
+    uint64_t     duration = std::max<uint64_t>(frame.end - frame.start, 1);
+    ImGui::Text("Frame: %.3f ms, %zu zones", duration * 1e-6,
+                frame.zones.size());
+    ImGui::Separator();
+
+    std::vector<Thread> threads = GetThreads();
+    std::vector<std::vector<const Zone*>> threadZones(threads.size());
+    for (const Zone& zone : frame.zones)
+      if (zone.thread < threadZones.size())
+        threadZones[zone.thread].push_back(&zone);
+
+    // Timeline, one row per nesting level and thread
+    ImDrawList* drawList  = ImGui::GetWindowDrawList();
+    float       width     = std::max(ImGui::GetContentRegionAvail().x, 1.0f);
+    float       rowHeight = ImGui::GetTextLineHeightWithSpacing();
+    float       scale     = width / duration;
+    for (size_t t = 0; t < threads.size(); t++) {
+      if (threadZones[t].empty()) continue;
+
+      ImGui::TextUnformatted(threads[t].name.c_str());
+      uint32_t maxDepth = 0;
+      for (const Zone* zone : threadZones[t])
+        maxDepth = std::max(maxDepth, zone->depth);
+
+      ImVec2 origin = ImGui::GetCursorScreenPos();
+      ImVec2 size(width, (maxDepth + 1) * rowHeight);
+      ImVec2 corner(origin.x + size.x, origin.y + size.y);
+      drawList->PushClipRect(origin, corner, true);
+      for (const Zone* zone : threadZones[t]) {
+        uint64_t start = std::max(zone->start, frame.start) - frame.start;
+        uint64_t end   = std::min(zone->end, frame.end) - frame.start;
+        ImVec2   min(origin.x + start * scale,
+                     origin.y + zone->depth * rowHeight);
+        ImVec2   max(std::max(origin.x + end * scale, min.x + 1.0f),
+                     min.y + rowHeight - 1.0f);
+        drawList->AddRectFilled(min, max, Utils::ZoneColor(zone->name));
+        if (max.x - min.x > ImGui::CalcTextSize(zone->name).x + 4.0f)
+          drawList->AddText(ImVec2(min.x + 2.0f, min.y), IM_COL32_BLACK,
+                            zone->name);
+        if (ImGui::IsMouseHoveringRect(min, max)) {
+          if (AllocationTracker::IsEnabled())
+            ImGui::SetTooltip("%s\n%.3f ms\n%u allocations", zone->name,
+                              (zone->end - zone->start) * 1e-6,
+                              zone->allocations);
+          else
+            ImGui::SetTooltip("%s\n%.3f ms", zone->name,
+                              (zone->end - zone->start) * 1e-6);
+        }
+      }
+      drawList->PopClipRect();
+      ImGui::Dummy(size);
+    }
+
+    ImGui::Separator();
+    for (size_t t = 0; t < threads.size(); t++) {
+      if (threadZones[t].empty()) continue;
+      if (ImGui::TreeNode(threads[t].name.c_str())) {
+        std::vector<Utils::TreeNode> nodes =
+            Utils::BuildCallTree(threadZones[t]);
+        Utils::DrawCallTree(nodes, 0);
+        ImGui::TreePop();
+      }
+    }
+
+    ImGui::End();
+  }
+
+}  // namespace Sera
@@ -1,9 +1,227 @@
 #include "Random.h"
 
+#include <algorithm>
+#include <atomic>
+#include <cmath>
+#include <random>
+
+#if defined(__AVX2__)
+#include <immintrin.h>
+#elif defined(__SSE2__) || defined(_M_X64) || \
+    (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#include <emmintrin.h>
+#define SR_RANDOM_SSE2
+#endif
+
 namespace Sera {
 
-  std::mt19937 Random::s_RandomEngine;
-  std::uniform_int_distribution<std::mt19937::result_type>
-      Random::s_Distribution;
+  namespace Utils {
+
+    static std::atomic<uint64_t> s_BaseSeed{0x853c49e6748fea9bull};
+    static std::atomic<uint64_t> s_NextSequence{0};
+
+    static PCG32 CreateThreadGenerator() {
+      return PCG32(s_BaseSeed.load(), s_NextSequence++);
+    }
+
+    // Eight interleaved xoshiro128++ generators for the batch functions.
+    // Unlike PCG32 they need no 64-bit multiply, so all lanes step at once
+    // with 32-bit SIMD instructions.
+    static constexpr uint32_t s_LaneCount = 8;
+
+    struct Lanes {
+        alignas(32) uint32_t state[4][s_LaneCount];
+        bool seeded = false;
+    };
+    static thread_local Lanes s_Lanes;
+
+    static Lanes& GetLanes(PCG32& generator) {
+      Lanes& lanes = s_Lanes;
+      if (!lanes.seeded) {
+        for (uint32_t lane = 0; lane < s_LaneCount; lane++) {
+          for (uint32_t i = 0; i < 4; i++)
+            lanes.state[i][lane] = generator.Next();
+          // An all zero state would only ever produce zeros
+          lanes.state[0][lane] |= 1;
+        }
+        lanes.seeded = true;
+      }
+      return lanes;
+    }
+
+    // Steps every lane once, writing one value per lane
+    static void NextLanes(Lanes& lanes, uint32_t* values) {
+#if defined(__AVX2__)
+      auto rotl = [](__m256i x, int k) {
+        return _mm256_or_si256(_mm256_slli_epi32(x, k),
+                               _mm256_srli_epi32(x, 32 - k));
+      };
+      __m256i* state = (__m256i*)lanes.state;
+      __m256i  s0    = _mm256_load_si256(state + 0);
+      __m256i  s1    = _mm256_load_si256(state + 1);
+      __m256i  s2    = _mm256_load_si256(state + 2);
+      __m256i  s3    = _mm256_load_si256(state + 3);
+
+      __m256i result = _mm256_add_epi32(rotl(_mm256_add_epi32(s0, s3), 7), s0);
+      __m256i t      = _mm256_slli_epi32(s1, 9);
+      s2             = _mm256_xor_si256(s2, s0);
+      s3             = _mm256_xor_si256(s3, s1);
+      s1             = _mm256_xor_si256(s1, s2);
+      s0             = _mm256_xor_si256(s0, s3);
+      s2             = _mm256_xor_si256(s2, t);
+      s3             = rotl(s3, 11);
+
+      _mm256_store_si256(state + 0, s0);
+      _mm256_store_si256(state + 1, s1);
+      _mm256_store_si256(state + 2, s2);
+      _mm256_store_si256(state + 3, s3);
+      _mm256_storeu_si256((__m256i*)values, result);
+#elif defined(SR_RANDOM_SSE2)
+      auto rotl = [](__m128i x, int k) {
+        return _mm_or_si128(_mm_slli_epi32(x, k), _mm_srli_epi32(x, 32 - k));
+      };
+      // Two halves of four lanes each
+      for (uint32_t half = 0; half < s_LaneCount; half += 4) {
+        __m128i s0 = _mm_load_si128((__m128i*)&lanes.state[0][half]);
+        __m128i s1 = _mm_load_si128((__m128i*)&lanes.state[1][half]);
+        __m128i s2 = _mm_load_si128((__m128i*)&lanes.state[2][half]);
+        __m128i s3 = _mm_load_si128((__m128i*)&lanes.state[3][half]);
+
+        __m128i result = _mm_add_epi32(rotl(_mm_add_epi32(s0, s3), 7), s0);
+        __m128i t      = _mm_slli_epi32(s1, 9);
+        s2             = _mm_xor_si128(s2, s0);
+        s3             = _mm_xor_si128(s3, s1);
+        s1             = _mm_xor_si128(s1, s2);
+        s0             = _mm_xor_si128(s0, s3);
+        s2             = _mm_xor_si128(s2, t);
+        s3             = rotl(s3, 11);
+
+        _mm_store_si128((__m128i*)&lanes.state[0][half], s0);
+        _mm_store_si128((__m128i*)&lanes.state[1][half], s1);
+        _mm_store_si128((__m128i*)&lanes.state[2][half], s2);
+        _mm_store_si128((__m128i*)&lanes.state[3][half], s3);
+        _mm_storeu_si128((__m128i*)(values + half), result);
+      }
+#else
+      auto rotl = [](uint32_t x, int k) { return (x << k) | (x >> (32 - k)); };
+      for (uint32_t lane = 0; lane < s_LaneCount; lane++) {
+        uint32_t& s0 = lanes.state[0][lane];
+        uint32_t& s1 = lanes.state[1][lane];
+        uint32_t& s2 = lanes.state[2][lane];
+        uint32_t& s3 = lanes.state[3][lane];
+
+        values[lane] = rotl(s0 + s3, 7) + s0;
+        uint32_t t   = s1 << 9;
+        s2 ^= s0;
+        s3 ^= s1;
+        s1 ^= s2;
+        s0 ^= s3;
+        s2 ^= t;
+        s3 = rotl(s3, 11);
+      }
+#endif
+    }
+
+    // Calls function(value) for `count` values from the lanes. A partial
+    // last block drops its remaining values, so every path gives the same
+    // sequence.
+    template <typename F>
+    static void ForEachLaneValue(PCG32& generator, size_t count, F&& function) {
+      Lanes&   lanes = GetLanes(generator);
+      uint32_t block[s_LaneCount];
+      for (size_t i = 0; i < count; i += s_LaneCount) {
+        NextLanes(lanes, block);
+        size_t end = count - i < s_LaneCount ? count - i : s_LaneCount;
+        for (size_t j = 0; j < end; j++) function(block[j]);
+      }
+    }
+
+    static float ToFloat(uint32_t value) {
+      return (value >> 8) * (1.0f / 16777216.0f);
+    }
+
+    // Archimedes: z is uniform on a sphere, the angle around z as well
+    static glm::vec3 SphereDirection(float u, float v) {
+      float z   = 1.0f - 2.0f * u;
+      float r   = std::sqrt(std::max(0.0f, 1.0f - z * z));
+      float phi = 6.28318530718f * v;
+      return glm::vec3(r * std::cos(phi), r * std::sin(phi), z);
+    }
+
+  }  // namespace Utils
+
+  thread_local PCG32 Random::s_Generator = Utils::CreateThreadGenerator();
+
+  void Random::Init() {
+    std::random_device device;
+    Init(((uint64_t)device() << 32) | device());
+  }
+
+  void Random::Init(uint64_t seed) {
+    Utils::s_BaseSeed = seed;
+    s_Generator.Seed(seed, Utils::s_NextSequence++);
+    Utils::s_Lanes.seeded = false;
+  }
+
+  glm::vec3 Random::InUnitSphere() {
+    // The radius follows the volume, which grows with its cube
+    glm::vec3 direction = OnUnitSphere();
+    return direction * std::cbrt(Float());
+  }
+
+  glm::vec3 Random::OnUnitSphere() {
+    float u = Float();
+    float v = Float();
+    return Utils::SphereDirection(u, v);
+  }
+
+  glm::vec3 Random::OnHemisphere(const glm::vec3& normal) {
+    glm::vec3 direction = OnUnitSphere();
+    return glm::dot(direction, normal) < 0.0f ? -direction : direction;
+  }
+
+  void Random::FillUInt(uint32_t* values, size_t count) {
+    Utils::ForEachLaneValue(s_Generator, count,
+                            [&values](uint32_t value) { *values++ = value; });
+  }
+
+  void Random::FillFloat(float* values, size_t count, float min, float max) {
+    float range = max - min;
+    Utils::ForEachLaneValue(s_Generator, count, [&](uint32_t value) {
+      *values++ = Utils::ToFloat(value) * range + min;
+    });
+  }
+
+  void Random::FillVec3(glm::vec3* values, size_t count, float min,
+                        float max) {
+    static_assert(sizeof(glm::vec3) == 3 * sizeof(float),
+                  "Vectors are filled as a flat array of floats");
+    FillFloat(&values->x, count * 3, min, max);
+  }
+
+  void Random::FillInUnitSphere(glm::vec3* values, size_t count) {
+    FillVec3(values, count);
+    for (size_t i = 0; i < count; i++) {
+      glm::vec3& value = values[i];
+      value = Utils::SphereDirection(value.x, value.y) * std::cbrt(value.z);
+    }
+  }
+
+  void Random::FillOnUnitSphere(glm::vec3* values, size_t count) {
+    // Two floats per direction fill the front of the array. Walking
+    // backwards, each direction only overwrites floats already consumed.
+    float* uv = &values->x;
+    FillFloat(uv, count * 2);
+    for (size_t i = count; i-- > 0;)
+      values[i] = Utils::SphereDirection(uv[2 * i], uv[2 * i + 1]);
+  }
+
+  void Random::FillOnHemisphere(glm::vec3* values, size_t count,
+                                const glm::vec3& normal) {
+    FillOnUnitSphere(values, count);
+    for (size_t i = 0; i < count; i++) {
+      if (glm::dot(values[i], normal) < 0.0f) values[i] = -values[i];
+    }
+  }
 
 }  // namespace Sera
@@ -0,0 +1,173 @@
+#include "Renderer2D.h"
+
+#include "Application.h"
+#include "Buffer.h"
+#include "FrameStats.h"
+#include "Image.h"
+
+#include "Backend/VulkanRenderPipeline.h"
+#include "Backend/VulkanShader.h"
+
+#include "Shaders/renderer2d_frag.h"
+#include "Shaders/renderer2d_vert.h"
+
+#include <algorithm>
+#include <iterator>
+#include <tuple>
+
+namespace Sera {
+
+  Renderer2D::Renderer2D() {
+    const uint32_t white = 0xffffffff;
+    m_WhiteTexture = std::make_unique<Image>(1, 1, ImageFormat::RGBA, &white);
+
+    auto vertexShader = Application::LoadShader(
+        "renderer2d-vert.spv", Shaders::renderer2d_vert,
+        std::size(Shaders::renderer2d_vert), VK_SHADER_STAGE_VERTEX_BIT);
+    auto fragmentShader = Application::LoadShader(
+        "renderer2d-frag.spv", Shaders::renderer2d_frag,
+        std::size(Shaders::renderer2d_frag), VK_SHADER_STAGE_FRAGMENT_BIT);
+
+    for (BlendMode blend : {BlendMode::Alpha, BlendMode::Opaque}) {
+      VulkanRenderPipeline::CreateInfo info{};
+      info.device         = Application::GetVulkanDevice();
+      info.vertexShader   = vertexShader;
+      info.fragmentShader = fragmentShader;
+      // Every input is per instance, there is no vertex buffer
+      info.firstInstanceLocation = 0;
+      info.cullMode              = VK_CULL_MODE_NONE;
+      info.blendEnable           = blend == BlendMode::Alpha;
+      info.depthTest             = false;
+      info.depthWrite            = false;
+      if (Application::IsDynamicRenderingEnabled()) {
+        info.colorFormats  = {Application::GetColorFormat()};
+        info.depthFormat   = Application::GetDepthFormat();
+        info.stencilFormat = Application::GetStencilFormat();
+      } else {
+        info.renderPass = Application::GetRenderPass();
+      }
+      m_Pipelines[(int)blend] = Application::GetPipelineRegistry()->Get(info);
+    }
+  }
+
+  Renderer2D::~Renderer2D() = default;
+
+  void Renderer2D::Begin() {
+    m_Instances.clear();
+    m_Keys.clear();
+  }
+
+  void Renderer2D::DrawQuad(const glm::vec2& position, const glm::vec2& size,
+                            const glm::vec4& color) {
+    Quad quad;
+    quad.position = position;
+    quad.size     = size;
+    quad.color    = color;
+    DrawQuad(quad);
+  }
+
+  void Renderer2D::DrawQuad(const glm::vec2& position, const glm::vec2& size,
+                            const Image& texture, const glm::vec4& tint) {
+    Quad quad;
+    quad.position = position;
+    quad.size     = size;
+    quad.color    = tint;
+    quad.texture  = &texture;
+    DrawQuad(quad);
+  }
+
+  void Renderer2D::DrawQuad(const Quad& quad) {
+    const Image* texture = quad.texture ? quad.texture : m_WhiteTexture.get();
+    m_Keys.push_back({quad.layer, quad.blend, texture->GetDescriptorSet(),
+                      (uint32_t)m_Instances.size()});
+    m_Instances.push_back({quad.position, quad.size, quad.rotation,
+                           glm::vec4(quad.uvMin, quad.uvMax), quad.color});
+  }
+
+  void Renderer2D::End(VkCommandBuffer commandBuffer) {
+    static_assert(sizeof(Instance) == 13 * sizeof(float),
+                  "Instances are packed the way renderer2d.vert reads them");
+
+    m_Stats       = {};
+    m_Stats.quads = (uint32_t)m_Instances.size();
+    if (m_Instances.empty()) return;
+
+    std::sort(m_Keys.begin(), m_Keys.end(),
+              [](const SortKey& a, const SortKey& b) {
+                return std::make_tuple(a.layer, a.blend, (uint64_t)a.texture,
+                                       a.index) <
+                       std::make_tuple(b.layer, b.blend, (uint64_t)b.texture,
+                                       b.index);
+              });
+
+    // Grows in powers of two, the old buffer is freed once its frames are done
+    uint64_t size = m_Instances.size() * sizeof(Instance);
+    if (!m_InstanceBuffer || m_InstanceBuffer->GetSize() < size) {
+      uint64_t capacity = 1024 * sizeof(Instance);
+      while (capacity < size) capacity *= 2;
+      if (m_InstanceBuffer)
+        m_InstanceBuffer->Resize(capacity);
+      else
+        m_InstanceBuffer = std::make_unique<Buffer>(
+            capacity, BufferUsage::Vertex, BufferMemory::Dynamic);
+    }
+    Instance* mapped = (Instance*)m_InstanceBuffer->GetMappedData();
+    for (size_t i = 0; i < m_Keys.size(); i++)
+      mapped[i] = m_Instances[m_Keys[i].index];
+
+    VkExtent2D extent  = Application::GetFramebufferExtent();
+    float      push[4] = {2.0f / extent.width, 2.0f / extent.height, -1.0f,
+                          -1.0f};
+    VkViewport viewport{};
+    viewport.width    = (float)extent.width;
+    viewport.height   = (float)extent.height;
+    viewport.maxDepth = 1.0f;
+    VkRect2D scissor{};
+    scissor.extent = extent;
+
+    VkBuffer     instanceBuffer = m_InstanceBuffer->GetBuffer();
+    VkDeviceSize instanceOffset = m_InstanceBuffer->GetOffset();
+
+    VulkanRenderPipeline* boundPipeline = nullptr;
+    VkDescriptorSet       boundTexture  = VK_NULL_HANDLE;
+    for (size_t first = 0; first < m_Keys.size();) {
+      // Consecutive layers with the same state share a batch
+      const SortKey& key  = m_Keys[first];
+      size_t         last = first + 1;
+      while (last < m_Keys.size() && m_Keys[last].blend == key.blend &&
+             m_Keys[last].texture == key.texture)
+        last++;
+      m_Stats.batches++;
+
+      VulkanRenderPipeline* pipeline = m_Pipelines[(int)key.blend].Get();
+      if (pipeline) {
+        if (pipeline != boundPipeline) {
+          vkCmdBindPipeline(commandBuffer, VK_PIPELINE_BIND_POINT_GRAPHICS,
+                            pipeline->GetHandle());
+          vkCmdSetViewport(commandBuffer, 0, 1, &viewport);
+          vkCmdSetScissor(commandBuffer, 0, 1, &scissor);
+          vkCmdPushConstants(commandBuffer, pipeline->GetLayout(),
+                             pipeline->GetPushConstantRange().stageFlags, 0,
+                             sizeof(push), push);
+          vkCmdBindVertexBuffers(commandBuffer, 1, 1, &instanceBuffer,
+                                 &instanceOffset);
+          boundPipeline = pipeline;
+          boundTexture  = VK_NULL_HANDLE;
+        }
+        if (key.texture != boundTexture) {
+          vkCmdBindDescriptorSets(commandBuffer,
+                                  VK_PIPELINE_BIND_POINT_GRAPHICS,
+                                  pipeline->GetLayout(), 0, 1, &key.texture, 0,
+                                  nullptr);
+          boundTexture = key.texture;
+        }
+        vkCmdDraw(commandBuffer, 6, (uint32_t)(last - first), 0,
+                  (uint32_t)first);
+        m_Stats.drawCalls++;
+        FrameStats::AddDrawCalls();
+      }
+      first = last;
+    }
+  }
+
+}  // namespace Sera
@@ -0,0 +1,286 @@
+#include "SceneViewport.h"
+
+#include "imgui.h"
+
+#include "Application.h"
+#include "Compute.h"
+#include "GpuProfiler.h"
+#include "Image.h"
+#include "MemoryTracker.h"
+
+#include "Backend/VulkanRenderpass.h"
+#include "Backend/VulkanRendering.h"
+
+#include "Shaders/sharpen_comp.h"
+
+#include <algorithm>
+#include <cmath>
+#include <iterator>
+
+namespace Sera {
+
+  // Share of the old average kept per measurement
+  static constexpr float    s_TimeSmoothing  = 0.9f;
+  // Frames after a change whose GPU times may still be measured at the old
+  // scale, they are skipped
+  static constexpr uint32_t s_SettleFrames   = 4;
+  // Frames after a change before the scale may grow again, decreases only
+  // wait for the settle frames
+  static constexpr uint32_t s_CooldownFrames = 30;
+  // No change while the scene takes between these shares of the budget
+  static constexpr float    s_LowerBand      = 0.8f;
+  static constexpr float    s_UpperBand      = 1.0f;
+  // Largest increase per change, decreases are not limited
+  static constexpr float    s_MaxScaleStep   = 0.05f;
+  // Scales are rounded to this step
+  static constexpr float    s_ScaleQuantum   = 1.0f / 64.0f;
+
+  namespace Utils {
+
+    // Grows to fit, but only shrinks below half the size so resizing the
+    // window does not reallocate every frame. True when reallocated.
+    static bool FitImage(std::unique_ptr<Image>& image, VkExtent2D extent) {
+      if (!image) {
+        image = std::make_unique<Image>(extent.width, extent.height,
+                                        ImageFormat::RGBA);
+        return true;
+      }
+      bool fits     = extent.width <= image->GetWidth() &&
+                      extent.height <= image->GetHeight();
+      bool tooLarge = extent.width * 2 < image->GetWidth() ||
+                      extent.height * 2 < image->GetHeight();
+      if (fits && !tooLarge) return false;
+      image->Resize(extent.width, extent.height);
+      return true;
+    }
+
+  }  // namespace Utils
+
+  SceneViewport::SceneViewport(const Settings& settings)
+      : m_Settings(settings), m_RequestedScale(settings.maxScale) {
+    m_SharpenShader = std::make_unique<ComputeShader>(
+        Shaders::sharpen_comp, std::size(Shaders::sharpen_comp),
+        "sharpen.comp");
+
+    if (!Application::IsDynamicRenderingEnabled()) {
+      // Compatible with pipelines of any other pass with the same format,
+      // ends in the layout Image tracks for the target
+      VulkanRenderPass::CreateInfo info{};
+      info.device               = Application::GetVulkanDevice();
+      info.allocator            = MemoryTracker::GetAllocationCallbacks(
+          VK_OBJECT_TYPE_RENDER_PASS);
+      info.surfaceFormat.format = GetColorFormat();
+      info.finalLayout          = VK_IMAGE_LAYOUT_COLOR_ATTACHMENT_OPTIMAL;
+      m_RenderPass.reset(VulkanRenderPass::Create(info));
+    }
+  }
+
+  SceneViewport::~SceneViewport() {
+    Application::SubmitResourceFree([framebuffer = m_Framebuffer,
+                                     renderPass  = m_RenderPass.release()]() {
+      vkDestroyFramebuffer(
+          Application::GetDevice(), framebuffer,
+          MemoryTracker::GetAllocationCallbacks(VK_OBJECT_TYPE_FRAMEBUFFER));
+      delete renderPass;
+    });
+  }
+
+  void SceneViewport::Show() {
+    ImVec2   available = ImGui::GetContentRegionAvail();
+    uint32_t width     = (uint32_t)std::max(available.x, 1.0f);
+    uint32_t height    = (uint32_t)std::max(available.y, 1.0f);
+
+    float scale = m_Settings.dynamicResolution &&
+                          Application::GetGpuProfiler().IsEnabled()
+                      ? m_RequestedScale
+                      : m_Settings.maxScale;
+    scale = std::max(std::min(scale, m_Settings.maxScale), m_Settings.minScale);
+    m_RequestedScale = scale;
+
+    m_Stats.scale         = scale;
+    m_Stats.displayExtent = {width, height};
+    m_Stats.renderExtent  = {std::max((uint32_t)(width * scale + 0.5f), 1u),
+                             std::max((uint32_t)(height * scale + 0.5f), 1u)};
+    m_Sharpen = m_Settings.sharpen && m_SharpenShader->IsValid();
+    AllocateTargets();
+
+    // Only the top left of the images holds this frame
+    ImVec2 uvMin, uvMax;
+    Image* image;
+    if (m_Sharpen) {
+      image = m_Upscaled.get();
+      uvMin = {0.0f, 0.0f};
+      uvMax = {(float)width / image->GetWidth(),
+               (float)height / image->GetHeight()};
+    } else {
+      // Inset by half a texel so bilinear filtering does not pull in the
+      // pixels outside the rendered region
+      image = m_Target.get();
+      uvMin = {0.5f / image->GetWidth(), 0.5f / image->GetHeight()};
+      uvMax = {(m_Stats.renderExtent.width - 0.5f) / image->GetWidth(),
+               (m_Stats.renderExtent.height - 0.5f) / image->GetHeight()};
+    }
+    ImGui::Image(image->GetDescriptorSet(), {(float)width, (float)height},
+                 uvMin, uvMax);
+    m_Shown = true;
+  }
+
+  bool SceneViewport::Begin(VkCommandBuffer commandBuffer) {
+    if (!m_Shown) return false;
+
+    // The profiler has just read back the frame that used this frame's
+    // slot before, with this viewport's pass if it was recorded then
+    GpuProfiler& profiler = Application::GetGpuProfiler();
+    float        gpuTime  = profiler.GetScopeTime(this);
+    if (gpuTime >= 0.0f) UpdateScale(gpuTime);
+    m_Scope = profiler.BeginScope(commandBuffer, "Scene", this);
+
+    m_Target->TransitionLayout(commandBuffer,
+                               VK_IMAGE_LAYOUT_COLOR_ATTACHMENT_OPTIMAL,
+                               VK_PIPELINE_STAGE_COLOR_ATTACHMENT_OUTPUT_BIT,
+                               VK_ACCESS_COLOR_ATTACHMENT_WRITE_BIT);
+
+    VkClearValue clearValue = {};
+    clearValue.color        = m_Settings.clearColor;
+    if (m_RenderPass) {
+      VkRenderPassBeginInfo info = {};
+      info.sType                 = VK_STRUCTURE_TYPE_RENDER_PASS_BEGIN_INFO;
+      info.renderPass            = m_RenderPass->GetHandle();
+      info.framebuffer           = m_Framebuffer;
+      info.renderArea.extent     = m_Stats.renderExtent;
+      info.clearValueCount       = 1;
+      info.pClearValues          = &clearValue;
+      vkCmdBeginRenderPass(commandBuffer, &info, VK_SUBPASS_CONTENTS_INLINE);
+    } else {
+      RenderingAttachment color;
+      color.view       = m_Target->GetImageView();
+      color.clearValue = clearValue;
+      BeginRendering(commandBuffer, m_Stats.renderExtent, &color, 1);
+    }
+
+    VkViewport viewport{};
+    viewport.width    = (float)m_Stats.renderExtent.width;
+    viewport.height   = (float)m_Stats.renderExtent.height;
+    viewport.maxDepth = 1.0f;
+    vkCmdSetViewport(commandBuffer, 0, 1, &viewport);
+    VkRect2D scissor{};
+    scissor.extent = m_Stats.renderExtent;
+    vkCmdSetScissor(commandBuffer, 0, 1, &scissor);
+    return true;
+  }
+
+  void SceneViewport::End(VkCommandBuffer commandBuffer) {
+    m_Shown = false;
+
+    if (m_RenderPass)
+      vkCmdEndRenderPass(commandBuffer);
+    else
+      EndRendering(commandBuffer);
+
+    if (m_Sharpen) {
+      struct {
+          int32_t sourceSize[2];
+          int32_t destinationSize[2];
+          float   sharpness;
+      } push = {
+          {(int32_t)m_Stats.renderExtent.width,
+           (int32_t)m_Stats.renderExtent.height},
+          {(int32_t)m_Stats.displayExtent.width,
+           (int32_t)m_Stats.displayExtent.height},
+          m_Settings.sharpness
+      };
+      uint32_t localX = m_SharpenShader->GetLocalSizeX();
+      uint32_t localY = m_SharpenShader->GetLocalSizeY();
+      ComputeDispatch(commandBuffer, *m_SharpenShader)
+          .Bind(0, *m_Target)
+          .Bind(1, *m_Upscaled)
+          .Push(push)
+          .Dispatch((m_Stats.displayExtent.width + localX - 1) / localX,
+                    (m_Stats.displayExtent.height + localY - 1) / localY);
+    } else {
+      m_Target->TransitionLayout(commandBuffer,
+                                 VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL,
+                                 VK_PIPELINE_STAGE_FRAGMENT_SHADER_BIT,
+                                 VK_ACCESS_SHADER_READ_BIT);
+    }
+
+    Application::GetGpuProfiler().EndScope(commandBuffer, m_Scope);
+  }
+
+  VkRenderPass SceneViewport::GetRenderPass() const {
+    return m_RenderPass ? m_RenderPass->GetHandle() : VK_NULL_HANDLE;
+  }
+
+  VkFormat SceneViewport::GetColorFormat() { return VK_FORMAT_R8G8B8A8_UNORM; }
+
+  void SceneViewport::AllocateTargets() {
+    // Sized for the largest scale, scale changes alone never reallocate
+    VkExtent2D targetExtent = {
+        std::max((uint32_t)(m_Stats.displayExtent.width * m_Settings.maxScale +
+                            0.5f),
+                 m_Stats.renderExtent.width),
+        std::max((uint32_t)(m_Stats.displayExtent.height * m_Settings.maxScale +
+                            0.5f),
+                 m_Stats.renderExtent.height)};
+    bool reallocated = Utils::FitImage(m_Target, targetExtent);
+    if (m_Sharpen) Utils::FitImage(m_Upscaled, m_Stats.displayExtent);
+
+    if (!m_RenderPass || (m_Framebuffer && !reallocated)) return;
+
+    Application::SubmitResourceFree([framebuffer = m_Framebuffer]() {
+      vkDestroyFramebuffer(
+          Application::GetDevice(), framebuffer,
+          MemoryTracker::GetAllocationCallbacks(VK_OBJECT_TYPE_FRAMEBUFFER));
+    });
+    VkImageView             view = m_Target->GetImageView();
+    VkFramebufferCreateInfo info = {};
+    info.sType                   = VK_STRUCTURE_TYPE_FRAMEBUFFER_CREATE_INFO;
+    info.renderPass              = m_RenderPass->GetHandle();
+    info.attachmentCount         = 1;
+    info.pAttachments            = &view;
+    info.width                   = m_Target->GetWidth();
+    info.height                  = m_Target->GetHeight();
+    info.layers                  = 1;
+    VkResult err = vkCreateFramebuffer(
+        Application::GetDevice(), &info,
+        MemoryTracker::GetAllocationCallbacks(VK_OBJECT_TYPE_FRAMEBUFFER),
+        &m_Framebuffer);
+    check_vk_result(err);
+  }
+
+  void SceneViewport::UpdateScale(float gpuTime) {
+    m_Stats.gpuTime = gpuTime;
+    if (m_Cooldown > 0) m_Cooldown--;
+    if (m_Settle > 0) {
+      m_Settle--;
+      return;
+    }
+    m_SmoothedTime =
+        m_SmoothedTime > 0.0f
+            ? m_SmoothedTime * s_TimeSmoothing + gpuTime * (1 - s_TimeSmoothing)
+            : gpuTime;
+    if (!m_Settings.dynamicResolution || m_SmoothedTime <= 0.0f) return;
+
+    float budget = m_Settings.targetTime;
+    if (m_SmoothedTime >= budget * s_LowerBand &&
+        m_SmoothedTime <= budget * s_UpperBand)
+      return;
+
+    // The cost follows the pixel count, the square of the scale. Aiming at
+    // the middle of the band keeps the next measurement inside it.
+    float target = budget * (s_LowerBand + s_UpperBand) * 0.5f;
+    float scale  = m_RequestedScale * std::sqrt(target / m_SmoothedTime);
+    scale        = std::min(scale, m_RequestedScale + s_MaxScaleStep);
+    scale        = std::round(scale / s_ScaleQuantum) * s_ScaleQuantum;
+    scale = std::max(std::min(scale, m_Settings.maxScale), m_Settings.minScale);
+    if (scale == m_RequestedScale) return;
+    if (scale > m_RequestedScale && m_Cooldown > 0) return;
+
+    // The average restarts with the first time measured at the new scale
+    m_RequestedScale = scale;
+    m_SmoothedTime   = 0.0f;
+    m_Settle         = s_SettleFrames;
+    m_Cooldown       = s_CooldownFrames;
+  }
+
+}  // namespace Sera
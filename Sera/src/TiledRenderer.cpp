@@ -0,0 +1,194 @@
+#include "TiledRenderer.h"
+
+#include <algorithm>
+#include <cmath>
+
+#include "Application.h"
+#include "Profiler.h"
+
+namespace Sera {
+
+  namespace Utils {
+
+    // Interleaves the bits of x and y, tiles sorted by it follow a Z curve
+    // and neighbours in the order stay neighbours in the image
+    static uint32_t MortonCode(uint32_t x, uint32_t y) {
+      auto spread = [](uint32_t v) {
+        v &= 0xffff;
+        v = (v | (v << 8)) & 0x00ff00ff;
+        v = (v | (v << 4)) & 0x0f0f0f0f;
+        v = (v | (v << 2)) & 0x33333333;
+        v = (v | (v << 1)) & 0x55555555;
+        return v;
+      };
+      return spread(x) | (spread(y) << 1);
+    }
+
+  }  // namespace Utils
+
+  TiledRenderer::TiledRenderer(uint32_t width, uint32_t height,
+                               TileFunction function, const Settings& settings)
+      : m_Settings(settings),
+        m_Function(std::move(function)),
+        m_JobSystem(Application::GetJobSystem()) {
+    m_Settings.tileSize = std::max(1u, m_Settings.tileSize);
+    m_Image = std::make_unique<Image>(std::max(1u, width),
+                                      std::max(1u, height), m_Settings.format);
+    Resize(width, height);
+  }
+
+  TiledRenderer::~TiledRenderer() { Cancel(); }
+
+  void TiledRenderer::Update() {
+    // Without workers nothing runs the tiles in the background
+    if (m_PassActive && m_JobSystem.GetWorkerCount() == 0)
+      m_JobSystem.Wait(m_Counter);
+
+    // Checked before collecting the tiles, so a finished pass has all of
+    // its tiles uploaded before the next one overwrites them
+    bool passDone = m_PassActive && m_Counter.IsDone();
+
+    m_Uploads.clear();
+    for (uint32_t i = 0; i < (uint32_t)m_Tiles.size(); i++) {
+      if (m_Dirty[i].exchange(false, std::memory_order_acquire))
+        m_Uploads.push_back(m_Tiles[i]);
+    }
+    if (!m_Uploads.empty())
+      m_Image->SetData(m_Pixels.data(), m_Uploads.data(),
+                       (uint32_t)m_Uploads.size());
+
+    if (passDone) {
+      m_PassActive = false;
+      m_PassCount++;
+      StartPass();
+    }
+  }
+
+  void TiledRenderer::Reset() {
+    Cancel();
+    m_PassCount = 0;
+    StartPass();
+  }
+
+  void TiledRenderer::Resize(uint32_t width, uint32_t height) {
+    width  = std::max(1u, width);
+    height = std::max(1u, height);
+
+    Cancel();
+    m_Image->Resize(width, height);
+    m_Pixels.assign((size_t)width * height * m_Image->GetBytesPerPixel(), 0);
+    m_Image->SetData(m_Pixels.data());
+    BuildTiles();
+
+    m_PassCount = 0;
+    StartPass();
+  }
+
+  bool TiledRenderer::IsComplete() const {
+    return !m_PassActive && m_Settings.maxPasses != 0 &&
+           m_PassCount >= m_Settings.maxPasses;
+  }
+
+  void TiledRenderer::BuildTiles() {
+    uint32_t width    = m_Image->GetWidth();
+    uint32_t height   = m_Image->GetHeight();
+    uint32_t tileSize = m_Settings.tileSize;
+    uint32_t tilesX   = (width + tileSize - 1) / tileSize;
+    uint32_t tilesY   = (height + tileSize - 1) / tileSize;
+
+    struct SortedTile {
+        VkRect2D rect;
+        uint32_t key;
+        float    angle;
+    };
+    std::vector<SortedTile> tiles;
+    tiles.reserve(tilesX * tilesY);
+    for (uint32_t ty = 0; ty < tilesY; ty++) {
+      for (uint32_t tx = 0; tx < tilesX; tx++) {
+        SortedTile tile{};
+        tile.rect.offset = {(int32_t)(tx * tileSize),
+                            (int32_t)(ty * tileSize)};
+        tile.rect.extent = {std::min(tileSize, width - tx * tileSize),
+                            std::min(tileSize, height - ty * tileSize)};
+
+        switch (m_Settings.order) {
+          case TileOrder::RowMajor:
+            tile.key = ty * tilesX + tx;
+            break;
+          case TileOrder::Morton:
+            tile.key = Utils::MortonCode(tx, ty);
+            break;
+          case TileOrder::Spiral: {
+            // Rings of tiles around the center, each walked by angle
+            VkOffset2D offset = tile.rect.offset;
+            VkExtent2D extent = tile.rect.extent;
+
+            float dx   = offset.x + (extent.width - (float)width) * 0.5f;
+            float dy   = offset.y + (extent.height - (float)height) * 0.5f;
+            float ring = std::max(std::abs(dx), std::abs(dy));
+            tile.key   = (uint32_t)(ring / tileSize);
+            tile.angle = std::atan2(dy, dx);
+            break;
+          }
+        }
+        tiles.push_back(tile);
+      }
+    }
+    std::sort(tiles.begin(), tiles.end(),
+              [](const SortedTile& a, const SortedTile& b) {
+                return a.key != b.key ? a.key < b.key : a.angle < b.angle;
+              });
+
+    m_Tiles.resize(tiles.size());
+    for (size_t i = 0; i < tiles.size(); i++) m_Tiles[i] = tiles[i].rect;
+    m_Dirty = std::make_unique<std::atomic<bool>[]>(m_Tiles.size());
+    for (size_t i = 0; i < m_Tiles.size(); i++) m_Dirty[i].store(false);
+  }
+
+  void TiledRenderer::StartPass() {
+    if (m_Settings.maxPasses != 0 && m_PassCount >= m_Settings.maxPasses)
+      return;
+
+    // One job per tile keeps every job short, so threads waiting on other
+    // work through JobSystem::Wait() are never stuck behind a whole pass
+    m_NextTile.store(0);
+    m_PassActive        = true;
+    uint32_t generation = m_Generation.load();
+    for (size_t i = 0; i < m_Tiles.size(); i++)
+      m_JobSystem.Run([this, generation]() { RenderNextTile(generation); },
+                      &m_Counter);
+  }
+
+  void TiledRenderer::RenderNextTile(uint32_t generation) {
+    if (m_Generation.load(std::memory_order_relaxed) != generation) return;
+    SR_PROFILE_SCOPE("Tile");
+
+    uint32_t        index = m_NextTile++;
+    const VkRect2D& rect  = m_Tiles[index];
+
+    Tile tile;
+    tile.x          = (uint32_t)rect.offset.x;
+    tile.y          = (uint32_t)rect.offset.y;
+    tile.width      = rect.extent.width;
+    tile.height     = rect.extent.height;
+    tile.pass       = m_PassCount;
+    tile.generation = &m_Generation;
+    tile.expected   = generation;
+    m_Function(tile);
+
+    if (!tile.IsCancelled())
+      m_Dirty[index].store(true, std::memory_order_release);
+  }
+
+  void TiledRenderer::Cancel() {
+    // The queued jobs see the new generation and return right away
+    m_Generation++;
+    m_JobSystem.Wait(m_Counter);
+    m_PassActive = false;
+
+    // Tiles finished before the cancel are left out, the next pass
+    // overwrites them anyway
+    for (size_t i = 0; i < m_Tiles.size(); i++) m_Dirty[i].store(false);
+  }
+
+}  // namespace Sera
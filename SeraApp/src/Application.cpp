@@ -1,23 +1,566 @@
 #include "Sera/Application.h"
+#include "Sera/Backend/VulkanPipelineRegistry.h"
+#include "Sera/Backend/VulkanShader.h"
+#include "Sera/Buffer.h"
+#include "Sera/Compute.h"
+#include "Sera/Draw.h"
 #include "Sera/EntryPoint.h"
+#include "Sera/Image.h"
+#include "Sera/IndirectDrawList.h"
+#include "Sera/JobSystem.h"
+#include "Sera/GpuProfiler.h"
+#include "Sera/MemoryTracker.h"
+#include "Sera/Profiler.h"
+#include "Sera/Random.h"
+#include "Sera/Renderer2D.h"
+#include "Sera/SceneViewport.h"
+#include "Sera/TiledRenderer.h"
+
+#include "Shaders/culled_drawid_vert.h"
+#include "Shaders/culled_vert.h"
+#include "Shaders/gradient_comp.h"
+#include "Shaders/instanced_frag.h"
+#include "Shaders/instanced_vert.h"
+#include "Shaders/scene_frag.h"
+#include "Shaders/scene_vert.h"
+
+#include <cmath>
+#include <cstdlib>
+#include <cstring>
+#include <iterator>
+#include <memory>
+#include <vector>
+
+#include <glm/gtc/matrix_transform.hpp>
+
+// Matches the per-instance inputs of instanced.vert, tightly packed
+struct QuadInstance {
+    float offset[2];
+    float scale;
+    float color[4];
+};
+
+static constexpr uint32_t s_QuadGridSize = 64;
 
 class ExampleLayer : public Sera::Layer {
   public:
+    virtual void OnAttach() override {
+      m_Image =
+          std::make_unique<Sera::Image>(256, 256, Sera::ImageFormat::RGBA);
+      m_Gradient = std::make_unique<Sera::ComputeShader>(
+          Sera::Shaders::gradient_comp, std::size(Sera::Shaders::gradient_comp),
+          "gradient.comp");
+
+      const float    vertices[] = {-1.0f, -1.0f, 1.0f, -1.0f,
+                                   1.0f,  1.0f,  -1.0f, 1.0f};
+      const uint32_t indices[]  = {0, 1, 2, 0, 2, 3};
+      m_QuadVertices            = std::make_unique<Sera::Buffer>(
+          sizeof(vertices), Sera::BufferUsage::Vertex,
+          Sera::BufferMemory::Static, vertices);
+      m_QuadIndices = std::make_unique<Sera::Buffer>(
+          sizeof(indices), Sera::BufferUsage::Index,
+          Sera::BufferMemory::Static, indices);
+      m_Quads.resize(s_QuadGridSize * s_QuadGridSize);
+      m_QuadInstances = std::make_unique<Sera::Buffer>(
+          m_Quads.size() * sizeof(QuadInstance), Sera::BufferUsage::Vertex,
+          Sera::BufferMemory::Dynamic);
+
+      Sera::VulkanRenderPipeline::CreateInfo info{};
+      info.device       = Sera::Application::GetVulkanDevice();
+      info.vertexShader = Sera::Application::LoadShader(
+          "instanced-vert.spv", Sera::Shaders::instanced_vert,
+          std::size(Sera::Shaders::instanced_vert), VK_SHADER_STAGE_VERTEX_BIT);
+      info.fragmentShader = Sera::Application::LoadShader(
+          "instanced-frag.spv", Sera::Shaders::instanced_frag,
+          std::size(Sera::Shaders::instanced_frag),
+          VK_SHADER_STAGE_FRAGMENT_BIT);
+      info.firstInstanceLocation = 1;
+      info.cullMode              = VK_CULL_MODE_NONE;
+      info.blendEnable           = true;
+      info.depthTest             = false;
+      info.depthWrite            = false;
+      if (Sera::Application::IsDynamicRenderingEnabled()) {
+        info.colorFormats  = {Sera::Application::GetColorFormat()};
+        info.depthFormat   = Sera::Application::GetDepthFormat();
+        info.stencilFormat = Sera::Application::GetStencilFormat();
+      } else {
+        info.renderPass = Sera::Application::GetRenderPass();
+      }
+      m_QuadPipeline = Sera::Application::GetPipelineRegistry()->Get(info);
+    }
+
+    virtual void OnDetach() override {
+      m_QuadPipeline = {};
+      m_QuadInstances.reset();
+      m_QuadIndices.reset();
+      m_QuadVertices.reset();
+      m_Gradient.reset();
+      m_Image.reset();
+    }
+
+    virtual void OnUpdate(float ts) override {
+      m_Time += ts;
+
+      // A grid of pulsing quads, all of them drawn with one instanced draw
+      for (uint32_t y = 0; y < s_QuadGridSize; y++) {
+        for (uint32_t x = 0; x < s_QuadGridSize; x++) {
+          float u    = (x + 0.5f) / s_QuadGridSize;
+          float v    = (y + 0.5f) / s_QuadGridSize;
+          float wave = std::sin(m_Time * 2.0f + (u + v) * 10.0f);
+
+          QuadInstance &quad = m_Quads[y * s_QuadGridSize + x];
+          quad.offset[0]     = u * 2.0f - 1.0f;
+          quad.offset[1]     = v * 2.0f - 1.0f;
+          quad.scale         = (0.25f + 0.2f * wave) / s_QuadGridSize;
+          quad.color[0]      = u;
+          quad.color[1]      = v;
+          quad.color[2]      = 0.5f + 0.5f * wave;
+          quad.color[3]      = 0.8f;
+        }
+      }
+    }
+
+    // Fills the image on the GPU, it is sampled by ImGui later in the frame
+    virtual void OnPreRender(VkCommandBuffer commandBuffer) override {
+      Sera::ComputeDispatch(commandBuffer, *m_Gradient)
+          .Bind(0, *m_Image)
+          .Push(m_Time)
+          .Dispatch(*m_Image);
+    }
+
+    // Dynamic buffers are written while recording, the frame's copy is free
+    virtual void OnRender(VkCommandBuffer commandBuffer) override {
+      m_QuadInstances->SetData(m_Quads.data(),
+                               m_Quads.size() * sizeof(QuadInstance));
+
+      VkExtent2D extent    = Sera::Application::GetFramebufferExtent();
+      float      aspect[2] = {(float)extent.height / (float)extent.width,
+                              1.0f};
+      Sera::DrawCall(commandBuffer, m_QuadPipeline.Get())
+          .BindVertexBuffer(0, *m_QuadVertices)
+          .BindVertexBuffer(1, *m_QuadInstances)
+          .BindIndexBuffer(*m_QuadIndices)
+          .Push(aspect)
+          .DrawIndexed(6, (uint32_t)m_Quads.size());
+    }
+
     virtual void OnUIRender() override {
       ImGui::Begin("Hello");
       ImGui::Button("Button");
       ImGui::End();
 
+      ImGui::Begin("Compute");
+      ImGui::Image(m_Image->GetDescriptorSet(),
+                   {(float)m_Image->GetWidth(), (float)m_Image->GetHeight()});
+      ImGui::End();
+
       ImGui::ShowDemoWindow();
     }
+
+  private:
+    std::unique_ptr<Sera::Image>         m_Image;
+    std::unique_ptr<Sera::ComputeShader> m_Gradient;
+    float                                m_Time = 0.0f;
+
+    std::unique_ptr<Sera::Buffer> m_QuadVertices;
+    std::unique_ptr<Sera::Buffer> m_QuadIndices;
+    std::unique_ptr<Sera::Buffer> m_QuadInstances;
+    std::vector<QuadInstance>     m_Quads;
+    Sera::PipelineHandle          m_QuadPipeline;
+};
+
+// Thousands of moving sprites through Renderer2D instead of ImGui draw lists
+class SpriteLayer : public Sera::Layer {
+  public:
+    virtual void OnAttach() override {
+      m_Renderer = std::make_unique<Sera::Renderer2D>();
+      m_Texture  = std::make_unique<Sera::Image>(2, 2, Sera::ImageFormat::RGBA,
+                                                 s_Checker);
+      m_Sprites.resize(20000);
+      for (auto &sprite : m_Sprites) {
+        sprite.position = {Sera::Random::Float() * 1600.0f,
+                           Sera::Random::Float() * 900.0f};
+        sprite.velocity = {Sera::Random::Float() * 200.0f - 100.0f,
+                           Sera::Random::Float() * 200.0f - 100.0f};
+        sprite.color    = glm::vec4(Sera::Random::Vec3(0.2f, 1.0f), 0.6f);
+        sprite.textured = Sera::Random::Float() < 0.5f;
+      }
+    }
+
+    virtual void OnDetach() override {
+      m_Renderer.reset();
+      m_Texture.reset();
+    }
+
+    virtual void OnUpdate(float ts) override {
+      SR_PROFILE_SCOPE("Move Sprites");
+      VkExtent2D extent = Sera::Application::GetFramebufferExtent();
+      auto      &jobs   = Sera::Application::GetJobSystem();
+      jobs.ParallelFor((uint32_t)m_Sprites.size(), [&](uint32_t i) {
+        Sprite &sprite = m_Sprites[i];
+        sprite.position += sprite.velocity * ts;
+        if (sprite.position.x < 0.0f || sprite.position.x > extent.width)
+          sprite.velocity.x = -sprite.velocity.x;
+        if (sprite.position.y < 0.0f || sprite.position.y > extent.height)
+          sprite.velocity.y = -sprite.velocity.y;
+      });
+    }
+
+    virtual void OnRender(VkCommandBuffer commandBuffer) override {
+      m_Renderer->Begin();
+      for (auto &sprite : m_Sprites) {
+        if (sprite.textured)
+          m_Renderer->DrawQuad(sprite.position, glm::vec2(8.0f), *m_Texture,
+                               sprite.color);
+        else
+          m_Renderer->DrawQuad(sprite.position, glm::vec2(6.0f),
+                               sprite.color);
+      }
+      m_Renderer->End(commandBuffer);
+    }
+
+    virtual void OnUIRender() override {
+      const auto &stats = m_Renderer->GetStats();
+      ImGui::Begin("Renderer2D");
+      ImGui::Text("Quads: %u", stats.quads);
+      ImGui::Text("Batches: %u", stats.batches);
+      ImGui::Text("Draw calls: %u", stats.drawCalls);
+      ImGui::End();
+    }
+
+  private:
+    struct Sprite {
+        glm::vec2 position;
+        glm::vec2 velocity;
+        glm::vec4 color;
+        bool      textured;
+    };
+
+    static constexpr uint32_t s_Checker[4] = {0xffffffff, 0xff808080,
+                                              0xff808080, 0xffffffff};
+
+    std::unique_ptr<Sera::Renderer2D> m_Renderer;
+    std::unique_ptr<Sera::Image>      m_Texture;
+    std::vector<Sprite>               m_Sprites;
+};
+
+// A large world of quads culled on the GPU, only the ones in view are drawn
+// by a single indirect draw
+class CullingLayer : public Sera::Layer {
+  public:
+    virtual void OnAttach() override {
+      m_DrawList = std::make_unique<Sera::IndirectDrawList>();
+
+      const float    vertices[] = {-1.0f, -1.0f, 1.0f, -1.0f,
+                                   1.0f,  1.0f,  -1.0f, 1.0f};
+      const uint32_t indices[]  = {0, 1, 2, 0, 2, 3};
+      m_Vertices                = std::make_unique<Sera::Buffer>(
+          sizeof(vertices), Sera::BufferUsage::Vertex,
+          Sera::BufferMemory::Static, vertices);
+      m_Indices = std::make_unique<Sera::Buffer>(
+          sizeof(indices), Sera::BufferUsage::Index,
+          Sera::BufferMemory::Static, indices);
+
+      std::vector<glm::vec4>                      quads(s_QuadCount);
+      std::vector<Sera::IndirectDrawList::Object> objects(s_QuadCount);
+      for (uint32_t i = 0; i < s_QuadCount; i++) {
+        glm::vec2 center = {Sera::Random::Float() * s_WorldSize,
+                            Sera::Random::Float() * s_WorldSize};
+        float     size   = 0.5f + Sera::Random::Float() * 2.0f;
+        float     hue    = Sera::Random::Float();
+        quads[i]         = glm::vec4(center, glm::vec2(size, hue));
+
+        auto &object         = objects[i];
+        object.center        = glm::vec3(center.x, center.y, 0.0f);
+        object.radius        = size * 1.5f;  // Covers the corners
+        object.indexCount    = 6;
+        object.firstIndex    = 0;
+        object.vertexOffset  = 0;
+        object.instanceIndex = i;
+      }
+      m_Quads = std::make_unique<Sera::Buffer>(
+          quads.size() * sizeof(glm::vec4), Sera::BufferUsage::Storage,
+          Sera::BufferMemory::Static, quads.data());
+      m_DrawList->SetObjects(objects);
+
+      Sera::VulkanRenderPipeline::CreateInfo info{};
+      info.device = Sera::Application::GetVulkanDevice();
+      if (m_DrawList->UsesFirstInstance())
+        info.vertexShader = Sera::Application::LoadShader(
+            "culled-vert.spv", Sera::Shaders::culled_vert,
+            std::size(Sera::Shaders::culled_vert), VK_SHADER_STAGE_VERTEX_BIT);
+      else
+        info.vertexShader = Sera::Application::LoadShader(
+            "culled_drawid-vert.spv", Sera::Shaders::culled_drawid_vert,
+            std::size(Sera::Shaders::culled_drawid_vert),
+            VK_SHADER_STAGE_VERTEX_BIT);
+      info.fragmentShader = Sera::Application::LoadShader(
+          "instanced-frag.spv", Sera::Shaders::instanced_frag,
+          std::size(Sera::Shaders::instanced_frag),
+          VK_SHADER_STAGE_FRAGMENT_BIT);
+      info.cullMode   = VK_CULL_MODE_NONE;
+      info.depthTest  = false;
+      info.depthWrite = false;
+      if (Sera::Application::IsDynamicRenderingEnabled()) {
+        info.colorFormats  = {Sera::Application::GetColorFormat()};
+        info.depthFormat   = Sera::Application::GetDepthFormat();
+        info.stencilFormat = Sera::Application::GetStencilFormat();
+      } else {
+        info.renderPass = Sera::Application::GetRenderPass();
+      }
+      m_Pipeline = Sera::Application::GetPipelineRegistry()->Get(info);
+    }
+
+    virtual void OnDetach() override {
+      m_Pipeline = {};
+      m_Quads.reset();
+      m_Indices.reset();
+      m_Vertices.reset();
+      m_DrawList.reset();
+    }
+
+    // The camera circles around the middle of the world
+    virtual void OnUpdate(float ts) override {
+      m_Time += ts;
+
+      VkExtent2D extent = Sera::Application::GetFramebufferExtent();
+      float      aspect = (float)extent.width / (float)extent.height;
+      glm::vec2  center = glm::vec2(s_WorldSize * 0.5f) +
+                         glm::vec2(std::cos(m_Time * 0.1f),
+                                   std::sin(m_Time * 0.1f)) *
+                             (s_WorldSize * 0.3f);
+      float halfHeight = m_Zoom * 0.5f;
+      float halfWidth  = halfHeight * aspect;
+      m_ViewProjection =
+          glm::ortho(center.x - halfWidth, center.x + halfWidth,
+                     center.y - halfHeight, center.y + halfHeight);
+    }
+
+    virtual void OnPreRender(VkCommandBuffer commandBuffer) override {
+      m_DrawList->Cull(commandBuffer, m_ViewProjection);
+    }
+
+    virtual void OnRender(VkCommandBuffer commandBuffer) override {
+      Sera::DrawCall drawCall(commandBuffer, m_Pipeline.Get());
+      drawCall.BindVertexBuffer(0, *m_Vertices)
+          .BindIndexBuffer(*m_Indices)
+          .Bind(0, *m_Quads)
+          .Push(m_ViewProjection);
+      if (!m_DrawList->UsesFirstInstance())
+        drawCall.Bind(1, *m_DrawList->GetDrawObjectBuffer());
+      m_DrawList->Draw(drawCall);
+    }
+
+    virtual void OnUIRender() override {
+      const auto &stats = m_DrawList->GetStats();
+      ImGui::Begin("GPU Culling");
+      ImGui::Text("Submitted: %u", stats.submitted);
+      ImGui::Text("Visible: %u", stats.visible);
+      ImGui::SliderFloat("View height", &m_Zoom, 10.0f, s_WorldSize);
+      ImGui::End();
+    }
+
+  private:
+    static constexpr uint32_t s_QuadCount = 100000;
+    static constexpr float    s_WorldSize = 2000.0f;
+
+    std::unique_ptr<Sera::IndirectDrawList> m_DrawList;
+    std::unique_ptr<Sera::Buffer>           m_Vertices;
+    std::unique_ptr<Sera::Buffer>           m_Indices;
+    std::unique_ptr<Sera::Buffer>           m_Quads;
+    Sera::PipelineHandle                    m_Pipeline;
+    glm::mat4                               m_ViewProjection = glm::mat4(1.0f);
+    float                                   m_Time           = 0.0f;
+    float                                   m_Zoom           = 200.0f;
+};
+
+// A fragment heavy scene in its own window, rendered at whatever resolution
+// keeps it within the GPU budget
+class SceneLayer : public Sera::Layer {
+  public:
+    virtual void OnAttach() override {
+      m_Viewport = std::make_unique<Sera::SceneViewport>();
+
+      Sera::VulkanRenderPipeline::CreateInfo info{};
+      info.device       = Sera::Application::GetVulkanDevice();
+      info.vertexShader = Sera::Application::LoadShader(
+          "scene-vert.spv", Sera::Shaders::scene_vert,
+          std::size(Sera::Shaders::scene_vert), VK_SHADER_STAGE_VERTEX_BIT);
+      info.fragmentShader = Sera::Application::LoadShader(
+          "scene-frag.spv", Sera::Shaders::scene_frag,
+          std::size(Sera::Shaders::scene_frag), VK_SHADER_STAGE_FRAGMENT_BIT);
+      info.cullMode   = VK_CULL_MODE_NONE;
+      info.depthTest  = false;
+      info.depthWrite = false;
+      if (Sera::Application::IsDynamicRenderingEnabled())
+        info.colorFormats = {Sera::SceneViewport::GetColorFormat()};
+      else
+        info.renderPass = m_Viewport->GetRenderPass();
+      m_Pipeline = Sera::Application::GetPipelineRegistry()->Get(info);
+    }
+
+    virtual void OnDetach() override {
+      m_Pipeline = {};
+      m_Viewport.reset();
+    }
+
+    virtual void OnUpdate(float ts) override { m_Time += ts; }
+
+    virtual void OnPreRender(VkCommandBuffer commandBuffer) override {
+      if (!m_Viewport->Begin(commandBuffer)) return;
+
+      VkExtent2D extent = m_Viewport->GetRenderExtent();
+      struct {
+          float   aspect[2];
+          float   time;
+          int32_t iterations;
+      } push = {
+          {(float)extent.width / extent.height, 1.0f},
+          m_Time, m_Iterations
+      };
+      Sera::DrawCall(commandBuffer, m_Pipeline.Get())
+          .SetViewport(0.0f, 0.0f, (float)extent.width, (float)extent.height)
+          .Push(push)
+          .Draw(3);
+      m_Viewport->End(commandBuffer);
+    }
+
+    virtual void OnUIRender() override {
+      ImGui::PushStyleVar(ImGuiStyleVar_WindowPadding, ImVec2(0.0f, 0.0f));
+      ImGui::Begin("Scene");
+      m_Viewport->Show();
+      ImGui::End();
+      ImGui::PopStyleVar();
+
+      auto       &settings = m_Viewport->GetSettings();
+      const auto &stats    = m_Viewport->GetStats();
+      ImGui::Begin("Dynamic Resolution");
+      ImGui::Text("Scale: %.2f", stats.scale);
+      ImGui::Text("GPU time: %.2f ms", stats.gpuTime);
+      ImGui::Text("Render: %ux%u", stats.renderExtent.width,
+                  stats.renderExtent.height);
+      ImGui::Text("Display: %ux%u", stats.displayExtent.width,
+                  stats.displayExtent.height);
+      ImGui::Checkbox("Dynamic resolution", &settings.dynamicResolution);
+      ImGui::SliderFloat("Budget (ms)", &settings.targetTime, 1.0f, 33.0f);
+      ImGui::SliderFloat("Max scale", &settings.maxScale, 0.25f, 2.0f);
+      ImGui::Checkbox("Sharpen", &settings.sharpen);
+      ImGui::SliderFloat("Sharpness", &settings.sharpness, 0.0f, 2.0f);
+      ImGui::SliderInt("Iterations", &m_Iterations, 1, 64);
+      ImGui::End();
+    }
+
+  private:
+    std::unique_ptr<Sera::SceneViewport> m_Viewport;
+    Sera::PipelineHandle                 m_Pipeline;
+    float                                m_Time       = 0.0f;
+    int32_t                              m_Iterations = 16;
+};
+
+// Progressive Mandelbrot set shaded on the CPU, one jittered sample per
+// pixel and pass averaged over the passes
+class TileLayer : public Sera::Layer {
+  public:
+    virtual void OnAttach() override {
+      m_Accumulation.resize(s_TileImageWidth * s_TileImageHeight);
+      m_Renderer = std::make_unique<Sera::TiledRenderer>(
+          s_TileImageWidth, s_TileImageHeight,
+          [this](const Sera::TiledRenderer::Tile &tile) { Shade(tile); });
+    }
+
+    virtual void OnDetach() override { m_Renderer.reset(); }
+
+    virtual void OnUpdate(float ts) override { m_Renderer->Update(); }
+
+    virtual void OnUIRender() override {
+      ImGui::Begin("CPU Tiles");
+      ImGui::Text("Passes: %u", m_Renderer->GetPassCount());
+      bool changed = ImGui::SliderFloat("Zoom", &m_Zoom, 0.5f, 64.0f);
+      changed |= ImGui::SliderInt("Iterations", &m_Iterations, 16, 1024);
+      if (changed) m_Renderer->Reset();
+      Sera::Image &image = m_Renderer->GetImage();
+      ImGui::Image(image.GetDescriptorSet(),
+                   {(float)image.GetWidth(), (float)image.GetHeight()});
+      ImGui::End();
+    }
+
+  private:
+    // Runs on the job system's threads, it only reads the zoom and
+    // iterations, which change after Reset() has cancelled all tiles
+    void Shade(const Sera::TiledRenderer::Tile &tile) {
+      uint32_t *pixels = (uint32_t *)m_Renderer->GetPixels();
+      float     scale  = 3.0f / (m_Zoom * s_TileImageHeight);
+      for (uint32_t y = tile.y; y < tile.y + tile.height; y++) {
+        if (tile.IsCancelled()) return;
+        for (uint32_t x = tile.x; x < tile.x + tile.width; x++) {
+          // The same jitter for a pixel and pass on whichever thread
+          Sera::PCG32 rng(Sera::Random::Hash(x, y, tile.pass));
+          float       jx = rng.NextFloat();
+          float       jy = rng.NextFloat();
+
+          float cx = (x + jx - s_TileImageWidth * 0.5f) * scale - 0.75f;
+          float cy = (y + jy - s_TileImageHeight * 0.5f) * scale;
+          float zx = 0.0f, zy = 0.0f;
+          int   i  = 0;
+          for (; i < m_Iterations && zx * zx + zy * zy < 4.0f; i++) {
+            float t = zx * zx - zy * zy + cx;
+            zy      = 2.0f * zx * zy + cy;
+            zx      = t;
+          }
+          float     v = i == m_Iterations ? 0.0f : (float)i / m_Iterations;
+          glm::vec4 color(std::sqrt(v), v, 0.5f + 0.5f * v, 1.0f);
+
+          glm::vec4 &sum = m_Accumulation[y * s_TileImageWidth + x];
+          sum            = tile.pass == 0 ? color : sum + color;
+          glm::vec4 c    = glm::clamp(sum / (float)(tile.pass + 1), 0.0f, 1.0f);
+          pixels[y * s_TileImageWidth + x] =
+              (uint32_t)(c.r * 255.0f) | ((uint32_t)(c.g * 255.0f) << 8) |
+              ((uint32_t)(c.b * 255.0f) << 16) | 0xff000000;
+        }
+      }
+    }
+
+  private:
+    static constexpr uint32_t s_TileImageWidth  = 512;
+    static constexpr uint32_t s_TileImageHeight = 384;
+
+    std::unique_ptr<Sera::TiledRenderer> m_Renderer;
+    std::vector<glm::vec4>               m_Accumulation;
+    float                                m_Zoom       = 1.0f;
+    int32_t                              m_Iterations = 128;
+};
+
+// Zones of the last frames, recorded by the SR_PROFILE_* macros, and the
+// GPU time of the passes
+class ProfilerLayer : public Sera::Layer {
+  public:
+    virtual void OnUIRender() override {
+      Sera::Profiler::ShowPanel();
+      Sera::Application::GetGpuProfiler().ShowPanel();
+      Sera::MemoryTracker::ShowPanel();
+    }
 };
 
 Sera::Application *Sera::CreateApplication(int argc, char **argv) {
   Sera::ApplicationSpecification spec;
   spec.Name = "Sera Example";
+  for (int i = 1; i < argc; i++) {
+    if (strcmp(argv[i], "--headless") == 0) spec.Headless = true;
+    if (strcmp(argv[i], "--frames") == 0 && i + 1 < argc)
+      spec.FrameCount = (uint32_t)atoi(argv[++i]);
+    if (strcmp(argv[i], "--track-memory") == 0) spec.TrackMemory = true;
+    if (strcmp(argv[i], "--steady-state") == 0 && i + 1 < argc)
+      spec.SteadyStateFrame = (uint64_t)atoll(argv[++i]);
+  }
+  if (spec.Headless) spec.FixedTimestep = 1.0f / 60.0f;
 
   Sera::Application *app = new Sera::Application(spec);
   app->PushLayer<ExampleLayer>();
+  app->PushLayer<SpriteLayer>();
+  app->PushLayer<CullingLayer>();
+  app->PushLayer<SceneLayer>();
+  app->PushLayer<TileLayer>();
+  app->PushLayer<ProfilerLayer>();
   app->SetMenubarCallback([&]() {
     if (ImGui::BeginMenu("File")) {
       if (ImGui::MenuItem("Exit")) {
@@ -29,6 +572,13 @@ Sera::Application *Sera::CreateApplication(int argc, char **argv) {
       }
       ImGui::EndMenu();
     }
+    if (ImGui::BeginMenu("View")) {
+      Sera::Application &application = Sera::Application::Get();
+      if (ImGui::MenuItem("Frame Stats", nullptr,
+                          application.IsFrameStatsVisible()))
+        application.SetFrameStatsVisible(!application.IsFrameStatsVisible());
+      ImGui::EndMenu();
+    }
   });
   return app;
 }
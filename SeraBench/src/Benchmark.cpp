@@ -0,0 +1,197 @@
+#include "Benchmark.h"
+
+#include <algorithm>
+#include <cmath>
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+
+#include "Sera/Log.h"
+
+namespace Bench {
+
+  namespace Utils {
+
+    // Value of `"key": ` in a line WriteJson() wrote
+    static const char* FindValue(const std::string& line, const char* key) {
+      std::string pattern = std::string("\"") + key + "\": ";
+      size_t      offset  = line.find(pattern);
+      if (offset == std::string::npos) return nullptr;
+      return line.c_str() + offset + pattern.size();
+    }
+
+    static bool ReadNumber(const std::string& line, const char* key,
+                           double& value) {
+      const char* text = FindValue(line, key);
+      if (!text) return false;
+      char* end;
+      value = strtod(text, &end);
+      return end != text;
+    }
+
+    // `text` as the contents of a JSON string
+    static std::string Escape(const std::string& text) {
+      std::string escaped;
+      escaped.reserve(text.size());
+      for (char c : text) {
+        if (c == '"' || c == '\\') escaped += '\\';
+        escaped += c;
+      }
+      return escaped;
+    }
+
+    // JSON string starting at the quote `text` points to, as Escape() wrote
+    // it
+    static bool ReadString(const char* text, std::string& value) {
+      if (!text || *text != '"') return false;
+      value.clear();
+      for (const char* c = text + 1; *c; c++) {
+        if (*c == '"') return true;
+        if (*c == '\\' && c[1]) c++;
+        value += *c;
+      }
+      return false;
+    }
+
+  }  // namespace Utils
+
+  Summary Summarize(const std::vector<double>& samples) {
+    Summary summary;
+    summary.count = (uint32_t)samples.size();
+    if (samples.empty()) return summary;
+
+    std::vector<double> sorted = samples;
+    std::sort(sorted.begin(), sorted.end());
+    size_t middle  = sorted.size() / 2;
+    summary.median = sorted.size() % 2
+                         ? sorted[middle]
+                         : (sorted[middle - 1] + sorted[middle]) * 0.5;
+    summary.min    = sorted.front();
+    summary.max    = sorted.back();
+
+    double total = 0.0;
+    for (double sample : samples) total += sample;
+    summary.mean = total / samples.size();
+
+    if (samples.size() > 1) {
+      double squares = 0.0;
+      for (double sample : samples)
+        squares += (sample - summary.mean) * (sample - summary.mean);
+      summary.stddev = std::sqrt(squares / (samples.size() - 1));
+    }
+    return summary;
+  }
+
+  bool WriteJson(const std::string& path, const std::string& device,
+                 const std::vector<Result>& results) {
+    std::ofstream stream(path);
+    if (!stream) {
+      SR_ERROR("Could not write benchmark results to {}", path);
+      return false;
+    }
+    stream.precision(9);
+
+    stream << "{\n  \"device\": \"" << Utils::Escape(device)
+           << "\",\n  \"benchmarks\": [\n";
+    for (size_t i = 0; i < results.size(); i++) {
+      const Result& result  = results[i];
+      Summary       summary = Summarize(result.samples);
+      stream << "    {\"name\": \"" << Utils::Escape(result.name)
+             << "\", \"unit\": \"" << Utils::Escape(result.unit)
+             << "\", \"higher_is_better\": "
+             << (result.higherIsBetter ? "true" : "false")
+             << ", \"repetitions\": " << summary.count
+             << ", \"median\": " << summary.median
+             << ", \"mean\": " << summary.mean
+             << ", \"stddev\": " << summary.stddev
+             << ", \"min\": " << summary.min << ", \"max\": " << summary.max
+             << ", \"samples\": [";
+      for (size_t j = 0; j < result.samples.size(); j++)
+        stream << (j ? ", " : "") << result.samples[j];
+      stream << "]}" << (i + 1 < results.size() ? "," : "") << '\n';
+    }
+    stream << "  ]\n}\n";
+
+    SR_INFO("Wrote {} benchmarks to {}", results.size(), path);
+    return true;
+  }
+
+  bool ReadBaseline(const std::string& path,
+                    std::vector<BaselineEntry>& baseline) {
+    std::ifstream stream(path);
+    if (!stream) {
+      SR_ERROR("Could not read baseline {}", path);
+      return false;
+    }
+
+    std::string line;
+    while (std::getline(stream, line)) {
+      BaselineEntry entry;
+      if (!Utils::ReadString(Utils::FindValue(line, "name"), entry.name))
+        continue;
+
+      const char* higher = Utils::FindValue(line, "higher_is_better");
+      entry.higherIsBetter = !higher || strncmp(higher, "false", 5) != 0;
+
+      double count = 0.0;
+      if (!Utils::ReadNumber(line, "repetitions", count) ||
+          !Utils::ReadNumber(line, "median", entry.summary.median) ||
+          !Utils::ReadNumber(line, "mean", entry.summary.mean) ||
+          !Utils::ReadNumber(line, "stddev", entry.summary.stddev))
+        continue;
+      entry.summary.count = (uint32_t)count;
+      Utils::ReadNumber(line, "min", entry.summary.min);
+      Utils::ReadNumber(line, "max", entry.summary.max);
+      baseline.push_back(entry);
+    }
+
+    if (baseline.empty()) {
+      SR_ERROR("{} has no benchmarks", path);
+      return false;
+    }
+    return true;
+  }
+
+  uint32_t Compare(const std::vector<Result>&        results,
+                   const std::vector<BaselineEntry>& baseline,
+                   double                            threshold) {
+    uint32_t regressions = 0;
+    SR_INFO("{:<40} {:>14} {:>14} {:>8}", "Benchmark", "Baseline", "Current",
+            "Change");
+    for (const Result& result : results) {
+      auto entry = std::find_if(
+          baseline.begin(), baseline.end(),
+          [&](const BaselineEntry& e) { return e.name == result.name; });
+      if (entry == baseline.end()) {
+        SR_INFO("{:<40} {:>14} not in the baseline", result.name, "");
+        continue;
+      }
+
+      const Summary& before = entry->summary;
+      Summary        after  = Summarize(result.samples);
+      if (before.median == 0.0) continue;
+      double difference = after.median - before.median;
+      double change     = difference / before.median;
+
+      // Standard error of the difference, the medians stand in for the
+      // means as they are less sensitive to a stray slow repetition
+      double noise = 0.0;
+      if (before.count > 0 && after.count > 0)
+        noise = std::sqrt(before.stddev * before.stddev / before.count +
+                          after.stddev * after.stddev / after.count);
+      bool significant = std::abs(change) > threshold &&
+                         std::abs(difference) > 2.0 * noise;
+      bool worse       = result.higherIsBetter ? difference < 0.0
+                                               : difference > 0.0;
+
+      const char* verdict = "";
+      if (significant) verdict = worse ? "REGRESSION" : "improved";
+      if (significant && worse) regressions++;
+      SR_INFO("{:<40} {:>14.3f} {:>14.3f} {:>+7.1f}% {} {}", result.name,
+              before.median, after.median, change * 100.0, result.unit,
+              verdict);
+    }
+    return regressions;
+  }
+
+}  // namespace Bench
@@ -0,0 +1,49 @@
+#pragma once
+
+#include <cstdint>
+#include <string>
+#include <vector>
+
+namespace Bench {
+
+  // Samples of one benchmark, one per measured repetition
+  struct Result {
+      std::string         name;
+      std::string         unit;
+      bool                higherIsBetter = true;
+      std::vector<double> samples;
+  };
+
+  struct Summary {
+      uint32_t count  = 0;
+      double   median = 0.0;
+      double   mean   = 0.0;
+      double   stddev = 0.0;
+      double   min    = 0.0;
+      double   max    = 0.0;
+  };
+
+  Summary Summarize(const std::vector<double>& samples);
+
+  // Writes every benchmark on its own line, ReadBaseline() reads them back
+  bool WriteJson(const std::string& path, const std::string& device,
+                 const std::vector<Result>& results);
+
+  struct BaselineEntry {
+      std::string name;
+      bool        higherIsBetter = true;
+      Summary     summary;
+  };
+
+  // Only reads files WriteJson() wrote
+  bool ReadBaseline(const std::string& path,
+                    std::vector<BaselineEntry>& baseline);
+
+  // Logs the change of every median against the baseline. A change counts
+  // when it is larger than `threshold` (0.05 is 5%) and than the noise of
+  // both runs, about two standard errors. Returns the regressions.
+  uint32_t Compare(const std::vector<Result>&        results,
+                   const std::vector<BaselineEntry>& baseline,
+                   double                            threshold);
+
+}  // namespace Bench
@@ -0,0 +1,332 @@
+#include "Sera/Application.h"
+#include "Sera/Backend/VulkanDevice.h"
+#include "Sera/Backend/VulkanPhysicalDevice.h"
+#include "Sera/Image.h"
+#include "Sera/Log.h"
+#include "Sera/Random.h"
+#include "Sera/Timer.h"
+
+#include "Benchmark.h"
+
+#include <algorithm>
+#include <cstdlib>
+#include <cstring>
+#include <functional>
+#include <memory>
+#include <string>
+#include <vector>
+
+// Application::Shutdown() clears it, EntryPoint.h defines it for apps that
+// restart. SeraBench has its own main() to return an exit code.
+bool g_ApplicationRunning = true;
+
+// Bytes one SetData() repetition uploads, small images upload several
+// times up to s_MaxUploads
+static constexpr uint64_t s_UploadBytes     = 32ull * 1024 * 1024;
+static constexpr uint32_t s_MaxUploads      = 64;
+static constexpr uint32_t s_CommandBuffers  = 64;
+static constexpr uint32_t s_Images          = 32;
+static constexpr uint32_t s_RandomValues    = 1 << 20;
+static constexpr uint32_t s_FramesPerSample = 30;
+
+struct Settings {
+    uint32_t    repetitions = 10;
+    // Repetitions run first and thrown away, they warm up caches, the
+    // driver and the frames in flight
+    uint32_t    warmup      = 2;
+    std::string filter;
+};
+
+// A benchmark runs one repetition per frame, so the frame loop recycles the
+// command buffers and frees the resources a repetition leaves behind
+struct Benchmark {
+    std::string             name;
+    std::string             unit;
+    bool                    higherIsBetter = true;
+    // Optional, before the first and after the last repetition
+    std::function<void()>   setup;
+    std::function<void()>   teardown;
+    // One repetition, returns the measured value. Negative while the
+    // repetition needs more frames.
+    std::function<double()> run;
+};
+
+static void AddSetDataBenchmarks(std::vector<Benchmark> &benchmarks) {
+  struct Upload {
+      std::unique_ptr<Sera::Image> image;
+      std::vector<uint8_t>         data;
+      uint32_t                     count = 0;
+  };
+
+  for (Sera::ImageFormat format :
+       {Sera::ImageFormat::RGBA, Sera::ImageFormat::RGBA32F}) {
+    for (uint32_t size : {256u, 1024u, 2048u}) {
+      bool     floats = format == Sera::ImageFormat::RGBA32F;
+      uint64_t bytes  = (uint64_t)size * size * (floats ? 16 : 4);
+      auto     upload = std::make_shared<Upload>();
+
+      Benchmark benchmark;
+      benchmark.name = std::string("Image::SetData/") +
+                       (floats ? "RGBA32F/" : "RGBA/") +
+                       std::to_string(size) + "x" + std::to_string(size);
+      benchmark.unit  = "MiB/s";
+      benchmark.setup = [=]() {
+        upload->image = std::make_unique<Sera::Image>(size, size, format);
+        upload->data.resize(bytes);
+        if (floats)
+          Sera::Random::FillFloat((float *)upload->data.data(), bytes / 4);
+        else
+          Sera::Random::FillUInt((uint32_t *)upload->data.data(), bytes / 4);
+        upload->count = (uint32_t)std::clamp<uint64_t>(s_UploadBytes / bytes,
+                                                       1, s_MaxUploads);
+      };
+      benchmark.teardown = [=]() {
+        upload->image.reset();
+        upload->data = std::vector<uint8_t>();
+      };
+      benchmark.run = [=]() {
+        Sera::Timer timer;
+        for (uint32_t i = 0; i < upload->count; i++)
+          upload->image->SetData(upload->data.data());
+        return bytes * upload->count / (1024.0 * 1024.0) / timer.Elapsed();
+      };
+      benchmarks.push_back(benchmark);
+    }
+  }
+}
+
+static void AddCommandBufferBenchmark(std::vector<Benchmark> &benchmarks) {
+  Benchmark benchmark;
+  benchmark.name           = "Application::FlushCommandBuffer/Empty";
+  benchmark.unit           = "us";
+  benchmark.higherIsBetter = false;
+  // Allocating, beginning, submitting and waiting for an empty command
+  // buffer, the fixed cost of every upload
+  benchmark.run = []() {
+    Sera::Timer timer;
+    for (uint32_t i = 0; i < s_CommandBuffers; i++) {
+      VkCommandBuffer commandBuffer =
+          Sera::Application::GetCommandBuffer(true);
+      Sera::Application::FlushCommandBuffer(commandBuffer);
+    }
+    return timer.ElapsedMillis() * 1000.0 / s_CommandBuffers;
+  };
+  benchmarks.push_back(benchmark);
+}
+
+static void AddImageBenchmark(std::vector<Benchmark> &benchmarks) {
+  Benchmark benchmark;
+  benchmark.name = "Image/CreateDestroy/256x256";
+  benchmark.unit = "images/s";
+  // Destroying an image only queues its release, the Vulkan objects are
+  // destroyed once the frame comes around again, outside the measurement
+  benchmark.run = []() {
+    Sera::Timer timer;
+    for (uint32_t i = 0; i < s_Images; i++)
+      Sera::Image image(256, 256, Sera::ImageFormat::RGBA);
+    return s_Images / timer.Elapsed();
+  };
+  benchmarks.push_back(benchmark);
+}
+
+static void AddRandomBenchmarks(std::vector<Benchmark> &benchmarks) {
+  Benchmark uints;
+  uints.name = "Random::UInt";
+  uints.unit = "M/s";
+  uints.run  = []() {
+    Sera::Timer timer;
+    uint32_t    hash = 0;
+    for (uint32_t i = 0; i < s_RandomValues; i++) hash ^= Sera::Random::UInt();
+    double time = timer.Elapsed();
+
+    // Keeps the loop from being optimized away
+    volatile uint32_t sink = hash;
+    (void)sink;
+    return s_RandomValues / 1e6 / time;
+  };
+  benchmarks.push_back(uints);
+
+  auto floats = std::make_shared<std::vector<float>>(s_RandomValues);
+  Benchmark fillFloat;
+  fillFloat.name = "Random::FillFloat";
+  fillFloat.unit = "M/s";
+  fillFloat.run  = [floats]() {
+    Sera::Timer timer;
+    Sera::Random::FillFloat(floats->data(), floats->size());
+    return floats->size() / 1e6 / timer.Elapsed();
+  };
+  benchmarks.push_back(fillFloat);
+
+  auto vectors = std::make_shared<std::vector<glm::vec3>>(s_RandomValues);
+  Benchmark fillSphere;
+  fillSphere.name = "Random::FillOnUnitSphere";
+  fillSphere.unit = "M/s";
+  fillSphere.run  = [vectors]() {
+    Sera::Timer timer;
+    Sera::Random::FillOnUnitSphere(vectors->data(), vectors->size());
+    return vectors->size() / 1e6 / timer.Elapsed();
+  };
+  benchmarks.push_back(fillSphere);
+}
+
+static void AddFrameBenchmark(std::vector<Benchmark> &benchmarks) {
+  struct Frames {
+      Sera::Timer timer;
+      uint32_t    count   = 0;
+      bool        started = false;
+  };
+  auto frames = std::make_shared<Frames>();
+
+  Benchmark benchmark;
+  benchmark.name           = "Application::Run/EmptyFrame";
+  benchmark.unit           = "ms";
+  benchmark.higherIsBetter = false;
+  // Runs once per frame and does nothing else, so the time between calls is
+  // the main loop: ImGui, recording, submitting and the frame fence
+  benchmark.run = [frames]() {
+    if (!frames->started) {
+      frames->timer.Reset();
+      frames->count   = 0;
+      frames->started = true;
+      return -1.0;
+    }
+    if (++frames->count < s_FramesPerSample) return -1.0;
+    frames->started = false;
+    return (double)frames->timer.ElapsedMillis() / frames->count;
+  };
+  benchmarks.push_back(benchmark);
+}
+
+static std::vector<Benchmark> CreateBenchmarks(const std::string &filter) {
+  std::vector<Benchmark> benchmarks;
+  AddSetDataBenchmarks(benchmarks);
+  AddCommandBufferBenchmark(benchmarks);
+  AddImageBenchmark(benchmarks);
+  AddRandomBenchmarks(benchmarks);
+  AddFrameBenchmark(benchmarks);
+
+  benchmarks.erase(std::remove_if(benchmarks.begin(), benchmarks.end(),
+                                  [&](const Benchmark &benchmark) {
+                                    return benchmark.name.find(filter) ==
+                                           std::string::npos;
+                                  }),
+                   benchmarks.end());
+  return benchmarks;
+}
+
+// Runs the benchmarks one after the other and closes the application after
+// the last
+class BenchLayer : public Sera::Layer {
+  public:
+    BenchLayer(std::vector<Benchmark> benchmarks, const Settings &settings,
+               std::vector<Bench::Result> &results)
+        : m_Benchmarks(std::move(benchmarks)),
+          m_Settings(settings),
+          m_Results(results) {}
+
+    virtual void OnUpdate(float ts) override {
+      if (m_Current >= m_Benchmarks.size()) {
+        Sera::Application::Get().Close();
+        return;
+      }
+
+      Benchmark &benchmark = m_Benchmarks[m_Current];
+      if (!m_Started) {
+        if (benchmark.setup) benchmark.setup();
+        m_Results.push_back(
+            {benchmark.name, benchmark.unit, benchmark.higherIsBetter, {}});
+        m_Started = true;
+      }
+
+      double value = benchmark.run();
+      if (value < 0.0) return;
+      if (m_Repetition >= m_Settings.warmup)
+        m_Results.back().samples.push_back(value);
+      if (++m_Repetition < m_Settings.warmup + m_Settings.repetitions) return;
+
+      if (benchmark.teardown) benchmark.teardown();
+      Bench::Summary summary = Bench::Summarize(m_Results.back().samples);
+      SR_INFO("{:<40} {:>14.3f} {} (stddev {:.1f}%)", benchmark.name,
+              summary.median, benchmark.unit,
+              summary.mean > 0.0 ? summary.stddev / summary.mean * 100.0
+                                 : 0.0);
+      m_Current++;
+      m_Repetition = 0;
+      m_Started    = false;
+    }
+
+  private:
+    std::vector<Benchmark>      m_Benchmarks;
+    Settings                    m_Settings;
+    std::vector<Bench::Result> &m_Results;
+
+    size_t   m_Current    = 0;
+    uint32_t m_Repetition = 0;
+    bool     m_Started    = false;
+};
+
+int main(int argc, char **argv) {
+  Sera::Log::Init();
+
+  Settings    settings;
+  std::string output = "sera_bench.json";
+  std::string baseline;
+  double      threshold = 0.05;
+  for (int i = 1; i < argc; i++) {
+    if (strcmp(argv[i], "--repetitions") == 0 && i + 1 < argc)
+      settings.repetitions = std::max(atoi(argv[++i]), 1);
+    if (strcmp(argv[i], "--warmup") == 0 && i + 1 < argc)
+      settings.warmup = std::max(atoi(argv[++i]), 0);
+    if (strcmp(argv[i], "--filter") == 0 && i + 1 < argc)
+      settings.filter = argv[++i];
+    if (strcmp(argv[i], "--out") == 0 && i + 1 < argc) output = argv[++i];
+    if (strcmp(argv[i], "--baseline") == 0 && i + 1 < argc)
+      baseline = argv[++i];
+    // In percent
+    if (strcmp(argv[i], "--threshold") == 0 && i + 1 < argc)
+      threshold = atof(argv[++i]) / 100.0;
+  }
+
+  std::vector<Benchmark> benchmarks = CreateBenchmarks(settings.filter);
+  if (benchmarks.empty()) {
+    SR_ERROR("No benchmark matches \"{}\"", settings.filter);
+    return 1;
+  }
+  // SR_DEBUG is only defined for the library
+  if (Sera::Application::IsDebugBuild())
+    SR_WARN("Debug build, validation layers slow down every Vulkan call");
+
+  // Headless needs no window or surface, on machines without a GPU the
+  // loader's only device is a software one like lavapipe
+  Sera::ApplicationSpecification spec;
+  spec.Name              = "Sera Bench";
+  spec.Width             = 1280;
+  spec.Height            = 720;
+  spec.Headless          = true;
+  spec.PipelineCachePath = "";
+  spec.ShaderHotReload   = false;
+
+  std::vector<Bench::Result> results;
+  std::string                device;
+  {
+    Sera::Application app(spec);
+    device = Sera::Application::GetVulkanDevice()
+                 ->physicalDevice->properties.deviceName;
+    SR_INFO("Running {} benchmarks on {}", benchmarks.size(), device);
+    app.PushLayer(std::make_shared<BenchLayer>(std::move(benchmarks),
+                                               settings, results));
+    app.Run();
+  }
+
+  if (!Bench::WriteJson(output, device, results)) return 1;
+  if (baseline.empty()) return 0;
+
+  std::vector<Bench::BaselineEntry> entries;
+  if (!Bench::ReadBaseline(baseline, entries)) return 1;
+  uint32_t regressions = Bench::Compare(results, entries, threshold);
+  if (regressions) {
+    SR_ERROR("{} benchmarks regressed against {}", regressions, baseline);
+    return 1;
+  }
+  return 0;
+}
@@ -0,0 +1,45 @@
+# Turns a SPIR-V binary into a header with a constexpr uint32_t array.
+# Usage: cmake -DINPUT=<spv> -DOUTPUT=<header> -DNAME=<symbol>
+#              [-DSOURCE=<glsl>] -P embed_spirv.cmake
+
+file(READ "${INPUT}" hex HEX)
+string(LENGTH "${hex}" length)
+math(EXPR remainder "${length} % 8")
+if(length EQUAL 0 OR NOT remainder EQUAL 0)
+	message(FATAL_ERROR "${INPUT} is not a SPIR-V module")
+endif()
+
+# SPIR-V words are little endian on disk
+string(REGEX REPLACE "(..)(..)(..)(..)" "0x\\4\\3\\2\\1, " words "${hex}")
+set(word "0x........, ")
+string(REGEX REPLACE "(${word}${word}${word}${word}${word}0x........,) "
+	"\\1\n      " words "${words}")
+string(REGEX REPLACE "\n      $" "" words "${words}")
+string(REGEX REPLACE ", $" "," words "${words}")
+
+if(NOT SOURCE)
+	set(SOURCE "${INPUT}")
+endif()
+get_filename_component(source_name "${SOURCE}" NAME)
+
+set(header
+"// Generated from ${source_name} at build time, do not edit
+#pragma once
+
+#include <cstdint>
+
+namespace Sera::Shaders {
+  constexpr uint32_t ${NAME}[] = {
+      ${words}
+  };
+}  // namespace Sera::Shaders
+")
+
+# Keeps the header timestamp when the SPIR-V did not change
+if(EXISTS "${OUTPUT}")
+	file(READ "${OUTPUT}" previous)
+	if(previous STREQUAL header)
+		return()
+	endif()
+endif()
+file(WRITE "${OUTPUT}" "${header}")
@@ -0,0 +1,64 @@
+# Build-time shader compilation. GLSL sources are compiled to SPIR-V in
+# ${SR_SHADER_DIR} and embedded into the target as constexpr uint32_t arrays,
+# see embed_spirv.cmake. <name>.<stage> becomes <name>-<stage>.spv and
+# Shaders/<name>_<stage>.h with the array Sera::Shaders::<name>_<stage>.
+
+set(SR_SHADER_DIR "${CMAKE_BINARY_DIR}/shaders")
+set(SR_EMBED_SPIRV_SCRIPT "${CMAKE_CURRENT_LIST_DIR}/embed_spirv.cmake")
+
+set(SR_SHADER_TOOL_HINTS "$ENV{VULKAN_SDK}/bin" "$ENV{VULKAN_SDK}/Bin")
+find_program(SR_GLSLC glslc HINTS ${SR_SHADER_TOOL_HINTS})
+find_program(SR_GLSLANG_VALIDATOR glslangValidator HINTS ${SR_SHADER_TOOL_HINTS})
+find_program(SR_SPIRV_OPT spirv-opt HINTS ${SR_SHADER_TOOL_HINTS})
+
+if(NOT SR_GLSLC AND NOT SR_GLSLANG_VALIDATOR)
+	message(FATAL_ERROR "glslc or glslangValidator is required to compile shaders, install the Vulkan SDK")
+endif()
+if(SR_SHADER_OPTIMIZE AND NOT SR_SPIRV_OPT)
+	message(WARNING "spirv-opt not found, shaders are embedded unoptimized")
+endif()
+
+function(sera_compile_shaders TARGET)
+	set(headers)
+	foreach(source ${ARGN})
+		get_filename_component(name "${source}" NAME_WE)
+		get_filename_component(extension "${source}" EXT)
+		string(SUBSTRING "${extension}" 1 -1 stage)
+
+		set(spv "${SR_SHADER_DIR}/${name}-${stage}.spv")
+		set(header "${SR_SHADER_DIR}/include/Shaders/${name}_${stage}.h")
+
+		# spirv-opt reads the raw compiler output, never its own output file
+		if(SR_SHADER_OPTIMIZE AND SR_SPIRV_OPT)
+			set(compiled "${spv}.unopt")
+			set(optimize COMMAND "${SR_SPIRV_OPT}" -O "${compiled}" -o "${spv}")
+		else()
+			set(compiled "${spv}")
+			set(optimize)
+		endif()
+		if(SR_GLSLC)
+			set(compile "${SR_GLSLC}" "${source}" -o "${compiled}")
+		else()
+			set(compile "${SR_GLSLANG_VALIDATOR}" -V "${source}" -o "${compiled}")
+		endif()
+
+		add_custom_command(
+			OUTPUT "${spv}" "${header}"
+			COMMAND "${CMAKE_COMMAND}" -E make_directory "${SR_SHADER_DIR}/include/Shaders"
+			COMMAND ${compile}
+			${optimize}
+			COMMAND "${CMAKE_COMMAND}"
+				"-DINPUT=${spv}" "-DOUTPUT=${header}"
+				"-DNAME=${name}_${stage}" "-DSOURCE=${source}"
+				-P "${SR_EMBED_SPIRV_SCRIPT}"
+			DEPENDS "${source}" "${SR_EMBED_SPIRV_SCRIPT}"
+			COMMENT "Compiling shader ${name}.${stage}"
+			VERBATIM
+		)
+		list(APPEND headers "${header}")
+	endforeach()
+
+	add_custom_target(${TARGET}Shaders DEPENDS ${headers})
+	add_dependencies(${TARGET} ${TARGET}Shaders)
+	target_include_directories(${TARGET} PUBLIC "${SR_SHADER_DIR}/include")
+endfunction()